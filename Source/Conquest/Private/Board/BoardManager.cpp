@@ -1,13 +1,17 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "BoardManager.h"
+#include "CSKZobrist.h"
 #include "UObject/ConstructorHelpers.h"
 
 #include "Components/BillboardComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
 #include "Components/StaticMeshComponent.h"
+#include "Engine/Texture2D.h"
 #include "Engine/World.h"
 #include "Materials/MaterialInstanceConstant.h"
 #include "Materials/MaterialInstanceDynamic.h"
+#include "TimerManager.h"
 
 #if WITH_EDITOR
 #include "DrawDebugHelpers.h"
@@ -18,6 +22,16 @@
 
 #define LOCTEXT_NAMESPACE "BoardManager"
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("BoardManager Path Cache Hits"), STAT_BoardManagerPathCacheHits, STATGROUP_Conquest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("BoardManager Path Cache Misses"), STAT_BoardManagerPathCacheMisses, STATGROUP_Conquest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("BoardManager Reachable Cache Hits"), STAT_BoardManagerReachableCacheHits, STATGROUP_Conquest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("BoardManager Reachable Cache Misses"), STAT_BoardManagerReachableCacheMisses, STATGROUP_Conquest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("BoardManager Highlight Refreshes"), STAT_BoardManagerHighlightRefreshes, STATGROUP_Conquest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("BoardManager Highlight Refreshes Avoided"), STAT_BoardManagerHighlightRefreshesAvoided, STATGROUP_Conquest);
+
+/** Max amount of results each query cache will hold */
+static const int32 BoardQueryCacheSize = 64;
+
 ABoardManager::ABoardManager()
 {
 	// We only need to tick in editor
@@ -63,6 +77,17 @@ ABoardManager::ABoardManager()
 	Player1PortalHex = FIntVector(-1);
 	Player2PortalHex = FIntVector(-1);
 
+	BoardOccupancy.BoardManager = this;
+	OccupancyGeneration = 0;
+	BoardHash = 0;
+	bUseInstancedTileRendering = false;
+	bInstancedTilesActive = false;
+	BoardStateMaterial = nullptr;
+	BoardStateMaterialInstance = nullptr;
+	BoardStateTexture = nullptr;
+	PathCache.Empty(BoardQueryCacheSize);
+	ReachableCache.Empty(BoardQueryCacheSize);
+
 	#if WITH_EDITORONLY_DATA
 	GridTileTemplate = nullptr;
 	bDrawDebugBoard = true;
@@ -78,6 +103,19 @@ void ABoardManager::BeginPlay()
 	#else
 	SetActorTickEnabled(false);
 	#endif
+
+	RebuildBitboards();
+
+	// Needs to be done before instancing, so all tiles will share the same batch
+	if (BoardStateMaterial)
+	{
+		InitBoardStateTexture();
+	}
+
+	if (bUseInstancedTileRendering)
+	{
+		InitInstancedTileRendering();
+	}
 }
 
 void ABoardManager::Tick(float DeltaTime)
@@ -126,6 +164,13 @@ void ABoardManager::Tick(float DeltaTime)
 	#endif
 }
 
+void ABoardManager::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ABoardManager, BoardOccupancy);
+}
+
 #if WITH_EDITOR
 void ABoardManager::CheckForErrors()
 {
@@ -311,16 +356,18 @@ void ABoardManager::InitBoard(const FBoardInitData& InitData)
 
 	// We can keep portals that still fit inside the new grid
 	{
-		if (!HexGrid.GridMap.Contains(Player1PortalHex))
+		if (!HexGrid.ContainsHex(Player1PortalHex))
 		{
 			Player1PortalHex = FIntVector(-1);
 		}
 
-		if (!HexGrid.GridMap.Contains(Player2PortalHex))
+		if (!HexGrid.ContainsHex(Player2PortalHex))
 		{
 			Player2PortalHex = FIntVector(-1);
 		}
 	}
+
+	RebuildBitboards();
 }
 
 void ABoardManager::SetPlayerPortal(int32 Player, const FIntVector& TileHex)
@@ -400,12 +447,40 @@ ATile* ABoardManager::TraceBoard(const FVector& Origin, const FVector& End) cons
 
 bool ABoardManager::FindPath(const ATile* Start, const ATile* Goal, FBoardPath& OutPath, bool bAllowPartial, int32 MaxDistance) const
 {
+	if (!Start || !Goal)
+	{
+		return false;
+	}
+
+	const FPathCacheKey Key(Start->GetGridHexValue(), Goal->GetGridHexValue(), MaxDistance, bAllowPartial, OccupancyGeneration);
+
+	const FHexGridPathFindResultData* ResultData = PathCache.FindAndTouch(Key);
+	if (ResultData)
+	{
+		INC_DWORD_STAT(STAT_BoardManagerPathCacheHits);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_BoardManagerPathCacheMisses);
+
+		FHexGridPathFindResultData NewResultData;
+		HexGrid.GeneratePath(Start, Goal, NewResultData, bAllowPartial, MaxDistance);
+
+		PathCache.Add(Key, MoveTemp(NewResultData));
+		ResultData = PathCache.FindAndTouch(Key);
+	}
+
 	bool bSuccess = false;
-	FHexGridPathFindResultData ResultData;
-	if (HexGrid.GeneratePath(Start, Goal, ResultData, bAllowPartial, MaxDistance))
+	switch (ResultData->Result)
 	{
-		OutPath.Path = ResultData.Path;
-		bSuccess = true;
+		case EHexGridPathFindResult::Success:
+		case EHexGridPathFindResult::AlreadyAtGoal:
+		case EHexGridPathFindResult::Partial:
+		{
+			OutPath.Path = ResultData->Path;
+			bSuccess = true;
+			break;
+		}
 	}
 
 	return bSuccess;
@@ -435,6 +510,46 @@ bool ABoardManager::GetOccupiedTilesWithinDistance(const ATile* Origin, int32 Di
 	return bSuccess;
 }
 
+TSharedPtr<const FHexGridReachableSet> ABoardManager::GetReachableTiles(const ATile* Origin, int32 MaxDistance) const
+{
+	if (!Origin)
+	{
+		return nullptr;
+	}
+
+	const FReachableCacheKey Key(Origin->GetGridHexValue(), MaxDistance, OccupancyGeneration);
+
+	// Sets with nothing reachable are cached as null
+	const TSharedPtr<const FHexGridReachableSet>* CachedSet = ReachableCache.FindAndTouch(Key);
+	if (CachedSet)
+	{
+		INC_DWORD_STAT(STAT_BoardManagerReachableCacheHits);
+		return *CachedSet;
+	}
+
+	INC_DWORD_STAT(STAT_BoardManagerReachableCacheMisses);
+
+	TSharedPtr<FHexGridReachableSet> NewSet = MakeShared<FHexGridReachableSet>();
+	if (!HexGrid.GetReachableSet(Origin->GetGridHexValue(), MaxDistance, *NewSet))
+	{
+		NewSet.Reset();
+	}
+
+	ReachableCache.Add(Key, NewSet);
+	return NewSet;
+}
+
+bool ABoardManager::GetPathFromReachableSet(const FHexGridReachableSet& ReachableSet, const ATile* Goal, FBoardPath& OutPath) const
+{
+	bool bSuccess = false;
+	if (Goal)
+	{
+		bSuccess = HexGrid.GetPathFromReachableSet(ReachableSet, Goal->GetGridHexValue(), OutPath.Path);
+	}
+
+	return bSuccess;
+}
+
 int32 ABoardManager::IsPlayerPortalTile(const ATile* Tile) const
 {
 	if (Tile)
@@ -468,12 +583,21 @@ TArray<ATile*> ABoardManager::GetTilesWithMatchingElement(ECSKElementType Elemen
 
 	if (HexGrid.bGridGenerated)
 	{
-		TArray<ATile*> AllTiles = HexGrid.GetAllTiles();
-		for (ATile* Tile : AllTiles)
+		if (AreBitboardsValid())
+		{
+			FHexBitboard Mask;
+			GetElementMask(Elements, Mask);
+			GetTilesFromMask(Mask, Tiles);
+		}
+		else
 		{
-			if (ensure(Tile) && (Tile->TileType & Elements) != ECSKElementType::None)
+			TArray<ATile*> AllTiles = HexGrid.GetAllTiles();
+			for (ATile* Tile : AllTiles)
 			{
-				Tiles.Add(Tile);
+				if (ensure(Tile) && (Tile->TileType & Elements) != ECSKElementType::None)
+				{
+					Tiles.Add(Tile);
+				}
 			}
 		}
 	}
@@ -487,12 +611,19 @@ TArray<ATile*> ABoardManager::GetNullTiles() const
 
 	if (HexGrid.bGridGenerated)
 	{
-		TArray<ATile*> AllTiles = HexGrid.GetAllTiles();
-		for (ATile* Tile : AllTiles)
+		if (AreBitboardsValid())
 		{
-			if (ensure(Tile) && Tile->bIsNullTile)
+			GetTilesFromMask(NullBitboard, Tiles);
+		}
+		else
+		{
+			TArray<ATile*> AllTiles = HexGrid.GetAllTiles();
+			for (ATile* Tile : AllTiles)
 			{
-				Tiles.Add(Tile);
+				if (ensure(Tile) && Tile->bIsNullTile)
+				{
+					Tiles.Add(Tile);
+				}
 			}
 		}
 	}
@@ -502,10 +633,16 @@ TArray<ATile*> ABoardManager::GetNullTiles() const
 
 bool ABoardManager::CanPlaceTowerOnTile(const ATile* Tile) const
 {
-	if (Tile && !Tile->IsTileOccupied())
+	if (Tile)
 	{
-		// Towers aren't allowed to be build on portal tiles
-		return IsPlayerPortalTile(Tile) == -1;
+		if (AreBitboardsValid())
+		{
+			// Towers aren't allowed to be build on portal tiles
+			int32 Index = HexGrid.HexToIndex(Tile->GetGridHexValue());
+			return Index != INDEX_NONE && !(OccupiedBitboard.Test(Index) || NullBitboard.Test(Index) || PortalBitboard.Test(Index));
+		}
+		
+		return !Tile->IsTileOccupied() && IsPlayerPortalTile(Tile) == -1;
 	}
 
 	return false;
@@ -517,7 +654,15 @@ bool ABoardManager::PlaceBoardPieceOnTile(AActor* BoardPiece, ATile* Tile)
 	{
 		if (Tile && Tile->SetBoardPiece(BoardPiece))
 		{
-			Multi_SetTileWithBoardPiece(Tile, true);
+			const int32 OwnerID = Tile->GetBoardPiecesOwnerPlayerID();
+			SetTileWithBoardPiece(Tile, true, OwnerID);
+
+			int32 Index = HexGrid.HexToIndex(Tile->GetGridHexValue());
+			if (ensure(Index != INDEX_NONE))
+			{
+				BoardOccupancy.AddEntry(Index, BoardPiece, OwnerID);
+			}
+
 			return true;
 		}
 	}
@@ -531,7 +676,8 @@ bool ABoardManager::ClearBoardPieceOnTile(ATile* Tile)
 	{
 		if (Tile && Tile->ClearBoardPiece())
 		{
-			Multi_SetTileWithBoardPiece(Tile, false);
+			SetTileWithBoardPiece(Tile, false, -1);
+			BoardOccupancy.RemoveEntry(HexGrid.HexToIndex(Tile->GetGridHexValue()));
 			return true;
 		}
 	}
@@ -539,7 +685,40 @@ bool ABoardManager::ClearBoardPieceOnTile(ATile* Tile)
 	return false;
 }
 
-void ABoardManager::Multi_SetTileWithBoardPiece_Implementation(ATile* Tile, bool bHasBoardPiece)
+void ABoardManager::OnBoardPieceEntryAdded(const FBoardOccupancyEntry& Entry)
+{
+	ATile* Tile = Entry.Cell >= 0 && Entry.Cell < HexGrid.Num() ? HexGrid.GetTileAtIndex(Entry.Cell) : nullptr;
+	if (!Tile)
+	{
+		UE_LOG(LogConquest, Warning, TEXT("ABoardManager: Replicated board piece is on cell %i, which has no tile"), Entry.Cell);
+		return;
+	}
+
+	// Board pieces might not have replicated yet, but we still know the tile is occupied
+	SetTileWithBoardPiece(Tile, true, Entry.OwnerID);
+
+	if (Entry.BoardPiece && Tile->GetBoardPiece() != Entry.BoardPiece)
+	{
+		Tile->HandleBoardPieceCleared();
+		Tile->HandleBoardPieceSet(Entry.BoardPiece);
+	}
+}
+
+void ABoardManager::OnBoardPieceEntryRemoved(const FBoardOccupancyEntry& Entry)
+{
+	ATile* Tile = Entry.Cell >= 0 && Entry.Cell < HexGrid.Num() ? HexGrid.GetTileAtIndex(Entry.Cell) : nullptr;
+	if (Tile)
+	{
+		// Piece may have already been replaced by a newer entry for this tile
+		if (!Entry.BoardPiece || Tile->GetBoardPiece() == Entry.BoardPiece)
+		{
+			Tile->HandleBoardPieceCleared();
+			SetTileWithBoardPiece(Tile, false, -1);
+		}
+	}
+}
+
+void ABoardManager::SetTileWithBoardPiece(ATile* Tile, bool bHasBoardPiece, int32 OwnerID)
 {
 	if (bHasBoardPiece)
 	{
@@ -549,6 +728,168 @@ void ABoardManager::Multi_SetTileWithBoardPiece_Implementation(ATile* Tile, bool
 	{
 		TilesWithBoardPieces.Remove(Tile);
 	}
+
+	UpdateBitboardsForTile(Tile, bHasBoardPiece, OwnerID);
+
+	// Any cached paths or reachable sets are now out of date
+	++OccupancyGeneration;
+}
+
+void ABoardManager::RebuildBitboards()
+{
+	// Board state is being rebuilt, so any cached queries are out of date
+	++OccupancyGeneration;
+
+	const int32 NumCells = HexGrid.Num();
+
+	BoardHash = 0;
+
+	NullBitboard.Init(NumCells);
+	OccupiedBitboard.Init(NumCells);
+	PortalBitboard.Init(NumCells);
+
+	for (FHexBitboard& Bitboard : PlayerBitboards)
+	{
+		Bitboard.Init(NumCells);
+	}
+
+	for (FHexBitboard& Bitboard : ElementBitboards)
+	{
+		Bitboard.Init(NumCells);
+	}
+
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		const ATile* Tile = HexGrid.GetTileAtIndex(Index);
+		if (!Tile)
+		{
+			continue;
+		}
+
+		NullBitboard.SetValue(Index, Tile->bIsNullTile);
+		PortalBitboard.SetValue(Index, IsPlayerPortalTile(Tile) != -1);
+
+		for (int32 i = 0; i < ARRAY_COUNT(ElementBitboards); ++i)
+		{
+			if ((Tile->TileType & static_cast<ECSKElementType>(1 << i)) != ECSKElementType::None)
+			{
+				ElementBitboards[i].Set(Index);
+			}
+		}
+
+		// Null tiles can never be occupied, so are treated as an element of their own
+		FCSKZobrist::Toggle(BoardHash, ECSKHashFeature::Element, Index, Tile->bIsNullTile ? 0xFF : static_cast<int32>(Tile->TileType));
+
+		if (Tile->IsTileOccupied(false))
+		{
+			UpdateBitboardsForTile(Tile, true, Tile->GetBoardPiecesOwnerPlayerID());
+		}
+	}
+
+	// Clients may have received entries whose board pieces have yet to replicate, leaving their tiles
+	// unoccupied. Entries are what decide if a tile is occupied, so they are applied on top of the tiles
+	for (const FBoardOccupancyEntry& Entry : BoardOccupancy.GetEntries())
+	{
+		const ATile* Tile = Entry.Cell >= 0 && Entry.Cell < NumCells ? HexGrid.GetTileAtIndex(Entry.Cell) : nullptr;
+		if (Tile)
+		{
+			UpdateBitboardsForTile(Tile, true, Entry.OwnerID);
+		}
+	}
+}
+
+bool ABoardManager::AreBitboardsValid() const
+{
+	// Tiles can be freely edited before play, so bitboards are only trusted once we have begun play
+	return HasActorBegunPlay() && NullBitboard.Num() == HexGrid.Num();
+}
+
+void ABoardManager::GetRangeMask(const ATile* Origin, int32 Distance, FHexBitboard& OutMask) const
+{
+	OutMask.Init(HexGrid.Num());
+
+	if (!Origin || Distance < 0)
+	{
+		return;
+	}
+
+	HexGrid.ForEachInRange(Origin->GetGridHexValue(), Distance, [&OutMask](ATile* Tile, int32 Index)
+	{
+		OutMask.Set(Index);
+		return true;
+	});
+}
+
+void ABoardManager::GetElementMask(ECSKElementType Elements, FHexBitboard& OutMask) const
+{
+	OutMask.Init(HexGrid.Num());
+
+	for (int32 i = 0; i < ARRAY_COUNT(ElementBitboards); ++i)
+	{
+		if ((Elements & static_cast<ECSKElementType>(1 << i)) != ECSKElementType::None)
+		{
+			OutMask |= ElementBitboards[i];
+		}
+	}
+}
+
+void ABoardManager::GetBuildableMask(FHexBitboard& OutMask) const
+{
+	OutMask.Init(HexGrid.Num());
+	OutMask.SetAll();
+
+	OutMask.AndNot(NullBitboard);
+	OutMask.AndNot(OccupiedBitboard);
+	OutMask.AndNot(PortalBitboard);
+}
+
+void ABoardManager::GetTilesFromMask(const FHexBitboard& Mask, TArray<ATile*>& OutTiles) const
+{
+	OutTiles.Reset(Mask.CountSetBits());
+
+	Mask.ForEachSetBit([this, &OutTiles](int32 Index)
+	{
+		OutTiles.Add(HexGrid.GetTileAtIndex(Index));
+	});
+}
+
+void ABoardManager::UpdateBitboardsForTile(const ATile* Tile, bool bHasBoardPiece, int32 OwnerID)
+{
+	int32 Index = Tile ? HexGrid.HexToIndex(Tile->GetGridHexValue()) : INDEX_NONE;
+	if (Index == INDEX_NONE || Index >= OccupiedBitboard.Num())
+	{
+		return;
+	}
+
+	// Occupants are hashed as their owner plus one, with unowned pieces being past the last player
+	auto GetOccupant = [this, Index]() -> int32
+	{
+		if (!OccupiedBitboard.Test(Index))
+		{
+			return 0;
+		}
+
+		for (int32 i = 0; i < CSK_MAX_NUM_PLAYERS; ++i)
+		{
+			if (PlayerBitboards[i].Test(Index))
+			{
+				return i + 1;
+			}
+		}
+
+		return CSK_MAX_NUM_PLAYERS + 1;
+	};
+
+	const int32 OldOccupant = GetOccupant();
+
+	OccupiedBitboard.SetValue(Index, bHasBoardPiece);
+
+	for (int32 i = 0; i < CSK_MAX_NUM_PLAYERS; ++i)
+	{
+		PlayerBitboards[i].SetValue(Index, bHasBoardPiece && i == OwnerID);
+	}
+
+	FCSKZobrist::Update(BoardHash, ECSKHashFeature::Occupant, Index, OldOccupant, GetOccupant());
 }
 
 void ABoardManager::MoveBoardPieceUnderBoard(AActor* BoardPiece, float Scale) const
@@ -580,7 +921,7 @@ void ABoardManager::RefreshAllTilesHighlightMaterials()
 		TArray<ATile*> AllTiles = HexGrid.GetAllTiles();
 		for (ATile* Tile : AllTiles)
 		{
-			SetTilesHighlightMaterial(Tile);
+			MarkTileHighlightDirty(Tile);
 		}
 	}
 }
@@ -606,96 +947,460 @@ UMaterialInstanceDynamic* ABoardManager::GetPlayerHighlightMaterial(int32 Player
 	return nullptr;
 }
 
-void ABoardManager::SetTilesHighlightMaterial(ATile* Tile) const
+void ABoardManager::SetTilesHighlightMaterial(ATile* Tile)
 {
-	if (Tile)
+	// Tiles all share the same material, we only need to update the tiles texel
+	if (BoardStateMaterialInstance)
 	{
-		// TODO: Add null checks for each material
-
-		UStaticMeshComponent* TilesHighlightMesh = Tile->GetMesh();
+		WriteTileBoardState(Tile);
+		return;
+	}
 
-		// Null takes priority
-		if (Tile->bIsNullTile)
+	UMaterialInterface* Material = nullptr;
+	if (GetTilesHighlightMaterial(Tile, Material))
+	{
+		if (bInstancedTilesActive)
 		{
-			TilesHighlightMesh->SetMaterial(0, NullHighlightMaterial);
-			return;
+			SetTileInstanceMaterial(Tile, Material);
+		}
+		else
+		{
+			Tile->GetMesh()->SetMaterial(0, Material);
 		}
+	}
+}
+
+void ABoardManager::MarkTileHighlightDirty(ATile* Tile)
+{
+	if (!Tile)
+	{
+		return;
+	}
+
+	// Outside of play (e.g. in editor) there is no next tick to wait for
+	UWorld* World = GetWorld();
+	int32 Index = HexGrid.bGridGenerated ? HexGrid.HexToIndex(Tile->GetGridHexValue()) : INDEX_NONE;
+	if (!World || !HasActorBegunPlay() || Index == INDEX_NONE)
+	{
+		SetTilesHighlightMaterial(Tile);
+		return;
+	}
+
+	// Grid could have been regenerated since last refresh
+	if (DirtyHighlightBitboard.Num() != HexGrid.Num())
+	{
+		DirtyHighlightBitboard.Init(HexGrid.Num());
+	}
+
+	if (DirtyHighlightBitboard.Test(Index))
+	{
+		INC_DWORD_STAT(STAT_BoardManagerHighlightRefreshesAvoided);
+		return;
+	}
 
-		bool bIsTileHovered = Tile->IsHovered();
+	DirtyHighlightBitboard.Set(Index);
 
-		// Tile has been marked as selectable or unselectable (e.g. highlighting
-		// tiles a player can move to during their action phase). For some visualizations,
-		// the selection takes priority over the hover highlight
-		ETileSelectionState SelectionState = Tile->GetSelectionState();
-		if (SelectionState != ETileSelectionState::NotSelectable)
+	if (!DirtyHighlightHandle.IsValid())
+	{
+		DirtyHighlightHandle = World->GetTimerManager().SetTimerForNextTick(this, &ABoardManager::FlushDirtyTileHighlights);
+	}
+}
+
+void ABoardManager::FlushDirtyTileHighlights()
+{
+	if (DirtyHighlightHandle.IsValid())
+	{
+		GetWorldTimerManager().ClearTimer(DirtyHighlightHandle);
+	}
+
+	if (DirtyHighlightBitboard.Num() == HexGrid.Num())
+	{
+		DirtyHighlightBitboard.ForEachSetBit([this](int32 Index)->void
 		{
-			UMaterialInstanceConstant* PriorityMat = nullptr;
+			INC_DWORD_STAT(STAT_BoardManagerHighlightRefreshes);
+			SetTilesHighlightMaterial(HexGrid.GetTileAtIndex(Index));
+		});
+	}
+
+	DirtyHighlightBitboard.ClearAll();
+
+	// Upload now rather than waiting another tick for the texels we just wrote
+	if (BoardStateUploadHandle.IsValid())
+	{
+		GetWorldTimerManager().ClearTimer(BoardStateUploadHandle);
+		UploadBoardStateTexture();
+	}
+}
 
-			switch (SelectionState)
+bool ABoardManager::GetTilesHighlightMaterial(const ATile* Tile, UMaterialInterface*& OutMaterial) const
+{
+	// TODO: Add null checks for each material
+
+	ETileHighlightState HighlightState;
+	int32 PlayerID;
+	if (!GetTilesHighlightState(Tile, HighlightState, PlayerID))
+	{
+		return false;
+	}
+
+	switch (HighlightState)
+	{
+		case ETileHighlightState::Null:
+		{
+			OutMaterial = NullHighlightMaterial;
+			return true;
+		}
+		case ETileHighlightState::Selectable:
+		{
+			OutMaterial = SelectableHighlightMaterial;
+			return true;
+		}
+		case ETileHighlightState::Unselectable:
+		{
+			OutMaterial = UnselectableHighlightMaterial;
+			return true;
+		}
+		case ETileHighlightState::Hovered:
+		{
+			OutMaterial = HoveredHighlightMaterial;
+			return true;
+		}
+		case ETileHighlightState::Player:
+		{
+			OutMaterial = GetPlayerHighlightMaterial(PlayerID);
+			return true;
+		}
+		case ETileHighlightState::Element:
+		{
+			if (ElementHighlightMaterials.Contains(Tile->TileType))
 			{
-				case ETileSelectionState::Selectable:
-				{
-					PriorityMat = bIsTileHovered ? nullptr : SelectableHighlightMaterial;
-					break;
-				}
-				case ETileSelectionState::Unselectable:
-				{
-					PriorityMat = bIsTileHovered ? nullptr : UnselectableHighlightMaterial;
-					break;
-				}
-				case ETileSelectionState::SelectablePriority:
-				{
-					PriorityMat = SelectableHighlightMaterial;
-					break;
-				}
-				case ETileSelectionState::UnselectablePriority:
-				{
-					PriorityMat = UnselectableHighlightMaterial;
-					break;
-				}
+				OutMaterial = ElementHighlightMaterials[Tile->TileType];
+				return true;
 			}
 
-			if (PriorityMat)
+			break;
+		}
+	}
+
+	return false;
+}
+
+bool ABoardManager::GetTilesHighlightState(const ATile* Tile, ETileHighlightState& OutState, int32& OutPlayerID) const
+{
+	OutPlayerID = -1;
+
+	if (!Tile)
+	{
+		return false;
+	}
+
+	// Null takes priority
+	if (Tile->bIsNullTile)
+	{
+		OutState = ETileHighlightState::Null;
+		return true;
+	}
+
+	bool bIsTileHovered = Tile->IsHovered();
+
+	// Tile has been marked as selectable or unselectable (e.g. highlighting
+	// tiles a player can move to during their action phase). For some visualizations,
+	// the selection takes priority over the hover highlight
+	switch (Tile->GetSelectionState())
+	{
+		case ETileSelectionState::Selectable:
+		{
+			if (!bIsTileHovered)
 			{
-				TilesHighlightMesh->SetMaterial(0, PriorityMat);
-				return;
+				OutState = ETileHighlightState::Selectable;
+				return true;
 			}
+
+			break;
 		}
+		case ETileSelectionState::Unselectable:
+		{
+			if (!bIsTileHovered)
+			{
+				OutState = ETileHighlightState::Unselectable;
+				return true;
+			}
 
-		// Player can potentially select this tile, signal this to
-		// them by displaying a unique material just for hovering
-		if (bIsTileHovered)
+			break;
+		}
+		case ETileSelectionState::SelectablePriority:
 		{
-			TilesHighlightMesh->SetMaterial(0, HoveredHighlightMaterial);
-			return;
+			OutState = ETileHighlightState::Selectable;
+			return true;
+		}
+		case ETileSelectionState::UnselectablePriority:
+		{
+			OutState = ETileHighlightState::Unselectable;
+			return true;
 		}
+	}
 
-		// This tile could potentially be a players portal, match it to their color
-		int32 PortalID = IsPlayerPortalTile(Tile);
-		if (PortalID != -1)
+	// Player can potentially select this tile, signal this to
+	// them by displaying a unique material just for hovering
+	if (bIsTileHovered)
+	{
+		OutState = ETileHighlightState::Hovered;
+		return true;
+	}
+
+	// This tile could potentially be a players portal, match it to their color
+	int32 PortalID = IsPlayerPortalTile(Tile);
+	if (PortalID != -1)
+	{
+		OutState = ETileHighlightState::Player;
+		OutPlayerID = PortalID;
+		return true;
+	}
+
+	// A player owns a board piece on this tile, we can
+	// highlight it with the players assigned color 
+	int32 OwnerID = Tile->GetBoardPiecesOwnerPlayerID();
+	if (OwnerID != -1)
+	{
+		OutState = ETileHighlightState::Player;
+		OutPlayerID = OwnerID;
+		return true;
+	}
+
+	// Last case is simply based off tiles element
+	OutState = ETileHighlightState::Element;
+	return true;
+}
+
+void ABoardManager::InitInstancedTileRendering()
+{
+	// Nothing to render for dedicated servers
+	if (bInstancedTilesActive || !HexGrid.bGridGenerated || GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	TileInstanceHandles.Init(FIntPoint(INDEX_NONE), HexGrid.Num());
+	bInstancedTilesActive = true;
+
+	for (int32 Index = 0; Index < HexGrid.Num(); ++Index)
+	{
+		ATile* Tile = HexGrid.GetTileAtIndex(Index);
+		if (!Tile)
 		{
-			TilesHighlightMesh->SetMaterial(0, GetPlayerHighlightMaterial(PortalID));
-			return;
+			continue;
 		}
 
-		// A player owns a board piece on this tile, we can
-		// highlight it with the players assigned color 
-		int32 OwnerID = Tile->GetBoardPiecesOwnerPlayerID();
-		if (OwnerID != -1)
+		// Tiles start with whatever material they already have (either from the editor or from BeginPlay)
+		UStaticMeshComponent* TileMesh = Tile->GetMesh();
+		AddTileInstance(Index, TileMesh->GetMaterial(0), TileMesh->GetComponentTransform());
+
+		// Keep the mesh around as it's still used for collision
+		TileMesh->SetVisibility(false);
+	}
+}
+
+void ABoardManager::SetTileInstanceMaterial(const ATile* Tile, UMaterialInterface* Material)
+{
+	int32 Index = Tile ? HexGrid.HexToIndex(Tile->GetGridHexValue()) : INDEX_NONE;
+	if (Index == INDEX_NONE || !TileInstanceHandles.IsValidIndex(Index))
+	{
+		return;
+	}
+
+	// Already in the right batch
+	const FIntPoint& Handle = TileInstanceHandles[Index];
+	if (Handle.X != INDEX_NONE && TileInstanceBatches[Handle.X]->GetMaterial(0) == Material)
+	{
+		return;
+	}
+
+	FTransform Transform = RemoveTileInstance(Index);
+	AddTileInstance(Index, Material, Transform);
+}
+
+void ABoardManager::AddTileInstance(int32 CellIndex, UMaterialInterface* Material, const FTransform& Transform)
+{
+	int32* BatchPtr = TileInstanceBatchLookup.Find(Material);
+	if (!BatchPtr)
+	{
+		// All tiles share the same mesh, so use the mesh of the tile we are adding
+		const ATile* Tile = HexGrid.GetTileAtIndex(CellIndex);
+
+		UInstancedStaticMeshComponent* Batch = NewObject<UInstancedStaticMeshComponent>(this);
+		Batch->SetupAttachment(GetRootComponent());
+		Batch->SetMobility(EComponentMobility::Movable);
+		Batch->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Batch->SetStaticMesh(Tile->GetMesh()->GetStaticMesh());
+		Batch->SetMaterial(0, Material);
+		Batch->RegisterComponent();
+
+		int32 BatchIndex = TileInstanceBatches.Add(Batch);
+		TileInstanceBatchCells.AddDefaulted();
+
+		BatchPtr = &TileInstanceBatchLookup.Add(Material, BatchIndex);
+	}
+
+	const int32 BatchIndex = *BatchPtr;
+	int32 InstanceIndex = TileInstanceBatches[BatchIndex]->AddInstanceWorldSpace(Transform);
+	check(InstanceIndex == TileInstanceBatchCells[BatchIndex].Num());
+
+	TileInstanceBatchCells[BatchIndex].Add(CellIndex);
+	TileInstanceHandles[CellIndex] = FIntPoint(BatchIndex, InstanceIndex);
+}
+
+FTransform ABoardManager::RemoveTileInstance(int32 CellIndex)
+{
+	FTransform Transform = FTransform::Identity;
+
+	FIntPoint& Handle = TileInstanceHandles[CellIndex];
+	if (Handle.X == INDEX_NONE)
+	{
+		return Transform;
+	}
+
+	UInstancedStaticMeshComponent* Batch = TileInstanceBatches[Handle.X];
+	TArray<int32>& BatchCells = TileInstanceBatchCells[Handle.X];
+
+	Batch->GetInstanceTransform(Handle.Y, Transform, true);
+
+	// Instanced components shift every instance after a removed one, to keep
+	// our handles valid we move the last instance into the slot being removed
+	const int32 LastInstance = BatchCells.Num() - 1;
+	if (Handle.Y != LastInstance)
+	{
+		FTransform LastTransform;
+		Batch->GetInstanceTransform(LastInstance, LastTransform, true);
+		Batch->UpdateInstanceTransform(Handle.Y, LastTransform, true, false);
+
+		const int32 MovedCell = BatchCells[LastInstance];
+		BatchCells[Handle.Y] = MovedCell;
+		TileInstanceHandles[MovedCell].Y = Handle.Y;
+	}
+
+	Batch->RemoveInstance(LastInstance);
+	BatchCells.Pop(false);
+
+	Handle = FIntPoint(INDEX_NONE);
+	return Transform;
+}
+
+void ABoardManager::InitBoardStateTexture()
+{
+	// Nothing to render for dedicated servers
+	if (BoardStateMaterialInstance || !HexGrid.bGridGenerated || GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	const int32 Rows = GridDimensions.X;
+	const int32 Columns = GridDimensions.Y;
+	if (Rows <= 0 || Columns <= 0 || HexGrid.Num() != Rows * Columns)
+	{
+		UE_LOG(LogConquest, Warning, TEXT("Unable to create board state texture as grid dimensions are invalid"));
+		return;
+	}
+
+	BoardStateTexture = UTexture2D::CreateTransient(Columns, Rows, PF_B8G8R8A8);
+	if (!BoardStateTexture)
+	{
+		return;
+	}
+
+	// Texels are raw data, they should be sampled exactly as written
+	BoardStateTexture->SRGB = false;
+	BoardStateTexture->Filter = TF_Nearest;
+	BoardStateTexture->AddressX = TA_Clamp;
+	BoardStateTexture->AddressY = TA_Clamp;
+	BoardStateTexture->CompressionSettings = TC_VectorDisplacementmap;
+	BoardStateTexture->UpdateResource();
+
+	BoardStateMaterialInstance = UMaterialInstanceDynamic::Create(BoardStateMaterial, this);
+	BoardStateMaterialInstance->SetTextureParameterValue(TEXT("BoardState"), BoardStateTexture);
+	BoardStateMaterialInstance->SetVectorParameterValue(TEXT("BoardOrigin"), GetActorLocation());
+	BoardStateMaterialInstance->SetScalarParameterValue(TEXT("BoardHexSize"), GridHexSize);
+	BoardStateMaterialInstance->SetVectorParameterValue(TEXT("BoardDimensions"), FLinearColor(Rows, Columns, 0.f, 0.f));
+
+	// Player colors might have been set before we were created
+	for (int32 PlayerID = 0; PlayerID < CSK_MAX_NUM_PLAYERS; ++PlayerID)
+	{
+		UMaterialInstanceDynamic* PlayerMaterial = GetPlayerHighlightMaterial(PlayerID);
+		FLinearColor PlayerColor;
+		if (PlayerMaterial && PlayerMaterial->GetVectorParameterValue(FMaterialParameterInfo(TEXT("Color")), PlayerColor))
 		{
-			TilesHighlightMesh->SetMaterial(0, GetPlayerHighlightMaterial(OwnerID));
-			return;
+			BoardStateMaterialInstance->SetVectorParameterValue(*FString::Printf(TEXT("Player%iColor"), PlayerID + 1), PlayerColor);
 		}
+	}
 
-		// Last case is simply based off tiles element
-		if (ElementHighlightMaterials.Contains(Tile->TileType))
+	BoardStateTexels.Init(FColor(0, 0, 0, 0), HexGrid.Num());
+
+	for (int32 Index = 0; Index < HexGrid.Num(); ++Index)
+	{
+		ATile* Tile = HexGrid.GetTileAtIndex(Index);
+		if (Tile)
 		{
-			TilesHighlightMesh->SetMaterial(0, ElementHighlightMaterials[Tile->TileType]);
-			return;
+			Tile->GetMesh()->SetMaterial(0, BoardStateMaterialInstance);
+			WriteTileBoardState(Tile);
 		}
 	}
 }
 
+void ABoardManager::WriteTileBoardState(const ATile* Tile)
+{
+	int32 Index = Tile ? HexGrid.HexToIndex(Tile->GetGridHexValue()) : INDEX_NONE;
+	if (Index == INDEX_NONE || !BoardStateTexels.IsValidIndex(Index))
+	{
+		return;
+	}
+
+	ETileHighlightState HighlightState;
+	int32 PlayerID;
+	if (!GetTilesHighlightState(Tile, HighlightState, PlayerID))
+	{
+		return;
+	}
+
+	FColor Texel(static_cast<uint8>(HighlightState), static_cast<uint8>(Tile->TileType), static_cast<uint8>(PlayerID + 1), 255);
+	if (BoardStateTexels[Index] == Texel)
+	{
+		return;
+	}
+
+	BoardStateTexels[Index] = Texel;
+
+	// Any other changes this frame will be included in this upload
+	UWorld* World = GetWorld();
+	if (World && !BoardStateUploadHandle.IsValid())
+	{
+		BoardStateUploadHandle = World->GetTimerManager().SetTimerForNextTick(this, &ABoardManager::UploadBoardStateTexture);
+	}
+}
+
+void ABoardManager::UploadBoardStateTexture()
+{
+	BoardStateUploadHandle.Invalidate();
+
+	if (!BoardStateTexture || BoardStateTexels.Num() == 0)
+	{
+		return;
+	}
+
+	const int32 Columns = GridDimensions.Y;
+	const int32 Rows = GridDimensions.X;
+
+	// Data is consumed on the render thread, so it needs to outlive this call
+	FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(0, 0, 0, 0, Columns, Rows);
+	FColor* Data = new FColor[BoardStateTexels.Num()];
+	FMemory::Memcpy(Data, BoardStateTexels.GetData(), BoardStateTexels.Num() * sizeof(FColor));
+
+	BoardStateTexture->UpdateTextureRegions(0, 1, Region, Columns * sizeof(FColor), sizeof(FColor), reinterpret_cast<uint8*>(Data),
+		[](uint8* SrcData, const FUpdateTextureRegion2D* Regions)->void
+	{
+		delete[] reinterpret_cast<FColor*>(SrcData);
+		delete Regions;
+	});
+}
+
 void ABoardManager::SetHighlightColorForPlayer(int32 PlayerID, FLinearColor Color)
 {
 	if (HasAuthority())
@@ -741,6 +1446,11 @@ void ABoardManager::Multi_SetHighlightColorForPlayer_Implementation(int32 Player
 	{
 		HighlightMat->SetVectorParameterValue(TEXT("Color"), Color);
 	}
+
+	if (BoardStateMaterialInstance)
+	{
+		BoardStateMaterialInstance->SetVectorParameterValue(*FString::Printf(TEXT("Player%iColor"), Player + 1), Color);
+	}
 }
 
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BoardOccupancy.h"
+#include "BoardManager.h"
+
+void FBoardOccupancyEntry::PreReplicatedRemove(const FBoardOccupancyArray& InArraySerializer)
+{
+	if (InArraySerializer.BoardManager)
+	{
+		InArraySerializer.BoardManager->OnBoardPieceEntryRemoved(*this);
+	}
+}
+
+void FBoardOccupancyEntry::PostReplicatedAdd(const FBoardOccupancyArray& InArraySerializer)
+{
+	if (InArraySerializer.BoardManager)
+	{
+		InArraySerializer.BoardManager->OnBoardPieceEntryAdded(*this);
+	}
+}
+
+void FBoardOccupancyEntry::PostReplicatedChange(const FBoardOccupancyArray& InArraySerializer)
+{
+	// Board pieces that had yet to replicate when added will be changed once mapped
+	if (InArraySerializer.BoardManager)
+	{
+		InArraySerializer.BoardManager->OnBoardPieceEntryAdded(*this);
+	}
+}
+
+void FBoardOccupancyArray::AddEntry(int32 Cell, AActor* BoardPiece, int32 OwnerID)
+{
+	check(Cell >= 0);
+
+	// Cells are unique, a piece can't be placed on a tile that is already occupied
+	RemoveEntry(Cell);
+
+	FBoardOccupancyEntry& Entry = Entries.Emplace_GetRef(Cell, BoardPiece, OwnerID);
+	MarkItemDirty(Entry);
+}
+
+bool FBoardOccupancyArray::RemoveEntry(int32 Cell)
+{
+	const int32 Index = Entries.IndexOfByPredicate([Cell](const FBoardOccupancyEntry& Entry)
+	{
+		return Entry.Cell == Cell;
+	});
+
+	if (Index != INDEX_NONE)
+	{
+		Entries.RemoveAtSwap(Index);
+		MarkArrayDirty();
+		return true;
+	}
+
+	return false;
+}
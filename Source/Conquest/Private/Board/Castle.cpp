@@ -3,19 +3,24 @@
 #include "Castle.h"
 #include "CastleAIController.h"
 #include "CSKPlayerState.h"
+#include "Tile.h"
 
 #include "HealthComponent.h"
 #include "Components/StaticMeshComponent.h"
 #include "GameFramework/FloatingPawnMovement.h"
+#include "GameFramework/GameStateBase.h"
 
 #define LOCTEXT_NAMESPACE "Castle"
 
 ACastle::ACastle()
 {
-	PrimaryActorTick.bCanEverTick = false;
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
+	// Clients simulate paths we follow locally instead of receiving our transform every
+	// net update. The server only sends the path, checkpoints along it and final location
 	bReplicates = true;
-	bReplicateMovement = true;
+	bReplicateMovement = false;
 	bOnlyRelevantToOwner = false;
 
 	AutoPossessAI = EAutoPossessAI::Disabled;
@@ -42,6 +47,9 @@ ACastle::ACastle()
 
 	OwnerPlayerState = nullptr;
 	CachedTile = nullptr;
+
+	SimulatedTileIndex = 0;
+	SimulatedTileTime = 0.f;
 }
 
 void ACastle::SetBoardPieceOwnerPlayerState(ACSKPlayerState* InPlayerState)
@@ -84,6 +92,17 @@ void ACastle::GetBoardPieceUIData(FBoardPieceUIData& OutUIData) const
 	}
 }
 
+void ACastle::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Only clients simulate paths, the server is moved by the castle controller
+	if (!HasAuthority() && SimulatedPath.IsValid())
+	{
+		TickSimulatedBoardPath();
+	}
+}
+
 void ACastle::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
@@ -91,4 +110,184 @@ void ACastle::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeP
 	DOREPLIFETIME_CONDITION(ACastle, OwnerPlayerState, COND_InitialOnly);
 }
 
+void ACastle::ReplicateBoardPath(const FBoardPath& InPath)
+{
+	if (HasAuthority() && InPath.IsValid())
+	{
+		// Paths are limited by max tile movements, so will never get close to this
+		if (!ensure(InPath.Num() <= MAX_uint8 + 1))
+		{
+			return;
+		}
+
+		SimulatedPath = InPath;
+		SimulatedTileIndex = 0;
+		SimulatedTileTime = GetServerWorldTime();
+
+		TArray<FNetTileRef> PathTiles;
+		PathTiles.Reserve(InPath.Num());
+
+		for (ATile* Tile : InPath.Path)
+		{
+			PathTiles.Emplace(Tile);
+		}
+
+		Multi_FollowBoardPath(PathTiles, SimulatedTileTime);
+	}
+}
+
+void ACastle::ReplicateBoardPathCheckpoint(ATile* Tile)
+{
+	if (HasAuthority() && SimulatedPath.IsValid())
+	{
+		// Paths never visit the same tile twice
+		const int32 TileIndex = SimulatedPath.Path.IndexOfByKey(Tile);
+		if (TileIndex != INDEX_NONE)
+		{
+			Multi_BoardPathCheckpoint(static_cast<uint8>(TileIndex), GetServerWorldTime());
+
+			// No more checkpoints will follow
+			if (TileIndex == SimulatedPath.Num() - 1)
+			{
+				SimulatedPath.Reset();
+			}
+		}
+	}
+}
+
+void ACastle::ReplicateLocation()
+{
+	if (HasAuthority())
+	{
+		SimulatedPath.Reset();
+		Multi_SyncLocation(GetActorLocation());
+	}
+}
+
+void ACastle::Multi_FollowBoardPath_Implementation(const TArray<FNetTileRef>& PathTiles, float ServerStartTime)
+{
+	if (HasAuthority())
+	{
+		return;
+	}
+
+	TArray<ATile*> Path;
+	Path.Reserve(PathTiles.Num());
+
+	for (const FNetTileRef& TileRef : PathTiles)
+	{
+		ATile* Tile = TileRef.Resolve(this);
+		if (!Tile)
+		{
+			UE_LOG(LogConquest, Warning, TEXT("ACastle::Multi_FollowBoardPath: Failed to resolve tile %s of path"), *TileRef.GetHex().ToString());
+			return;
+		}
+
+		Path.Add(Tile);
+	}
+
+	SimulatedPath = FBoardPath(MoveTemp(Path));
+	SimulatedTileIndex = 0;
+	SimulatedTileTime = ServerStartTime;
+
+	SetActorTickEnabled(true);
+}
+
+void ACastle::Multi_BoardPathCheckpoint_Implementation(uint8 TileIndex, float ServerTime)
+{
+	if (HasAuthority() || !SimulatedPath.IsValid() || TileIndex >= SimulatedPath.Num())
+	{
+		return;
+	}
+
+	// Continue on from where the server is, this will correct any drift
+	SimulatedTileIndex = TileIndex;
+	SimulatedTileTime = ServerTime;
+
+	if (TileIndex == SimulatedPath.Num() - 1)
+	{
+		SetActorLocation(SimulatedPath.Goal()->GetActorLocation());
+		StopSimulatingBoardPath();
+	}
+	else
+	{
+		TickSimulatedBoardPath();
+	}
+}
+
+void ACastle::Multi_SyncLocation_Implementation(FVector_NetQuantize Location)
+{
+	if (HasAuthority())
+	{
+		return;
+	}
+
+	StopSimulatingBoardPath();
+	SetActorLocation(Location, false, nullptr, ETeleportType::TeleportPhysics);
+}
+
+void ACastle::TickSimulatedBoardPath()
+{
+	// The castle controller moves at max speed directly towards each tile, so we can work out where it
+	// should be based on how long its been since the last checkpoint. We stop at the goal regardless,
+	// as the server may have stopped earlier (we will be corrected once it informs us)
+	float Distance = FMath::Max(0.f, GetServerWorldTime() - SimulatedTileTime) * PawnMovement->GetMaxSpeed();
+
+	const int32 LastIndex = SimulatedPath.Num() - 1;
+	int32 TileIndex = SimulatedTileIndex;
+
+	FVector Location = SimulatedPath[TileIndex]->GetActorLocation();
+	FVector Direction = FVector::ZeroVector;
+
+	while (TileIndex < LastIndex)
+	{
+		const FVector NextLocation = SimulatedPath[TileIndex + 1]->GetActorLocation();
+		const FVector Segment = NextLocation - Location;
+		const float SegmentLength = Segment.Size();
+
+		Direction = Segment.GetSafeNormal();
+
+		if (Distance < SegmentLength)
+		{
+			Location += Direction * Distance;
+			break;
+		}
+
+		Distance -= SegmentLength;
+		Location = NextLocation;
+		++TileIndex;
+	}
+
+	// Face where we are heading, like the castle controller does on the server
+	if (!Direction.IsNearlyZero())
+	{
+		SetActorLocationAndRotation(Location, FRotator(0.f, Direction.Rotation().Yaw, 0.f));
+	}
+	else
+	{
+		SetActorLocation(Location);
+	}
+}
+
+void ACastle::StopSimulatingBoardPath()
+{
+	SimulatedPath.Reset();
+	SimulatedTileIndex = 0;
+	SimulatedTileTime = 0.f;
+
+	SetActorTickEnabled(false);
+}
+
+float ACastle::GetServerWorldTime() const
+{
+	UWorld* World = GetWorld();
+	AGameStateBase* GameState = World ? World->GetGameState() : nullptr;
+	if (GameState)
+	{
+		return GameState->GetServerWorldTimeSeconds();
+	}
+
+	return World ? World->GetTimeSeconds() : 0.f;
+}
+
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
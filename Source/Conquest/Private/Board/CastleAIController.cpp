@@ -23,7 +23,16 @@ bool ACastleAIController::FollowPath(const FBoardPath& InPath)
 	UBoardPathFollowingComponent* BoardFollowComponent = GetBoardPathFollowingComponent();
 	if (BoardFollowComponent && BoardFollowComponent->GetStatus() != EPathFollowingStatus::Moving)
 	{
-		return BoardFollowComponent->FollowPath(InPath);
+		if (BoardFollowComponent->FollowPath(InPath))
+		{
+			ACastle* Castle = GetCastle();
+			if (Castle)
+			{
+				Castle->ReplicateBoardPath(InPath);
+			}
+
+			return true;
+		}
 	}
 
 	return false;
@@ -35,16 +44,32 @@ void ACastleAIController::StopFollowingPath()
 	if (BoardFollowComponent && BoardFollowComponent->GetStatus() == EPathFollowingStatus::Moving)
 	{
 		BoardFollowComponent->StopFollowingPath();
+
+		ACastle* Castle = GetCastle();
+		if (Castle)
+		{
+			Castle->ReplicateLocation();
+		}
 	}
 }
 
 void ACastleAIController::OnBoardPathSegmentCompleted(ATile* SegmentTile)
 {
-
+	ACastle* Castle = GetCastle();
+	if (Castle)
+	{
+		Castle->ReplicateBoardPathCheckpoint(SegmentTile);
+	}
 }
 
 void ACastleAIController::OnBoardPathCompleted(ATile* DestinationTile)
 {
+	ACastle* Castle = GetCastle();
+	if (Castle)
+	{
+		Castle->ReplicateBoardPathCheckpoint(DestinationTile);
+	}
+
 	UE_LOG(LogConquest, Log, TEXT("Castle %s has finished moving!"), *GetCastle()->GetFName().ToString());
 }
 
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NetTileRef.h"
+#include "BoardManager.h"
+#include "ConquestFunctionLibrary.h"
+#include "Tile.h"
+#include "Containers/HexCore.h"
+
+namespace
+{
+	/** Bits used to write how many bits each coordinate uses */
+	const uint32 NetTileRefSizeBits = 4;
+
+	/** Largest row or column that can be referenced */
+	const uint32 NetTileRefMaxCoordinate = (1 << ((1 << NetTileRefSizeBits) - 1)) - 1;
+}
+
+FNetTileRef::FNetTileRef(const ATile* Tile)
+	: Hex(Tile ? Tile->GetGridHexValue() : FIntVector(-1))
+{
+
+}
+
+bool FNetTileRef::IsValid() const
+{
+	return HexCore::IsValidHex(Hex);
+}
+
+ATile* FNetTileRef::Resolve(const ABoardManager* BoardManager) const
+{
+	if (BoardManager && IsValid())
+	{
+		return BoardManager->GetTileAt(Hex);
+	}
+
+	return nullptr;
+}
+
+ATile* FNetTileRef::Resolve(const UObject* WorldContextObject) const
+{
+	return Resolve(UConquestFunctionLibrary::GetMatchBoardManager(WorldContextObject, false));
+}
+
+bool FNetTileRef::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	// Hexes are written as row and column as those are never negative (see HexCore::HexToIndex)
+	uint32 Row = 0;
+	uint32 Column = 0;
+
+	uint8 bHasTile = 0;
+	if (Ar.IsSaving())
+	{
+		if (IsValid())
+		{
+			Row = static_cast<uint32>(Hex.X + (Hex.Y >> 1));
+			Column = static_cast<uint32>(Hex.Y);
+
+			bHasTile = Row <= NetTileRefMaxCoordinate && Column <= NetTileRefMaxCoordinate;
+		}
+	}
+
+	Ar.SerializeBits(&bHasTile, 1);
+
+	if (bHasTile)
+	{
+		uint32 NumBits = Ar.IsSaving() ? FMath::CeilLogTwo(FMath::Max(Row, Column) + 1) : 0;
+		Ar.SerializeBits(&NumBits, NetTileRefSizeBits);
+
+		if (NumBits > 0)
+		{
+			Ar.SerializeBits(&Row, NumBits);
+			Ar.SerializeBits(&Column, NumBits);
+		}
+
+		if (Ar.IsLoading())
+		{
+			const int32 Y = static_cast<int32>(Column);
+			const int32 X = static_cast<int32>(Row) - (Y >> 1);
+			Hex = FIntVector(X, Y, -X - Y);
+		}
+	}
+	else if (Ar.IsLoading())
+	{
+		Hex = FIntVector(-1);
+	}
+
+	return true;
+}
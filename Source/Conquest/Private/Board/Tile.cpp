@@ -13,11 +13,10 @@ ATile::ATile()
 {
 	PrimaryActorTick.bCanEverTick = false;
 
-	bReplicates = true;
+	// Tiles are placed with the level, so clients already have every tile. They are never considered
+	// for replication, with occupancy being replicated by the board manager (see FBoardOccupancyArray)
+	bReplicates = false;
 	bNetLoadOnClient = true;
-	bAlwaysRelevant = false;
-	bOnlyRelevantToOwner = false;
-	bReplicateMovement = false;
 
 	Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
 	SetRootComponent(Mesh);
@@ -34,11 +33,6 @@ ATile::ATile()
 	#endif
 }
 
-void ATile::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
-{
-	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
-}
-
 #if WITH_EDITOR
 void ATile::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
 {
@@ -152,8 +146,8 @@ void ATile::RefreshHoveringPlayersBoardPieceUI()
 
 bool ATile::SetBoardPiece(AActor* BoardPiece)
 {
-	// Only set on the server
-	if (!HasAuthority())
+	// Only set on the server (tiles don't replicate, so will always have authority)
+	if (GetNetMode() == NM_Client)
 	{
 		return false;
 	}
@@ -173,15 +167,15 @@ bool ATile::SetBoardPiece(AActor* BoardPiece)
 	UE_LOG(LogConquest, Log, TEXT("Setting Board Piece %s for Tile %s (Hex Value %s)"),
 		*BoardPiece->GetName(), *GetName(), *GridHexIndex.ToString());
 
-	// Board piece is valid, have all clients update their occupant
-	Multi_SetBoardPiece(BoardPiece);
+	// Board piece is valid, clients will update their occupant once the board managers occupancy replicates
+	HandleBoardPieceSet(BoardPiece);
 	return true;
 }
 
 bool ATile::ClearBoardPiece()
 {
-	// Only clear on server
-	if (!HasAuthority())
+	// Only clear on server (tiles don't replicate, so will always have authority)
+	if (GetNetMode() == NM_Client)
 	{
 		return false;
 	}
@@ -195,12 +189,12 @@ bool ATile::ClearBoardPiece()
 	UE_LOG(LogConquest, Log, TEXT("Clearing Board Piece %s for Tile %s (Hex Value %s)"),
 		*PieceOccupant.GetObject()->GetName(), *GetName(), *GridHexIndex.ToString());
 
-	// We have a board piece to clear, have all clients update their occupant
-	Multi_ClearBoardPiece();
+	// We have a board piece to clear, clients will update their occupant once the board managers occupancy replicates
+	HandleBoardPieceCleared();
 	return true;
 }
 
-void ATile::Multi_SetBoardPiece_Implementation(AActor* BoardPiece)
+void ATile::HandleBoardPieceSet(AActor* BoardPiece)
 {
 	if (BoardPiece && ensure(BoardPiece->Implements<UBoardPieceInterface>()))
 	{
@@ -221,18 +215,9 @@ void ATile::Multi_SetBoardPiece_Implementation(AActor* BoardPiece)
 		RefreshHighlightMaterial();
 		RefreshHoveringPlayersBoardPieceUI();
 	}
-	else
-	{
-		// If we are clients and the board piece is null
-		if (!BoardPiece && !HasAuthority())
-		{
-			UE_LOG(LogConquest, Warning, TEXT("ATile::Multi_SetBoardPiece: Board Piece is null on the client. "
-				"This board piece may not be replicating or has yet to replicate."))
-		}
-	}
 }
 
-void ATile::Multi_ClearBoardPiece_Implementation()
+void ATile::HandleBoardPieceCleared()
 {
 	if (PieceOccupant.GetInterface() != nullptr)
 	{
@@ -345,6 +330,6 @@ void ATile::RefreshHighlightMaterial()
 	ABoardManager* BoardManager = UConquestFunctionLibrary::GetMatchBoardManager(this);
 	if (BoardManager)
 	{
-		BoardManager->SetTilesHighlightMaterial(this);
+		BoardManager->MarkTileHighlightDirty(this);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,323 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CSKAIComponent.h"
+#include "CSKGameMode.h"
+#include "CSKGameState.h"
+#include "CSKPlayerController.h"
+#include "CSKPlayerState.h"
+
+#include "BoardManager.h"
+#include "ConquestFunctionLibrary.h"
+#include "Spell.h"
+#include "SpellCard.h"
+#include "Tile.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	/** Get the index of the spell to use when casting spell card during the action phase */
+	int32 GetActionSpellIndex(TSubclassOf<USpellCard> SpellCard)
+	{
+		const USpellCard* DefaultSpellCard = SpellCard.GetDefaultObject();
+		if (DefaultSpellCard)
+		{
+			const TArray<TSubclassOf<USpell>>& Spells = DefaultSpellCard->GetSpells();
+			for (int32 i = 0; i < Spells.Num(); ++i)
+			{
+				const USpell* DefaultSpell = Spells[i].GetDefaultObject();
+				if (DefaultSpell && DefaultSpell->GetSpellType() == ESpellType::ActionPhase)
+				{
+					return i;
+				}
+			}
+		}
+
+		return INDEX_NONE;
+	}
+}
+
+UCSKAIComponent::UCSKAIComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = true;
+	PrimaryComponentTick.TickInterval = 0.1f;
+
+	TimeBudget = 2.f;
+	NumThreads = 0;
+
+	ActionPhaseRound = INDEX_NONE;
+	ActionPhaseRoundState = ECSKRoundState::Invalid;
+	bWaitingForTimeOut = false;
+}
+
+void UCSKAIComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Decisions are only made by the server
+	AActor* Owner = GetOwner();
+	if (!Owner || !Owner->HasAuthority() || !Owner->IsA<ACSKPlayerController>())
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UCSKAIComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	CancelSearch();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UCSKAIComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	ACSKGameMode* GameMode = UConquestFunctionLibrary::GetCSKGameMode(this);
+	ACSKPlayerController* Controller = Cast<ACSKPlayerController>(GetOwner());
+	if (!GameMode || !Controller)
+	{
+		return;
+	}
+
+	if (PendingResult.IsValid())
+	{
+		if (PendingResult.IsReady())
+		{
+			FinishSearch(GameMode);
+		}
+
+		return;
+	}
+
+	// Quick effects and bonus spells are not simulated, so we always skip them
+	if (Controller->bCanSelectNullifyQuickEffect || Controller->bCanSelectPostQuickEffect)
+	{
+		Controller->Server_SkipQuickEffectSelection();
+		return;
+	}
+
+	if (Controller->bCanSelectBonusSpellTarget)
+	{
+		Controller->Server_SkipBonusSpellSelection();
+		return;
+	}
+
+	if (!Controller->IsPerformingActionPhase() || !GameMode->IsActionPhaseInProgress())
+	{
+		return;
+	}
+
+	// Wait for our previous action to finish
+	if (GameMode->IsWaitingForAction() || GameMode->IsWaitingForSpellSelection())
+	{
+		return;
+	}
+
+	if (HasActionPhaseChanged(GameMode))
+	{
+		DeniedActions.Reset();
+		bWaitingForTimeOut = false;
+	}
+
+	if (!bWaitingForTimeOut)
+	{
+		StartSearch(GameMode);
+	}
+}
+
+void UCSKAIComponent::StartSearch(ACSKGameMode* GameMode)
+{
+	check(!PendingResult.IsValid());
+
+	// We simulate using the same rules our requests will be validated by
+	TSharedPtr<const FCSKRulesEngine, ESPMode::ThreadSafe> RulesEngine = GameMode->GetRulesEngine();
+	if (!RulesEngine.IsValid())
+	{
+		UE_LOG(LogConquest, Warning, TEXT("UCSKAIComponent::StartSearch: No rules engine for match, AI will not be able to act"));
+		bWaitingForTimeOut = true;
+		return;
+	}
+
+	TSharedPtr<FSearchTask, ESPMode::ThreadSafe> Task = MakeShared<FSearchTask, ESPMode::ThreadSafe>();
+	if (!GameMode->GetRulesEngineState(RulesEngine->GetRules(), Task->State))
+	{
+		return;
+	}
+
+	Task->Settings.TimeBudget = TimeBudget;
+	Task->Settings.NumThreads = NumThreads;
+	Task->Settings.Seed = FMath::Rand();
+	Task->Settings.ExcludedActions = DeniedActions;
+
+	// Leave plenty of time to act if the action phase is timed
+	const ACSKGameState* CSKGameState = UConquestFunctionLibrary::GetCSKGameState(this);
+	if (CSKGameState)
+	{
+		bool bIsInfinite = false;
+		const float TimeRemaining = CSKGameState->GetCountdownTimeRemainingSeconds(bIsInfinite);
+		if (!bIsInfinite)
+		{
+			Task->Settings.TimeBudget = FMath::Clamp(TimeRemaining * 0.25, 0.05, Task->Settings.TimeBudget);
+		}
+	}
+
+	PendingSearch = Task;
+	PendingResult = FCSKMonteCarloSearch::SearchAsync(RulesEngine.ToSharedRef(), Task->State, Task->Settings, &Task->bCancelled);
+}
+
+void UCSKAIComponent::FinishSearch(ACSKGameMode* GameMode)
+{
+	const FCSKSearchResult Result = PendingResult.Get();
+
+	PendingResult = TFuture<FCSKSearchResult>();
+	PendingSearch.Reset();
+
+	ACSKPlayerController* Controller = CastChecked<ACSKPlayerController>(GetOwner());
+
+	// The action phase might have ended (e.g. timed out) while we were searching
+	if (HasActionPhaseChanged(GameMode) || !Controller->IsPerformingActionPhase())
+	{
+		DeniedActions.Reset();
+		bWaitingForTimeOut = false;
+		return;
+	}
+
+	if (!Result.bFoundAction)
+	{
+		bWaitingForTimeOut = true;
+		return;
+	}
+
+	RequestAction(Controller, Result.BestAction);
+
+	// Requests are confirmed immediately, so if we are not waiting the request was denied. This can happen
+	// as simulated spells don't know the actual targeting rules or final cost of the spell being cast
+	const bool bAccepted = !Controller->IsPerformingActionPhase() || GameMode->IsWaitingForAction() || GameMode->IsWaitingForSpellSelection();
+	if (!bAccepted)
+	{
+		UE_LOG(LogConquest, Log, TEXT("UCSKAIComponent: Player %i had action %i (cell %i) denied"),
+			Controller->CSKPlayerID + 1, static_cast<int32>(Result.BestAction.Type), Result.BestAction.Cell);
+
+		// Ending the phase is validated by the same rules we simulate, if it was still denied all we can do is wait
+		if (Result.BestAction.Type == ECSKRulesActionType::EndPhase)
+		{
+			bWaitingForTimeOut = true;
+		}
+		else
+		{
+			DeniedActions.Add(Result.BestAction);
+		}
+	}
+}
+
+void UCSKAIComponent::CancelSearch()
+{
+	if (PendingResult.IsValid())
+	{
+		PendingSearch->bCancelled = true;
+		PendingResult.Wait();
+
+		PendingResult = TFuture<FCSKSearchResult>();
+		PendingSearch.Reset();
+	}
+}
+
+void UCSKAIComponent::RequestAction(ACSKPlayerController* Controller, const FCSKRulesAction& Action) const
+{
+	const ABoardManager* BoardManager = UConquestFunctionLibrary::GetMatchBoardManager(this);
+	if (!BoardManager)
+	{
+		return;
+	}
+
+	ATile* Tile = Action.Cell != INDEX_NONE ? BoardManager->GetHexGrid().GetTileAtIndex(Action.Cell) : nullptr;
+
+	switch (Action.Type)
+	{
+		case ECSKRulesActionType::EndPhase:
+		{
+			Controller->Server_EndActionPhase();
+			break;
+		}
+		case ECSKRulesActionType::MoveCastle:
+		{
+			Controller->Server_RequestCastleMoveAction(Tile);
+			break;
+		}
+		case ECSKRulesActionType::BuildTower:
+		{
+			const ACSKGameState* CSKGameState = UConquestFunctionLibrary::GetCSKGameState(this);
+			if (CSKGameState && CSKGameState->GetAvailableTowers().IsValidIndex(Action.Index))
+			{
+				Controller->Server_RequestBuildTowerAction(CSKGameState->GetAvailableTowers()[Action.Index], Tile);
+			}
+
+			break;
+		}
+		case ECSKRulesActionType::CastSpell:
+		{
+			// Rules engine indexes spells by hand slot, which skips cards not available in this match
+			const ACSKGameMode* GameMode = UConquestFunctionLibrary::GetCSKGameMode(this);
+			TSubclassOf<USpellCard> SpellCard = GameMode ? GameMode->GetRulesEngineHandCard(Controller->GetCSKPlayerState(), Action.Index) : nullptr;
+			if (SpellCard)
+			{
+				const int32 SpellIndex = GetActionSpellIndex(SpellCard);
+				if (SpellIndex != INDEX_NONE)
+				{
+					Controller->Server_RequestCastSpellAction(SpellCard, SpellIndex, Tile, Action.AdditionalMana);
+				}
+			}
+
+			break;
+		}
+	}
+}
+
+bool UCSKAIComponent::HasActionPhaseChanged(ACSKGameMode* GameMode)
+{
+	const ACSKGameState* CSKGameState = UConquestFunctionLibrary::GetCSKGameState(this);
+	const int32 Round = CSKGameState ? CSKGameState->GetRound() : INDEX_NONE;
+	const ECSKRoundState RoundState = GameMode->GetRoundState();
+
+	if (Round != ActionPhaseRound || RoundState != ActionPhaseRoundState)
+	{
+		ActionPhaseRound = Round;
+		ActionPhaseRoundState = RoundState;
+		return true;
+	}
+
+	return false;
+}
+
+#if !UE_BUILD_SHIPPING
+
+/** Sets if a player should have their actions decided by the AI */
+static void SetPlayerUsesAI(const TArray<FString>& Args, UWorld* World)
+{
+	if (Args.Num() < 1)
+	{
+		UE_LOG(LogConquest, Display, TEXT("Usage: CSK.AI.SetPlayerUsesAI <Player (1 or 2)> [Enable (0 or 1)]"));
+		return;
+	}
+
+	ACSKGameMode* GameMode = World ? UConquestFunctionLibrary::GetCSKGameMode(World) : nullptr;
+	if (!GameMode)
+	{
+		UE_LOG(LogConquest, Warning, TEXT("CSK.AI.SetPlayerUsesAI: Can only be used by the server during a match"));
+		return;
+	}
+
+	const int32 PlayerID = FCString::Atoi(*Args[0]) - 1;
+	const bool bEnable = Args.Num() < 2 || FCString::Atoi(*Args[1]) != 0;
+
+	GameMode->SetPlayerUsesAI(PlayerID, bEnable);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SetPlayerUsesAICommand(
+	TEXT("CSK.AI.SetPlayerUsesAI"),
+	TEXT("Sets if a player has their actions decided by the AI. Usage: CSK.AI.SetPlayerUsesAI <Player (1 or 2)> [Enable (0 or 1)]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SetPlayerUsesAI));
+
+#endif
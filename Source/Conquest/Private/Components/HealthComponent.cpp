@@ -44,6 +44,15 @@ void UHealthComponent::InitHealth(int32 InHealth, int32 InMaxHealth)
 	}
 }
 
+void UHealthComponent::OverrideHealth(int32 InHealth, int32 InMaxHealth)
+{
+	if (GetOwnerRole() == ROLE_Authority)
+	{
+		MaxHealth = FMath::Max(1, InMaxHealth);
+		Health = FMath::Clamp(InHealth, 0, MaxHealth);
+	}
+}
+
 int32 UHealthComponent::ApplyDamage(int32 Amount)
 {
 	if (GetOwnerRole() == ROLE_Authority && !IsDead())
@@ -156,7 +156,7 @@ bool UConquestFunctionLibrary::CanActivateSpell(TSubclassOf<USpell> Spell, const
 		}
 
 		const USpell* DefaultSpell = Spell.GetDefaultObject();
-		if (DefaultSpell && DefaultSpell->CanActivateSpell(CastingPlayer, TargetTile))
+		if (DefaultSpell && DefaultSpell->CanActivateSpellOnTile(CastingPlayer, TargetTile))
 		{
 			return true;
 		}
@@ -1,11 +1,22 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "ConquestModule.h"
+#include "CSKMonteCarloSearch.h"
 
 class FConquestModule : public IConquestModule
 {
 public:
 
+	virtual void StartupModule() override
+	{
+		FCSKMonteCarloSearch::StartupThreadPool();
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FCSKMonteCarloSearch::ShutdownThreadPool();
+	}
+
 	virtual bool IsGameModule() const
 	{
 		return true;
@@ -4,16 +4,14 @@
 #include "Conquest.h"
 #include "Tile.h"
 
+#include "Algo/Reverse.h"
+
 DECLARE_CYCLE_STAT(TEXT("HexGrid FindPath"), STAT_HexGridFindPath, STATGROUP_Conquest);
+DECLARE_DWORD_COUNTER_STAT(TEXT("HexGrid FindPath Nodes Expanded"), STAT_HexGridFindPathNodesExpanded, STATGROUP_Conquest);
+DECLARE_CYCLE_STAT(TEXT("HexGrid GetReachableSet"), STAT_HexGridGetReachableSet, STATGROUP_Conquest);
 DECLARE_CYCLE_STAT(TEXT("HexGrid GetAllTilesWithinRange"), STAT_HexGridGetAllTilesWithinRange, STATGROUP_Conquest);
 DECLARE_CYCLE_STAT(TEXT("HexGrid GetAllOccupiedTilesWithinRange"), STAT_HexGridGetAllOccupiedTilesWithinRange, STATGROUP_Conquest);
 
-const FHexGrid::FHex FHexGrid::DirectionTable[] =
-{
-	FHex(+1, -1, 0), FHex(+1, 0, -1), FHex(0, +1, -1),
-	FHex(-1, +1, 0), FHex(-1, 0, +1), FHex(0, -1, +1)
-};
-
 void FHexGrid::GenerateGrid(int32 Rows, int32 Columns, const TFunction<ATile*(const FHex&, int32, int32)>& Predicate, bool bClearGrid)
 {
 	if (bClearGrid)
@@ -53,6 +51,8 @@ void FHexGrid::GenerateGrid(int32 Rows, int32 Columns, const TFunction<ATile*(co
 
 	GridDimensions = FIntPoint(Rows, Columns);
 	bGridGenerated = true;
+
+	RebuildDenseStorage();
 }
 
 void FHexGrid::ClearGrid()
@@ -74,6 +74,8 @@ void FHexGrid::ClearGrid()
 		}
 
 		GridMap.Empty();
+		GridTiles.Empty();
+		NeighborTable.Empty();
 		GridDimensions = FIntPoint::ZeroValue;
 		bGridGenerated = false;
 	}
@@ -97,9 +99,9 @@ void FHexGrid::RemoveCellsFrom(int32 Row, int32 Column)
 
 	// Cycle through every cell and simply remove the cells
 	// that lie beyond the specified limit
-	for (int32 c = 0; c < MaxRows; ++c)
+	for (int32 c = 0; c < MaxCols; ++c)
 	{	
-		for (int32 r = 0; r < MaxCols; ++r)
+		for (int32 r = 0; r < MaxRows; ++r)
 		{
 			// Cell is out of range
 			if (r >= Row || c >= Column)
@@ -117,6 +119,84 @@ void FHexGrid::RemoveCellsFrom(int32 Row, int32 Column)
 	}
 
 	GridMap.Shrink();
+
+	GridDimensions = FIntPoint(FMath::Min(Row, GridDimensions.X), FMath::Min(Column, GridDimensions.Y));
+	RebuildDenseStorage();
+}
+
+void FHexGrid::RebuildDenseStorage()
+{
+	GridTiles.Reset();
+	NeighborTable.Reset();
+
+	if (!bGridGenerated)
+	{
+		return;
+	}
+
+	const int32 NumCells = GridDimensions.X * GridDimensions.Y;
+	GridTiles.SetNumZeroed(NumCells);
+	NeighborTable.SetNumUninitialized(NumCells * 6);
+
+	int32 NumMapped = 0;
+	for (const TPair<FHex, ATile*>& Cell : GridMap)
+	{
+		int32 Index = HexToIndex(Cell.Key);
+		if (Index != INDEX_NONE)
+		{
+			GridTiles[Index] = Cell.Value;
+			++NumMapped;
+		}
+	}
+
+	if (NumMapped != GridMap.Num() || NumMapped != NumCells)
+	{
+		UE_LOG(LogConquest, Warning, TEXT("FHexGrid::RebuildDenseStorage: Grid map has %i cells but dimensions (%i x %i) expect %i"),
+			GridMap.Num(), GridDimensions.X, GridDimensions.Y, NumCells);
+	}
+
+	// Neighbors are resolved once here so traversal never has to repeat bounds checks
+	for (int32 Index = 0; Index < NumCells; ++Index)
+	{
+		const FHex Hex = IndexToHex(Index);
+		for (int32 i = 0; i < 6; ++i)
+		{
+			NeighborTable[Index * 6 + i] = HexToIndex(HexCore::HexNeighbor(Hex, i));
+		}
+	}
+}
+
+const TArray<FHexGrid::FHex>& FHexGrid::GetSpiralStencil()
+{
+	struct FSpiralStencil
+	{
+		FSpiralStencil()
+		{
+			Offsets.Reserve(HexCore::NumHexesInRange(MaxStencilRadius));
+			HexCore::ForEachHexInSpiral(FHex(0), MaxStencilRadius, [this](const FHex& Hex)
+			{
+				Offsets.Add(Hex);
+				return true;
+			});
+
+			check(Offsets.Num() == HexCore::NumHexesInRange(MaxStencilRadius));
+		}
+
+		TArray<FHex> Offsets;
+	};
+
+	// Static local, so initialization is thread safe
+	static const FSpiralStencil Stencil;
+	return Stencil.Offsets;
+}
+
+void FHexGrid::PostSerialize(const FArchive& Ar)
+{
+	// Dense storage is never saved, boards saved with only the grid map will rebuild it here
+	if (Ar.IsLoading())
+	{
+		RebuildDenseStorage();
+	}
 }
 
 bool FHexGrid::GeneratePath(const FHex& Start, const FHex& Goal, FHexGridPathFindResultData& OutResultData, bool bAllowPartial, int32 MaxDistance) const
@@ -136,7 +216,7 @@ bool FHexGrid::GeneratePath(const FHex& Start, const FHex& Goal, FHexGridPathFin
 	}
 
 	// Invalid hex (goal can still be treated as valid if allowing partial path)
-	if (!GridMap.Contains(Start) || (!bAllowPartial && !GridMap.Contains(Goal)))
+	if (!ContainsHex(Start) || (!bAllowPartial && !ContainsHex(Goal)))
 	{
 		OutResultData.Set(EHexGridPathFindResult::InvalidTargets);
 		return false;
@@ -180,9 +260,312 @@ bool FHexGrid::GeneratePath(const ATile* Start, const ATile* Goal, FHexGridPathF
 	return GeneratePath(Start->GetGridHexValue(), Goal->GetGridHexValue(), OutResultData, bAllowPartial, MaxDistance);
 }
 
-// TODO: Needs to be fixed (as in partial path returning the tile that was closest to the goal, it doesn't right now)
 bool FHexGrid::FindPath(const FHex& Start, const FHex& Goal, FHexGridPathFindResultData& OutResultData, bool bAllowPartial, int32 MaxDistance) const
 {
+	SCOPE_CYCLE_COUNTER(STAT_HexGridFindPath);
+
+	const int32 StartIndex = HexToIndex(Start);
+	const int32 GoalIndex = HexToIndex(Goal);
+	check(StartIndex != INDEX_NONE && GoalIndex != INDEX_NONE);
+
+	// We can never enter the goal if it's occupied, only a partial path could be found
+	const ATile* GoalTile = GridTiles[GoalIndex];
+	const bool bGoalReachable = GoalTile && !GoalTile->IsTileOccupied();
+	if (!bGoalReachable && !bAllowPartial)
+	{
+		OutResultData.Set(EHexGridPathFindResult::Failure);
+		return false;
+	}
+
+	TArray<int32> Parents;
+	Parents.SetNumUninitialized(GridTiles.Num());
+
+	TArray<int32> Costs;
+	Costs.SetNumUninitialized(GridTiles.Num());
+
+	auto Neighbor = [this](int32 Index, int32 Direction) { return GetNeighborIndex(Index, Direction); };
+	auto Heuristic = [this, &Goal](int32 Index) { return HexDisplacement(IndexToHex(Index), Goal); };
+
+	// Occupied tiles (which includes null tiles) can't be travelled through
+	auto Passable = [this](int32 Index)
+	{
+		const ATile* Tile = GridTiles[Index];
+		return Tile && !Tile->IsTileOccupied();
+	};
+
+	HexCore::FSearchStats SearchStats;
+	bool bGoalFound = HexCore::AStarSearch(GridTiles.Num(), StartIndex, GoalIndex, MaxDistance, 
+		Parents.GetData(), Costs.GetData(), Neighbor, Passable, Heuristic, SearchStats);
+
+	INC_DWORD_STAT_BY(STAT_HexGridFindPathNodesExpanded, SearchStats.NumExpanded);
+
+	// Did we exit by reaching the goal?
+	if (bGoalFound)
+	{
+		TArray<ATile*> Tiles;
+		ConvertParentsToPath(GoalIndex, Parents, Tiles);
+
+		OutResultData.Set(EHexGridPathFindResult::Success, MoveTemp(Tiles));
+	}
+	// We exited without reaching the goal but we can still use a path to the closest tile we found
+	else if (bAllowPartial)
+	{
+		TArray<ATile*> Tiles;
+		ConvertParentsToPath(SearchStats.ClosestIndex, Parents, Tiles);
+
+		OutResultData.Set(EHexGridPathFindResult::Partial, MoveTemp(Tiles));
+
+		// We still managed to find something
+		bGoalFound = true;
+	}
+	else
+	{
+		OutResultData.Set(EHexGridPathFindResult::Failure);
+	}
+
+	OutResultData.NumExpanded = SearchStats.NumExpanded;
+
+	return bGoalFound;
+}
+
+void FHexGrid::ConvertParentsToPath(int32 GoalIndex, const TArray<int32>& Parents, TArray<ATile*>& OutPath) const
+{
+	OutPath.Reset();
+
+	// Walk back from the goal to the start (which has no parent)
+	for (int32 Index = GoalIndex; Index != INDEX_NONE; Index = Parents[Index])
+	{
+		OutPath.Add(GridTiles[Index]);
+	}
+
+	// Path should be from start to finish
+	Algo::Reverse(OutPath);
+}
+
+bool FHexGrid::GetReachableSet(const FHex& Origin, int32 MaxDistance, FHexGridReachableSet& OutReachableSet) const
+{
+	OutReachableSet.Reset();
+
+	const int32 OriginIndex = bGridGenerated ? HexToIndex(Origin) : INDEX_NONE;
+	if (OriginIndex == INDEX_NONE || MaxDistance <= 0)
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_HexGridGetReachableSet);
+
+	OutReachableSet.OriginIndex = OriginIndex;
+	OutReachableSet.MaxDistance = MaxDistance;
+	OutReachableSet.Distances.SetNumUninitialized(GridTiles.Num());
+	OutReachableSet.Parents.SetNumUninitialized(GridTiles.Num());
+
+	TArray<int32>& Cells = OutReachableSet.Cells;
+	Cells.SetNumUninitialized(GridTiles.Num());
+
+	auto Neighbor = [this](int32 Index, int32 Direction) { return GetNeighborIndex(Index, Direction); };
+
+	// Occupied tiles (which includes null tiles) can't be travelled through
+	auto Passable = [this](int32 Index)
+	{
+		const ATile* Tile = GridTiles[Index];
+		return Tile && !Tile->IsTileOccupied();
+	};
+
+	// Cells are written in order of distance, with the origin first (which we remove)
+	int32 NumReached = HexCore::BreadthFirstSearch(GridTiles.Num(), OriginIndex, MaxDistance, 
+		OutReachableSet.Distances.GetData(), OutReachableSet.Parents.GetData(), Cells.GetData(), Neighbor, Passable);
+
+	Cells.SetNum(NumReached, false);
+	Cells.RemoveAt(0, 1, false);
+	return Cells.Num() > 0;
+}
+
+bool FHexGrid::GetPathFromReachableSet(const FHexGridReachableSet& ReachableSet, const FHex& Goal, TArray<ATile*>& OutPath) const
+{
+	OutPath.Reset();
+
+	const int32 GoalIndex = bGridGenerated ? HexToIndex(Goal) : INDEX_NONE;
+	if (GoalIndex == INDEX_NONE || !ReachableSet.IsReachable(GoalIndex))
+	{
+		return false;
+	}
+
+	// Reachable set might have been generated using a different grid
+	if (!ensure(ReachableSet.Parents.Num() == GridTiles.Num()))
+	{
+		return false;
+	}
+
+	ConvertParentsToPath(GoalIndex, ReachableSet.Parents, OutPath);
+	return true;
+}
+
+bool FHexGrid::GetAllTilesWithinRange(const FHex& Origin, int32 Distance, TArray<ATile*>& OutTiles, bool bIgnoreOccupiedTiles) const
+{
+	OutTiles.Reset();
+
+	// Invalid distance
+	if (Distance <= 0)
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_HexGridGetAllTilesWithinRange);
+
+	ForEachInRange(Origin, Distance, [&OutTiles, bIgnoreOccupiedTiles](ATile* Tile, int32 Index)
+	{
+		if (!bIgnoreOccupiedTiles || !Tile->IsTileOccupied())
+		{
+			OutTiles.Add(Tile);
+		}
+
+		return true;
+	});
+
+	return OutTiles.Num() > 0;
+}
+
+bool FHexGrid::GetAllOccupiedTilesWithinRange(const FHex& Origin, int32 Distance, TArray<ATile*>& OutTiles, bool bIgnoreNullTiles, bool bIgnoreOrigin) const
+{
+	OutTiles.Reset();
+
+	// Invalid distance
+	if (Distance <= 0)
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_HexGridGetAllOccupiedTilesWithinRange);
+
+	// Origin is always first in the spiral, so we can skip it by starting from the first ring
+	for (int32 Ring = bIgnoreOrigin ? 1 : 0; Ring <= Distance; ++Ring)
+	{
+		ForEachInRing(Origin, Ring, [&OutTiles, bIgnoreNullTiles](ATile* Tile, int32 Index)
+		{
+			if (Tile->IsTileOccupied(!bIgnoreNullTiles))
+			{
+				OutTiles.Add(Tile);
+			}
+
+			return true;
+		});
+	}
+
+	return OutTiles.Num() > 0;
+}
+
+#if !UE_BUILD_SHIPPING
+
+/** Compares dense storage and visitors against hashing into the grid map. Tiles are
+all the tile CDO, so this can be run without needing a board in the world */
+static void RunHexGridStorageBenchmark()
+{
+	using FHex = FHexGrid::FHex;
+
+	const int32 GridSizes[] = { 16, 64, 256 };
+	const int32 NumLookupPasses = 32;
+	const int32 RangeDistance = 4;
+
+	ATile* TemplateTile = GetMutableDefault<ATile>();
+
+	for (int32 Size : GridSizes)
+	{
+		FHexGrid Grid;
+		Grid.GenerateGrid(Size, Size, [TemplateTile](const FHex&, int32, int32)->ATile* { return TemplateTile; });
+
+		TArray<FHex> Hexes;
+		Grid.GridMap.GenerateKeyArray(Hexes);
+
+		int32 NumFound = 0;
+
+		// Single tile lookups
+		double MapLookupTime = FPlatformTime::Seconds();
+		for (int32 Pass = 0; Pass < NumLookupPasses; ++Pass)
+		{
+			for (const FHex& Hex : Hexes)
+			{
+				NumFound += Grid.GridMap.Find(Hex) != nullptr ? 1 : 0;
+			}
+		}
+		MapLookupTime = FPlatformTime::Seconds() - MapLookupTime;
+
+		double DenseLookupTime = FPlatformTime::Seconds();
+		for (int32 Pass = 0; Pass < NumLookupPasses; ++Pass)
+		{
+			for (const FHex& Hex : Hexes)
+			{
+				NumFound += Grid.GetTile(Hex) != nullptr ? 1 : 0;
+			}
+		}
+		DenseLookupTime = FPlatformTime::Seconds() - DenseLookupTime;
+
+		// Range queries from every cell, the map version mirrors what GetAllTilesWithinRange used to do
+		TArray<ATile*> Tiles;
+
+		double MapRangeTime = FPlatformTime::Seconds();
+		for (const FHex& Hex : Hexes)
+		{
+			Tiles.Empty();
+			for (int32 x = -RangeDistance; x <= RangeDistance; ++x)
+			{
+				for (int32 y = FMath::Max(-RangeDistance, -x - RangeDistance); y <= FMath::Min(RangeDistance, -x + RangeDistance); ++y)
+				{
+					ATile* const* TilePtr = Grid.GridMap.Find(Hex + FHexGrid::ConvertIndicesToHex(x, y));
+					if (TilePtr && !(*TilePtr)->IsTileOccupied())
+					{
+						Tiles.Add(*TilePtr);
+					}
+				}
+			}
+
+			NumFound += Tiles.Num();
+		}
+		MapRangeTime = FPlatformTime::Seconds() - MapRangeTime;
+
+		double DenseRangeTime = FPlatformTime::Seconds();
+		for (const FHex& Hex : Hexes)
+		{
+			Grid.GetAllTilesWithinRange(Hex, RangeDistance, Tiles);
+			NumFound += Tiles.Num();
+		}
+		DenseRangeTime = FPlatformTime::Seconds() - DenseRangeTime;
+
+		// Same query as above, but visiting tiles in place instead of filling an array
+		double VisitorRangeTime = FPlatformTime::Seconds();
+		for (const FHex& Hex : Hexes)
+		{
+			Grid.ForEachInRange(Hex, RangeDistance, [&NumFound](ATile* Tile, int32 Index)
+			{
+				NumFound += Tile->IsTileOccupied() ? 0 : 1;
+				return true;
+			});
+		}
+		VisitorRangeTime = FPlatformTime::Seconds() - VisitorRangeTime;
+
+		const double NumLookups = static_cast<double>(Hexes.Num() * NumLookupPasses);
+		const double NumRanges = static_cast<double>(Hexes.Num());
+
+		UE_LOG(LogConquest, Display, TEXT("HexGrid %ix%i: Lookups (map %.2f ns, dense %.2f ns) Range %i queries (map %.2f us, dense %.2f us, visitor %.2f us) [%i]"),
+			Size, Size,
+			MapLookupTime * 1e9 / NumLookups, DenseLookupTime * 1e9 / NumLookups,
+			RangeDistance, MapRangeTime * 1e6 / NumRanges, DenseRangeTime * 1e6 / NumRanges, VisitorRangeTime * 1e6 / NumRanges,
+			NumFound);
+	}
+}
+
+static FAutoConsoleCommand HexGridStorageBenchmarkCommand(
+	TEXT("CSK.HexGrid.BenchmarkStorage"),
+	TEXT("Compares dense hex grid lookups and range queries against the grid map on 16x16, 64x64 and 256x256 grids"),
+	FConsoleCommandDelegate::CreateStatic(&RunHexGridStorageBenchmark));
+
+/** The greedy search FindPath used before it was replaced with A*. Only the best neighbor of each
+tile is ever queued, making this a walk towards the goal. The original ranked neighbors by world
+distance squared, benchmark tiles have no location so hex displacement squared is used instead.
+Get the amount of tiles in the path found (or zero if the goal wasn't reached) */
+static int32 FindLegacyGreedyPath(const FHexGrid& Grid, const FHexGrid::FHex& Start, const FHexGrid::FHex& Goal, int32 MaxDistance, int32& OutNumExpanded)
+{
+	using FHex = FHexGrid::FHex;
+
 	struct FPathSegment
 	{
 		FPathSegment()
@@ -201,17 +584,11 @@ bool FHexGrid::FindPath(const FHex& Start, const FHex& Goal, FHexGridPathFindRes
 
 		}
 
-		// Hex for this current segment
 		FHex Hex;
-
-		// Cost for reaching this segment
 		float Cost;
-
-		// Amount of tiles since origin
 		int32 Distance;
 	};
 
-	// Predicate for sorting queue
 	struct FPathPredicate
 	{
 		bool operator() (const FPathSegment& lhs, const FPathSegment& rhs) const
@@ -220,235 +597,185 @@ bool FHexGrid::FindPath(const FHex& Start, const FHex& Goal, FHexGridPathFindRes
 		}
 	};
 
-	SCOPE_CYCLE_COUNTER(STAT_HexGridFindPath);
-	
-	const ATile* GoalTile = GetTile(Goal);
-	check(GoalTile);
-
-	bool bGoalFound = false;
-	FHex LastHex = FHex(-1);
-
-	// Hex indices we have already visited
 	TSet<FHex> Visited;
 
-	// Edges between the path being constructed
 	TMap<FHex, FHex> PathEdges;
 	PathEdges.Add(Start, Start);
 
-	// Queue with cheapest hex tiles placed in the front
 	TArray<FPathSegment> Queue;
 	Queue.HeapPush(FPathSegment(Start, 0.f, 0), FPathPredicate());
 
-	while (true)
-	{
-		// Are we unable to continue?
-		if (Queue.Num() == 0)
-		{
-			break;
-		}
+	OutNumExpanded = 0;
 
-		// Remove this hex from the queue
+	while (Queue.Num() > 0)
+	{
 		FPathSegment Segment;
 		Queue.HeapPop(Segment, FPathPredicate());
-		LastHex = Segment.Hex;
-		
-		// Have we reached our target?
+
+		++OutNumExpanded;
+
 		if (Segment.Hex == Goal)
 		{
-			bGoalFound = true;
-			break;
+			// Count the tiles along the edges we generated
+			int32 NumTiles = 1;
+			for (FHex Current = Start; Current != Goal; Current = PathEdges[Current])
+			{
+				++NumTiles;
+			}
+
+			return NumTiles;
 		}
 
-		// Marked as visit, so we don't return here
 		Visited.Add(Segment.Hex);
-	
-		int32 BestNeighborIndex = -1;
+
 		FHex BestNeighborHex = FHex(-1);
 		float BestNeighborCost = FLT_MAX;
 
-		// If goal was found but is null, we should forcefully exit
-		bool bForceExit = false;
-		
-		// Cycle through all this segments neighbors to determine which path to prioritize
-		TArray<FHex> Neighbors = GetNeighbors(Segment.Hex);
-		for (int32 i = 0; i < Neighbors.Num(); ++i)
+		for (const FHex& Neighbor : Grid.GetNeighbors(Segment.Hex))
 		{
-			const FHex& Neighbor = Neighbors[i];
-			const ATile* NeighborTile = GetTile(Neighbor);
-
-			// Ignore visited tiles as they probaly are in the queue
-			if (!Visited.Contains(Neighbor))
+			if (Visited.Contains(Neighbor) || Grid.GetTile(Neighbor)->IsTileOccupied())
 			{
-				// Don't bother processing this tile since it's occupied
-				if (NeighborTile->IsTileOccupied())
-				{
-					// If finding partial paths, there is a chance of the goal tile being null
-					if (NeighborTile == GoalTile)
-					{
-						// Stop the search, we know we can't reach the goal
-						bForceExit = true;
-						break;
-					}
-					else
-					{
-						// There is still a chance of reaching the goal
-						continue;
-					}
-				}
-
-				float NewCost = Segment.Cost + PathHeuristic(NeighborTile, GoalTile);
-				if (NewCost < BestNeighborCost)
-				{
-					BestNeighborIndex = i;
-					BestNeighborHex = Neighbor;
-					BestNeighborCost = NewCost;
-				}
+				continue;
 			}
-		}
 
-		if (bForceExit)
-		{
-			break;
+			const float NewCost = Segment.Cost + FMath::Square(static_cast<float>(FHexGrid::HexDisplacement(Neighbor, Goal)));
+			if (NewCost < BestNeighborCost)
+			{
+				BestNeighborHex = Neighbor;
+				BestNeighborCost = NewCost;
+			}
 		}
 
-		// Can we still continue down this path?
-		if (BestNeighborIndex != -1)
+		if (BestNeighborCost != FLT_MAX && Segment.Distance + 1 <= MaxDistance)
 		{
-			int32 NewDistance = Segment.Distance + 1;
-			if (NewDistance <= MaxDistance)
-			{
-				// Establish new path edge (increment distance)
-				Queue.HeapPush(FPathSegment(BestNeighborHex, BestNeighborCost, Segment.Distance + 1), FPathPredicate());
-				PathEdges[Segment.Hex] = BestNeighborHex;
-
-				PathEdges.Add(BestNeighborHex, BestNeighborHex);
-			}
+			Queue.HeapPush(FPathSegment(BestNeighborHex, BestNeighborCost, Segment.Distance + 1), FPathPredicate());
+			PathEdges[Segment.Hex] = BestNeighborHex;
+			PathEdges.Add(BestNeighborHex, BestNeighborHex);
 		}
 	}
 
-	// Did we exit by reaching the goal?
-	if (bGoalFound)
-	{
-		TArray<ATile*> Tiles;
-		ConvertEdgesToPath(Start, Goal, PathEdges, Tiles);
+	return 0;
+}
 
-		OutResultData.Set(EHexGridPathFindResult::Success, Tiles);
-	}
-	// We exited without reaching the goal but we can still use a partial path
-	else if (bAllowPartial)
-	{
-		TArray<ATile*> Tiles;
-		ConvertEdgesToPath(Start, LastHex, PathEdges, Tiles);
+/** Compares the old greedy search against A* on boards where a third of the tiles are null. Like the
+storage benchmark, tiles are the tile CDO (with a transient null tile for obstacles) so no board is needed */
+static void RunHexGridPathBenchmark()
+{
+	using FHex = FHexGrid::FHex;
 
-		OutResultData.Set(EHexGridPathFindResult::Partial, Tiles);
+	const int32 GridSizes[] = { 16, 64, 256 };
+	const int32 NumQueries = 256;
+	const float ObstacleChance = 0.35f;
 
-		// We still managed to find something
-		bGoalFound = true;
-	}
-	else
-	{
-		OutResultData.Set(EHexGridPathFindResult::Failure);
-	}
+	ATile* FreeTile = GetMutableDefault<ATile>();
 
-	return bGoalFound;
-}
+	ATile* NullTile = NewObject<ATile>(GetTransientPackage(), NAME_None, RF_Transient);
+	NullTile->bIsNullTile = true;
 
-void FHexGrid::ConvertEdgesToPath(const FHex& Start, const FHex& Goal, const TMap<FHex, FHex>& Edges, TArray<ATile*>& OutPath) const
-{
-	OutPath.Empty();
+	FRandomStream RandomStream(1337);
 
-	// Cycle through the path edges that were generated
-	// to get the path of tiles in the correct order
-	FHex Current = Start;
-	while (Current != Goal)
+	for (int32 Size : GridSizes)
 	{
-		OutPath.Add(GetTile(Current));
+		FHexGrid Grid;
+		Grid.GenerateGrid(Size, Size, [&](const FHex&, int32, int32)->ATile*
+		{
+			return RandomStream.FRand() < ObstacleChance ? NullTile : FreeTile;
+		});
 
-		// Move onto next segment
-		Current = Edges[Current];
-	}
+		TArray<FHex> FreeHexes;
+		for (const TPair<FHex, ATile*>& Cell : Grid.GridMap)
+		{
+			if (Cell.Value == FreeTile)
+			{
+				FreeHexes.Add(Cell.Key);
+			}
+		}
 
-	// Add goal tile as well
-	OutPath.Add(GetTile(Goal));
-}
+		if (FreeHexes.Num() < 2)
+		{
+			continue;
+		}
 
-float FHexGrid::PathHeuristic(const ATile* T1, const ATile* T2)
-{
-	if (T1 && T2)
-	{
-		return T1->GetSquaredDistanceTo(T2);
-	}
+		TArray<TPair<FHex, FHex>> Queries;
+		for (int32 i = 0; i < NumQueries; ++i)
+		{
+			const int32 StartIndex = RandomStream.RandHelper(FreeHexes.Num());
+			const int32 GoalIndex = (StartIndex + 1 + RandomStream.RandHelper(FreeHexes.Num() - 1)) % FreeHexes.Num();
 
-	return MAX_FLT;
-}
+			Queries.Emplace(FreeHexes[StartIndex], FreeHexes[GoalIndex]);
+		}
 
-bool FHexGrid::GetAllTilesWithinRange(const FHex& Origin, int32 Distance, TArray<ATile*>& OutTiles, bool bIgnoreOccupiedTiles) const
-{
-	OutTiles.Empty();
+		TArray<int32> GreedyLengths;
+		GreedyLengths.SetNumZeroed(NumQueries);
 
-	// Invalid distance
-	if (Distance <= 0)
-	{
-		return false;
-	}
-
-	SCOPE_CYCLE_COUNTER(STAT_HexGridGetAllTilesWithinRange);
+		int64 GreedyTotalExpanded = 0;
 
-	// Thanks to: https://www.redblobgames.com/grids/hexagons/#range for the fast for loop version
-	for (int32 x = -Distance; x <= Distance; ++x)
-	{
-		for (int32 y = FMath::Max(-Distance, -x - Distance); y <= FMath::Min(Distance, -x + Distance); ++y)
+		double GreedyTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumQueries; ++i)
 		{
-			ATile* const* TilePtr = GridMap.Find(Origin + ConvertIndicesToHex(x, y));
-			if (TilePtr)
-			{
-				ATile* Tile = *TilePtr;
-
-				if (!bIgnoreOccupiedTiles || !Tile->IsTileOccupied())
-				{
-					OutTiles.Add(*TilePtr);
-				}
-			}
+			int32 NumExpanded = 0;
+			GreedyLengths[i] = FindLegacyGreedyPath(Grid, Queries[i].Key, Queries[i].Value, INT_MAX, NumExpanded);
+			GreedyTotalExpanded += NumExpanded;
 		}
-	}
+		GreedyTime = FPlatformTime::Seconds() - GreedyTime;
 
-	return OutTiles.Num() > 0;
-}
+		TArray<int32> AStarLengths;
+		AStarLengths.SetNumZeroed(NumQueries);
 
-bool FHexGrid::GetAllOccupiedTilesWithinRange(const FHex& Origin, int32 Distance, TArray<ATile*>& OutTiles, bool bIgnoreNullTiles, bool bIgnoreOrigin) const
-{
-	OutTiles.Empty();
+		int64 AStarTotalExpanded = 0;
 
-	// Invalid distance
-	if (Distance <= 0)
-	{
-		return false;
-	}
-
-	SCOPE_CYCLE_COUNTER(STAT_HexGridGetAllOccupiedTilesWithinRange);
+		FHexGridPathFindResultData ResultData;
 
-	// Thanks to: https://www.redblobgames.com/grids/hexagons/#range for the fast for loop version
-	for (int32 x = -Distance; x <= Distance; ++x)
-	{
-		for (int32 y = FMath::Max(-Distance, -x - Distance); y <= FMath::Min(Distance, -x + Distance); ++y)
+		double AStarTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumQueries; ++i)
 		{
-			ATile* const* TilePtr = GridMap.Find(Origin + ConvertIndicesToHex(x, y));
-			if (TilePtr)
+			if (Grid.GeneratePath(Queries[i].Key, Queries[i].Value, ResultData))
 			{
-				ATile* Tile = *TilePtr;
+				AStarLengths[i] = ResultData.Path.Num();
+			}
 
-				if (bIgnoreOrigin && Tile->GetGridHexValue() == Origin)
-				{
-					continue;
-				}
+			AStarTotalExpanded += ResultData.NumExpanded;
+		}
+		AStarTime = FPlatformTime::Seconds() - AStarTime;
 
-				if (Tile->IsTileOccupied(!bIgnoreNullTiles))
-				{
-					OutTiles.Add(*TilePtr);
-				}
+		// Only paths both searches found can be compared
+		int32 NumGreedyFound = 0;
+		int32 NumAStarFound = 0;
+		int32 NumCompared = 0;
+		int32 NumGreedyLonger = 0;
+		int64 GreedyTotalLength = 0;
+		int64 AStarTotalLength = 0;
+
+		for (int32 i = 0; i < NumQueries; ++i)
+		{
+			NumGreedyFound += GreedyLengths[i] > 0 ? 1 : 0;
+			NumAStarFound += AStarLengths[i] > 0 ? 1 : 0;
+
+			if (GreedyLengths[i] > 0 && AStarLengths[i] > 0)
+			{
+				++NumCompared;
+				NumGreedyLonger += GreedyLengths[i] > AStarLengths[i] ? 1 : 0;
+				GreedyTotalLength += GreedyLengths[i];
+				AStarTotalLength += AStarLengths[i];
 			}
 		}
+
+		const double Compared = static_cast<double>(FMath::Max(1, NumCompared));
+
+		UE_LOG(LogConquest, Display, TEXT("HexGrid %ix%i FindPath (%i queries): Greedy %.2f us expanded %.1f found %i, A* %.2f us expanded %.1f found %i. ")
+			TEXT("Over %i common paths average length greedy %.2f, A* %.2f (%i greedy paths longer)"),
+			Size, Size, NumQueries,
+			GreedyTime * 1e6 / NumQueries, GreedyTotalExpanded / static_cast<double>(NumQueries), NumGreedyFound,
+			AStarTime * 1e6 / NumQueries, AStarTotalExpanded / static_cast<double>(NumQueries), NumAStarFound,
+			NumCompared, GreedyTotalLength / Compared, AStarTotalLength / Compared, NumGreedyLonger);
 	}
 
-	return OutTiles.Num() > 0;
+	NullTile->MarkPendingKill();
 }
+
+static FAutoConsoleCommand HexGridPathBenchmarkCommand(
+	TEXT("CSK.HexGrid.BenchmarkPath"),
+	TEXT("Compares the old greedy FindPath against A* on obstacle heavy 16x16, 64x64 and 256x256 grids"),
+	FConsoleCommandDelegate::CreateStatic(&RunHexGridPathBenchmark));
+
+#endif
@@ -4,13 +4,16 @@
 #include "CSKGameInstance.h"
 #include "CSKGameState.h"
 #include "CSKHUD.h"
+#include "CSKMatchSnapshot.h"
 #include "CSKPawn.h"
 #include "CSKPlayerController.h"
 #include "CSKPlayerStart.h"
 #include "CSKPlayerState.h"
+#include "CSKRulesEngine.h"
 
 #include "BoardManager.h"
 #include "BoardPathFollowingComponent.h"
+#include "CSKAIComponent.h"
 #include "Castle.h"
 #include "CastleAIController.h"
 #include "CoinSequenceActor.h"
@@ -27,6 +30,9 @@
 #include "Engine/Engine.h"
 #include "Engine/World.h"
 
+DECLARE_CYCLE_STAT(TEXT("ACSKGameMode CaptureMatchSnapshot"), STAT_CSKGameModeCaptureMatchSnapshot, STATGROUP_Conquest);
+DECLARE_CYCLE_STAT(TEXT("ACSKGameMode ApplyMatchSnapshot"), STAT_CSKGameModeApplyMatchSnapshot, STATGROUP_Conquest);
+
 #define LOCTEXT_NAMESPACE "CSKGameMode"
 
 ACSKGameMode::ACSKGameMode()
@@ -55,6 +61,10 @@ ACSKGameMode::ACSKGameMode()
 	bWinnerSequenceActorSpawned = false;
 	bWinnerSequenceOrActionFinished = false;
 
+	bPlayer1UsesAI = false;
+	bPlayer2UsesAI = false;
+	bSaveReplayLogs = true;
+
 	StartingGold = 5;
 	StartingMana = 3;
 	CollectionPhaseGold = 3;
@@ -125,6 +135,9 @@ void ACSKGameMode::StartPlay()
 		EnterMatchState(ECSKMatchState::WaitingPreMatch);
 	}
 
+	// The AI plays for anyone who hasn't joined yet
+	SpawnAIPlayers();
+
 	// We might be able to start immediately
 	if (ShouldStartMatch())
 	{
@@ -140,6 +153,13 @@ void ACSKGameMode::StartPlay()
 void ACSKGameMode::Logout(AController* Exiting)
 {
 	ACSKPlayerController* Controller = Cast<ACSKPlayerController>(Exiting);
+
+	// AI players never logged in, they only leave once we are leaving the match
+	if (Controller && Controller->IsAIPlayer())
+	{
+		return;
+	}
+
 	if (Controller && Players.IsValidIndex(Controller->CSKPlayerID))
 	{
 		// We add one since PlayerID is an index
@@ -154,21 +174,33 @@ void ACSKGameMode::HandleStartingNewPlayer_Implementation(APlayerController* New
 {
 	// We need to set which player this is before continuing the login
 	{
-		if (GetPlayer1Controller() != nullptr)
+		// Prefer players the AI isn't going to play as, as they will be filled by AI players
+		int32 PlayerID = INDEX_NONE;
+		for (int32 i = 0; i < CSK_MAX_NUM_PLAYERS && PlayerID == INDEX_NONE; ++i)
 		{
-			// We should only ever have two players
-			if (!ensure(!GetPlayer2Controller()))
+			if (!Players[i] && !IsPlayerUsingAI(i))
 			{
-				UE_LOG(LogConquest, Error, TEXT("More than 2 people of joined a CSK match even though only 2 max are allowed"));
+				PlayerID = i;
 			}
-			else
+		}
+
+		// Otherwise this player will have their actions decided by the AI
+		for (int32 i = 0; i < CSK_MAX_NUM_PLAYERS && PlayerID == INDEX_NONE; ++i)
+		{
+			if (!Players[i])
 			{
-				SetPlayerWithID(CastChecked<ACSKPlayerController>(NewPlayer), 1);
+				PlayerID = i;
 			}
 		}
+
+		// We should only ever have two players
+		if (!ensure(PlayerID != INDEX_NONE))
+		{
+			UE_LOG(LogConquest, Error, TEXT("More than 2 people of joined a CSK match even though only 2 max are allowed"));
+		}
 		else
 		{
-			SetPlayerWithID(CastChecked<ACSKPlayerController>(NewPlayer), 0);
+			SetPlayerWithID(CastChecked<ACSKPlayerController>(NewPlayer), PlayerID);
 		}
 	}
 
@@ -402,6 +434,11 @@ void ACSKGameMode::SetPlayerWithID(ACSKPlayerController* Controller, int32 Playe
 				PlayerState->SetAssignedColor(PlayerID == 0 ? P1AssignedColor : P2AssignedColor);
 				#endif
 			}
+
+			if (IsPlayerUsingAI(PlayerID))
+			{
+				SetPlayerUsesAI(PlayerID, true);
+			}
 		}
 	}
 }
@@ -730,7 +767,15 @@ void ACSKGameMode::OnCoinFlipStart()
 		{
 			if (Controller)
 			{
-				Controller->Client_TransitionToCoinSequence(CoinSequenceActor);
+				// AI players have no client to transition
+				if (Controller->IsAIPlayer())
+				{
+					OnPlayerTransitionSequenceFinished();
+				}
+				else
+				{
+					Controller->Client_TransitionToCoinSequence(CoinSequenceActor);
+				}
 			}
 		}
 	}
@@ -756,6 +801,12 @@ void ACSKGameMode::OnMatchStart()
 	// Give players the default resources
 	ResetResourcesForPlayers();
 
+	// Requests are validated by the rules engine from now on
+	InitRulesEngine();
+
+	// Record from now, as the deck reshuffle seed and starting player are known
+	BeginReplayLog();
+
 	AWorldSettings* WorldSettings = GetWorldSettings();
 	WorldSettings->NotifyMatchStarted();
 
@@ -787,6 +838,11 @@ void ACSKGameMode::OnMatchFinished()
 	FTimerManager& TimerManager = GetWorldTimerManager();
 	TimerManager.ClearAllTimersForObject(this);
 
+	if (bSaveReplayLogs && ReplayLog.IsRecording())
+	{
+		SaveReplayLog();
+	}
+
 	// Delay exiting so players can read post match states
 	EnterMatchStateAfterDelay(ECSKMatchState::LeavingGame, FMath::Max(1.f, PostMatchDelay));
 }
@@ -808,6 +864,9 @@ void ACSKGameMode::OnFinishedWaitingPostMatch()
 	}
 	#endif
 
+	// AI players only exist for this match
+	DestroyAIPlayers();
+
 	FString LevelName("L_Lobby");
 	TArray<FString> Options{ "listen", "gamemode='Blueprint'/Game/Game/Blueprints/BP_LobbyGameMode.BP_LobbyGameMode'" };
 
@@ -820,6 +879,12 @@ void ACSKGameMode::OnMatchAbort()
 	FTimerManager& TimerManager = GetWorldTimerManager();
 	TimerManager.ClearAllTimersForObject(this);
 
+	// Aborted matches are the ones most likely to need reproducing
+	if (bSaveReplayLogs && ReplayLog.IsRecording())
+	{
+		SaveReplayLog();
+	}
+
 	OnFinishedWaitingPostMatch();
 }
 
@@ -1124,7 +1189,15 @@ void ACSKGameMode::PostCoinFlipDelayFinished()
 	{
 		if (Controller)
 		{
-			Controller->Client_TransitionToBoard();
+			// AI players have no client to transition
+			if (Controller->IsAIPlayer())
+			{
+				OnPlayerTransitionSequenceFinished();
+			}
+			else
+			{
+				Controller->Client_TransitionToBoard();
+			}
 		}
 	}
 }
@@ -1243,14 +1316,14 @@ void ACSKGameMode::UpdatePlayerResources(ACSKPlayerController* Controller, int32
 			return;
 		}
 
-		int32 GoldToGive = CollectionPhaseGold;
-		int32 ManaToGive = CollectionPhaseMana;
+		// Fixed yields of towers without the event are summed as towers are added and removed
+		int32 GoldToGive = CollectionPhaseGold + State->GetCollectionGoldFromTowers();
+		int32 ManaToGive = CollectionPhaseMana + State->GetCollectionManaFromTowers();
 
-		// Cycle through this players towers to collect any additional resources
-		TArray<ATower*> PlayersTowers = State->GetOwnedTowers();
-		for (ATower* Tower : PlayersTowers)
+		// Only towers with their own collection logic need to be asked for additional resources
+		for (ATower* Tower : State->GetCollectionPhaseTowers())
 		{
-			if (ensure(Tower) && Tower->WantsCollectionPhaseEvent())
+			if (ensure(Tower))
 			{
 				int32 AdditionalGold = 0;
 				int32 AdditionalMana = 0;
@@ -1294,8 +1367,16 @@ void ACSKGameMode::UpdatePlayerResources(ACSKPlayerController* Controller, int32
 		int32 GoldGiven = NewGold - OriginalGold;
 		int32 ManaGiven = NewMana - OriginalMana;
 
-		FCollectionPhaseResourcesTally TalliedResults(GoldGiven, ManaGiven, bDeckReshuffled, SpellCard);
-		Controller->Client_OnCollectionPhaseResourcesTallied(TalliedResults);
+		// AI players have no client to play the collection sequence
+		if (Controller->IsAIPlayer())
+		{
+			NotifyCollectionPhaseSequenceFinished(Controller);
+		}
+		else
+		{
+			FCollectionPhaseResourcesTally TalliedResults(GoldGiven, ManaGiven, bDeckReshuffled, SpellCard);
+			Controller->Client_OnCollectionPhaseResourcesTallied(TalliedResults);
+		}
 	}
 	else
 	{
@@ -1341,11 +1422,20 @@ bool ACSKGameMode::RequestEndActionPhase(bool bTimeOut)
 	}
 
 	// Player might not have fulfilled action phase requirements (e.g. moving castle)
-	if (!bTimeOut && !ActionPhaseActiveController->CanEndActionPhase())
+	if (!bTimeOut)
 	{
-		return false;
+		const bool bCanEndPhase = RulesEngine.IsValid() ?
+			IsRulesEngineActionLegal(FCSKRulesAction(ECSKRulesActionType::EndPhase, INDEX_NONE)) :
+			ActionPhaseActiveController->CanEndActionPhase();
+
+		if (!bCanEndPhase)
+		{
+			return false;
+		}
 	}
 
+	RecordReplayRequest(ECSKReplayRecordType::EndActionPhase, ActionPhaseActiveController->CSKPlayerID, nullptr, nullptr, 0, 0, bTimeOut);
+
 	ActionPhaseActiveController->SetActionPhaseEnabled(false);
 
 	// Move onto next phase
@@ -1385,6 +1475,12 @@ bool ACSKGameMode::RequestCastleMove(ATile* Goal)
 			return false;
 		}
 
+		// Goal must be reachable with the moves this player has left
+		if (RulesEngine.IsValid() && !IsRulesEngineActionLegal(FCSKRulesAction(ECSKRulesActionType::MoveCastle, GetRulesEngineCell(Goal))))
+		{
+			return false;
+		}
+
 		// The max amount of tiles this player is allowed to move, a path exceeding this amount will result in being denied
 		int32 TileSegments = MaxTileMovements;
 
@@ -1411,11 +1507,17 @@ bool ACSKGameMode::RequestCastleMove(ATile* Goal)
 		ABoardManager* BoardManager = UConquestFunctionLibrary::GetMatchBoardManager(this);
 		check(BoardManager);
 
-		// Confirm request if path is successfully found
-		FBoardPath OutBoardPath;
-		if (BoardManager->FindPath(Origin, Goal, OutBoardPath, false, TileSegments))
+		// Generate the path to the goal. This is the same search used to give
+		// the player their move candidates, so will agree with the rules engine
+		TSharedPtr<const FHexGridReachableSet> ReachableSet = BoardManager->GetReachableTiles(Origin, TileSegments);
+		if (ReachableSet.IsValid())
 		{
-			return ConfirmCastleMove(OutBoardPath);
+			FBoardPath OutBoardPath;
+			if (BoardManager->GetPathFromReachableSet(*ReachableSet, Goal, OutBoardPath) && ConfirmCastleMove(OutBoardPath))
+			{
+				RecordReplayRequest(ECSKReplayRecordType::CastleMove, ActionPhaseActiveController->CSKPlayerID, nullptr, Goal);
+				return true;
+			}
 		}
 	}
 
@@ -1450,42 +1552,24 @@ bool ACSKGameMode::RequestBuildTower(TSubclassOf<UTowerConstructionData> TowerTe
 
 	if (ActionPhaseActiveController->CanRequestBuildTowerAction())
 	{
-		// We have to be allowed to place towers on the desired tile
-		if (!Tile->CanPlaceTowersOn())
-		{
-			return false;
-		}
-
-		ACastle* Castle = ActionPhaseActiveController->GetCastlePawn();
-		ATile* Origin = Castle ? Castle->GetCachedTile() : nullptr;
-
-		if (Origin)
+		if (RulesEngine.IsValid())
 		{
-			// The requested tile is not within build range
-			if (FHexGrid::HexDisplacement(Origin->GetGridHexValue(), Tile->GetGridHexValue()) > MaxBuildRange)
+			// Only towers available in this match can be built
+			const int32 TowerType = AvailableTowers.IndexOfByKey(TowerTemplate);
+			if (TowerType == INDEX_NONE)
 			{
 				return false;
 			}
-		}
-		else
-		{
-			UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::RequestBuildTower: Confirming build request "
-				"without range check as players castle cached tile is invalid"));
-		}
 
-		ACSKGameState* CSKGameState = Cast<ACSKGameState>(GameState);
-		if (CSKGameState)
-		{
-			// The player might not be able to build this tower
-			if (!CSKGameState->CanPlayerBuildTower(ActionPhaseActiveController, TowerTemplate))
+			// Tile must be buildable and within range, while the player needs to afford the tower without exceeding any limits
+			if (!IsRulesEngineActionLegal(FCSKRulesAction(ECSKRulesActionType::BuildTower, GetRulesEngineCell(Tile), TowerType)))
 			{
 				return false;
 			}
 		}
-		else
+		else if (!CanBuildTowerWithoutRulesEngine(TowerTemplate, Tile))
 		{
-			UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::RequestBuildTower: Confirming build request "
-				"without board validation as game state is not of CSKGameState"));
+			return false;
 		}
 
 		UTowerConstructionData* ConstructData = TowerTemplate.GetDefaultObject();
@@ -1495,6 +1579,7 @@ bool ACSKGameMode::RequestBuildTower(TSubclassOf<UTowerConstructionData> TowerTe
 		ATower* NewTower = SpawnTowerFor(TowerClass, Tile, ConstructData, ActionPhaseActiveController->GetCSKPlayerState());
 		if (NewTower)
 		{
+			RecordReplayRequest(ECSKReplayRecordType::BuildTower, ActionPhaseActiveController->CSKPlayerID, TowerTemplate, Tile);
 			return ConfirmBuildTower(NewTower, Tile, ConstructData);
 		}
 	}
@@ -1544,7 +1629,7 @@ bool ACSKGameMode::RequestCastSpell(TSubclassOf<USpellCard> SpellCard, int32 Spe
 
 		// Spell can't (or there is not point) be cast at tile
 		ACSKPlayerState* PlayerState = ActionPhaseActiveController->GetCSKPlayerState();
-		if (!DefaultSpell->CanActivateSpell(PlayerState, TargetTile))
+		if (!DefaultSpell->CanActivateSpellOnTile(PlayerState, TargetTile))
 		{
 			return false;
 		}
@@ -1554,13 +1639,25 @@ bool ACSKGameMode::RequestCastSpell(TSubclassOf<USpellCard> SpellCard, int32 Spe
 
 		if (PlayerState)
 		{
+			if (RulesEngine.IsValid())
+			{
+				// Player must be able to cast another spell and afford this one (with discounts applied). The rules engine
+				// only models spells as damaging the target, so the targeting rules of the spell were checked instead
+				const int32 HandSlot = GetRulesEngineHandSlot(PlayerState, SpellCard);
+				const int32 RulesAdditionalMana = DefaultSpell->ExpectsAdditionalMana() ? FMath::Clamp(AdditionalMana, 0, static_cast<int32>(MAX_uint8)) : 0;
+				if (HandSlot == INDEX_NONE || !IsRulesEngineActionLegal(FCSKRulesAction(ECSKRulesActionType::CastSpell,
+					GetRulesEngineCell(TargetTile), HandSlot, RulesAdditionalMana), false))
+				{
+					return false;
+				}
+			}
 			// Player isn't able to cast another spell (we don't need to check costs)
-			if (!PlayerState->CanCastAnotherSpell(false))
+			else if (!PlayerState->CanCastAnotherSpell(false))
 			{
 				return false;
 			}
 
-			// Spell isn't affordable (with discounts applied)
+			// Discounted cost is needed for the final cost
 			int32 DiscountedCost = 0;
 			if (!PlayerState->GetDiscountedManaIfAffordable(DefaultSpell->GetSpellStaticCost(), DiscountedCost))
 			{
@@ -1568,7 +1665,7 @@ bool ACSKGameMode::RequestCastSpell(TSubclassOf<USpellCard> SpellCard, int32 Spe
 			}
 
 			// Re-calculate as spell might use additional mana
-			FinalCost = DefaultSpell->CalculateFinalCost(PlayerState, TargetTile, DiscountedCost, AdditionalMana);
+			FinalCost = DefaultSpell->GetFinalCost(PlayerState, TargetTile, DiscountedCost, AdditionalMana);
 			if (!PlayerState->HasRequiredMana(FinalCost, true))
 			{
 				return false;
@@ -1589,6 +1686,8 @@ bool ACSKGameMode::RequestCastSpell(TSubclassOf<USpellCard> SpellCard, int32 Spe
 		if (OpposingPlayerState && OpposingPlayerState->CanCastQuickEffectSpell(true))
 		{
 			SaveActionSpellRequestAndWaitForCounterSelection(SpellCard, SpellIndex, TargetTile, FinalCost, AdditionalMana);
+
+			RecordReplayRequest(ECSKReplayRecordType::CastSpell, ActionPhaseActiveController->CSKPlayerID, SpellCard, TargetTile, SpellIndex, AdditionalMana);
 			return true;
 		}
 
@@ -1596,6 +1695,7 @@ bool ACSKGameMode::RequestCastSpell(TSubclassOf<USpellCard> SpellCard, int32 Spe
 		ASpellActor* SpellActor = SpawnSpellActor(DefaultSpell, TargetTile, FinalCost, AdditionalMana, PlayerState);
 		if (SpellActor)
 		{
+			RecordReplayRequest(ECSKReplayRecordType::CastSpell, ActionPhaseActiveController->CSKPlayerID, SpellCard, TargetTile, SpellIndex, AdditionalMana);
 			return ConfirmCastSpell(DefaultSpell, DefaultSpellCard, SpellActor, FinalCost, TargetTile, EActiveSpellContext::Action);
 		}
 	}
@@ -1675,7 +1775,7 @@ bool ACSKGameMode::RequestCastQuickEffect(TSubclassOf<USpellCard> SpellCard, int
 
 		// Spell can't (or there is no point) be cast at tile
 		ACSKPlayerState* PlayerState = OpposingPlayer->GetCSKPlayerState();
-		if (!DefaultSpell->CanActivateSpell(PlayerState, TargetTile))
+		if (!DefaultSpell->CanActivateSpellOnTile(PlayerState, TargetTile))
 		{
 			return false;
 		}
@@ -1693,7 +1793,7 @@ bool ACSKGameMode::RequestCastQuickEffect(TSubclassOf<USpellCard> SpellCard, int
 			}
 
 			// Re-calculate as spell might use additional mana
-			FinalCost = DefaultSpell->CalculateFinalCost(PlayerState, TargetTile, DiscountedCost, AdditionalMana);
+			FinalCost = DefaultSpell->GetFinalCost(PlayerState, TargetTile, DiscountedCost, AdditionalMana);
 			if (!PlayerState->HasRequiredMana(FinalCost, true))
 			{
 				return false;
@@ -1723,6 +1823,8 @@ bool ACSKGameMode::RequestCastQuickEffect(TSubclassOf<USpellCard> SpellCard, int
 		ASpellActor* SpellActor = SpawnSpellActor(DefaultSpell, TargetTile, FinalCost, AdditionalMana, PlayerState);
 		if (SpellActor)
 		{
+			RecordReplayRequest(ECSKReplayRecordType::CastQuickEffect, OpposingPlayer->CSKPlayerID, SpellCard, TargetTile, SpellIndex, AdditionalMana);
+
 			// We only consume mana from active player if we are casting a nullify quick effect
 			return ConfirmCastSpell(DefaultSpell, DefaultSpellCard, SpellActor, FinalCost, 
 				TargetTile, EActiveSpellContext::Counter, bWaitingOnPostQuickEffectSelection);
@@ -1736,6 +1838,9 @@ bool ACSKGameMode::RequestSkipQuickEffect()
 {
 	if (IsActionPhaseInProgress() && (bWaitingOnNullifyQuickEffectSelection || bWaitingOnPostQuickEffectSelection))
 	{
+		// Only the opposing player can select quick effects
+		RecordReplayRequest(ECSKReplayRecordType::SkipQuickEffect, 1 - ActionPhaseActiveController->CSKPlayerID);
+
 		if (bWaitingOnNullifyQuickEffectSelection)
 		{
 			ensure(ActivePlayerPendingSpellRequest.IsValid());
@@ -1797,7 +1902,7 @@ bool ACSKGameMode::RequestCastBonusSpell(ATile* TargetTile)
 		}
 
 		ACSKPlayerState* PlayerState = CastingPlayer->GetCSKPlayerState();
-		if (!DefaultSpell->CanActivateSpell(PlayerState, TargetTile))
+		if (!DefaultSpell->CanActivateSpellOnTile(PlayerState, TargetTile))
 		{
 			return false;
 		}
@@ -1806,6 +1911,8 @@ bool ACSKGameMode::RequestCastBonusSpell(ATile* TargetTile)
 		ASpellActor* SpellActor = SpawnSpellActor(DefaultSpell, TargetTile, 0, 0, PlayerState);
 		if (SpellActor)
 		{
+			RecordReplayRequest(ECSKReplayRecordType::CastBonusSpell, CastingPlayer->CSKPlayerID, nullptr, TargetTile);
+
 			BonusSpellContext = ActiveSpellContext;
 			return ConfirmCastSpell(DefaultSpell, nullptr, SpellActor, 0, TargetTile, EActiveSpellContext::Bonus);
 		}
@@ -1818,6 +1925,9 @@ bool ACSKGameMode::RequestSkipBonusSpell()
 {
 	if (IsActionPhaseInProgress() && bWaitingOnBonusSpellSelection)
 	{
+		const int32 ActivePlayerID = ActionPhaseActiveController->CSKPlayerID;
+		RecordReplayRequest(ECSKReplayRecordType::SkipBonusSpell, ActiveSpellContext == EActiveSpellContext::Action ? ActivePlayerID : 1 - ActivePlayerID);
+
 		FinishCastSpell(true, true);
 		bWaitingOnBonusSpellSelection = false;
 
@@ -1894,7 +2004,7 @@ ASpellActor* ACSKGameMode::CastSubSpellForActiveSpell(TSubclassOf<USpell> SubSpe
 		}
 
 		// Re-calculate as spell might use additional mana
-		FinalCost = DefaultSpell->CalculateFinalCost(PlayerState, TargetTile, DiscountedCost, AdditionalMana);
+		FinalCost = DefaultSpell->GetFinalCost(PlayerState, TargetTile, DiscountedCost, AdditionalMana);
 		if (!PlayerState->HasRequiredMana(FinalCost, true))
 		{
 			return nullptr;
@@ -2221,6 +2331,17 @@ bool ACSKGameMode::ConfirmBuildTower(ATower* Tower, ATile* Tile, UTowerConstruct
 		Tower->BP_OnBuiltByPlayer(ActionPhaseActiveController);
 	}
 
+	// Towers might decide what events they want when built, so only use them after the event
+	{
+		ACSKPlayerState* PlayerState = ActionPhaseActiveController->GetCSKPlayerState();
+		if (PlayerState)
+		{
+			PlayerState->UpdateCollectionPhaseTower(Tower);
+		}
+
+		InsertEndRoundActionTower(Tower);
+	}
+
 	ActivePlayerPendingTower = Tower;
 	ActivePlayerPendingTowerTile = Tile;
 
@@ -2889,10 +3010,9 @@ void ACSKGameMode::NotifyEndRoundActionFinished(ATower* Tower)
 		// If we should end the end round phase and move back onto the collection phase
 		bool bEndPhase = false;
 
-		if (ensure(EndRoundActionTowers.IsValidIndex(EndRoundRunningTower)))
+		// Index is one before the start if the first tower destroyed itself during its action
+		if (ensure(EndRoundRunningTower >= INDEX_NONE && EndRoundRunningTower < EndRoundActionTowers.Num()))
 		{
-			// Double check
-			//check(EndRoundActionTowers[EndRoundRunningTower] == Tower);
 			bRunningTowerEndRoundAction = false;
 		}
 		else
@@ -2925,72 +3045,82 @@ void ACSKGameMode::NotifyEndRoundActionFinished(ATower* Tower)
 	}
 }
 
-// TODO: Optomize by associating towers with a CSKPlayerID before sorting
-// right now, the sorting predicate will constantly use get player state which involes casting
 bool ACSKGameMode::PrepareEndRoundActionTowers()
 {
-	// We will most likely have the same amount of tiles as last round
-	// (Maybe one or two towers were added since the last round)
-	TArray<ATower*> ActionTowers;
-	ActionTowers.Reserve(EndRoundActionTowers.Num());
+	// Towers are kept in order as they are built and destroyed, so there is nothing to sort here.
+	// Towers that no longer want their action are skipped once their turn comes around
+	return EndRoundActionTowers.Num() > 0;
+}
 
-	// First get all towers that will run an action this round
-	for (ACSKPlayerController* Controller : Players)
+void ACSKGameMode::InsertEndRoundActionTower(ATower* Tower)
+{
+	if (!ensure(Tower) || !Tower->WantsEndRoundPhaseEvent())
 	{
-		if (Controller)
-		{
-			ACSKPlayerState* PlayerState = Controller->GetCSKPlayerState();
-			check(PlayerState);
+		return;
+	}
 
-			const TArray<ATower*>& PlayerTower = PlayerState->GetOwnedTowers();
-			for (ATower* Tower : PlayerTower)
-			{
-				// TODO: We might not need to check WantsEndRoundPhaseEvent here anymore!
-				if (ensure(Tower) && Tower->WantsEndRoundPhaseEvent())
-				{
-					ActionTowers.Add(Tower);
-				}
-			}
-		}
+	// Insert after every tower that should go first, this keeps towers that tie in build order
+	int32 Index = EndRoundActionTowers.Num();
+	while (Index > 0 && ShouldRunEndRoundActionBefore(Tower, EndRoundActionTowers[Index - 1]))
+	{
+		--Index;
 	}
 
-	// If two towers happen to share the same priority, we decide
-	// who goes first based on the player who won the coin toss 
-	int32 PlayerWithPriority = StartingPlayerID;
+	EndRoundActionTowers.Insert(Tower, Index);
 
-	// Now sort action towers based on their priority
-	ActionTowers.Sort([PlayerWithPriority](const ATower& lhs, const ATower& rhs)->bool
+	// Make sure we don't run an action twice if this happens mid phase
+	if (IsEndRoundPhaseInProgress() && Index <= EndRoundRunningTower)
 	{
-		int32 T1Priority = lhs.GetEndRoundActionPriority();
-		int32 T2Priority = rhs.GetEndRoundActionPriority();
+		++EndRoundRunningTower;
+	}
+}
 
-		if (T1Priority < T2Priority)
-		{
-			return true;
-		}
-		else if (T1Priority > T2Priority)
+void ACSKGameMode::RemoveEndRoundActionTower(ATower* Tower)
+{
+	int32 Index = EndRoundActionTowers.Find(Tower);
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (IsEndRoundPhaseInProgress())
+	{
+		if (Index == EndRoundRunningTower && bRunningTowerEndRoundAction)
 		{
-			return false;
+			UE_LOG(LogConquest, Warning, TEXT("Tower %s has destroyed itself during it's action. "
+				"Is this intended?"), *Tower->GetFName().ToString());
+
+			// We let this tower finish it's execution
 		}
-		else
+
+		// We need to revert the index back one if this tower has already executed (or is executing),
+		// as not doing so will skip one towers end round action. Towers after it are unaffected
+		if (Index <= EndRoundRunningTower)
 		{
-			ACSKPlayerState* T1PlayerState = lhs.GetBoardPieceOwnerPlayerState();
-			if (T1PlayerState->GetCSKPlayerID() == PlayerWithPriority)
-			{
-				// Starting player always takes priority
-				return true;
-			}
-			else
-			{
-				ACSKPlayerState* T2PlayerState = lhs.GetBoardPieceOwnerPlayerState();
-				return T2PlayerState->GetCSKPlayerID() != PlayerWithPriority;
-			}
+			--EndRoundRunningTower;
 		}
-	});
+	}
 
-	// We can perform end round phase if there are any towers that can perform an action
-	EndRoundActionTowers = MoveTemp(ActionTowers);
-	return EndRoundActionTowers.Num() > 0;
+	EndRoundActionTowers.RemoveAt(Index);
+}
+
+bool ACSKGameMode::ShouldRunEndRoundActionBefore(const ATower* Tower, const ATower* Other) const
+{
+	const int32 Priority = Tower->GetEndRoundActionPriority();
+	const int32 OtherPriority = Other->GetEndRoundActionPriority();
+	if (Priority != OtherPriority)
+	{
+		return Priority < OtherPriority;
+	}
+
+	// If two towers happen to share the same priority, we decide
+	// who goes first based on the player who won the coin toss
+	const ACSKPlayerState* PlayerState = Tower->GetBoardPieceOwnerPlayerState();
+	const ACSKPlayerState* OtherPlayerState = Other->GetBoardPieceOwnerPlayerState();
+
+	const bool bHasPriority = PlayerState && PlayerState->GetCSKPlayerID() == StartingPlayerID;
+	const bool bOtherHasPriority = OtherPlayerState && OtherPlayerState->GetCSKPlayerID() == StartingPlayerID;
+	return bHasPriority && !bOtherHasPriority;
 }
 
 bool ACSKGameMode::StartRunningTowersEndRoundAction(int32 Index)
@@ -3178,31 +3308,7 @@ void ACSKGameMode::OnBoardPieceHealthChanged(UHealthComponent* HealthComp, int32
 			}
 
 			// We need to make sure this tower is removed from end round phase actions
-			if (IsEndRoundPhaseInProgress())
-			{
-				// This tower could possibly be a tower with an end round action
-				int32 Index = EndRoundActionTowers.Find(DestroyedTower);
-				if (Index != -1)
-				{
-					if (Index == EndRoundRunningTower)
-					{
-						check(EndRoundActionTowers[Index] == DestroyedTower);
-						UE_LOG(LogConquest, Warning, TEXT("Tower %s has destroyed itself during it's action. "
-							"Is this intended?"), *DestroyedTower->GetFName().ToString());
-
-						// We let this tower finish it's execution
-					}
-
-					// We need to revert the index back one if this tower has already,
-					// executed as not doing so will skip one towers end round action
-					if (Index >= EndRoundRunningTower)
-					{
-						--EndRoundRunningTower;
-					}
-
-					EndRoundActionTowers.RemoveAt(Index);
-				}
-			}
+			RemoveEndRoundActionTower(DestroyedTower);
 
 			// Cache this tower to be destroyed after the current action
 			ActiveActionsDestroyedTowers.Add(DestroyedTower);
@@ -3229,14 +3335,31 @@ void ACSKGameMode::OnBoardPieceHealthChanged(UHealthComponent* HealthComp, int32
 	// Generate a change report and save it
 	{
 		FHealthChangeReport Report(CompOwner, PlayerState, bIsCastle, bKilled, Delta);
-		ActiveActionHealthReports.Add(MoveTemp(Report));
+
+		// Building may have already changed during this action, in which case we merge the change into it.
+		// This keeps the amount of reports (and what gets replicated) bound by the amount of buildings
+		FHealthChangeReport* ExistingReport = ActiveActionHealthReports.FindByPredicate([&Report](const FHealthChangeReport& Repo)
+		{
+			return Repo.Building == Report.Building && Repo.bWasDamaged == Report.bWasDamaged;
+		});
+
+		if (ExistingReport)
+		{
+			ExistingReport->Delta += Report.Delta;
+			ExistingReport->bKilled |= Report.bKilled;
+		}
+		else
+		{
+			ActiveActionHealthReports.Add(MoveTemp(Report));
+		}
 	}
 }
 
 void ACSKGameMode::ClearHealthReports()
 {
-	ActiveActionHealthReports.Empty();
-	PreviousActionHealthReports.Empty();
+	// Reports are cleared every action, so we keep the memory around
+	ActiveActionHealthReports.Reset();
+	PreviousActionHealthReports.Reset();
 
 	ACSKGameState* CSKGameState = CastChecked<ACSKGameState>(GameState);
 	if (CSKGameState)
@@ -3247,7 +3370,9 @@ void ACSKGameMode::ClearHealthReports()
 
 void ACSKGameMode::CacheAndClearHealthReports()
 {
-	PreviousActionHealthReports = MoveTemp(ActiveActionHealthReports);
+	// Swap so both arrays keep their allocations between actions
+	Swap(PreviousActionHealthReports, ActiveActionHealthReports);
+	ActiveActionHealthReports.Reset();
 
 	ACSKGameState* CSKGameState = CastChecked<ACSKGameState>(GameState);
 	if (CSKGameState)
@@ -3328,4 +3453,940 @@ void ACSKGameMode::OnDisconnect(UWorld* InWorld, UNetDriver* NetDriver)
 	}
 }
 
+bool ACSKGameMode::GetRulesEngineRules(FCSKRules& OutRules) const
+{
+	const ABoardManager* BoardManager = UConquestFunctionLibrary::GetMatchBoardManager(this);
+	if (!BoardManager)
+	{
+		return false;
+	}
+
+	const FHexGrid& HexGrid = BoardManager->GetHexGrid();
+	const FIntPoint& Dimensions = BoardManager->GetGridDimensions();
+
+	OutRules = FCSKRules();
+	if (!OutRules.InitBoard(Dimensions.X, Dimensions.Y))
+	{
+		UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::GetRulesEngineRules: Board of %ix%i tiles exceeds the max amount of cells supported by the rules engine (%i)"),
+			Dimensions.X, Dimensions.Y, MAX_int16);
+
+		return false;
+	}
+
+	for (int32 Index = 0; Index < HexGrid.Num(); ++Index)
+	{
+		const ATile* Tile = HexGrid.GetTileAtIndex(Index);
+		if (!Tile || Tile->bIsNullTile)
+		{
+			OutRules.NullCells.Set(Index);
+		}
+	}
+
+	for (int32 PlayerID = 0; PlayerID < CSK_MAX_NUM_PLAYERS; ++PlayerID)
+	{
+		const ATile* PortalTile = BoardManager->GetPlayerPortalTile(PlayerID);
+		if (!PortalTile)
+		{
+			return false;
+		}
+
+		const int32 Cell = HexGrid.HexToIndex(PortalTile->GetGridHexValue());
+		OutRules.PlayerPortals[PlayerID] = Cell;
+		OutRules.PortalCells.Set(Cell);
+	}
+
+	OutRules.StartingGold = StartingGold;
+	OutRules.StartingMana = StartingMana;
+	OutRules.CollectionPhaseGold = CollectionPhaseGold;
+	OutRules.CollectionPhaseMana = CollectionPhaseMana;
+	OutRules.MaxGold = MaxGold;
+	OutRules.MaxMana = MaxMana;
+	OutRules.MaxBuildRange = MaxBuildRange;
+	OutRules.MaxSpellUses = MaxSpellUses;
+	OutRules.MaxSpellCardsInHand = MaxSpellCardsInHand;
+	OutRules.MinTileMovements = MinTileMovements;
+	OutRules.MaxTileMovements = MaxTileMovements;
+	OutRules.bLimitOneMoveActionPerTurn = bLimitOneMoveActionPerTurn;
+
+	// Both castles are expected to share the same health
+	const ACastle* DefaultCastle = Player1CastleClass.GetDefaultObject();
+	if (DefaultCastle && DefaultCastle->GetHealthComponent())
+	{
+		OutRules.CastleHealth = DefaultCastle->GetHealthComponent()->GetMaxHealth();
+	}
+
+	OutRules.TowerLimits.MaxNumTowers = MaxNumTowers;
+	OutRules.TowerLimits.MaxNumDuplicatedTowers = MaxNumDuplicatedTowers;
+	OutRules.TowerLimits.MaxNumDuplicatedTowerTypes = MaxNumDuplicatedTowerTypes;
+	OutRules.TowerLimits.MaxNumLegendaryTowers = MaxNumLegendaryTowers;
+
+	// Towers and spells are referenced by their index into the available arrays
+	for (TSubclassOf<UTowerConstructionData> TowerTemplate : AvailableTowers)
+	{
+		FCSKRulesTower& RulesTower = OutRules.Towers.AddDefaulted_GetRef();
+
+		const UTowerConstructionData* ConstructData = TowerTemplate.GetDefaultObject();
+		const ATower* DefaultTower = ConstructData ? ConstructData->TowerClass.GetDefaultObject() : nullptr;
+		if (!DefaultTower)
+		{
+			// Can never be afforded
+			RulesTower.GoldCost = MAX_int32;
+			continue;
+		}
+
+		RulesTower.GoldCost = ConstructData->GoldCost;
+		RulesTower.ManaCost = ConstructData->ManaCost;
+		// Resources given by the collection phase event can only be estimated (see ACSKPlayerState::AddTower)
+		if (DefaultTower->WantsCollectionPhaseEvent())
+		{
+			RulesTower.CollectionGold = ConstructData->SimulatedCollectionGold;
+			RulesTower.CollectionMana = ConstructData->SimulatedCollectionMana;
+		}
+		else
+		{
+			RulesTower.CollectionGold = ConstructData->CollectionGold;
+			RulesTower.CollectionMana = ConstructData->CollectionMana;
+			RulesTower.SpellUses = ConstructData->CollectionSpellUses;
+		}
+
+		RulesTower.EndRoundDamage = ConstructData->SimulatedEndRoundDamage;
+		RulesTower.EndRoundRange = ConstructData->SimulatedEndRoundRange;
+		RulesTower.EndRoundPriority = DefaultTower->GetEndRoundActionPriority();
+		RulesTower.bIsLegendary = DefaultTower->IsLegendaryTower();
+
+		if (DefaultTower->GetHealthComponent())
+		{
+			RulesTower.Health = DefaultTower->GetHealthComponent()->GetMaxHealth();
+		}
+	}
+
+	for (TSubclassOf<USpellCard> SpellCard : AvailableSpellCards)
+	{
+		FCSKRulesSpellCard& RulesSpellCard = OutRules.SpellCards.AddDefaulted_GetRef();
+		RulesSpellCard.bIsActionSpell = false;
+
+		const USpellCard* DefaultSpellCard = SpellCard.GetDefaultObject();
+		if (!DefaultSpellCard)
+		{
+			continue;
+		}
+
+		for (TSubclassOf<USpell> Spell : DefaultSpellCard->GetSpells())
+		{
+			const USpell* DefaultSpell = Spell.GetDefaultObject();
+			if (DefaultSpell && DefaultSpell->GetSpellType() == ESpellType::ActionPhase)
+			{
+				RulesSpellCard.StaticCost = DefaultSpell->GetSpellStaticCost();
+				RulesSpellCard.Damage = DefaultSpell->GetSimulatedDamage();
+				RulesSpellCard.bExpectsAdditionalMana = DefaultSpell->ExpectsAdditionalMana();
+				RulesSpellCard.bIsActionSpell = true;
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool ACSKGameMode::GetRulesEngineState(const FCSKRules& Rules, FCSKRulesState& OutState) const
+{
+	const ABoardManager* BoardManager = UConquestFunctionLibrary::GetMatchBoardManager(this);
+	const ACSKGameState* CSKGameState = Cast<ACSKGameState>(GameState);
+	if (!BoardManager || !CSKGameState || !IsMatchInProgress())
+	{
+		return false;
+	}
+
+	const FHexGrid& HexGrid = BoardManager->GetHexGrid();
+	if (HexGrid.Num() != Rules.NumCells())
+	{
+		return false;
+	}
+
+	auto GetCell = [&HexGrid](const ATile* Tile) -> int32
+	{
+		return Tile ? HexGrid.HexToIndex(Tile->GetGridHexValue()) : INDEX_NONE;
+	};
+
+	OutState = FCSKRulesState();
+	OutState.OccupiedCells.Init(Rules.NumCells());
+	OutState.DeckReshuffleStream = DeckReshuffleStream;
+	OutState.Round = CSKGameState->GetRound();
+	OutState.RoundState = RoundState;
+	OutState.StartingPlayer = StartingPlayerID;
+	OutState.ActivePlayer = ActionPhaseActiveController ? ActionPhaseActiveController->CSKPlayerID : INDEX_NONE;
+
+	for (int32 PlayerID = 0; PlayerID < CSK_MAX_NUM_PLAYERS; ++PlayerID)
+	{
+		const ACSKPlayerController* Controller = Players[PlayerID];
+		const ACSKPlayerState* PlayerState = Controller ? Controller->GetCSKPlayerState() : nullptr;
+		const ACastle* Castle = PlayerState ? PlayerState->GetCastle() : nullptr;
+		if (!Castle || !Castle->GetHealthComponent())
+		{
+			return false;
+		}
+
+		FCSKRulesPlayerState& Player = OutState.Players[PlayerID];
+		Player.Gold = PlayerState->GetGold();
+		Player.Mana = PlayerState->GetMana();
+		Player.CastleCell = GetCell(Castle->GetCachedTile());
+		Player.CastleHealth = Castle->GetHealthComponent()->GetHealth();
+		Player.TilesTraversedThisRound = PlayerState->GetTilesTraversedThisRound();
+		Player.BonusTileMovements = PlayerState->GetBonusTileMovements();
+		Player.SpellsCastThisRound = PlayerState->GetSpellsCastThisRound();
+		Player.MaxNumSpellUses = PlayerState->HasInfiniteSpellUses() ? MAX_int32 : PlayerState->GetMaxNumSpellUses();
+		Player.SpellDiscount = PlayerState->GetSpellDiscount();
+		Player.RemainingActions = Controller->GetRemainingActions();
+
+		if (Player.CastleCell == INDEX_NONE)
+		{
+			return false;
+		}
+
+		OutState.OccupiedCells.Set(Player.CastleCell);
+
+		for (TSubclassOf<USpellCard> SpellCard : PlayerState->GetSpellCardsInHand())
+		{
+			const int32 CardIndex = AvailableSpellCards.IndexOfByKey(SpellCard);
+			if (CardIndex != INDEX_NONE)
+			{
+				Player.SpellCardsInHand.Add(static_cast<uint8>(CardIndex));
+			}
+		}
+
+		for (TSubclassOf<USpellCard> SpellCard : PlayerState->GetSpellCardDeck())
+		{
+			const int32 CardIndex = AvailableSpellCards.IndexOfByKey(SpellCard);
+			if (CardIndex != INDEX_NONE)
+			{
+				Player.SpellCardDeck.Add(static_cast<uint8>(CardIndex));
+			}
+		}
+
+		Player.TowerCounts.SetNumZeroed(Rules.Towers.Num());
+
+		for (const ATower* Tower : PlayerState->GetOwnedTowers())
+		{
+			const int32 Cell = Tower ? GetCell(Tower->GetCachedTile()) : INDEX_NONE;
+			const UHealthComponent* HealthComp = Tower ? Tower->GetHealthComponent() : nullptr;
+			if (Cell == INDEX_NONE || !HealthComp || HealthComp->IsDead())
+			{
+				continue;
+			}
+
+			// Towers not available to build are still on the board, but their effects are unknown
+			const int32 TowerType = Tower->ConstructData ? AvailableTowers.IndexOfByKey(Tower->ConstructData->GetClass()) : INDEX_NONE;
+			if (TowerType != INDEX_NONE)
+			{
+				FCSKRulesTowerState& RulesTower = OutState.Towers.AddDefaulted_GetRef();
+				RulesTower.Type = static_cast<uint8>(TowerType);
+				RulesTower.Owner = static_cast<uint8>(PlayerID);
+				RulesTower.Cell = static_cast<int16>(Cell);
+				RulesTower.Health = static_cast<int16>(HealthComp->GetHealth());
+
+				++Player.TowerCounts[TowerType];
+			}
+
+			if (Tower->IsLegendaryTower())
+			{
+				++Player.NumLegendaryTowers;
+			}
+			else
+			{
+				++Player.NumNormalTowers;
+			}
+
+			OutState.OccupiedCells.Set(Cell);
+		}
+	}
+
+	return true;
+}
+
+void ACSKGameMode::InitRulesEngine()
+{
+	RulesEngine.Reset();
+
+	FCSKRules Rules;
+	if (GetRulesEngineRules(Rules))
+	{
+		RulesEngine = MakeShared<FCSKRulesEngine, ESPMode::ThreadSafe>(Rules);
+	}
+	else
+	{
+		UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::InitRulesEngine: Unable to get rules for match, "
+			"requests will only be validated by the game mode"));
+	}
+}
+
+bool ACSKGameMode::IsRulesEngineActionLegal(const FCSKRulesAction& Action, bool bCheckSpellTarget) const
+{
+	// Requests validate themselves when there is no rules engine
+	if (!RulesEngine.IsValid())
+	{
+		return false;
+	}
+
+	FCSKRulesState State;
+	if (!GetRulesEngineState(RulesEngine->GetRules(), State))
+	{
+		UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::IsRulesEngineActionLegal: Unable to capture match state, denying request"));
+		return false;
+	}
+
+	return RulesEngine->IsActionLegal(State, Action, bCheckSpellTarget);
+}
+
+bool ACSKGameMode::CanBuildTowerWithoutRulesEngine(TSubclassOf<UTowerConstructionData> TowerTemplate, ATile* Tile) const
+{
+	// We have to be allowed to place towers on the desired tile
+	if (!Tile->CanPlaceTowersOn())
+	{
+		return false;
+	}
+
+	ACastle* Castle = ActionPhaseActiveController->GetCastlePawn();
+	ATile* Origin = Castle ? Castle->GetCachedTile() : nullptr;
+
+	if (Origin)
+	{
+		// The requested tile is not within build range
+		if (FHexGrid::HexDisplacement(Origin->GetGridHexValue(), Tile->GetGridHexValue()) > MaxBuildRange)
+		{
+			return false;
+		}
+	}
+	else
+	{
+		UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::RequestBuildTower: Confirming build request "
+			"without range check as players castle cached tile is invalid"));
+	}
+
+	ACSKGameState* CSKGameState = Cast<ACSKGameState>(GameState);
+	if (CSKGameState)
+	{
+		// The player might not be able to build this tower
+		if (!CSKGameState->CanPlayerBuildTower(ActionPhaseActiveController, TowerTemplate))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::RequestBuildTower: Confirming build request "
+			"without board validation as game state is not of CSKGameState"));
+	}
+
+	return true;
+}
+
+int32 ACSKGameMode::GetRulesEngineCell(const ATile* Tile) const
+{
+	const ABoardManager* BoardManager = UConquestFunctionLibrary::GetMatchBoardManager(this);
+	if (Tile && BoardManager)
+	{
+		return BoardManager->GetHexGrid().HexToIndex(Tile->GetGridHexValue());
+	}
+
+	return INDEX_NONE;
+}
+
+int32 ACSKGameMode::GetRulesEngineHandSlot(const ACSKPlayerState* PlayerState, TSubclassOf<USpellCard> SpellCard) const
+{
+	// Cards not available in this match are left out of the rules engines hand (see GetRulesEngineState)
+	int32 HandSlot = 0;
+	for (TSubclassOf<USpellCard> CardInHand : PlayerState->GetSpellCardsInHand())
+	{
+		if (CardInHand == SpellCard)
+		{
+			return AvailableSpellCards.Contains(SpellCard) ? HandSlot : INDEX_NONE;
+		}
+
+		if (AvailableSpellCards.Contains(CardInHand))
+		{
+			++HandSlot;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+TSubclassOf<USpellCard> ACSKGameMode::GetRulesEngineHandCard(const ACSKPlayerState* PlayerState, int32 HandSlot) const
+{
+	if (!PlayerState || HandSlot < 0)
+	{
+		return nullptr;
+	}
+
+	// Cards not available in this match are left out of the rules engines hand (see GetRulesEngineState)
+	for (TSubclassOf<USpellCard> CardInHand : PlayerState->GetSpellCardsInHand())
+	{
+		if (AvailableSpellCards.Contains(CardInHand) && HandSlot-- == 0)
+		{
+			return CardInHand;
+		}
+	}
+
+	return nullptr;
+}
+
+void ACSKGameMode::SetPlayerUsesAI(int32 PlayerID, bool bEnable)
+{
+	if (PlayerID == 0)
+	{
+		bPlayer1UsesAI = bEnable;
+	}
+	else if (PlayerID == 1)
+	{
+		bPlayer2UsesAI = bEnable;
+	}
+	else
+	{
+		return;
+	}
+
+	// Player might not have joined yet, in which case we will do this once they do. If play has
+	// already started we instead fill their slot with an AI player, as they might never join
+	ACSKPlayerController* Controller = Players[PlayerID];
+	if (!Controller && bEnable && HasActorBegunPlay() && !HasMatchStarted())
+	{
+		SpawnAIPlayer(PlayerID);
+	}
+	else if (Controller)
+	{
+		UCSKAIComponent* AIComponent = Controller->FindComponentByClass<UCSKAIComponent>();
+		if (bEnable && !AIComponent)
+		{
+			AIComponent = NewObject<UCSKAIComponent>(Controller, TEXT("AIComponent"));
+			AIComponent->RegisterComponent();
+		}
+		else if (!bEnable && AIComponent)
+		{
+			AIComponent->DestroyComponent();
+		}
+	}
+}
+
+ACSKPlayerController* ACSKGameMode::SpawnAIPlayer(int32 PlayerID)
+{
+	check(Players.IsValidIndex(PlayerID) && !Players[PlayerID]);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Instigator = Instigator;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	// AI players are player controllers so they can use the same requests as everyone else
+	ACSKPlayerController* Controller = GetWorld()->SpawnActor<ACSKPlayerController>(PlayerControllerClass, SpawnParams);
+	if (!Controller)
+	{
+		UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::SpawnAIPlayer: Failed to spawn AI player for Player %i"), PlayerID + 1);
+		return nullptr;
+	}
+
+	// Player state is spawned with the controller, this is how we tell AI players apart
+	ACSKPlayerState* PlayerState = Controller->GetCSKPlayerState();
+	if (PlayerState)
+	{
+		PlayerState->bIsABot = true;
+		ChangeName(Controller, FText::Format(LOCTEXT("AIPlayerName", "{0} (AI)"), DefaultPlayerName).ToString(), false);
+	}
+
+	// This will also add the AI component, as this player uses the AI
+	SetPlayerWithID(Controller, PlayerID);
+
+	// Spawns the default pawn, which in turn spawns our castle
+	RestartPlayer(Controller);
+
+	UE_LOG(LogConquest, Log, TEXT("Spawned AI player for Player %i"), PlayerID + 1);
+	return Controller;
+}
+
+void ACSKGameMode::SpawnAIPlayers()
+{
+	for (int32 i = 0; i < CSK_MAX_NUM_PLAYERS; ++i)
+	{
+		if (!Players[i] && IsPlayerUsingAI(i))
+		{
+			SpawnAIPlayer(i);
+		}
+	}
+}
+
+void ACSKGameMode::DestroyAIPlayers()
+{
+	for (int32 i = 0; i < CSK_MAX_NUM_PLAYERS; ++i)
+	{
+		ACSKPlayerController* Controller = Players[i];
+		if (Controller && Controller->IsAIPlayer())
+		{
+			Players[i] = nullptr;
+
+			// Player states are kept when travelling, we don't want AI players appearing in the lobby
+			Controller->Destroy();
+		}
+	}
+}
+
+bool ACSKGameMode::SaveReplayLog(const FString& Filename) const
+{
+	if (!ReplayLog.IsRecording())
+	{
+		UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::SaveReplayLog: No match has been recorded"));
+		return false;
+	}
+
+	const FString FinalFilename = Filename.IsEmpty() ?
+		FString::Printf(TEXT("Match_%s.cskreplay"), *FDateTime::Now().ToString()) : Filename;
+
+	return ReplayLog.SaveToFile(FinalFilename);
+}
+
+void ACSKGameMode::BeginReplayLog()
+{
+	if (!RulesEngine.IsValid())
+	{
+		UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::BeginReplayLog: No rules engine for match, match will not be recorded"));
+
+		ReplayLog.Reset();
+		return;
+	}
+
+	ReplayLog.BeginMatch(RulesEngine->GetRules(), DeckReshuffleStream.GetCurrentSeed(), StartingPlayerID, AvailableTowers, AvailableSpellCards);
+}
+
+void ACSKGameMode::RecordReplayRequest(ECSKReplayRecordType Type, int32 PlayerID, const UClass* Class,
+	const ATile* Tile, int32 SpellIndex, int32 AdditionalMana, bool bTimeOut)
+{
+	if (!ReplayLog.IsRecording())
+	{
+		return;
+	}
+
+	const ABoardManager* BoardManager = UConquestFunctionLibrary::GetMatchBoardManager(this);
+	const ACSKGameState* CSKGameState = Cast<ACSKGameState>(GameState);
+
+	FCSKReplayRecord Record;
+	Record.Type = Type;
+	Record.PlayerID = static_cast<uint8>(PlayerID);
+	Record.bTimeOut = bTimeOut;
+	Record.Round = CSKGameState ? CSKGameState->GetRound() : 0;
+	Record.Cell = Tile && BoardManager ? BoardManager->GetHexGrid().HexToIndex(Tile->GetGridHexValue()) : INDEX_NONE;
+	Record.ClassIndex = ReplayLog.GetClassIndex(Class);
+	Record.SpellIndex = SpellIndex;
+	Record.AdditionalMana = AdditionalMana;
+	Record.Seed = DeckReshuffleStream.GetCurrentSeed();
+
+	ReplayLog.AddRecord(Record);
+}
+
+bool ACSKGameMode::CaptureMatchSnapshot(FCSKMatchSnapshot& OutSnapshot) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_CSKGameModeCaptureMatchSnapshot);
+
+	const ABoardManager* BoardManager = UConquestFunctionLibrary::GetMatchBoardManager(this);
+	const ACSKGameState* CSKGameState = Cast<ACSKGameState>(GameState);
+	if (!BoardManager || !CSKGameState || !CanSnapshotMatch())
+	{
+		return false;
+	}
+
+	const FHexGrid& HexGrid = BoardManager->GetHexGrid();
+	const FIntPoint& Dimensions = BoardManager->GetGridDimensions();
+	if (HexGrid.Num() != Dimensions.X * Dimensions.Y)
+	{
+		return false;
+	}
+
+	auto GetCell = [&HexGrid](const ATile* Tile) -> int32
+	{
+		return Tile ? HexGrid.HexToIndex(Tile->GetGridHexValue()) : INDEX_NONE;
+	};
+
+	OutSnapshot.Reset();
+	OutSnapshot.Rows = Dimensions.X;
+	OutSnapshot.Columns = Dimensions.Y;
+	OutSnapshot.NullCells.Init(HexGrid.Num());
+	OutSnapshot.TileElements.SetNumUninitialized(HexGrid.Num());
+
+	for (int32 Cell = 0; Cell < HexGrid.Num(); ++Cell)
+	{
+		const ATile* Tile = HexGrid.GetTileAtIndex(Cell);
+		OutSnapshot.NullCells.SetValue(Cell, !Tile || Tile->bIsNullTile);
+		OutSnapshot.TileElements[Cell] = Tile ? Tile->TileType : ECSKElementType::None;
+	}
+
+	OutSnapshot.RoundState = RoundState;
+	OutSnapshot.StartingPlayer = StartingPlayerID;
+	OutSnapshot.DeckReshuffleSeed = DeckReshuffleStream.GetCurrentSeed();
+
+	CSKGameState->CaptureMatchSnapshot(OutSnapshot);
+
+	// Custom timers are driven by listeners we can't restore
+	if (OutSnapshot.TimerState == ECSKTimerState::Custom)
+	{
+		return false;
+	}
+
+	for (int32 PlayerID = 0; PlayerID < CSK_MAX_NUM_PLAYERS; ++PlayerID)
+	{
+		const ACSKPlayerController* Controller = Players[PlayerID];
+		const ACSKPlayerState* PlayerState = Controller ? Controller->GetCSKPlayerState() : nullptr;
+		const ACastle* Castle = PlayerState ? PlayerState->GetCastle() : nullptr;
+		const UHealthComponent* CastleHealthComp = Castle ? Castle->GetHealthComponent() : nullptr;
+		if (!CastleHealthComp)
+		{
+			return false;
+		}
+
+		FCSKPlayerSnapshot& Player = OutSnapshot.Players[PlayerID];
+		PlayerState->CaptureMatchSnapshot(Player);
+
+		Player.RemainingActions = Controller->GetRemainingActions();
+		Player.CastleCell = GetCell(Castle->GetCachedTile());
+		Player.CastleHealth = CastleHealthComp->GetHealth();
+		Player.CastleMaxHealth = CastleHealthComp->GetMaxHealth();
+
+		if (Player.CastleCell == INDEX_NONE)
+		{
+			return false;
+		}
+
+		for (const ATower* Tower : PlayerState->GetOwnedTowers())
+		{
+			const int32 Cell = Tower ? GetCell(Tower->GetCachedTile()) : INDEX_NONE;
+			const UHealthComponent* HealthComp = Tower ? Tower->GetHealthComponent() : nullptr;
+			if (Cell == INDEX_NONE || !HealthComp || HealthComp->IsDead() || !Tower->ConstructData)
+			{
+				continue;
+			}
+
+			FCSKTowerSnapshot& TowerSnapshot = OutSnapshot.Towers.AddDefaulted_GetRef();
+			TowerSnapshot.ConstructData = Tower->ConstructData->GetClass();
+			TowerSnapshot.Owner = static_cast<uint8>(PlayerID);
+			TowerSnapshot.Cell = Cell;
+			TowerSnapshot.Health = HealthComp->GetHealth();
+			TowerSnapshot.MaxHealth = HealthComp->GetMaxHealth();
+		}
+	}
+
+	if (ActivePlayerPendingSpellRequest.IsValid())
+	{
+		FCSKPendingSpellSnapshot& PendingSpell = OutSnapshot.PendingSpell;
+		PendingSpell.bIsSet = true;
+		PendingSpell.SpellCard = ActivePlayerPendingSpellRequest.SpellCard;
+		PendingSpell.SpellIndex = ActivePlayerPendingSpellRequest.SpellIndex;
+		PendingSpell.TargetCell = GetCell(ActivePlayerPendingSpellRequest.TargetTile);
+		PendingSpell.CalculatedCost = ActivePlayerPendingSpellRequest.CalculatedCost;
+		PendingSpell.AdditionalMana = ActivePlayerPendingSpellRequest.AdditionalMana;
+
+		if (PendingSpell.TargetCell == INDEX_NONE)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool ACSKGameMode::ApplyMatchSnapshot(const FCSKMatchSnapshot& Snapshot)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CSKGameModeApplyMatchSnapshot);
+
+	ABoardManager* BoardManager = UConquestFunctionLibrary::GetMatchBoardManager(this);
+	ACSKGameState* CSKGameState = Cast<ACSKGameState>(GameState);
+	if (!BoardManager || !CSKGameState || !CanSnapshotMatch())
+	{
+		return false;
+	}
+
+	const FHexGrid& HexGrid = BoardManager->GetHexGrid();
+	const FIntPoint& Dimensions = BoardManager->GetGridDimensions();
+
+	// Validate everything before patching, so we never leave the match half restored
+	{
+		if (Dimensions.X != Snapshot.Rows || Dimensions.Y != Snapshot.Columns || HexGrid.Num() != Snapshot.NumCells())
+		{
+			UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::ApplyMatchSnapshot: Snapshot was captured on a board of a different size"));
+			return false;
+		}
+
+		for (int32 Cell = 0; Cell < HexGrid.Num(); ++Cell)
+		{
+			const ATile* Tile = HexGrid.GetTileAtIndex(Cell);
+			if ((!Tile || Tile->bIsNullTile) != Snapshot.NullCells.Test(Cell))
+			{
+				UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::ApplyMatchSnapshot: Snapshot was captured on a different board"));
+				return false;
+			}
+		}
+
+		for (int32 PlayerID = 0; PlayerID < CSK_MAX_NUM_PLAYERS; ++PlayerID)
+		{
+			const ACSKPlayerState* PlayerState = Players[PlayerID] ? Players[PlayerID]->GetCSKPlayerState() : nullptr;
+			const ACastle* Castle = PlayerState ? PlayerState->GetCastle() : nullptr;
+			if (!Castle || !Castle->GetHealthComponent() || !Castle->GetCachedTile() || Snapshot.NullCells.Test(Snapshot.Players[PlayerID].CastleCell))
+			{
+				return false;
+			}
+		}
+
+		for (const FCSKTowerSnapshot& TowerSnapshot : Snapshot.Towers)
+		{
+			const UTowerConstructionData* ConstructData = TowerSnapshot.ConstructData.GetDefaultObject();
+			if (!ConstructData || !ConstructData->TowerClass || Snapshot.NullCells.Test(TowerSnapshot.Cell))
+			{
+				return false;
+			}
+		}
+
+		if (Snapshot.PendingSpell.bIsSet)
+		{
+			const USpellCard* DefaultSpellCard = Snapshot.PendingSpell.SpellCard.GetDefaultObject();
+			if (!DefaultSpellCard || !DefaultSpellCard->GetSpellAtIndex(Snapshot.PendingSpell.SpellIndex))
+			{
+				return false;
+			}
+		}
+	}
+
+	// Cancel the nullify selection we are waiting on, the snapshot might not have one
+	if (bWaitingOnNullifyQuickEffectSelection)
+	{
+		ACSKPlayerController* OpposingController = GetOpposingPlayersController(ActionPhaseActiveController->CSKPlayerID);
+		if (OpposingController)
+		{
+			OpposingController->SetNullifyQuickEffectSelectionEnabled(false);
+		}
+	}
+
+	ResetWaitingOnActionFlags();
+	ClearHealthReports();
+
+	// Requests from here on can't be replayed from the start of the match, so we stop recording
+	if (ReplayLog.IsRecording())
+	{
+		if (bSaveReplayLogs)
+		{
+			SaveReplayLog();
+		}
+
+		ReplayLog.Reset();
+	}
+
+	StartingPlayerID = Snapshot.StartingPlayer;
+
+	// Initializing with the current seed continues the stream from where it was captured
+	DeckReshuffleStream.Initialize(Snapshot.DeckReshuffleSeed);
+
+	// Patch tile elements
+	{
+		bool bElementsChanged = false;
+		for (int32 Cell = 0; Cell < HexGrid.Num(); ++Cell)
+		{
+			ATile* Tile = HexGrid.GetTileAtIndex(Cell);
+			if (Tile && Tile->TileType != Snapshot.TileElements[Cell])
+			{
+				Tile->TileType = Snapshot.TileElements[Cell];
+				bElementsChanged = true;
+			}
+		}
+
+		if (bElementsChanged)
+		{
+			BoardManager->RebuildBitboards();
+		}
+	}
+
+	// Castles are cleared from the board before being placed, as they might be swapping tiles
+	{
+		for (ACSKPlayerController* Controller : Players)
+		{
+			ACastle* Castle = Controller->GetCSKPlayerState()->GetCastle();
+
+			const FCSKPlayerSnapshot& Player = Snapshot.Players[Controller->CSKPlayerID];
+			if (HexGrid.GetTileAtIndex(Player.CastleCell) != Castle->GetCachedTile())
+			{
+				BoardManager->ClearBoardPieceOnTile(Castle->GetCachedTile());
+			}
+		}
+
+		for (ACSKPlayerController* Controller : Players)
+		{
+			ACastle* Castle = Controller->GetCSKPlayerState()->GetCastle();
+			ATile* CurrentTile = Castle->GetCachedTile();
+
+			const FCSKPlayerSnapshot& Player = Snapshot.Players[Controller->CSKPlayerID];
+			ATile* SnapshotTile = HexGrid.GetTileAtIndex(Player.CastleCell);
+			if (SnapshotTile != CurrentTile)
+			{
+				// Keep the castles offset from its tile
+				const FVector Offset = Castle->GetActorLocation() - CurrentTile->GetActorLocation();
+				Castle->SetActorLocation(SnapshotTile->GetActorLocation() + Offset, false, nullptr, ETeleportType::TeleportPhysics);
+				Castle->ReplicateLocation();
+
+				BoardManager->PlaceBoardPieceOnTile(Castle, SnapshotTile);
+			}
+
+			Castle->GetHealthComponent()->OverrideHealth(Player.CastleHealth, Player.CastleMaxHealth);
+		}
+	}
+
+	ApplyTowerSnapshots(Snapshot, BoardManager, CSKGameState);
+
+	// Entering the round state will enable the action phase for the active player. If
+	// we are already in it, we still refresh it as the active player might have changed
+	if (RoundState != Snapshot.RoundState)
+	{
+		EnterRoundState(Snapshot.RoundState);
+	}
+	else
+	{
+		UpdateActivePlayerForActionPhase(RoundState == ECSKRoundState::FirstActionPhase ? 0 : 1);
+	}
+
+	check(ActionPhaseActiveController);
+
+	// Player states are restored after the action phase, as enabling it resets their counters
+	for (ACSKPlayerController* Controller : Players)
+	{
+		const FCSKPlayerSnapshot& Player = Snapshot.Players[Controller->CSKPlayerID];
+		Controller->GetCSKPlayerState()->RestoreMatchSnapshot(Player);
+
+		if (Controller == ActionPhaseActiveController)
+		{
+			const ECSKActionPhaseMode DisabledActions = Controller->GetRemainingActions() & ~Player.RemainingActions;
+			if (DisabledActions != ECSKActionPhaseMode::None)
+			{
+				Controller->DisableActionMode(DisabledActions);
+			}
+		}
+	}
+
+	if (Snapshot.PendingSpell.bIsSet)
+	{
+		const FCSKPendingSpellSnapshot& PendingSpell = Snapshot.PendingSpell;
+		SaveActionSpellRequestAndWaitForCounterSelection(PendingSpell.SpellCard, PendingSpell.SpellIndex,
+			HexGrid.GetTileAtIndex(PendingSpell.TargetCell), PendingSpell.CalculatedCost, PendingSpell.AdditionalMana);
+	}
+
+	// Timers are restored last, as the steps above activate timers of their own
+	CSKGameState->RestoreMatchSnapshot(Snapshot);
+
+	UE_LOG(LogConquest, Log, TEXT("ACSKGameMode: Applied match snapshot (round %i, Player %i's action phase)"),
+		Snapshot.Round, ActionPhaseActiveController->CSKPlayerID + 1);
+
+	return true;
+}
+
+bool ACSKGameMode::CanSnapshotMatch() const
+{
+	if (!IsMatchInProgress() || !IsActionPhaseInProgress() || !ActionPhaseActiveController || Players.Num() != CSK_MAX_NUM_PLAYERS)
+	{
+		return false;
+	}
+
+	for (const ACSKPlayerController* Controller : Players)
+	{
+		if (!Controller || !Controller->GetCSKPlayerState())
+		{
+			return false;
+		}
+	}
+
+	// A spell waiting on a nullify quick effect hasn't started yet, so we can save its request
+	return !IsWaitingForAction() && !bWaitingOnPostQuickEffectSelection && !bWaitingOnBonusSpellSelection && ActiveActionsDestroyedTowers.Num() == 0;
+}
+
+void ACSKGameMode::ApplyTowerSnapshots(const FCSKMatchSnapshot& Snapshot, ABoardManager* BoardManager, ACSKGameState* CSKGameState)
+{
+	const FHexGrid& HexGrid = BoardManager->GetHexGrid();
+
+	// Towers already on the board are kept if the same tower of the same player is on the same tile
+	TMap<int32, const FCSKTowerSnapshot*> SnapshotTowers;
+	SnapshotTowers.Reserve(Snapshot.Towers.Num());
+
+	for (const FCSKTowerSnapshot& TowerSnapshot : Snapshot.Towers)
+	{
+		SnapshotTowers.Add(TowerSnapshot.Cell, &TowerSnapshot);
+	}
+
+	for (ACSKPlayerController* Controller : Players)
+	{
+		ACSKPlayerState* PlayerState = Controller->GetCSKPlayerState();
+
+		// Copy as we might be removing towers while iterating
+		const TArray<ATower*> OwnedTowers = PlayerState->GetOwnedTowers();
+		for (ATower* Tower : OwnedTowers)
+		{
+			if (!Tower)
+			{
+				continue;
+			}
+
+			const int32 Cell = Tower->GetCachedTile() ? HexGrid.HexToIndex(Tower->GetCachedTile()->GetGridHexValue()) : INDEX_NONE;
+			const FCSKTowerSnapshot* const* TowerSnapshot = SnapshotTowers.Find(Cell);
+
+			if (TowerSnapshot && Tower->ConstructData && (*TowerSnapshot)->ConstructData == Tower->ConstructData->GetClass() &&
+				(*TowerSnapshot)->Owner == Controller->CSKPlayerID)
+			{
+				Tower->GetHealthComponent()->OverrideHealth((*TowerSnapshot)->Health, (*TowerSnapshot)->MaxHealth);
+				SnapshotTowers.Remove(Cell);
+			}
+			else
+			{
+				BoardManager->ClearBoardPieceOnTile(Tower->GetCachedTile());
+				PlayerState->RemoveTower(Tower);
+				RemoveEndRoundActionTower(Tower);
+
+				CSKGameState->HandleTowerDestroyed(Tower, true);
+
+				Tower->Destroy();
+			}
+		}
+	}
+
+	// Whatever is left needs to be spawned
+	for (const TPair<int32, const FCSKTowerSnapshot*>& Pair : SnapshotTowers)
+	{
+		const FCSKTowerSnapshot& TowerSnapshot = *Pair.Value;
+		ACSKPlayerState* PlayerState = Players[TowerSnapshot.Owner]->GetCSKPlayerState();
+
+		ATile* Tile = HexGrid.GetTileAtIndex(TowerSnapshot.Cell);
+		UTowerConstructionData* ConstructData = TowerSnapshot.ConstructData.GetDefaultObject();
+
+		ATower* Tower = SpawnTowerFor(ConstructData->TowerClass, Tile, ConstructData, PlayerState);
+		if (!Tower)
+		{
+			UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::ApplyMatchSnapshot: Failed to spawn tower %s"), *ConstructData->GetName());
+			continue;
+		}
+
+		// Restored towers skip the build sequence, so can be shown straight away
+		Tower->SetActorHiddenInGame(false);
+
+		UHealthComponent* HealthComp = Tower->GetHealthComponent();
+		HealthComp->OnHealthChanged.AddDynamic(this, &ACSKGameMode::OnBoardPieceHealthChanged);
+		HealthComp->OverrideHealth(TowerSnapshot.Health, TowerSnapshot.MaxHealth);
+
+		if (!BoardManager->PlaceBoardPieceOnTile(Tower, Tile))
+		{
+			UE_LOG(LogConquest, Warning, TEXT("ACSKGameMode::ApplyMatchSnapshot: Failed to place tower %s on the board"), *Tower->GetName());
+
+			Tower->Destroy();
+			continue;
+		}
+
+		PlayerState->AddTower(Tower);
+		InsertEndRoundActionTower(Tower);
+
+		CSKGameState->HandleTowerRestored(Tower);
+	}
+
+	// The coin toss winner may have changed, which decides the order of towers with equal priority
+	EndRoundActionTowers.StableSort([this](const ATower& Tower, const ATower& Other)
+	{
+		return ShouldRunEndRoundActionBefore(&Tower, &Other);
+	});
+}
+
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
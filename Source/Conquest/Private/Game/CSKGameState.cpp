@@ -2,21 +2,28 @@
 
 #include "CSKGameState.h"
 #include "CSKGameMode.h"
+#include "CSKMatchSnapshot.h"
 #include "CSKPawn.h"
 #include "CSKPlayerController.h"
 #include "CSKPlayerState.h"
+#include "CSKRulesEngine.h"
+#include "CSKZobrist.h"
 
 #include "BoardManager.h"
 #include "BoardPathFollowingComponent.h"
 #include "Castle.h"
 #include "CastleAIController.h"
+#include "ConquestFunctionLibrary.h"
+#include "HealthComponent.h"
 #include "Spell.h"
 #include "SpellCard.h"
 #include "Tower.h"
 #include "TowerConstructionData.h"
 #include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
 
 DECLARE_CYCLE_STAT(TEXT("ACSKGameState GetTilesPlayerCanMoveTo Pathfind"), STAT_CSKGameStateGetTilesPlayerCanMoveToPathfind, STATGROUP_Conquest);
+DECLARE_CYCLE_STAT(TEXT("ACSKGameState GetSpellTargetMask"), STAT_CSKGameStateGetSpellTargetMask, STATGROUP_Conquest);
 
 ACSKGameState::ACSKGameState()
 {
@@ -34,8 +41,11 @@ ACSKGameState::ACSKGameState()
 
 	CoinTossWinnerPlayerID = -1;
 	TimerState = ECSKTimerState::None;
-	TimeRemaining = 0;
+	TimerEndTime = 0.f;
+	TimerPauseTime = 0.f;
+	NewActionPhaseTimeRemaining = 0.f;
 	bTimerPaused = false;
+	bHealthReportBucketsDirty = false;
 
 	ActionPhaseTime = 90.f;
 	MaxNumTowers = 7;
@@ -72,7 +82,9 @@ void ACSKGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLif
 
 	DOREPLIFETIME(ACSKGameState, CoinTossWinnerPlayerID);
 	DOREPLIFETIME(ACSKGameState, TimerState);
-	DOREPLIFETIME(ACSKGameState, TimeRemaining);
+	DOREPLIFETIME(ACSKGameState, TimerEndTime);
+	DOREPLIFETIME(ACSKGameState, TimerPauseTime);
+	DOREPLIFETIME(ACSKGameState, bTimerPaused);
 	DOREPLIFETIME(ACSKGameState, LatestActionHealthReports);
 
 	DOREPLIFETIME(ACSKGameState, ActionPhaseTime);
@@ -228,6 +240,9 @@ void ACSKGameState::NotifyCollectionPhaseStart()
 void ACSKGameState::NotifyFirstActionPhaseStart()
 {
 	UpdateActionPhaseProperties();
+
+	// Logged on every machine so logs can be compared when tracking down a desync
+	UE_LOG(LogConquest, Verbose, TEXT("ACSKGameState: Round %i started with match hash %016llx"), RoundsPlayed, GetMatchHash());
 }
 
 void ACSKGameState::NotifySecondActionPhaseStart()
@@ -385,15 +400,16 @@ void ACSKGameState::DeactivateCustomTimer()
 
 int32 ACSKGameState::GetCountdownTimeRemaining(bool& bOutIsInfinite) const
 {
-	bOutIsInfinite = false;
+	const float TimeRemaining = GetCountdownTimeRemainingSeconds(bOutIsInfinite);
+	return bOutIsInfinite ? -1 : FMath::CeilToInt(TimeRemaining);
+}
 
-	if (TimerState != ECSKTimerState::None)
-	{
-		bOutIsInfinite = TimeRemaining == -1;
-		return TimeRemaining;
-	}
+float ACSKGameState::GetCountdownTimeRemainingSeconds(bool& bOutIsInfinite) const
+{
+	const float TimeRemaining = GetTimerTimeRemaining();
+	bOutIsInfinite = TimeRemaining < 0.f;
 
-	return 0;
+	return TimeRemaining;
 }
 
 int32 ACSKGameState::GetTowerInstanceCount(TSubclassOf<ATower> Tower) const
@@ -412,30 +428,31 @@ void ACSKGameState::SetLatestActionHealthReports(const TArray<FHealthChangeRepor
 	if (HasAuthority())
 	{
 		LatestActionHealthReports = InHealthReports;
+		bHealthReportBucketsDirty = true;
 	}
 }
 
-TArray<FHealthChangeReport> ACSKGameState::GetDamageHealthReports(bool bFilterOutDead) const
+const TArray<FHealthChangeReport>& ACSKGameState::GetDamageHealthReports(bool bFilterOutDead) const
 {
 	return QueryLatestHealthReports(true, nullptr, bFilterOutDead);
 }
 
-TArray<FHealthChangeReport> ACSKGameState::GetHealingHealthReports() const
+const TArray<FHealthChangeReport>& ACSKGameState::GetHealingHealthReports() const
 {
 	return QueryLatestHealthReports(false, nullptr, true);
 }
 
-TArray<FHealthChangeReport> ACSKGameState::GetPlayersDamagedHealthReports(ACSKPlayerState* PlayerState, bool bFilterOutDead) const
+const TArray<FHealthChangeReport>& ACSKGameState::GetPlayersDamagedHealthReports(ACSKPlayerState* PlayerState, bool bFilterOutDead) const
 {
 	return QueryLatestHealthReports(true, PlayerState, bFilterOutDead);
 }
 
-TArray<FHealthChangeReport> ACSKGameState::GetPlayersHealingHealthReports(ACSKPlayerState* PlayerState) const
+const TArray<FHealthChangeReport>& ACSKGameState::GetPlayersHealingHealthReports(ACSKPlayerState* PlayerState) const
 {
 	return QueryLatestHealthReports(false, PlayerState, true);
 }
 
-void ACSKGameState::ActivateTickTimer(ECSKTimerState InTimerState, int32 InTime)
+void ACSKGameState::ActivateTickTimer(ECSKTimerState InTimerState, float InTime)
 {
 	if (HasAuthority())
 	{
@@ -454,7 +471,7 @@ void ACSKGameState::ActivateTickTimer(ECSKTimerState InTimerState, int32 InTime)
 		// We save this to restore later (if required)
 		if (TimerState == ECSKTimerState::ActionPhase)
 		{
-			NewActionPhaseTimeRemaining = TimeRemaining;
+			NewActionPhaseTimeRemaining = GetTimerTimeRemaining();
 		}
 
 		// Custom listener would appreciate being notified it was cancelled
@@ -463,12 +480,19 @@ void ACSKGameState::ActivateTickTimer(ECSKTimerState InTimerState, int32 InTime)
 			ExecuteCustomTimerFinishedEvent(true);
 		}
 
+		// Clients only receive the end time, which they count down to by themselves
+		const float ServerWorldTime = GetServerWorldTimeSeconds();
+
 		TimerState = InTimerState;
-		TimeRemaining = InTime;
+		TimerEndTime = InTime >= 0.f ? ServerWorldTime + InTime : -1.f;
+		TimerPauseTime = ServerWorldTime;
+
+		// Any pending finish belongs to the previous timer
+		SetTickTimerEnabled(false);
 
 		// We allow setting infinite times using -1, but
 		// for this we don't need to activate the timer
-		if (TimeRemaining > 0)
+		if (InTime > 0.f)
 		{
 			SetTickTimerEnabled(true);
 		}
@@ -480,7 +504,7 @@ void ACSKGameState::DeactivateTickTimer()
 	if (HasAuthority())
 	{
 		TimerState = ECSKTimerState::None;
-		TimeRemaining = 0;
+		TimerEndTime = 0.f;
 
 		SetTickTimerEnabled(false);
 	}
@@ -490,11 +514,21 @@ void ACSKGameState::SetTickTimerEnabled(bool bEnable)
 {
 	if (HasAuthority())
 	{
+		// Paused timers will be enabled again once resumed
 		FTimerManager& TimerManager = GetWorldTimerManager();
-		if (bEnable && !TimerManager.IsTimerActive(Handle_TickTimer))
+		if (bEnable && !bTimerPaused && !TimerManager.IsTimerActive(Handle_TickTimer))
 		{
-			AWorldSettings* WorldSettings = GetWorldSettings();
-			TimerManager.SetTimer(Handle_TickTimer, this, &ACSKGameState::TickTimer, WorldSettings->GetEffectiveTimeDilation(), true);
+			// Timer finishes once, at the end time clients are counting down to
+			const float TimeRemaining = GetTimerTimeRemaining();
+			if (TimeRemaining > 0.f)
+			{
+				TimerManager.SetTimer(Handle_TickTimer, this, &ACSKGameState::HandleTickTimerFinished, TimeRemaining, false);
+			}
+			else if (TimeRemaining == 0.f)
+			{
+				// Finish on the next tick, as enabling the timer shouldn't instantly trigger its events
+				Handle_TickTimer = TimerManager.SetTimerForNextTick(this, &ACSKGameState::HandleTickTimerFinished);
+			}
 		}
 		else if (!bEnable && TimerManager.IsTimerActive(Handle_TickTimer))
 		{
@@ -503,18 +537,48 @@ void ACSKGameState::SetTickTimerEnabled(bool bEnable)
 	}
 }
 
-int32 ACSKGameState::GetActionTimeBonusApplied(int32 Time) const
+void ACSKGameState::SetTimerPaused(bool bPaused)
+{
+	if (HasAuthority() && bTimerPaused != bPaused)
+	{
+		const float ServerWorldTime = GetServerWorldTimeSeconds();
+		if (bPaused)
+		{
+			SetTickTimerEnabled(false);
+
+			TimerPauseTime = ServerWorldTime;
+			bTimerPaused = true;
+		}
+		else
+		{
+			// Push the end time back by how long we were paused for
+			if (TimerEndTime >= 0.f)
+			{
+				TimerEndTime += ServerWorldTime - TimerPauseTime;
+			}
+
+			bTimerPaused = false;
+
+			if (TimerState != ECSKTimerState::None && TimerEndTime >= 0.f)
+			{
+				SetTickTimerEnabled(true);
+			}
+		}
+	}
+}
+
+float ACSKGameState::GetActionTimeBonusApplied(float Time) const
 {
 	ACSKGameMode* GameMode = Cast<ACSKGameMode>(AuthorityGameMode);
 	if (GameMode)
 	{
 		if (IsActionPhaseTimed())
 		{
-			return FMath::Min(ActionPhaseTime, Time + GameMode->GetBonusActionPhaseTime());
+			return FMath::Min<float>(ActionPhaseTime, Time + GameMode->GetBonusActionPhaseTime());
 		}
 		else
 		{
-			return -1;
+			return -1.f;
 		}
 	}
 
@@ -536,22 +600,68 @@ void ACSKGameState::UpdateActionPhaseProperties()
 	}
 }
 
-void ACSKGameState::TickTimer()
+void ACSKGameState::CaptureMatchSnapshot(FCSKMatchSnapshot& OutSnapshot) const
 {
-	// We should only tick on the server
-	if (HasAuthority() && !bTimerPaused)
+	OutSnapshot.Round = RoundsPlayed;
+	// Snapshots store whole seconds, rounding up avoids restoring a timer that has already finished
+	const float TimeRemaining = GetTimerTimeRemaining();
+	OutSnapshot.TimerState = TimerState;
+	OutSnapshot.TimeRemaining = TimeRemaining < 0.f ? -1 : FMath::CeilToInt(TimeRemaining);
+	OutSnapshot.ActionPhaseTimeRemaining = NewActionPhaseTimeRemaining < 0.f ? -1 : FMath::CeilToInt(NewActionPhaseTimeRemaining);
+}
+
+void ACSKGameState::RestoreMatchSnapshot(const FCSKMatchSnapshot& Snapshot)
+{
+	if (HasAuthority())
 	{
-		TimeRemaining -= 1;
-		if (TimeRemaining <= 0)
+		RoundsPlayed = Snapshot.Round;
+		CoinTossWinnerPlayerID = Snapshot.StartingPlayer;
+
+		// The coin toss winner might have changed without the round state changing
+		if (IsActionPhaseActive())
 		{
-			HandleTickTimerFinished();
+			ActionPhasePlayerID = RoundState == ECSKRoundState::FirstActionPhase ? CoinTossWinnerPlayerID : FMath::Abs(CoinTossWinnerPlayerID - 1);
 		}
+
+		// We set the timer directly, as activating it would overwrite the saved action phase time
+		const int32 TimeRemaining = Snapshot.TimerState != ECSKTimerState::None ? Snapshot.TimeRemaining : 0;
+		const float ServerWorldTime = GetServerWorldTimeSeconds();
+
+		SetTickTimerEnabled(false);
+
+		TimerState = Snapshot.TimerState;
+		TimerEndTime = TimeRemaining >= 0 ? ServerWorldTime + TimeRemaining : -1.f;
+		TimerPauseTime = ServerWorldTime;
+		NewActionPhaseTimeRemaining = Snapshot.ActionPhaseTimeRemaining;
+
+		SetTickTimerEnabled(TimeRemaining > 0);
+	}
+}
+
+float ACSKGameState::GetTimerTimeRemaining() const
+{
+	if (TimerState == ECSKTimerState::None)
+	{
+		return 0.f;
+	}
+
+	if (TimerEndTime < 0.f)
+	{
+		return -1.f;
 	}
+
+	// Time is frozen while paused
+	const float CurrentTime = bTimerPaused ? TimerPauseTime : GetServerWorldTimeSeconds();
+	return FMath::Max(0.f, TimerEndTime - CurrentTime);
 }
 
 void ACSKGameState::HandleTickTimerFinished()
 {
-	ensure(TimeRemaining <= 0);
+	// Timer might have been paused or stopped while this was pending
+	if (bTimerPaused || TimerState == ECSKTimerState::None)
+	{
+		return;
+	}
 
 	// Game mode only exists on the server
 	ACSKGameMode* GameMode = Cast<ACSKGameMode>(AuthorityGameMode);
@@ -603,46 +713,111 @@ void ACSKGameState::ExecuteCustomTimerFinishedEvent(bool bWasSkipped)
 	}
 }
 
-TArray<FHealthChangeReport> ACSKGameState::QueryLatestHealthReports(bool bDamaged, ACSKPlayerState* InOwner, bool bExcludeDead) const
+const TArray<FHealthChangeReport>& ACSKGameState::QueryLatestHealthReports(bool bDamaged, ACSKPlayerState* InOwner, bool bExcludeDead) const
 {
-	TArray<FHealthChangeReport> Reports;
-	for (const FHealthChangeReport& Repo : LatestActionHealthReports)
+	if (bHealthReportBucketsDirty)
+	{
+		RebuildHealthReportBuckets();
+	}
+
+	const FHealthReportBuckets* Buckets = &AllHealthReports;
+
+	// Filter owner
+	if (InOwner)
 	{
-		// Filter owner
-		if (InOwner)
+		Buckets = nullptr;
+		for (const FHealthReportBuckets& OwnerBuckets : PlayersHealthReports)
 		{
-			if (Repo.Owner != InOwner)
+			if (OwnerBuckets.Owner == InOwner)
 			{
-				continue;
+				Buckets = &OwnerBuckets;
+				break;
 			}
 		}
 
-		// Filter out differen type
-		if (bDamaged != Repo.bWasDamaged)
+		if (!Buckets)
+		{
+			static const TArray<FHealthChangeReport> NoReports;
+			return NoReports;
+		}
+	}
+
+	// Only filter killed if checking damaged
+	if (bDamaged)
+	{
+		return bExcludeDead ? Buckets->DamagedAlive : Buckets->Damaged;
+	}
+
+	return Buckets->Healed;
+}
+
+void ACSKGameState::OnRep_LatestActionHealthReports()
+{
+	// This is also called once owners that hadn't replicated with the reports have been resolved
+	bHealthReportBucketsDirty = true;
+}
+
+void ACSKGameState::RebuildHealthReportBuckets() const
+{
+	AllHealthReports.Reset();
+	for (FHealthReportBuckets& Buckets : PlayersHealthReports)
+	{
+		Buckets.Reset();
+	}
+
+	for (const FHealthChangeReport& Repo : LatestActionHealthReports)
+	{
+		AllHealthReports.Add(Repo);
+
+		// Owner may not have replicated yet, in which case it will be bucketed once it has
+		if (!Repo.Owner)
 		{
 			continue;
 		}
 
-		// Only filter killed if checking damaged
-		if (bDamaged)
+		for (FHealthReportBuckets& Buckets : PlayersHealthReports)
 		{
-			if (bExcludeDead && Repo.bKilled)
+			if (!Buckets.Owner || Buckets.Owner == Repo.Owner)
 			{
-				continue;
+				Buckets.Owner = Repo.Owner;
+				Buckets.Add(Repo);
+				break;
 			}
 		}
-
-		Reports.Add(Repo);
 	}
 
-	return Reports;
+	bHealthReportBucketsDirty = false;
+}
+
+void ACSKGameState::FHealthReportBuckets::Reset()
+{
+	Owner = nullptr;
+	Damaged.Reset();
+	DamagedAlive.Reset();
+	Healed.Reset();
+}
+
+void ACSKGameState::FHealthReportBuckets::Add(const FHealthChangeReport& Report)
+{
+	if (Report.bWasDamaged)
+	{
+		Damaged.Add(Report);
+		if (!Report.bKilled)
+		{
+			DamagedAlive.Add(Report);
+		}
+	}
+	else
+	{
+		Healed.Add(Report);
+	}
 }
 
 void ACSKGameState::HandleMoveRequestConfirmed()
 {
 	if (IsActionPhaseActive() && HasAuthority())
 	{
-		NewActionPhaseTimeRemaining = TimeRemaining;
+		NewActionPhaseTimeRemaining = GetTimerTimeRemaining();
 		DeactivateTickTimer();
 
 		Multi_HandleMoveRequestConfirmed();
@@ -664,7 +839,7 @@ void ACSKGameState::HandleBuildRequestConfirmed(ATile* TargetTile)
 {
 	if (IsActionPhaseActive() && HasAuthority())
 	{
-		NewActionPhaseTimeRemaining = TimeRemaining;
+		NewActionPhaseTimeRemaining = GetTimerTimeRemaining();
 		DeactivateTickTimer();
 
 		Multi_HandleBuildRequestConfirmed(TargetTile);
@@ -762,17 +937,8 @@ int32 ACSKGameState::GetPlayersNumRemainingMoves(const ACSKPlayerState* PlayerSt
 {
 	if (PlayerState)
 	{
-		int32 TilesTraversed = PlayerState->GetTilesTraversedThisRound();
-		int32 BonusTiles = PlayerState->GetBonusTileMovements();
-
-		// The max amount of movements a player can make during the move action. Bonus tiles
-		// can be negative (to signal less moves) but should ultimately be clamped to not exceed min
-		int32 CalculatedMaxMovements = FMath::Max(MinTileMovements, MaxTileMovements + BonusTiles);
-
-		if (TilesTraversed < CalculatedMaxMovements)
-		{
-			return CalculatedMaxMovements - TilesTraversed;
-		}
+		return FCSKRulesEngine::GetRemainingMoves(MinTileMovements, MaxTileMovements,
+			PlayerState->GetBonusTileMovements(), PlayerState->GetTilesTraversedThisRound());
 	}
 
 	return 0;
@@ -796,27 +962,29 @@ bool ACSKGameState::GetTilesPlayerCanMoveTo(const ACSKPlayerController* Controll
 		int32 MaxDistance = GetPlayersNumRemainingMoves(PlayerState);
 		if (MaxDistance > 0)
 		{
-			TArray<ATile*> Candidates;
-			if (BoardManager->GetTilesWithinDistance(CastlePawn->GetCachedTile(), MaxDistance, Candidates))
+			if (bPathfind)
 			{
-				if (bPathfind)
+				SCOPE_CYCLE_COUNTER(STAT_CSKGameStateGetTilesPlayerCanMoveToPathfind);
+
+				// Single search for every tile we can reach, instead of a path find per tile in range
+				TSharedPtr<const FHexGridReachableSet> ReachableSet = BoardManager->GetReachableTiles(CastlePawn->GetCachedTile(), MaxDistance);
+				if (ReachableSet.IsValid())
 				{
-					SCOPE_CYCLE_COUNTER(STAT_CSKGameStateGetTilesPlayerCanMoveToPathfind);
-					
-					// Initialize this here to avoid creation every loop
-					FBoardPath BoardPath;
+					const FHexGrid& HexGrid = BoardManager->GetHexGrid();
 
-					for (ATile* Tile : Candidates)
+					OutTiles.Reserve(ReachableSet->Num());
+					for (int32 Index : ReachableSet->Cells)
 					{
-						if (BoardManager->FindPath(CastlePawn->GetCachedTile(), Tile, BoardPath, false, MaxDistance))
-						{
-							OutTiles.Add(Tile);
-						}
+						OutTiles.Add(HexGrid.GetTileAtIndex(Index));
 					}
 
-					return OutTiles.Num() > 0;
+					return true;
 				}
-				else
+			}
+			else
+			{
+				TArray<ATile*> Candidates;
+				if (BoardManager->GetTilesWithinDistance(CastlePawn->GetCachedTile(), MaxDistance, Candidates))
 				{
 					// Not all these tiles may be reachable in given moves (player might need to walk
 					// around an obstacle) but they are within MaxDistance tiles of eachother 
@@ -844,14 +1012,16 @@ bool ACSKGameState::GetTilesPlayerCanBuildOn(const ACSKPlayerController* Control
 	if (PlayerState)
 	{
 		ACastle* CastlePawn = PlayerState->GetCastle();
-		if (BoardManager->GetTilesWithinDistance(CastlePawn->GetCachedTile(), MaxBuildRange, OutTiles))
-		{
-			// We need to remove any portal tiles
-			OutTiles.RemoveAll([this](const ATile* Tile)->bool
-			{
-				return !BoardManager->IsPlayerPortalTile(Tile);
-			});
-		}
+
+		FHexBitboard RangeMask;
+		BoardManager->GetRangeMask(CastlePawn->GetCachedTile(), MaxBuildRange, RangeMask);
+
+		// Buildable excludes occupied, null and portal tiles
+		FHexBitboard BuildableMask;
+		BoardManager->GetBuildableMask(BuildableMask);
+
+		RangeMask &= BuildableMask;
+		BoardManager->GetTilesFromMask(RangeMask, OutTiles);
 	}
 
 	return OutTiles.Num() > 0;
@@ -957,7 +1127,7 @@ bool ACSKGameState::CanPlayerCastSpell(const ACSKPlayerController* Controller, A
 		const USpell* DefaultSpell = Spell.GetDefaultObject();
 
 		// This spell might not accept the tile as a target
-		if (!DefaultSpell->CanActivateSpell(PlayerState, TargetTile))
+		if (!DefaultSpell->CanActivateSpellOnTile(PlayerState, TargetTile))
 		{
 			return false;
 		}
@@ -967,7 +1137,7 @@ bool ACSKGameState::CanPlayerCastSpell(const ACSKPlayerController* Controller, A
 		int32 DiscountedMana = 0;
 		if (PlayerState->GetDiscountedManaIfAffordable(DefaultSpell->GetSpellStaticCost(), DiscountedMana))
 		{
-			int32 FinalCost = DefaultSpell->CalculateFinalCost(PlayerState, TargetTile, DiscountedMana, AdditionalMana);
+			int32 FinalCost = DefaultSpell->GetFinalCost(PlayerState, TargetTile, DiscountedMana, AdditionalMana);
 			return PlayerState->HasRequiredMana(FinalCost);
 		}
 	}
@@ -975,6 +1145,82 @@ bool ACSKGameState::CanPlayerCastSpell(const ACSKPlayerController* Controller, A
 	return false;
 }
 
+void ACSKGameState::GetSpellTargetMask(const ACSKPlayerController* Controller, TSubclassOf<USpellCard> SpellCard,
+	int32 SpellIndex, int32 AdditionalMana, FHexBitboard& OutMask) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_CSKGameStateGetSpellTargetMask);
+
+	const ABoardManager* BoardManagerPtr = GetBoardManager(false);
+	if (!BoardManagerPtr)
+	{
+		OutMask.Init(0);
+		return;
+	}
+
+	const FHexGrid& HexGrid = BoardManagerPtr->GetHexGrid();
+	const int32 NumCells = HexGrid.Num();
+
+	OutMask.Init(NumCells);
+
+	const USpellCard* DefaultSpellCard = SpellCard ? SpellCard.GetDefaultObject() : nullptr;
+	const ACSKPlayerState* PlayerState = Controller ? Controller->GetCSKPlayerState() : nullptr;
+	if (!DefaultSpellCard || !PlayerState)
+	{
+		return;
+	}
+
+	TSubclassOf<USpell> Spell = DefaultSpellCard->GetSpellAtIndex(SpellIndex);
+	if (!Spell)
+	{
+		return;
+	}
+
+	const USpell* DefaultSpell = Spell.GetDefaultObject();
+
+	// The static cost doesn't depend on the tile, so we only need to check it once
+	int32 DiscountedMana = 0;
+	if (!PlayerState->GetDiscountedManaIfAffordable(DefaultSpell->GetSpellStaticCost(), DiscountedMana))
+	{
+		return;
+	}
+
+	if (DefaultSpell->UsesCustomTargeting())
+	{
+		// Custom logic can depend on anything, so every tile needs to go through blueprints
+		for (int32 Index = 0; Index < NumCells; ++Index)
+		{
+			const ATile* Tile = HexGrid.GetTileAtIndex(Index);
+			if (Tile && DefaultSpell->CanActivateSpell(PlayerState, Tile))
+			{
+				const int32 FinalCost = DefaultSpell->CalculateFinalCost(PlayerState, Tile, DiscountedMana, AdditionalMana);
+				OutMask.SetValue(Index, PlayerState->HasRequiredMana(FinalCost));
+			}
+		}
+
+		return;
+	}
+
+	DefaultSpell->GetTargetingRulesMask(PlayerState, BoardManagerPtr, OutMask);
+
+	// Cost only differs between tiles if the targeting rules charge by distance
+	if (DefaultSpell->GetTargetingRules().HasCostPerTile())
+	{
+		OutMask.ForEachSetBit([&](int32 Index)
+		{
+			const int32 FinalCost = DefaultSpell->CalculateFinalCost_Implementation(PlayerState, HexGrid.GetTileAtIndex(Index), DiscountedMana, AdditionalMana);
+			OutMask.SetValue(Index, PlayerState->HasRequiredMana(FinalCost));
+		});
+	}
+	else
+	{
+		const int32 FinalCost = DefaultSpell->CalculateFinalCost_Implementation(PlayerState, nullptr, DiscountedMana, AdditionalMana);
+		if (!PlayerState->HasRequiredMana(FinalCost))
+		{
+			OutMask.ClearAll();
+		}
+	}
+}
+
 void ACSKGameState::UpdateRules()
 {
 	// Game mode only exists on the server
@@ -1026,50 +1272,19 @@ bool ACSKGameState::CanPlayerBuildTower(const ACSKPlayerState* PlayerState, TSub
 	ATower* DefaultTower = TowerClass.GetDefaultObject();
 	check(DefaultTower);
 
-	// Different cases depending on if tower is legendary
-	if (DefaultTower->IsLegendaryTower())
-	{
-		// Has player built max amount of legendary towers allowed?
-		if (MaxNumLegendaryTowers > 0 && PlayerState->GetNumLegendaryTowersOwned() >= MaxNumLegendaryTowers)
-		{
-			return false;
-		}
-
-		// There can only be one instance 
-		if (GetTowerInstanceCount(TowerClass) > 0)
-		{
-			return false;
-		}
-	}
-	else
-	{
-		// Has player built the max amount of normal towers allowed?
-		if (MaxNumTowers > 0 && PlayerState->GetNumNormalTowersOwned() >= MaxNumTowers)
-		{
-			return false;
-		}
-
-		int32 TowerInstanceCount = PlayerState->GetNumOwnedTowerDuplicates(TowerClass);
+	FCSKTowerLimits Limits;
+	Limits.MaxNumTowers = MaxNumTowers;
+	Limits.MaxNumDuplicatedTowers = MaxNumDuplicatedTowers;
+	Limits.MaxNumDuplicatedTowerTypes = MaxNumDuplicatedTowerTypes;
+	Limits.MaxNumLegendaryTowers = MaxNumLegendaryTowers;
 
-		// Has player already built the max amount of duplicates for this tower?
-		if (MaxNumDuplicatedTowers > 0 && TowerInstanceCount >= MaxNumDuplicatedTowers)
-		{
-			return false;
-		}
+	// Legendary towers are unique across all players, while duplicates of normal towers are per player
+	const bool bIsLegendary = DefaultTower->IsLegendaryTower();
+	const int32 NumInstances = bIsLegendary ? GetTowerInstanceCount(TowerClass) : PlayerState->GetNumOwnedTowerDuplicates(TowerClass);
 
-		// Has player already created too many duplicates for different towers?
-		if (MaxNumDuplicatedTowerTypes > 0 && PlayerState->GetNumOwnedTowerDuplicateTypes() >= MaxNumDuplicatedTowerTypes)
-		{
-			// Player might be attempting to build duplicate of this building
-			if ((TowerInstanceCount + 1) > 1)
-			{
-				return false;
-			}
-		}
-	}
-
-	// If this point has been reached, it means the player is allowed to build this tower
-	return true;
+	// Shared with the rules engine so simulated matches follow the same limits
+	return FCSKRulesEngine::IsTowerWithinLimits(Limits, bIsLegendary, PlayerState->GetNumNormalTowersOwned(),
+		PlayerState->GetNumLegendaryTowersOwned(), NumInstances, PlayerState->GetNumOwnedTowerDuplicateTypes());
 }
 
 void ACSKGameState::Multi_HandleMoveRequestConfirmed_Implementation()
@@ -1082,7 +1297,7 @@ void ACSKGameState::Multi_HandleMoveRequestFinished_Implementation()
 	
 }
 
-void ACSKGameState::Multi_HandleBuildRequestConfirmed_Implementation(ATile* TargetTile)
+void ACSKGameState::Multi_HandleBuildRequestConfirmed_Implementation(const FNetTileRef& TargetTileRef)
 {
 	
 }
@@ -1108,7 +1323,7 @@ void ACSKGameState::Multi_HandleBuildRequestFinished_Implementation(ATower* NewT
 	}
 }
 
-void ACSKGameState::Multi_HandleSpellRequestConfirmed_Implementation(EActiveSpellContext Context, ATile* TargetTile)
+void ACSKGameState::Multi_HandleSpellRequestConfirmed_Implementation(EActiveSpellContext Context, const FNetTileRef& TargetTileRef)
 {
 
 }
@@ -1143,7 +1358,7 @@ void ACSKGameState::HandleCastleDestroyed(ACSKPlayerController* Controller, ACas
 	{
 		// We want to freeze the timer to prevent timer events from being sent
 		// (There is a chance that custom timer is currently active)
-		bTimerPaused = true;
+		SetTimerPaused(true);
 
 		Multi_HandleCastleDestroyed(Controller->GetCSKPlayerState(), DestroyedCastle);
 	}
@@ -1158,7 +1373,16 @@ void ACSKGameState::HandleTowerDestroyed(ATower* DestroyedTower, bool bByRequest
 	}
 }
 
-void ACSKGameState::Multi_HandlePortalReached_Implementation(ACSKPlayerState* Player, ATile* ReachedPortal)
+void ACSKGameState::HandleTowerRestored(ATower* RestoredTower)
+{
+	if (HasAuthority())
+	{
+		// Restored towers skip the build sequence, but clients still need to count them
+		Multi_HandleBuildRequestFinished(RestoredTower);
+	}
+}
+
+void ACSKGameState::Multi_HandlePortalReached_Implementation(ACSKPlayerState* Player, const FNetTileRef& ReachedPortalRef)
 {
 }
 
@@ -1209,3 +1433,64 @@ float ACSKGameState::GetMatchTimeSeconds() const
 
 	return 0.f;
 }
+
+uint64 ACSKGameState::GetMatchHash() const
+{
+	const ABoardManager* BoardManagerPtr = GetBoardManager(false);
+	if (!BoardManagerPtr || !BoardManagerPtr->AreBitboardsValid())
+	{
+		return 0;
+	}
+
+	uint64 Hash = BoardManagerPtr->GetBoardHash();
+
+	const FHexGrid& HexGrid = BoardManagerPtr->GetHexGrid();
+	BoardManagerPtr->GetOccupiedBitboard().ForEachSetBit([&Hash, &HexGrid](int32 Index)
+	{
+		const ATile* Tile = HexGrid.GetTileAtIndex(Index);
+		const IBoardPieceInterface* BoardPiece = Tile ? Cast<IBoardPieceInterface>(Tile->GetBoardPiece()) : nullptr;
+		const UHealthComponent* HealthComp = BoardPiece ? BoardPiece->GetHealthComponent() : nullptr;
+
+		if (HealthComp)
+		{
+			FCSKZobrist::Toggle(Hash, ECSKHashFeature::Health, Index, HealthComp->GetHealth());
+		}
+	});
+
+	for (int32 PlayerID = 0; PlayerID < CSK_MAX_NUM_PLAYERS; ++PlayerID)
+	{
+		if (const ACSKPlayerState* PlayerState = GetPlayerStateWithID(PlayerID))
+		{
+			FCSKZobrist::Toggle(Hash, ECSKHashFeature::Gold, PlayerID, PlayerState->GetGold());
+			FCSKZobrist::Toggle(Hash, ECSKHashFeature::Mana, PlayerID, PlayerState->GetMana());
+		}
+	}
+
+	FCSKZobrist::Toggle(Hash, ECSKHashFeature::Round, 0, RoundsPlayed);
+	FCSKZobrist::Toggle(Hash, ECSKHashFeature::RoundState, 0, static_cast<int32>(RoundState));
+
+	return Hash;
+}
+
+#if !UE_BUILD_SHIPPING
+
+/** Logs the match hash of this machine, to compare against the hashes logged by other machines */
+static void PrintMatchHash(const TArray<FString>& Args, UWorld* World)
+{
+	const ACSKGameState* GameState = World ? UConquestFunctionLibrary::GetCSKGameState(World) : nullptr;
+	if (!GameState || !GameState->GetBoardManager(false))
+	{
+		UE_LOG(LogConquest, Warning, TEXT("CSK.Hash.Print: Can only be used during a match"));
+		return;
+	}
+
+	UE_LOG(LogConquest, Display, TEXT("CSK.Hash.Print: Round %i, match hash %016llx, board hash %016llx"),
+		GameState->GetRound(), GameState->GetMatchHash(), GameState->GetBoardManager()->GetBoardHash());
+}
+
+static FAutoConsoleCommandWithWorldAndArgs PrintMatchHashCommand(
+	TEXT("CSK.Hash.Print"),
+	TEXT("Logs the hash of the match as seen by this machine. Usage: CSK.Hash.Print"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&PrintMatchHash));
+
+#endif
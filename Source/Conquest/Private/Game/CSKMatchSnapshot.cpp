@@ -0,0 +1,574 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CSKMatchSnapshot.h"
+#include "CSKBinaryStream.h"
+#include "CSKGameMode.h"
+
+#include "SpellCard.h"
+#include "TowerConstructionData.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/SoftObjectPath.h"
+
+DECLARE_CYCLE_STAT(TEXT("MatchSnapshot Serialize"), STAT_MatchSnapshotSerialize, STATGROUP_Conquest);
+DECLARE_CYCLE_STAT(TEXT("MatchSnapshot Deserialize"), STAT_MatchSnapshotDeserialize, STATGROUP_Conquest);
+
+namespace
+{
+	/** Identifies a snapshot file, followed by the version */
+	const uint8 SnapshotMagic[4] = { 'C', 'S', 'K', 'S' };
+	const uint32 SnapshotVersion = 1;
+
+	/** Table of classes referenced by a snapshot. Indices are offset by one so null is zero */
+	class FSnapshotClassTable
+	{
+	public:
+
+		uint32 GetIndex(const UClass* Class)
+		{
+			if (!Class)
+			{
+				return 0;
+			}
+
+			const int32* Index = Indices.Find(Class);
+			if (Index)
+			{
+				return *Index + 1;
+			}
+
+			const int32 NewIndex = Classes.Add(Class);
+			Indices.Add(Class, NewIndex);
+
+			return NewIndex + 1;
+		}
+
+	public:
+
+		TArray<const UClass*> Classes;
+		TMap<const UClass*, int32> Indices;
+	};
+
+	/** Reads a class index, rejecting classes that are not of type T */
+	template <typename T>
+	bool ReadClass(FCSKBinaryReader& Reader, const TArray<UClass*>& Classes, TSubclassOf<T>& OutClass)
+	{
+		const uint32 Index = Reader.ReadUnsigned();
+		if (Index == 0)
+		{
+			OutClass = nullptr;
+			return true;
+		}
+
+		if (Index > static_cast<uint32>(Classes.Num()) || !Classes[Index - 1]->IsChildOf(T::StaticClass()))
+		{
+			return false;
+		}
+
+		OutClass = Classes[Index - 1];
+		return true;
+	}
+
+	void WriteSpellCards(FCSKBinaryWriter& Writer, FSnapshotClassTable& Table, const TArray<TSubclassOf<USpellCard>>& SpellCards)
+	{
+		Writer.WriteUnsigned(SpellCards.Num());
+		for (TSubclassOf<USpellCard> SpellCard : SpellCards)
+		{
+			Writer.WriteUnsigned(Table.GetIndex(SpellCard.Get()));
+		}
+	}
+
+	bool ReadSpellCards(FCSKBinaryReader& Reader, const TArray<UClass*>& Classes, TArray<TSubclassOf<USpellCard>>& OutSpellCards)
+	{
+		const int32 NumSpellCards = Reader.ReadCount();
+		OutSpellCards.SetNum(NumSpellCards);
+
+		for (TSubclassOf<USpellCard>& SpellCard : OutSpellCards)
+		{
+			if (!ReadClass(Reader, Classes, SpellCard))
+			{
+				return false;
+			}
+		}
+
+		return !Reader.HasError();
+	}
+
+	void WritePlayer(FCSKBinaryWriter& Writer, FSnapshotClassTable& Table, const FCSKPlayerSnapshot& Player)
+	{
+		Writer.WriteSigned(Player.Gold);
+		Writer.WriteSigned(Player.Mana);
+		Writer.WriteSigned(Player.BonusTileMovements);
+		Writer.WriteSigned(Player.MaxNumSpellUses);
+		Writer.WriteByte(Player.bHasInfiniteSpellUses ? 1 : 0);
+		Writer.WriteSigned(Player.SpellDiscount);
+
+		Writer.WriteSigned(Player.TilesTraversedThisRound);
+		Writer.WriteSigned(Player.SpellsCastThisRound);
+
+		Writer.WriteSigned(Player.TotalGoldCollected);
+		Writer.WriteSigned(Player.TotalManaCollected);
+		Writer.WriteSigned(Player.TotalTilesTraversed);
+		Writer.WriteSigned(Player.TotalTowersBuilt);
+		Writer.WriteSigned(Player.TotalLegendaryTowersBuilt);
+		Writer.WriteSigned(Player.TotalSpellsCast);
+		Writer.WriteSigned(Player.TotalQuickEffectSpellsCast);
+
+		Writer.WriteByte(static_cast<uint8>(Player.RemainingActions));
+
+		Writer.WriteUnsigned(Player.CastleCell + 1);
+		Writer.WriteSigned(Player.CastleHealth);
+		Writer.WriteSigned(Player.CastleMaxHealth);
+
+		WriteSpellCards(Writer, Table, Player.SpellCardDeck);
+		WriteSpellCards(Writer, Table, Player.SpellCardsInHand);
+		WriteSpellCards(Writer, Table, Player.SpellCardsDiscarded);
+	}
+
+	bool ReadPlayer(FCSKBinaryReader& Reader, const TArray<UClass*>& Classes, int32 NumCells, FCSKPlayerSnapshot& Player)
+	{
+		Player.Gold = Reader.ReadSigned();
+		Player.Mana = Reader.ReadSigned();
+		Player.BonusTileMovements = Reader.ReadSigned();
+		Player.MaxNumSpellUses = Reader.ReadSigned();
+		Player.bHasInfiniteSpellUses = Reader.ReadByte() != 0;
+		Player.SpellDiscount = Reader.ReadSigned();
+
+		Player.TilesTraversedThisRound = Reader.ReadSigned();
+		Player.SpellsCastThisRound = Reader.ReadSigned();
+
+		Player.TotalGoldCollected = Reader.ReadSigned();
+		Player.TotalManaCollected = Reader.ReadSigned();
+		Player.TotalTilesTraversed = Reader.ReadSigned();
+		Player.TotalTowersBuilt = Reader.ReadSigned();
+		Player.TotalLegendaryTowersBuilt = Reader.ReadSigned();
+		Player.TotalSpellsCast = Reader.ReadSigned();
+		Player.TotalQuickEffectSpellsCast = Reader.ReadSigned();
+
+		Player.RemainingActions = static_cast<ECSKActionPhaseMode>(Reader.ReadByte()) & ECSKActionPhaseMode::All;
+
+		Player.CastleCell = static_cast<int32>(Reader.ReadUnsigned()) - 1;
+		Player.CastleHealth = Reader.ReadSigned();
+		Player.CastleMaxHealth = Reader.ReadSigned();
+
+		if (Player.CastleCell < 0 || Player.CastleCell >= NumCells)
+		{
+			return false;
+		}
+
+		return ReadSpellCards(Reader, Classes, Player.SpellCardDeck) &&
+			ReadSpellCards(Reader, Classes, Player.SpellCardsInHand) &&
+			ReadSpellCards(Reader, Classes, Player.SpellCardsDiscarded);
+	}
+}
+
+FCSKMatchSnapshot::FCSKMatchSnapshot()
+{
+	Reset();
+}
+
+void FCSKMatchSnapshot::Reset()
+{
+	Rows = 0;
+	Columns = 0;
+	NullCells.Init(0);
+	TileElements.Reset();
+	Round = 0;
+	RoundState = ECSKRoundState::Invalid;
+	StartingPlayer = 0;
+	DeckReshuffleSeed = 0;
+	TimerState = ECSKTimerState::None;
+	TimeRemaining = 0;
+	ActionPhaseTimeRemaining = 0;
+
+	for (FCSKPlayerSnapshot& Player : Players)
+	{
+		Player = FCSKPlayerSnapshot();
+	}
+
+	Towers.Reset();
+	PendingSpell = FCSKPendingSpellSnapshot();
+}
+
+void FCSKMatchSnapshot::Serialize(TArray<uint8>& OutBytes) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_MatchSnapshotSerialize);
+
+	check(NullCells.Num() == NumCells() && TileElements.Num() == NumCells());
+
+	// Classes are only known once everything else has been written,
+	// so the body is written first then placed after the class table
+	FSnapshotClassTable Table;
+
+	TArray<uint8> Body;
+	Body.Reserve(NumCells() + 256);
+
+	FCSKBinaryWriter BodyWriter(Body);
+
+	// Null cells are written in ascending order, so we only need the gap between them
+	BodyWriter.WriteUnsigned(NullCells.CountSetBits());
+
+	int32 PreviousCell = 0;
+	NullCells.ForEachSetBit([&BodyWriter, &PreviousCell](int32 Cell)
+	{
+		BodyWriter.WriteUnsigned(Cell - PreviousCell);
+		PreviousCell = Cell;
+	});
+
+	// Elements only use the lower four bits, so we can pack two per byte
+	for (int32 Cell = 0; Cell < TileElements.Num(); Cell += 2)
+	{
+		const uint8 Low = static_cast<uint8>(TileElements[Cell]) & 0x0F;
+		const uint8 High = Cell + 1 < TileElements.Num() ? static_cast<uint8>(TileElements[Cell + 1]) & 0x0F : 0;
+
+		BodyWriter.WriteByte(Low | (High << 4));
+	}
+
+	BodyWriter.WriteSigned(Round);
+	BodyWriter.WriteByte(static_cast<uint8>(RoundState));
+	BodyWriter.WriteUnsigned(StartingPlayer);
+	BodyWriter.WriteSigned(DeckReshuffleSeed);
+	BodyWriter.WriteByte(static_cast<uint8>(TimerState));
+	BodyWriter.WriteSigned(TimeRemaining);
+	BodyWriter.WriteSigned(ActionPhaseTimeRemaining);
+
+	for (const FCSKPlayerSnapshot& Player : Players)
+	{
+		WritePlayer(BodyWriter, Table, Player);
+	}
+
+	BodyWriter.WriteUnsigned(Towers.Num());
+	for (const FCSKTowerSnapshot& Tower : Towers)
+	{
+		BodyWriter.WriteUnsigned(Table.GetIndex(Tower.ConstructData.Get()));
+		BodyWriter.WriteByte(Tower.Owner);
+		BodyWriter.WriteUnsigned(Tower.Cell + 1);
+		BodyWriter.WriteSigned(Tower.Health);
+		BodyWriter.WriteSigned(Tower.MaxHealth);
+	}
+
+	BodyWriter.WriteByte(PendingSpell.bIsSet ? 1 : 0);
+	if (PendingSpell.bIsSet)
+	{
+		BodyWriter.WriteUnsigned(Table.GetIndex(PendingSpell.SpellCard.Get()));
+		BodyWriter.WriteUnsigned(PendingSpell.SpellIndex);
+		BodyWriter.WriteUnsigned(PendingSpell.TargetCell + 1);
+		BodyWriter.WriteSigned(PendingSpell.CalculatedCost);
+		BodyWriter.WriteSigned(PendingSpell.AdditionalMana);
+	}
+
+	OutBytes.Reset(Body.Num() + 64 * Table.Classes.Num() + 16);
+	FCSKBinaryWriter Writer(OutBytes);
+
+	for (uint8 Byte : SnapshotMagic)
+	{
+		Writer.WriteByte(Byte);
+	}
+
+	Writer.WriteUnsigned(SnapshotVersion);
+	Writer.WriteUnsigned(Rows);
+	Writer.WriteUnsigned(Columns);
+
+	Writer.WriteUnsigned(Table.Classes.Num());
+	for (const UClass* Class : Table.Classes)
+	{
+		Writer.WriteString(Class->GetPathName());
+	}
+
+	OutBytes.Append(Body);
+}
+
+bool FCSKMatchSnapshot::Deserialize(const TArray<uint8>& Bytes)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MatchSnapshotDeserialize);
+
+	Reset();
+
+	FCSKBinaryReader Reader(Bytes);
+
+	for (uint8 Byte : SnapshotMagic)
+	{
+		if (Reader.ReadByte() != Byte)
+		{
+			UE_LOG(LogConquest, Warning, TEXT("FCSKMatchSnapshot::Deserialize: Data is not a match snapshot"));
+			return false;
+		}
+	}
+
+	const uint32 Version = Reader.ReadUnsigned();
+	if (Version != SnapshotVersion)
+	{
+		UE_LOG(LogConquest, Warning, TEXT("FCSKMatchSnapshot::Deserialize: Snapshot is version %u, only version %u is supported"), Version, SnapshotVersion);
+		return false;
+	}
+
+	auto Fail = [this](const TCHAR* Reason)
+	{
+		UE_LOG(LogConquest, Warning, TEXT("FCSKMatchSnapshot::Deserialize: Snapshot is malformed (%s)"), Reason);
+
+		Reset();
+		return false;
+	};
+
+	Rows = Reader.ReadUnsigned();
+	Columns = Reader.ReadUnsigned();
+	if (Reader.HasError() || Rows <= 0 || Columns <= 0 || Rows > MAX_int16 || Columns > MAX_int16 || Rows * Columns > MAX_int16)
+	{
+		return Fail(TEXT("invalid board"));
+	}
+
+	const int32 NumClasses = Reader.ReadCount();
+
+	TArray<UClass*> Classes;
+	Classes.Reserve(NumClasses);
+
+	for (int32 i = 0; i < NumClasses; ++i)
+	{
+		const FString ClassPath = Reader.ReadString();
+
+		UClass* Class = Reader.HasError() ? nullptr : FSoftClassPath(ClassPath).TryLoadClass<UObject>();
+		if (!Class)
+		{
+			UE_LOG(LogConquest, Warning, TEXT("FCSKMatchSnapshot::Deserialize: Unable to find class %s"), *ClassPath);
+			return Fail(TEXT("unknown class"));
+		}
+
+		Classes.Add(Class);
+	}
+
+	NullCells.Init(NumCells());
+
+	const int32 NumNullCells = Reader.ReadCount();
+
+	int32 Cell = 0;
+	for (int32 i = 0; i < NumNullCells; ++i)
+	{
+		const uint32 Gap = Reader.ReadUnsigned();
+		if (Reader.HasError() || Gap >= static_cast<uint32>(NumCells() - Cell))
+		{
+			return Fail(TEXT("invalid null tile"));
+		}
+
+		Cell += Gap;
+		NullCells.Set(Cell);
+	}
+
+	TileElements.SetNumUninitialized(NumCells());
+	for (Cell = 0; Cell < TileElements.Num(); Cell += 2)
+	{
+		const uint8 Packed = Reader.ReadByte();
+
+		TileElements[Cell] = static_cast<ECSKElementType>(Packed & 0x0F);
+		if (Cell + 1 < TileElements.Num())
+		{
+			TileElements[Cell + 1] = static_cast<ECSKElementType>(Packed >> 4);
+		}
+	}
+
+	Round = Reader.ReadSigned();
+	RoundState = static_cast<ECSKRoundState>(Reader.ReadByte());
+	StartingPlayer = Reader.ReadUnsigned();
+	DeckReshuffleSeed = Reader.ReadSigned();
+	TimerState = static_cast<ECSKTimerState>(Reader.ReadByte());
+	TimeRemaining = Reader.ReadSigned();
+	ActionPhaseTimeRemaining = Reader.ReadSigned();
+
+	if (RoundState != ECSKRoundState::FirstActionPhase && RoundState != ECSKRoundState::SecondActionPhase)
+	{
+		return Fail(TEXT("not captured during an action phase"));
+	}
+
+	if (StartingPlayer < 0 || StartingPlayer >= CSK_MAX_NUM_PLAYERS || TimerState > ECSKTimerState::None)
+	{
+		return Fail(TEXT("invalid round"));
+	}
+
+	for (FCSKPlayerSnapshot& Player : Players)
+	{
+		if (!ReadPlayer(Reader, Classes, NumCells(), Player))
+		{
+			return Fail(TEXT("invalid player"));
+		}
+	}
+
+	const int32 NumTowers = Reader.ReadCount();
+	if (NumTowers > NumCells())
+	{
+		return Fail(TEXT("too many towers"));
+	}
+
+	Towers.SetNum(NumTowers);
+	for (FCSKTowerSnapshot& Tower : Towers)
+	{
+		const bool bValidClass = ReadClass(Reader, Classes, Tower.ConstructData);
+
+		Tower.Owner = Reader.ReadByte();
+		Tower.Cell = static_cast<int32>(Reader.ReadUnsigned()) - 1;
+		Tower.Health = Reader.ReadSigned();
+		Tower.MaxHealth = Reader.ReadSigned();
+
+		if (!bValidClass || !Tower.ConstructData || Tower.Owner >= CSK_MAX_NUM_PLAYERS || Tower.Cell < 0 || Tower.Cell >= NumCells())
+		{
+			return Fail(TEXT("invalid tower"));
+		}
+	}
+
+	PendingSpell.bIsSet = Reader.ReadByte() != 0;
+	if (PendingSpell.bIsSet)
+	{
+		const bool bValidClass = ReadClass(Reader, Classes, PendingSpell.SpellCard);
+
+		PendingSpell.SpellIndex = Reader.ReadUnsigned();
+		PendingSpell.TargetCell = static_cast<int32>(Reader.ReadUnsigned()) - 1;
+		PendingSpell.CalculatedCost = Reader.ReadSigned();
+		PendingSpell.AdditionalMana = Reader.ReadSigned();
+
+		if (!bValidClass || !PendingSpell.SpellCard || PendingSpell.TargetCell < 0 || PendingSpell.TargetCell >= NumCells())
+		{
+			return Fail(TEXT("invalid pending spell"));
+		}
+	}
+
+	if (Reader.HasError())
+	{
+		return Fail(TEXT("unexpected end of data"));
+	}
+
+	return true;
+}
+
+bool FCSKMatchSnapshot::SaveToFile(const FString& Filename) const
+{
+	const FString Path = FPaths::IsRelative(Filename) ? GetSnapshotDirectory() / Filename : Filename;
+
+	TArray<uint8> Bytes;
+	Serialize(Bytes);
+
+	if (!FFileHelper::SaveArrayToFile(Bytes, *Path))
+	{
+		UE_LOG(LogConquest, Warning, TEXT("FCSKMatchSnapshot::SaveToFile: Failed to save snapshot to %s"), *Path);
+		return false;
+	}
+
+	UE_LOG(LogConquest, Log, TEXT("FCSKMatchSnapshot: Saved snapshot (%i bytes) to %s"), Bytes.Num(), *Path);
+	return true;
+}
+
+bool FCSKMatchSnapshot::LoadFromFile(const FString& Filename)
+{
+	const FString Path = FPaths::IsRelative(Filename) ? GetSnapshotDirectory() / Filename : Filename;
+
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Path))
+	{
+		UE_LOG(LogConquest, Warning, TEXT("FCSKMatchSnapshot::LoadFromFile: Failed to load snapshot from %s"), *Path);
+		return false;
+	}
+
+	return Deserialize(Bytes);
+}
+
+FString FCSKMatchSnapshot::GetSnapshotDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Snapshots");
+}
+
+#if !UE_BUILD_SHIPPING
+
+/** Captures the match in progress and saves it to file */
+static void SaveMatchSnapshot(const TArray<FString>& Args, UWorld* World)
+{
+	ACSKGameMode* GameMode = World ? UConquestFunctionLibrary::GetCSKGameMode(World) : nullptr;
+	if (!GameMode)
+	{
+		UE_LOG(LogConquest, Warning, TEXT("CSK.Snapshot.Save: Can only be used by the server during a match"));
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	FCSKMatchSnapshot Snapshot;
+	if (!GameMode->CaptureMatchSnapshot(Snapshot))
+	{
+		UE_LOG(LogConquest, Warning, TEXT("CSK.Snapshot.Save: Snapshots can only be captured during an action phase while no action is being performed"));
+		return;
+	}
+
+	const double CaptureTime = FPlatformTime::Seconds();
+
+	TArray<uint8> Bytes;
+	Snapshot.Serialize(Bytes);
+
+	const double SerializeTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogConquest, Display, TEXT("MatchSnapshot: Captured in %.3f ms, serialized %i bytes in %.3f ms"),
+		(CaptureTime - StartTime) * 1000.0, Bytes.Num(), (SerializeTime - CaptureTime) * 1000.0);
+
+	const FString Filename = Args.Num() > 0 ? Args[0] : FString::Printf(TEXT("Snapshot_%s.csks"), *FDateTime::Now().ToString());
+	const FString Path = FPaths::IsRelative(Filename) ? FCSKMatchSnapshot::GetSnapshotDirectory() / Filename : Filename;
+
+	if (!FFileHelper::SaveArrayToFile(Bytes, *Path))
+	{
+		UE_LOG(LogConquest, Warning, TEXT("CSK.Snapshot.Save: Failed to save snapshot to %s"), *Path);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SaveMatchSnapshotCommand(
+	TEXT("CSK.Snapshot.Save"),
+	TEXT("Captures the match in progress and saves it to file. Usage: CSK.Snapshot.Save [Filename]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SaveMatchSnapshot));
+
+/** Loads a snapshot from file and applies it to the match in progress */
+static void LoadMatchSnapshot(const TArray<FString>& Args, UWorld* World)
+{
+	if (Args.Num() < 1)
+	{
+		UE_LOG(LogConquest, Display, TEXT("Usage: CSK.Snapshot.Load <Filename>"));
+		return;
+	}
+
+	ACSKGameMode* GameMode = World ? UConquestFunctionLibrary::GetCSKGameMode(World) : nullptr;
+	if (!GameMode)
+	{
+		UE_LOG(LogConquest, Warning, TEXT("CSK.Snapshot.Load: Can only be used by the server during a match"));
+		return;
+	}
+
+	const FString Path = FPaths::IsRelative(Args[0]) ? FCSKMatchSnapshot::GetSnapshotDirectory() / Args[0] : Args[0];
+
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Path))
+	{
+		UE_LOG(LogConquest, Warning, TEXT("CSK.Snapshot.Load: Failed to load snapshot from %s"), *Path);
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	FCSKMatchSnapshot Snapshot;
+	if (!Snapshot.Deserialize(Bytes))
+	{
+		return;
+	}
+
+	const double DeserializeTime = FPlatformTime::Seconds();
+
+	if (!GameMode->ApplyMatchSnapshot(Snapshot))
+	{
+		UE_LOG(LogConquest, Warning, TEXT("CSK.Snapshot.Load: Snapshot could not be applied to the match in progress"));
+		return;
+	}
+
+	const double ApplyTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogConquest, Display, TEXT("MatchSnapshot: Deserialized %i bytes in %.3f ms, applied in %.3f ms"),
+		Bytes.Num(), (DeserializeTime - StartTime) * 1000.0, (ApplyTime - DeserializeTime) * 1000.0);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs LoadMatchSnapshotCommand(
+	TEXT("CSK.Snapshot.Load"),
+	TEXT("Applies a saved snapshot to the match in progress. Usage: CSK.Snapshot.Load <Filename>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&LoadMatchSnapshot));
+
+#endif
@@ -0,0 +1,576 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CSKMonteCarloSearch.h"
+#include "CSKZobrist.h"
+
+#include "HAL/Event.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/QueuedThreadPool.h"
+
+DECLARE_CYCLE_STAT(TEXT("MonteCarloSearch Search"), STAT_MonteCarloSearch, STATGROUP_Conquest);
+
+FQueuedThreadPool* FCSKMonteCarloSearch::ThreadPool = nullptr;
+
+namespace
+{
+	/** Single node of a search tree */
+	struct FSearchNode
+	{
+		/** Action used to reach this node */
+		FCSKRulesAction Action;
+
+		/** Index of first child, INDEX_NONE if not yet expanded */
+		int32 FirstChild;
+
+		/** Amount of children */
+		int32 NumChildren;
+
+		/** Amount of times this node has been visited */
+		int32 Visits;
+
+		/** Sum of results for player who performed action */
+		float Value;
+
+		/** Player who performed action */
+		int32 Player;
+
+		/** Hash of the state this node was last reached in, zero if not yet reached */
+		uint64 Hash;
+	};
+
+	/** Tree grown by a single thread */
+	struct FSearchTree
+	{
+		TArray<FSearchNode> Nodes;
+		int64 NumRollouts = 0;
+		int64 NumTranspositionHits = 0;
+	};
+
+	/** Work for growing a single tree on the search thread pool */
+	class FGrowTreeWork : public IQueuedWork
+	{
+	public:
+
+		FGrowTreeWork(TFunction<void()>&& InFunction)
+			: Function(MoveTemp(InFunction))
+			, DoneEvent(FPlatformProcess::GetSynchEventFromPool(true))
+		{
+
+		}
+
+		virtual ~FGrowTreeWork()
+		{
+			FPlatformProcess::ReturnSynchEventToPool(DoneEvent);
+		}
+
+		// Begin IQueuedWork Interface
+		virtual void DoThreadedWork() override
+		{
+			Function();
+			DoneEvent->Trigger();
+		}
+
+		virtual void Abandon() override
+		{
+			DoneEvent->Trigger();
+		}
+		// End IQueuedWork Interface
+
+		/** Blocks until work has either been done or abandoned */
+		void Wait()
+		{
+			DoneEvent->Wait();
+		}
+
+	private:
+
+		/** Function that grows the tree */
+		TFunction<void()> Function;
+
+		/** Event triggered once finished */
+		FEvent* DoneEvent;
+	};
+
+	/** Work for running an entire search on the search thread pool. This deletes itself once finished */
+	class FSearchWork : public IQueuedWork
+	{
+	public:
+
+		FSearchWork(TFunction<FCSKSearchResult()>&& InFunction)
+			: Function(MoveTemp(InFunction))
+		{
+
+		}
+
+		// Begin IQueuedWork Interface
+		virtual void DoThreadedWork() override
+		{
+			Promise.SetValue(Function());
+			delete this;
+		}
+
+		virtual void Abandon() override
+		{
+			Promise.SetValue(FCSKSearchResult());
+			delete this;
+		}
+		// End IQueuedWork Interface
+
+		/** Get the future for the result of the search. Should only be called once */
+		TFuture<FCSKSearchResult> GetFuture()
+		{
+			return Promise.GetFuture();
+		}
+
+	private:
+
+		/** Function that runs the search */
+		TFunction<FCSKSearchResult()> Function;
+
+		/** Promise fulfilled once finished */
+		TPromise<FCSKSearchResult> Promise;
+	};
+
+	/** Grows tree from root until time or iterations run out. Table is shared with every other thread (if set) */
+	void GrowTree(const FCSKRulesEngine& Engine, const FCSKRulesState& Root, const FCSKSearchSettings& Settings,
+		double EndTime, int32 ThreadIndex, const TAtomic<bool>* bCancelled, FCSKTranspositionTable* Table, FSearchTree& Tree)
+	{
+		const FCSKRules& Rules = Engine.GetRules();
+		const int32 MaxRound = Root.Round + Settings.MaxRolloutRounds;
+
+		FRandomStream Stream(Settings.Seed + ThreadIndex * 7919);
+
+		TArray<FSearchNode>& Nodes = Tree.Nodes;
+		Nodes.Reset();
+		Nodes.Reserve(FMath::Min(Settings.MaxNodesPerThread, 4096));
+		Nodes.Add({ FCSKRulesAction(), INDEX_NONE, 0, 0, 0.f, INDEX_NONE, 0 });
+
+		TArray<int32, TInlineAllocator<64>> Path;
+		TArray<FCSKRulesAction> Actions;
+		FCSKRulesState State;
+
+		for (int32 Iteration = 0; Settings.MaxIterations <= 0 || Iteration < Settings.MaxIterations; ++Iteration)
+		{
+			// Checking time is not free, but is insignificant compared to a rollout
+			if (FPlatformTime::Seconds() >= EndTime || (bCancelled && *bCancelled))
+			{
+				break;
+			}
+
+			State = Root;
+
+			// The order of decks is hidden from players, so every iteration assumes a different shuffle
+			State.DeckReshuffleStream.Initialize(Stream.RandHelper(MAX_int32));
+
+			Path.Reset();
+			Path.Add(0);
+
+			// Selection
+			int32 NodeIndex = 0;
+			while (Nodes[NodeIndex].FirstChild != INDEX_NONE && Nodes[NodeIndex].NumChildren > 0)
+			{
+				const FSearchNode& Node = Nodes[NodeIndex];
+				const float LogVisits = FMath::Loge(static_cast<float>(FMath::Max(1, Node.Visits)));
+
+				int32 BestChild = INDEX_NONE;
+				float BestScore = -MAX_flt;
+
+				for (int32 Child = Node.FirstChild; Child < Node.FirstChild + Node.NumChildren; ++Child)
+				{
+					const FSearchNode& ChildNode = Nodes[Child];
+					if (ChildNode.Visits == 0)
+					{
+						BestChild = Child;
+						break;
+					}
+
+					float Mean = ChildNode.Value / ChildNode.Visits;
+
+					// Prefer the shared statistics if they have seen more of this state than we have. Exploration
+					// still uses our own visits, otherwise we would never explore states other threads have found
+					int32 SharedVisits;
+					float SharedValue;
+					if (Table && ChildNode.Hash != 0 && Table->Probe(ChildNode.Hash, SharedVisits, SharedValue) && SharedVisits > ChildNode.Visits)
+					{
+						// Shared values are always for the first player
+						const float SharedMean = SharedValue / SharedVisits;
+						Mean = ChildNode.Player == 0 ? SharedMean : 1.f - SharedMean;
+
+						++Tree.NumTranspositionHits;
+					}
+
+					const float Score = Mean + Settings.ExplorationConstant * FMath::Sqrt(LogVisits / ChildNode.Visits);
+
+					if (Score > BestScore)
+					{
+						BestScore = Score;
+						BestChild = Child;
+					}
+				}
+
+				// Hands might differ from when this node was expanded, as each iteration shuffles decks differently
+				if (!Engine.ApplyAction(State, Nodes[BestChild].Action))
+				{
+					break;
+				}
+
+				NodeIndex = BestChild;
+				Path.Add(NodeIndex);
+
+				if (Table)
+				{
+					Nodes[NodeIndex].Hash = FCSKRulesEngine::HashState(State);
+				}
+
+				if (Nodes[NodeIndex].Visits == 0)
+				{
+					break;
+				}
+			}
+
+			// Expansion (tree might be full, in which case we only rollout)
+			if (Nodes[NodeIndex].FirstChild == INDEX_NONE && !State.IsMatchOver())
+			{
+				Engine.GetLegalActions(State, Actions);
+				if (NodeIndex == 0)
+				{
+					Actions.RemoveAll([&Settings](const FCSKRulesAction& Action) { return Settings.ExcludedActions.Contains(Action); });
+				}
+
+				if (Nodes.Num() + Actions.Num() <= Settings.MaxNodesPerThread)
+				{
+					const int32 FirstChild = Nodes.Num();
+					for (const FCSKRulesAction& Action : Actions)
+					{
+						Nodes.Add({ Action, INDEX_NONE, 0, 0, 0.f, State.ActivePlayer, 0 });
+					}
+
+					// Nodes may have been reallocated
+					Nodes[NodeIndex].FirstChild = FirstChild;
+					Nodes[NodeIndex].NumChildren = Actions.Num();
+
+					if (Actions.Num() > 0)
+					{
+						const int32 Child = FirstChild + Stream.RandHelper(Actions.Num());
+						verify(Engine.ApplyAction(State, Nodes[Child].Action));
+
+						NodeIndex = Child;
+						Path.Add(NodeIndex);
+
+						if (Table)
+						{
+							Nodes[NodeIndex].Hash = FCSKRulesEngine::HashState(State);
+						}
+					}
+				}
+			}
+
+			// Rollout
+			while (!State.IsMatchOver() && State.Round <= MaxRound)
+			{
+				Engine.GetLegalActions(State, Actions);
+				if (Actions.Num() == 0)
+				{
+					if (State.ActivePlayer == INDEX_NONE)
+					{
+						break;
+					}
+
+					// Player is stuck, in the game they would have to wait for the action phase to time out
+					Engine.TimeOutActionPhase(State);
+					continue;
+				}
+
+				verify(Engine.ApplyAction(State, Actions[Stream.RandHelper(Actions.Num())]));
+			}
+
+			++Tree.NumRollouts;
+
+			// Backpropagation
+			float Results[CSK_MAX_NUM_PLAYERS];
+			for (int32 PlayerID = 0; PlayerID < CSK_MAX_NUM_PLAYERS; ++PlayerID)
+			{
+				Results[PlayerID] = FCSKMonteCarloSearch::EvaluateState(Rules, State, PlayerID);
+			}
+
+			for (int32 Index : Path)
+			{
+				FSearchNode& Node = Nodes[Index];
+				++Node.Visits;
+
+				if (Node.Player != INDEX_NONE)
+				{
+					Node.Value += Results[Node.Player];
+				}
+
+				if (Table && Node.Hash != 0)
+				{
+					Table->Add(Node.Hash, 1, Results[0]);
+				}
+			}
+		}
+	}
+}
+
+FCSKSearchResult FCSKMonteCarloSearch::Search(const FCSKRulesEngine& Engine, const FCSKRulesState& State,
+	const FCSKSearchSettings& Settings, const TAtomic<bool>* bCancelled)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MonteCarloSearch);
+
+	FCSKSearchResult Result;
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 PlayerID = State.ActivePlayer;
+
+	TArray<FCSKRulesAction> RootActions;
+	Engine.GetLegalActions(State, RootActions);
+	RootActions.RemoveAll([&Settings](const FCSKRulesAction& Action) { return Settings.ExcludedActions.Contains(Action); });
+
+	if (RootActions.Num() == 0)
+	{
+		return Result;
+	}
+
+	Result.bFoundAction = true;
+
+	// No need to search if there is only one option
+	if (RootActions.Num() == 1)
+	{
+		Result.BestAction = RootActions[0];
+		return Result;
+	}
+
+	// Threads grow their trees for the entire time budget, so we can't queue more than there are threads
+	const int32 MaxThreads = GetMaxThreads();
+	const int32 NumThreads = Settings.NumThreads > 0 ? FMath::Min(Settings.NumThreads, MaxThreads) : MaxThreads;
+	const double EndTime = StartTime + Settings.TimeBudget;
+
+	TArray<FSearchTree> Trees;
+	Trees.SetNum(NumThreads);
+
+	TUniquePtr<FCSKTranspositionTable> Table;
+	if (Settings.TranspositionTableSize > 0)
+	{
+		Table = MakeUnique<FCSKTranspositionTable>(Settings.TranspositionTableSize);
+	}
+
+	auto GrowTreeForThread = [&](int32 ThreadIndex)
+	{
+		GrowTree(Engine, State, Settings, EndTime, ThreadIndex, bCancelled, Table.Get(), Trees[ThreadIndex]);
+	};
+
+	// The calling thread grows the first tree while pooled threads grow the rest
+	TArray<TUniquePtr<FGrowTreeWork>> Work;
+	for (int32 ThreadIndex = 1; ThreadIndex < NumThreads; ++ThreadIndex)
+	{
+		Work.Add(MakeUnique<FGrowTreeWork>([&GrowTreeForThread, ThreadIndex]() { GrowTreeForThread(ThreadIndex); }));
+		ThreadPool->AddQueuedWork(Work.Last().Get());
+	}
+
+	GrowTreeForThread(0);
+
+	for (const TUniquePtr<FGrowTreeWork>& TreeWork : Work)
+	{
+		TreeWork->Wait();
+	}
+
+	// Every root was expanded using the same legal actions, so children line up
+	TArray<int32> Visits;
+	TArray<float> Values;
+	Visits.SetNumZeroed(RootActions.Num());
+	Values.SetNumZeroed(RootActions.Num());
+
+	for (const FSearchTree& Tree : Trees)
+	{
+		Result.NumRollouts += Tree.NumRollouts;
+		Result.NumTranspositionHits += Tree.NumTranspositionHits;
+
+		// Work is abandoned (never run) if the pool is destroyed while queued
+		if (Tree.Nodes.Num() == 0)
+		{
+			continue;
+		}
+
+		const FSearchNode& Root = Tree.Nodes[0];
+		if (Root.FirstChild == INDEX_NONE)
+		{
+			continue;
+		}
+
+		check(Root.NumChildren == RootActions.Num());
+		for (int32 i = 0; i < Root.NumChildren; ++i)
+		{
+			const FSearchNode& Child = Tree.Nodes[Root.FirstChild + i];
+			Visits[i] += Child.Visits;
+			Values[i] += Child.Value;
+		}
+	}
+
+	int32 BestIndex = 0;
+	for (int32 i = 1; i < RootActions.Num(); ++i)
+	{
+		if (Visits[i] > Visits[BestIndex])
+		{
+			BestIndex = i;
+		}
+	}
+
+	Result.BestAction = RootActions[BestIndex];
+	Result.NumThreads = NumThreads;
+	Result.Visits = Visits[BestIndex];
+	Result.WinRate = Visits[BestIndex] > 0 ? Values[BestIndex] / Visits[BestIndex] : 0.f;
+	Result.Time = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogConquest, Verbose, TEXT("FCSKMonteCarloSearch: Player %i chose action %i (cell %i) after %lld rollouts on %i threads in %.3fs (win rate %.2f)"),
+		PlayerID + 1, static_cast<int32>(Result.BestAction.Type), Result.BestAction.Cell, Result.NumRollouts, NumThreads, Result.Time, Result.WinRate);
+
+	return Result;
+}
+
+float FCSKMonteCarloSearch::EvaluateState(const FCSKRules& Rules, const FCSKRulesState& State, int32 PlayerID)
+{
+	if (State.IsMatchOver())
+	{
+		return State.Winner == PlayerID ? 1.f : 0.f;
+	}
+
+	const int32 OpposingID = 1 - PlayerID;
+
+	// How close each player is to winning by either condition
+	auto GetProgress = [&Rules, &State](int32 ID) -> float
+	{
+		const FCSKRulesPlayerState& Player = State.Players[ID];
+		const FCSKRulesPlayerState& Opponent = State.Players[1 - ID];
+
+		float PortalProgress = 0.f;
+
+		const int32 OwnPortal = Rules.PlayerPortals[ID];
+		const int32 GoalPortal = Rules.PlayerPortals[1 - ID];
+		if (OwnPortal != INDEX_NONE && GoalPortal != INDEX_NONE)
+		{
+			const float Total = FMath::Max(1, Rules.GetDistance(OwnPortal, GoalPortal));
+			PortalProgress = 1.f - Rules.GetDistance(Player.CastleCell, GoalPortal) / Total;
+		}
+
+		const float DamageProgress = 1.f - static_cast<float>(Opponent.CastleHealth) / FMath::Max(1, Rules.CastleHealth);
+		return FMath::Max(PortalProgress, DamageProgress);
+	};
+
+	const float Difference = GetProgress(PlayerID) - GetProgress(OpposingID);
+	return FMath::Clamp(0.5f + Difference * 0.5f, 0.f, 1.f);
+}
+
+TFuture<FCSKSearchResult> FCSKMonteCarloSearch::SearchAsync(const TSharedRef<const FCSKRulesEngine, ESPMode::ThreadSafe>& Engine,
+	const FCSKRulesState& State, const FCSKSearchSettings& Settings, const TAtomic<bool>* bCancelled)
+{
+	FCSKSearchSettings PooledSettings = Settings;
+	if (ThreadPool)
+	{
+		// The search itself occupies one of the pooled threads, so has one less to queue trees on
+		const int32 MaxThreads = GetMaxThreads() - 1;
+		PooledSettings.NumThreads = Settings.NumThreads > 0 ? FMath::Min(Settings.NumThreads, MaxThreads) : MaxThreads;
+	}
+
+	FSearchWork* Work = new FSearchWork([Engine, State, PooledSettings, bCancelled]()
+	{
+		return Search(*Engine, State, PooledSettings, bCancelled);
+	});
+
+	TFuture<FCSKSearchResult> Result = Work->GetFuture();
+
+	if (ThreadPool)
+	{
+		ThreadPool->AddQueuedWork(Work);
+	}
+	else
+	{
+		Work->DoThreadedWork();
+	}
+
+	return Result;
+}
+
+int32 FCSKMonteCarloSearch::GetMaxThreads()
+{
+	return ThreadPool ? ThreadPool->GetNumThreads() + 1 : 1;
+}
+
+void FCSKMonteCarloSearch::StartupThreadPool()
+{
+	check(!ThreadPool);
+
+	if (FPlatformProcess::SupportsMultithreading())
+	{
+		// Searches are started from a thread of their own, which grows a tree as well. Together
+		// with the pool this matches the amount of task graph workers, but at a lower priority
+		const int32 NumThreads = FMath::Max(1, FPlatformMisc::NumberOfWorkerThreadsToSpawn() - 1);
+
+		ThreadPool = FQueuedThreadPool::Allocate();
+		verify(ThreadPool->Create(NumThreads, 128 * 1024, TPri_BelowNormal));
+	}
+}
+
+void FCSKMonteCarloSearch::ShutdownThreadPool()
+{
+	if (ThreadPool)
+	{
+		ThreadPool->Destroy();
+		delete ThreadPool;
+		ThreadPool = nullptr;
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+/** Runs a fixed time search from the start of a match with increasing thread counts, reporting rollouts per second */
+static void RunMonteCarloSearchBenchmark(const TArray<FString>& Args)
+{
+	const double TimeBudget = Args.Num() > 0 ? FMath::Max(0.1, FCString::Atod(*Args[0])) : 1.0;
+
+	FCSKRules Rules;
+	Rules.InitBenchmark();
+
+	FCSKRulesEngine Engine(Rules);
+
+	FCSKRulesState State;
+	Engine.InitMatch(State, 0, 0);
+
+	const int32 MaxThreads = FCSKMonteCarloSearch::GetMaxThreads();
+
+	double SingleThreadRate = 0.0;
+	for (int32 NumThreads = 1; ; NumThreads = FMath::Min(NumThreads * 2, MaxThreads))
+	{
+		FCSKSearchSettings Settings;
+		Settings.TimeBudget = TimeBudget;
+		Settings.NumThreads = NumThreads;
+
+		if (Args.Num() > 1)
+		{
+			Settings.TranspositionTableSize = FMath::Max(0, FCString::Atoi(*Args[1]));
+		}
+
+		const FCSKSearchResult Result = FCSKMonteCarloSearch::Search(Engine, State, Settings);
+
+		const double Rate = Result.NumRollouts / FMath::Max(Result.Time, SMALL_NUMBER);
+		if (NumThreads == 1)
+		{
+			SingleThreadRate = Rate;
+		}
+
+		UE_LOG(LogConquest, Display, TEXT("MonteCarloSearch: %2i threads, %lld rollouts in %.3f s (%.1f rollouts/s, %.2fx, %lld transposition hits)"),
+			NumThreads, Result.NumRollouts, Result.Time, Rate, Rate / FMath::Max(SingleThreadRate, SMALL_NUMBER), Result.NumTranspositionHits);
+
+		if (NumThreads == MaxThreads)
+		{
+			break;
+		}
+	}
+}
+
+static FAutoConsoleCommand MonteCarloSearchBenchmarkCommand(
+	TEXT("CSK.AI.Benchmark"),
+	TEXT("Reports rollouts per second of the AI search for an increasing amount of threads. Usage: CSK.AI.Benchmark [SecondsPerRun] [TranspositionTableSize]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunMonteCarloSearchBenchmark));
+
+#endif
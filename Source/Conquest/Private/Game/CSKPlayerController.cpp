@@ -32,6 +32,7 @@ ACSKPlayerController::ACSKPlayerController()
 	CastlePawn = nullptr;
 	CSKPlayerID = -1;
 	HoveredTile = nullptr;
+	bHasSpellTargetMask = false;
 	bCanSelectTile = false;
 	bWaitingOnTallyEvent = false;
 	bIsActionPhase = false;
@@ -181,6 +182,9 @@ void ACSKPlayerController::SetSelectedSpellCard(TSubclassOf<USpellCard> InSpellC
 		{
 			SelectedSpellIndex = InSpellIndex;
 
+			// Evaluate every tile now, so hovering over tiles is only a look up
+			UpdateSpellTargetMask();
+
 			// Stop here if ignoring spell selections
 			if (bIgnoreCanSelectSpellFlags)
 			{
@@ -202,7 +206,7 @@ void ACSKPlayerController::SetSelectedSpellCard(TSubclassOf<USpellCard> InSpellC
 				// Tile might expect the castles tile to be the target
 				ATile* TargetTile = CastlePawn ? CastlePawn->GetCachedTile() : nullptr;
 
-				if (!DefaultSpell->CanActivateSpell(CSKPlayerState, TargetTile))
+				if (!DefaultSpell->CanActivateSpellOnTile(CSKPlayerState, TargetTile))
 				{
 					return;
 				}
@@ -275,6 +279,11 @@ ACSKPlayerCameraManager* ACSKPlayerController::GetCSKPlayerCameraManager() const
 	return Cast<ACSKPlayerCameraManager>(PlayerCameraManager);
 }
 
+bool ACSKPlayerController::IsAIPlayer() const
+{
+	return PlayerState && PlayerState->bIsABot;
+}
+
 ACSKHUD* ACSKPlayerController::GetCSKHUD() const
 {
 	return CachedCSKHUD;
@@ -358,15 +367,11 @@ void ACSKPlayerController::OnNewTileHovered_Implementation(ATile* NewTile)
 			SelectedActionTileCandidates.Empty(1);
 			SelectedActionTileCandidates.Add(NewTile);
 
-			ACSKGameState* CSKGameState = UConquestFunctionLibrary::GetCSKGameState(this);
-			if (CSKGameState)
-			{
-				// We want the selectable highlight to take priority over 
-				ETileSelectionState SelectionState = CSKGameState->CanPlayerCastSpell(this, NewTile, SelectedSpellCard, SelectedSpellIndex, SelectedSpellAdditionalMana)
-					? ETileSelectionState::SelectablePriority : ETileSelectionState::UnselectablePriority;
+			// We want the selectable highlight to take priority over 
+			ETileSelectionState SelectionState = CanCastSelectedSpellOnTile(NewTile)
+				? ETileSelectionState::SelectablePriority : ETileSelectionState::UnselectablePriority;
 
-				NewTile->SetSelectionState(SelectionState);
-			}
+			NewTile->SetSelectionState(SelectionState);
 		}
 		else
 		{
@@ -375,6 +380,47 @@ void ACSKPlayerController::OnNewTileHovered_Implementation(ATile* NewTile)
 	}
 }
 
+bool ACSKPlayerController::CanCastSelectedSpellOnTile(const ATile* Tile)
+{
+	ABoardManager* BoardManager = UConquestFunctionLibrary::GetMatchBoardManager(this);
+	if (!Tile || !BoardManager)
+	{
+		return false;
+	}
+
+	UpdateSpellTargetMask();
+
+	const int32 Index = BoardManager->GetHexGrid().HexToIndex(Tile->GetGridHexValue());
+	return Index != INDEX_NONE && Index < SpellTargetMask.Num() && SpellTargetMask.Test(Index);
+}
+
+void ACSKPlayerController::UpdateSpellTargetMask()
+{
+	ACSKGameState* CSKGameState = UConquestFunctionLibrary::GetCSKGameState(this);
+	ABoardManager* BoardManager = UConquestFunctionLibrary::GetMatchBoardManager(this);
+	ACSKPlayerState* CSKPlayerState = GetCSKPlayerState();
+	if (!CSKGameState || !BoardManager || !CSKPlayerState)
+	{
+		return;
+	}
+
+	FSpellTargetMaskKey Key;
+	Key.SpellCard = SelectedSpellCard.Get();
+	Key.SpellIndex = SelectedSpellIndex;
+	Key.AdditionalMana = SelectedSpellAdditionalMana;
+	Key.Mana = CSKPlayerState->GetMana();
+	Key.SpellDiscount = CSKPlayerState->GetSpellDiscount();
+	Key.Generation = BoardManager->GetOccupancyGeneration();
+
+	if (!bHasSpellTargetMask || Key != SpellTargetMaskKey)
+	{
+		CSKGameState->GetSpellTargetMask(this, SelectedSpellCard, SelectedSpellIndex, SelectedSpellAdditionalMana, SpellTargetMask);
+
+		SpellTargetMaskKey = Key;
+		bHasSpellTargetMask = true;
+	}
+}
+
 void ACSKPlayerController::NotifyFadeOutInSequenceFinished()
 {
 	Server_TransitionSequenceFinished();
@@ -466,13 +512,15 @@ void ACSKPlayerController::ResetCamera()
 	}
 }
 
-bool ACSKPlayerController::Server_ExecuteCustomOnSelectTile_Validate(ATile* SelectedTile)
+bool ACSKPlayerController::Server_ExecuteCustomOnSelectTile_Validate(const FNetTileRef& SelectedTileRef)
 {
 	return true;
 }
 
-void ACSKPlayerController::Server_ExecuteCustomOnSelectTile_Implementation(ATile* SelectedTile)
+void ACSKPlayerController::Server_ExecuteCustomOnSelectTile_Implementation(const FNetTileRef& SelectedTileRef)
 {
+	ATile* SelectedTile = SelectedTileRef.Resolve(this);
+
 	// We can skip the can select if it's not bound (assume it returns true)
 	if (!CustomCanSelectTile.IsBound() || CustomCanSelectTile.Execute(SelectedTile))
 	{
@@ -1057,8 +1105,10 @@ void ACSKPlayerController::Client_OnCastleMoveRequestFinished_Implementation()
 	}
 }
 
-void ACSKPlayerController::Client_OnTowerBuildRequestConfirmed_Implementation(ATile* TargetTile)
+void ACSKPlayerController::Client_OnTowerBuildRequestConfirmed_Implementation(const FNetTileRef& TargetTileRef)
 {
+	ATile* TargetTile = TargetTileRef.Resolve(this);
+
 	SetCanSelectTile(false);
 	SetIgnoreMoveInput(true);
 
@@ -1105,8 +1155,10 @@ void ACSKPlayerController::Client_OnTowerBuildRequestFinished_Implementation()
 	}
 }
 
-void ACSKPlayerController::Client_OnCastSpellRequestConfirmed_Implementation(EActiveSpellContext SpellContext, ATile* TargetTile)
+void ACSKPlayerController::Client_OnCastSpellRequestConfirmed_Implementation(EActiveSpellContext SpellContext, const FNetTileRef& TargetTileRef)
 {
+	ATile* TargetTile = TargetTileRef.Resolve(this);
+
 	SetCanSelectTile(false);
 
 	// We want to ignore any spell selections at this point
@@ -1152,8 +1204,10 @@ void ACSKPlayerController::Client_OnCastSpellRequestFinished_Implementation(EAct
 	}
 }
 
-void ACSKPlayerController::Client_OnSelectCounterSpell_Implementation(bool bNullify, TSubclassOf<USpell> SpellToCounter, ATile* TargetTile)
+void ACSKPlayerController::Client_OnSelectCounterSpell_Implementation(bool bNullify, TSubclassOf<USpell> SpellToCounter, const FNetTileRef& TargetTileRef)
 {
+	ATile* TargetTile = TargetTileRef.Resolve(this);
+
 	SetCanSelectTile(true);
 	SetIgnoreMoveInput(false);
 
@@ -1221,8 +1275,10 @@ bool ACSKPlayerController::DisableActionMode(ECSKActionPhaseMode ActionMode)
 	return false;
 }
 
-void ACSKPlayerController::Client_OnTowerActionStart_Implementation(ATile* TileWithTower)
+void ACSKPlayerController::Client_OnTowerActionStart_Implementation(const FNetTileRef& TileWithTowerRef)
 {
+	ATile* TileWithTower = TileWithTowerRef.Resolve(this);
+
 	ACSKPawn* CSKPawn = GetCSKPawn();
 	if (CSKPawn && TileWithTower)
 	{
@@ -1369,13 +1425,15 @@ void ACSKPlayerController::Server_EndActionPhase_Implementation()
 	}
 }
 
-bool ACSKPlayerController::Server_RequestCastleMoveAction_Validate(ATile* Goal)
+bool ACSKPlayerController::Server_RequestCastleMoveAction_Validate(const FNetTileRef& GoalRef)
 {
 	return true;
 }
 
-void ACSKPlayerController::Server_RequestCastleMoveAction_Implementation(ATile* Goal)
+void ACSKPlayerController::Server_RequestCastleMoveAction_Implementation(const FNetTileRef& GoalRef)
 {
+	ATile* Goal = GoalRef.Resolve(this);
+
 	bool bSuccess = false;
 
 	if (CanRequestCastleMoveAction())
@@ -1394,13 +1452,15 @@ void ACSKPlayerController::Server_RequestCastleMoveAction_Implementation(ATile*
 	}
 }
 
-bool ACSKPlayerController::Server_RequestBuildTowerAction_Validate(TSubclassOf<UTowerConstructionData> TowerConstructData, ATile* Target)
+bool ACSKPlayerController::Server_RequestBuildTowerAction_Validate(TSubclassOf<UTowerConstructionData> TowerConstructData, const FNetTileRef& TargetRef)
 {
 	return true;
 }
 
-void ACSKPlayerController::Server_RequestBuildTowerAction_Implementation(TSubclassOf<UTowerConstructionData> TowerConstructData, ATile* Target)
+void ACSKPlayerController::Server_RequestBuildTowerAction_Implementation(TSubclassOf<UTowerConstructionData> TowerConstructData, const FNetTileRef& TargetRef)
 {
+	ATile* Target = TargetRef.Resolve(this);
+
 	bool bSuccess = false;
 
 	if (CanRequestBuildTowerAction())
@@ -1419,13 +1479,15 @@ void ACSKPlayerController::Server_RequestBuildTowerAction_Implementation(TSubcla
 	}
 }
 
-bool ACSKPlayerController::Server_RequestCastSpellAction_Validate(TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, ATile* Target, int32 AdditionalMana)
+bool ACSKPlayerController::Server_RequestCastSpellAction_Validate(TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, const FNetTileRef& TargetRef, int32 AdditionalMana)
 {
 	return true;
 }
 
-void ACSKPlayerController::Server_RequestCastSpellAction_Implementation(TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, ATile* Target, int32 AdditionalMana)
+void ACSKPlayerController::Server_RequestCastSpellAction_Implementation(TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, const FNetTileRef& TargetRef, int32 AdditionalMana)
 {
+	ATile* Target = TargetRef.Resolve(this);
+
 	bool bSuccess = false;
 
 	if (CanRequestCastSpellAction())
@@ -1444,13 +1506,15 @@ void ACSKPlayerController::Server_RequestCastSpellAction_Implementation(TSubclas
 	}
 }
 
-bool ACSKPlayerController::Server_RequestCastQuickEffectAction_Validate(TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, ATile* Target, int32 AdditionalMana)
+bool ACSKPlayerController::Server_RequestCastQuickEffectAction_Validate(TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, const FNetTileRef& TargetRef, int32 AdditionalMana)
 {
 	return true;
 }
 
-void ACSKPlayerController::Server_RequestCastQuickEffectAction_Implementation(TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, ATile* Target, int32 AdditionalMana)
+void ACSKPlayerController::Server_RequestCastQuickEffectAction_Implementation(TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, const FNetTileRef& TargetRef, int32 AdditionalMana)
 {
+	ATile* Target = TargetRef.Resolve(this);
+
 	bool bSuccess = false;
 
 	if (bCanSelectNullifyQuickEffect || bCanSelectPostQuickEffect)
@@ -1494,13 +1558,15 @@ void ACSKPlayerController::Server_SkipQuickEffectSelection_Implementation()
 	}
 }
 
-bool ACSKPlayerController::Server_RequestCastBonusSpellAction_Validate(ATile* Target)
+bool ACSKPlayerController::Server_RequestCastBonusSpellAction_Validate(const FNetTileRef& TargetRef)
 {
 	return true;
 }
 
-void ACSKPlayerController::Server_RequestCastBonusSpellAction_Implementation(ATile* Target)
+void ACSKPlayerController::Server_RequestCastBonusSpellAction_Implementation(const FNetTileRef& TargetRef)
 {
+	ATile* Target = TargetRef.Resolve(this);
+
 	bool bSuccess = false;
 
 	if (bCanSelectBonusSpellTarget)
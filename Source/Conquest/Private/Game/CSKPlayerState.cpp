@@ -3,8 +3,10 @@
 #include "CSKPlayerState.h"
 #include "CSKPlayerController.h"
 #include "CSKGameState.h"
+#include "CSKMatchSnapshot.h"
 #include "SpellCard.h"
 #include "Tower.h"
+#include "TowerConstructionData.h"
 
 #include "LobbyPlayerState.h"
 
@@ -18,6 +20,8 @@ ACSKPlayerState::ACSKPlayerState()
 	Mana = 0;
 	BonusTileMovements = 0;
 	CachedNumLegendaryTowers = 0;
+	CollectionGoldFromTowers = 0;
+	CollectionManaFromTowers = 0;
 	MaxNumSpellUses = 1;
 	bHasInfiniteSpellUses = false;
 	SpellDiscount = 0;
@@ -171,6 +175,17 @@ void ACSKPlayerState::AddTower(ATower* InTower)
 		// Recalculate the cached counts we have
 		UpdateTowerCounts();
 
+		// Subscribe to collection phase, the wants event is only checked here rather than every round.
+		// Towers that don't want the event give the fixed resources of their construction data instead
+		if (InTower->WantsCollectionPhaseEvent())
+		{
+			CollectionPhaseTowers.Add(InTower);
+		}
+		else
+		{
+			ApplyFixedCollectionYields(InTower, 1);
+		}
+
 		if (InTower->IsLegendaryTower())
 		{
 			++TotalLegendaryTowersBuilt;
@@ -191,10 +206,49 @@ void ACSKPlayerState::RemoveTower(ATower* InTower)
 		{
 			// Recalculate the cached counts we have
 			UpdateTowerCounts();
+
+			// Only towers that weren't subscribed to collection phase gave fixed resources
+			if (CollectionPhaseTowers.Remove(InTower) == 0)
+			{
+				ApplyFixedCollectionYields(InTower, -1);
+			}
 		}
 	}
 }
 
+void ACSKPlayerState::UpdateCollectionPhaseTower(ATower* InTower)
+{
+	if (HasAuthority() && InTower && OwnedTowers.Contains(InTower))
+	{
+		const bool bWantsEvent = InTower->WantsCollectionPhaseEvent();
+		if (bWantsEvent == CollectionPhaseTowers.Contains(InTower))
+		{
+			return;
+		}
+
+		if (bWantsEvent)
+		{
+			CollectionPhaseTowers.Add(InTower);
+			ApplyFixedCollectionYields(InTower, -1);
+		}
+		else
+		{
+			CollectionPhaseTowers.Remove(InTower);
+			ApplyFixedCollectionYields(InTower, 1);
+		}
+	}
+}
+
+void ACSKPlayerState::ApplyFixedCollectionYields(const ATower* InTower, int32 Scale)
+{
+	if (InTower && InTower->ConstructData)
+	{
+		CollectionGoldFromTowers += InTower->ConstructData->CollectionGold * Scale;
+		CollectionManaFromTowers += InTower->ConstructData->CollectionMana * Scale;
+		AddSpellUses(InTower->ConstructData->CollectionSpellUses * Scale);
+	}
+}
+
 void ACSKPlayerState::AddSpellUses(int32 Amount)
 {
 	SetSpellUses(MaxNumSpellUses + Amount);
@@ -524,3 +578,56 @@ void ACSKPlayerState::ResetSpellsCast()
 		SpellsCastThisRound = 0;
 	}
 }
+
+void ACSKPlayerState::CaptureMatchSnapshot(FCSKPlayerSnapshot& OutSnapshot) const
+{
+	OutSnapshot.Gold = Gold;
+	OutSnapshot.Mana = Mana;
+	OutSnapshot.BonusTileMovements = BonusTileMovements;
+	OutSnapshot.MaxNumSpellUses = MaxNumSpellUses;
+	OutSnapshot.bHasInfiniteSpellUses = bHasInfiniteSpellUses;
+	OutSnapshot.SpellDiscount = SpellDiscount;
+
+	OutSnapshot.TilesTraversedThisRound = TilesTraversedThisRound;
+	OutSnapshot.SpellsCastThisRound = SpellsCastThisRound;
+
+	OutSnapshot.TotalGoldCollected = TotalGoldCollected;
+	OutSnapshot.TotalManaCollected = TotalManaCollected;
+	OutSnapshot.TotalTilesTraversed = TotalTilesTraversed;
+	OutSnapshot.TotalTowersBuilt = TotalTowersBuilt;
+	OutSnapshot.TotalLegendaryTowersBuilt = TotalLegendaryTowersBuilt;
+	OutSnapshot.TotalSpellsCast = TotalSpellsCast;
+	OutSnapshot.TotalQuickEffectSpellsCast = TotalQuickEffectSpellsCast;
+
+	OutSnapshot.SpellCardDeck = SpellCardDeck;
+	OutSnapshot.SpellCardsInHand = SpellCardsInHand;
+	OutSnapshot.SpellCardsDiscarded = SpellCardsDiscarded;
+}
+
+void ACSKPlayerState::RestoreMatchSnapshot(const FCSKPlayerSnapshot& Snapshot)
+{
+	if (HasAuthority())
+	{
+		Gold = Snapshot.Gold;
+		Mana = Snapshot.Mana;
+		BonusTileMovements = Snapshot.BonusTileMovements;
+		MaxNumSpellUses = Snapshot.MaxNumSpellUses;
+		bHasInfiniteSpellUses = Snapshot.bHasInfiniteSpellUses;
+		SpellDiscount = Snapshot.SpellDiscount;
+
+		TilesTraversedThisRound = Snapshot.TilesTraversedThisRound;
+		SpellsCastThisRound = Snapshot.SpellsCastThisRound;
+
+		TotalGoldCollected = Snapshot.TotalGoldCollected;
+		TotalManaCollected = Snapshot.TotalManaCollected;
+		TotalTilesTraversed = Snapshot.TotalTilesTraversed;
+		TotalTowersBuilt = Snapshot.TotalTowersBuilt;
+		TotalLegendaryTowersBuilt = Snapshot.TotalLegendaryTowersBuilt;
+		TotalSpellsCast = Snapshot.TotalSpellsCast;
+		TotalQuickEffectSpellsCast = Snapshot.TotalQuickEffectSpellsCast;
+
+		SpellCardDeck = Snapshot.SpellCardDeck;
+		SpellCardsInHand = Snapshot.SpellCardsInHand;
+		SpellCardsDiscarded = Snapshot.SpellCardsDiscarded;
+	}
+}
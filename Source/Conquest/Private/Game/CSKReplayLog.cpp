@@ -0,0 +1,705 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CSKReplayLog.h"
+#include "CSKBinaryStream.h"
+#include "CSKGameMode.h"
+
+#include "SpellCard.h"
+#include "TowerConstructionData.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DECLARE_CYCLE_STAT(TEXT("ReplayLog FastForward"), STAT_ReplayLogFastForward, STATGROUP_Conquest);
+
+namespace
+{
+	/** Identifies a replay log file, followed by the version */
+	const uint8 ReplayMagic[4] = { 'C', 'S', 'K', 'R' };
+	const uint32 ReplayVersion = 2;
+
+	/** Flags packed into the first byte of every record (type uses the lower 4 bits) */
+	const uint8 RecordTypeMask = 0x0F;
+	const uint8 RecordTimeOutFlag = 1 << 4;
+	const uint8 RecordPlayerFlag = 1 << 5;
+	const uint8 RecordRoundChangedFlag = 1 << 6;
+	const uint8 RecordSeedChangedFlag = 1 << 7;
+
+	void WriteRules(FCSKBinaryWriter& Writer, const FCSKRules& Rules)
+	{
+		Writer.WriteUnsigned(Rules.Rows);
+		Writer.WriteUnsigned(Rules.Columns);
+
+		// Null cells are written in ascending order, so we only need the gap between them
+		Writer.WriteUnsigned(Rules.NullCells.CountSetBits());
+
+		int32 PreviousCell = 0;
+		Rules.NullCells.ForEachSetBit([&Writer, &PreviousCell](int32 Cell)
+		{
+			Writer.WriteUnsigned(Cell - PreviousCell);
+			PreviousCell = Cell;
+		});
+
+		for (int32 PlayerID = 0; PlayerID < CSK_MAX_NUM_PLAYERS; ++PlayerID)
+		{
+			Writer.WriteSigned(Rules.PlayerPortals[PlayerID]);
+		}
+
+		Writer.WriteSigned(Rules.StartingGold);
+		Writer.WriteSigned(Rules.StartingMana);
+		Writer.WriteSigned(Rules.CollectionPhaseGold);
+		Writer.WriteSigned(Rules.CollectionPhaseMana);
+		Writer.WriteSigned(Rules.MaxGold);
+		Writer.WriteSigned(Rules.MaxMana);
+		Writer.WriteSigned(Rules.MaxBuildRange);
+		Writer.WriteSigned(Rules.MaxSpellUses);
+		Writer.WriteSigned(Rules.MaxSpellCardsInHand);
+		Writer.WriteSigned(Rules.MinTileMovements);
+		Writer.WriteSigned(Rules.MaxTileMovements);
+		Writer.WriteSigned(Rules.CastleHealth);
+		Writer.WriteByte(Rules.bLimitOneMoveActionPerTurn ? 1 : 0);
+
+		Writer.WriteSigned(Rules.TowerLimits.MaxNumTowers);
+		Writer.WriteSigned(Rules.TowerLimits.MaxNumDuplicatedTowers);
+		Writer.WriteSigned(Rules.TowerLimits.MaxNumDuplicatedTowerTypes);
+		Writer.WriteSigned(Rules.TowerLimits.MaxNumLegendaryTowers);
+
+		Writer.WriteUnsigned(Rules.Towers.Num());
+		for (const FCSKRulesTower& Tower : Rules.Towers)
+		{
+			Writer.WriteSigned(Tower.GoldCost);
+			Writer.WriteSigned(Tower.ManaCost);
+			Writer.WriteSigned(Tower.Health);
+			Writer.WriteSigned(Tower.CollectionGold);
+			Writer.WriteSigned(Tower.CollectionMana);
+			Writer.WriteSigned(Tower.SpellUses);
+			Writer.WriteSigned(Tower.EndRoundPriority);
+			Writer.WriteSigned(Tower.EndRoundRange);
+			Writer.WriteSigned(Tower.EndRoundDamage);
+			Writer.WriteByte(Tower.bIsLegendary ? 1 : 0);
+		}
+
+		Writer.WriteUnsigned(Rules.SpellCards.Num());
+		for (const FCSKRulesSpellCard& SpellCard : Rules.SpellCards)
+		{
+			Writer.WriteSigned(SpellCard.StaticCost);
+			Writer.WriteSigned(SpellCard.Damage);
+			Writer.WriteByte((SpellCard.bExpectsAdditionalMana ? 1 : 0) | (SpellCard.bIsActionSpell ? 2 : 0));
+		}
+	}
+
+	bool ReadRules(FCSKBinaryReader& Reader, FCSKRules& Rules)
+	{
+		const int32 Rows = Reader.ReadUnsigned();
+		const int32 Columns = Reader.ReadUnsigned();
+		if (Reader.HasError() || Rows <= 0 || Columns <= 0 || Rows > MAX_int16 || Columns > MAX_int16)
+		{
+			return false;
+		}
+
+		Rules = FCSKRules();
+		if (!Rules.InitBoard(Rows, Columns))
+		{
+			return false;
+		}
+
+		const int32 NumNullCells = Reader.ReadCount();
+
+		int32 Cell = 0;
+		for (int32 i = 0; i < NumNullCells; ++i)
+		{
+			const uint32 Gap = Reader.ReadUnsigned();
+			if (Reader.HasError() || Gap >= static_cast<uint32>(Rules.NumCells() - Cell))
+			{
+				return false;
+			}
+
+			Cell += Gap;
+
+			Rules.NullCells.Set(Cell);
+		}
+
+		for (int32 PlayerID = 0; PlayerID < CSK_MAX_NUM_PLAYERS; ++PlayerID)
+		{
+			const int32 Portal = Reader.ReadSigned();
+			if (Portal < INDEX_NONE || Portal >= Rules.NumCells())
+			{
+				return false;
+			}
+
+			Rules.PlayerPortals[PlayerID] = Portal;
+			if (Portal != INDEX_NONE)
+			{
+				Rules.PortalCells.Set(Portal);
+			}
+		}
+
+		Rules.StartingGold = Reader.ReadSigned();
+		Rules.StartingMana = Reader.ReadSigned();
+		Rules.CollectionPhaseGold = Reader.ReadSigned();
+		Rules.CollectionPhaseMana = Reader.ReadSigned();
+		Rules.MaxGold = Reader.ReadSigned();
+		Rules.MaxMana = Reader.ReadSigned();
+		Rules.MaxBuildRange = Reader.ReadSigned();
+		Rules.MaxSpellUses = Reader.ReadSigned();
+		Rules.MaxSpellCardsInHand = Reader.ReadSigned();
+		Rules.MinTileMovements = Reader.ReadSigned();
+		Rules.MaxTileMovements = Reader.ReadSigned();
+		Rules.CastleHealth = Reader.ReadSigned();
+		Rules.bLimitOneMoveActionPerTurn = Reader.ReadByte() != 0;
+
+		Rules.TowerLimits.MaxNumTowers = Reader.ReadSigned();
+		Rules.TowerLimits.MaxNumDuplicatedTowers = Reader.ReadSigned();
+		Rules.TowerLimits.MaxNumDuplicatedTowerTypes = Reader.ReadSigned();
+		Rules.TowerLimits.MaxNumLegendaryTowers = Reader.ReadSigned();
+
+		const int32 NumTowers = Reader.ReadCount();
+		if (NumTowers > MAX_uint8)
+		{
+			return false;
+		}
+
+		Rules.Towers.SetNum(NumTowers);
+		for (FCSKRulesTower& Tower : Rules.Towers)
+		{
+			Tower.GoldCost = Reader.ReadSigned();
+			Tower.ManaCost = Reader.ReadSigned();
+			Tower.Health = Reader.ReadSigned();
+			Tower.CollectionGold = Reader.ReadSigned();
+			Tower.CollectionMana = Reader.ReadSigned();
+			Tower.SpellUses = Reader.ReadSigned();
+			Tower.EndRoundPriority = Reader.ReadSigned();
+			Tower.EndRoundRange = Reader.ReadSigned();
+			Tower.EndRoundDamage = Reader.ReadSigned();
+			Tower.bIsLegendary = Reader.ReadByte() != 0;
+		}
+
+		const int32 NumSpellCards = Reader.ReadCount();
+		if (NumSpellCards > MAX_uint8)
+		{
+			return false;
+		}
+
+		Rules.SpellCards.SetNum(NumSpellCards);
+		for (FCSKRulesSpellCard& SpellCard : Rules.SpellCards)
+		{
+			SpellCard.StaticCost = Reader.ReadSigned();
+			SpellCard.Damage = Reader.ReadSigned();
+
+			const uint8 Flags = Reader.ReadByte();
+			SpellCard.bExpectsAdditionalMana = (Flags & 1) != 0;
+			SpellCard.bIsActionSpell = (Flags & 2) != 0;
+		}
+
+		return !Reader.HasError();
+	}
+
+	/** Get if record of type is re-executed by the rules engine */
+	FORCEINLINE bool IsSimulatedRecord(ECSKReplayRecordType Type)
+	{
+		return Type == ECSKReplayRecordType::EndActionPhase || Type == ECSKReplayRecordType::CastleMove ||
+			Type == ECSKReplayRecordType::BuildTower || Type == ECSKReplayRecordType::CastSpell;
+	}
+}
+
+FCSKReplayLog::FCSKReplayLog()
+	: Seed(0)
+	, StartingPlayer(0)
+	, bRecording(false)
+{
+
+}
+
+void FCSKReplayLog::BeginMatch(const FCSKRules& InRules, int32 InSeed, int32 InStartingPlayer,
+	const TArray<TSubclassOf<UTowerConstructionData>>& Towers, const TArray<TSubclassOf<USpellCard>>& SpellCards)
+{
+	check(Towers.Num() == InRules.Towers.Num() && SpellCards.Num() == InRules.SpellCards.Num());
+
+	Reset();
+
+	Rules = InRules;
+	Seed = InSeed;
+	StartingPlayer = InStartingPlayer;
+	bRecording = true;
+
+	// Towers and spell cards always come first, so the replayer can map them to the rules.
+	// Duplicates are still added to keep the mapping, but records will use the first instance
+	auto AddClass = [this](const UClass* Class)
+	{
+		const int32 Index = ClassPaths.Add(Class ? Class->GetPathName() : FString());
+		if (Class && !ClassIndices.Contains(Class))
+		{
+			ClassIndices.Add(Class, Index);
+		}
+	};
+
+	for (TSubclassOf<UTowerConstructionData> Tower : Towers)
+	{
+		AddClass(Tower.Get());
+	}
+
+	for (TSubclassOf<USpellCard> SpellCard : SpellCards)
+	{
+		AddClass(SpellCard.Get());
+	}
+}
+
+void FCSKReplayLog::Reset()
+{
+	Rules = FCSKRules();
+	Seed = 0;
+	StartingPlayer = 0;
+	ClassPaths.Reset();
+	ClassIndices.Reset();
+	Records.Reset();
+	bRecording = false;
+}
+
+void FCSKReplayLog::AddRecord(const FCSKReplayRecord& Record)
+{
+	if (bRecording)
+	{
+		check(Record.ClassIndex < ClassPaths.Num());
+		Records.Add(Record);
+	}
+}
+
+int32 FCSKReplayLog::GetClassIndex(const UClass* Class)
+{
+	if (!Class)
+	{
+		return INDEX_NONE;
+	}
+
+	const int32* Index = ClassIndices.Find(Class);
+	if (Index)
+	{
+		return *Index;
+	}
+
+	const int32 NewIndex = ClassPaths.Add(Class->GetPathName());
+	ClassIndices.Add(Class, NewIndex);
+
+	return NewIndex;
+}
+
+void FCSKReplayLog::Serialize(TArray<uint8>& OutBytes) const
+{
+	OutBytes.Reset();
+	FCSKBinaryWriter Writer(OutBytes);
+
+	for (uint8 Byte : ReplayMagic)
+	{
+		Writer.WriteByte(Byte);
+	}
+
+	Writer.WriteUnsigned(ReplayVersion);
+	Writer.WriteSigned(Seed);
+	Writer.WriteUnsigned(StartingPlayer);
+
+	WriteRules(Writer, Rules);
+
+	Writer.WriteUnsigned(ClassPaths.Num());
+	for (const FString& ClassPath : ClassPaths)
+	{
+		Writer.WriteString(ClassPath);
+	}
+
+	// Most records share the round and seed of the record before them, so
+	// we only write them when they change (flagged in the records header)
+	int32 PreviousRound = 0;
+	int32 PreviousSeed = Seed;
+
+	Writer.WriteUnsigned(Records.Num());
+	for (const FCSKReplayRecord& Record : Records)
+	{
+		uint8 Header = static_cast<uint8>(Record.Type) & RecordTypeMask;
+		Header |= Record.bTimeOut ? RecordTimeOutFlag : 0;
+		Header |= Record.PlayerID != 0 ? RecordPlayerFlag : 0;
+		Header |= Record.Round != PreviousRound ? RecordRoundChangedFlag : 0;
+		Header |= Record.Seed != PreviousSeed ? RecordSeedChangedFlag : 0;
+
+		Writer.WriteByte(Header);
+
+		if (Header & RecordRoundChangedFlag)
+		{
+			Writer.WriteSigned(Record.Round - PreviousRound);
+			PreviousRound = Record.Round;
+		}
+
+		if (Header & RecordSeedChangedFlag)
+		{
+			Writer.WriteSigned(Record.Seed);
+			PreviousSeed = Record.Seed;
+		}
+
+		// Tiles and classes are offset by one so INDEX_NONE fits in one byte
+		switch (Record.Type)
+		{
+			case ECSKReplayRecordType::CastleMove:
+			case ECSKReplayRecordType::CastBonusSpell:
+			{
+				Writer.WriteUnsigned(Record.Cell + 1);
+				break;
+			}
+			case ECSKReplayRecordType::BuildTower:
+			{
+				Writer.WriteUnsigned(Record.ClassIndex + 1);
+				Writer.WriteUnsigned(Record.Cell + 1);
+				break;
+			}
+			case ECSKReplayRecordType::CastSpell:
+			case ECSKReplayRecordType::CastQuickEffect:
+			{
+				Writer.WriteUnsigned(Record.ClassIndex + 1);
+				Writer.WriteUnsigned(Record.SpellIndex);
+				Writer.WriteUnsigned(Record.Cell + 1);
+				Writer.WriteUnsigned(Record.AdditionalMana);
+				break;
+			}
+			default:
+			{
+				break;
+			}
+		}
+	}
+}
+
+bool FCSKReplayLog::Deserialize(const TArray<uint8>& Bytes)
+{
+	Reset();
+
+	FCSKBinaryReader Reader(Bytes);
+
+	for (uint8 Byte : ReplayMagic)
+	{
+		if (Reader.ReadByte() != Byte)
+		{
+			UE_LOG(LogConquest, Warning, TEXT("FCSKReplayLog::Deserialize: Data is not a replay log"));
+			return false;
+		}
+	}
+
+	const uint32 Version = Reader.ReadUnsigned();
+	if (Version != ReplayVersion)
+	{
+		UE_LOG(LogConquest, Warning, TEXT("FCSKReplayLog::Deserialize: Replay log is version %u, only version %u is supported"), Version, ReplayVersion);
+		return false;
+	}
+
+	Seed = Reader.ReadSigned();
+	StartingPlayer = Reader.ReadUnsigned();
+
+	bool bSuccess = StartingPlayer >= 0 && StartingPlayer < CSK_MAX_NUM_PLAYERS && ReadRules(Reader, Rules);
+	if (bSuccess)
+	{
+		const int32 NumClasses = Reader.ReadCount();
+		for (int32 i = 0; i < NumClasses; ++i)
+		{
+			ClassPaths.Add(Reader.ReadString());
+		}
+
+		int32 PreviousRound = 0;
+		int32 PreviousSeed = Seed;
+
+		const int32 NumRecords = Reader.ReadCount();
+		Records.Reserve(NumRecords);
+
+		for (int32 i = 0; i < NumRecords && bSuccess; ++i)
+		{
+			const uint8 Header = Reader.ReadByte();
+			if ((Header & RecordTypeMask) >= static_cast<uint8>(ECSKReplayRecordType::MAX))
+			{
+				bSuccess = false;
+				break;
+			}
+
+			FCSKReplayRecord& Record = Records.AddDefaulted_GetRef();
+			Record.Type = static_cast<ECSKReplayRecordType>(Header & RecordTypeMask);
+			Record.bTimeOut = (Header & RecordTimeOutFlag) != 0;
+			Record.PlayerID = (Header & RecordPlayerFlag) != 0 ? 1 : 0;
+
+			if (Header & RecordRoundChangedFlag)
+			{
+				PreviousRound += Reader.ReadSigned();
+			}
+
+			if (Header & RecordSeedChangedFlag)
+			{
+				PreviousSeed = Reader.ReadSigned();
+			}
+
+			Record.Round = PreviousRound;
+			Record.Seed = PreviousSeed;
+
+			switch (Record.Type)
+			{
+				case ECSKReplayRecordType::CastleMove:
+				case ECSKReplayRecordType::CastBonusSpell:
+				{
+					Record.Cell = static_cast<int32>(Reader.ReadUnsigned()) - 1;
+					break;
+				}
+				case ECSKReplayRecordType::BuildTower:
+				{
+					Record.ClassIndex = static_cast<int32>(Reader.ReadUnsigned()) - 1;
+					Record.Cell = static_cast<int32>(Reader.ReadUnsigned()) - 1;
+					break;
+				}
+				case ECSKReplayRecordType::CastSpell:
+				case ECSKReplayRecordType::CastQuickEffect:
+				{
+					Record.ClassIndex = static_cast<int32>(Reader.ReadUnsigned()) - 1;
+					Record.SpellIndex = Reader.ReadUnsigned();
+					Record.Cell = static_cast<int32>(Reader.ReadUnsigned()) - 1;
+					Record.AdditionalMana = Reader.ReadUnsigned();
+					break;
+				}
+				default:
+				{
+					break;
+				}
+			}
+
+			bSuccess = Record.ClassIndex >= INDEX_NONE && Record.ClassIndex < ClassPaths.Num();
+		}
+	}
+
+	if (!bSuccess || Reader.HasError())
+	{
+		UE_LOG(LogConquest, Warning, TEXT("FCSKReplayLog::Deserialize: Replay log is malformed"));
+
+		Reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool FCSKReplayLog::SaveToFile(const FString& Filename) const
+{
+	const FString Path = FPaths::IsRelative(Filename) ? GetReplayDirectory() / Filename : Filename;
+
+	TArray<uint8> Bytes;
+	Serialize(Bytes);
+
+	if (!FFileHelper::SaveArrayToFile(Bytes, *Path))
+	{
+		UE_LOG(LogConquest, Warning, TEXT("FCSKReplayLog::SaveToFile: Failed to save replay log to %s"), *Path);
+		return false;
+	}
+
+	UE_LOG(LogConquest, Log, TEXT("FCSKReplayLog: Saved %i records (%i bytes) to %s"), Records.Num(), Bytes.Num(), *Path);
+	return true;
+}
+
+bool FCSKReplayLog::LoadFromFile(const FString& Filename)
+{
+	const FString Path = FPaths::IsRelative(Filename) ? GetReplayDirectory() / Filename : Filename;
+
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Path))
+	{
+		UE_LOG(LogConquest, Warning, TEXT("FCSKReplayLog::LoadFromFile: Failed to load replay log from %s"), *Path);
+		return false;
+	}
+
+	return Deserialize(Bytes);
+}
+
+void FCSKReplayLog::FastForward(FCSKReplayResult& OutResult) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ReplayLogFastForward);
+
+	OutResult = FCSKReplayResult();
+
+	if (Rules.NumCells() == 0)
+	{
+		OutResult.DivergedRecord = 0;
+		OutResult.Divergence = TEXT("Replay log has no rules");
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	const FCSKRulesEngine Engine(Rules);
+	FCSKRulesState& State = OutResult.State;
+	Engine.InitMatch(State, StartingPlayer, Seed);
+
+	const int32 NumTowers = Rules.Towers.Num();
+
+	for (int32 i = 0; i < Records.Num(); ++i)
+	{
+		const FCSKReplayRecord& Record = Records[i];
+
+		// Records are checked against the state before applying them, the
+		// first mismatch is where the simulation has diverged from the match
+		FString& Divergence = OutResult.Divergence;
+		if (State.IsMatchOver())
+		{
+			Divergence = FString::Printf(TEXT("Match already won by player %i"), State.Winner + 1);
+		}
+		else if (Record.Round != State.Round)
+		{
+			Divergence = FString::Printf(TEXT("Recorded in round %i, but simulation is in round %i"), Record.Round, State.Round);
+		}
+		else if (Record.Seed != State.DeckReshuffleStream.GetCurrentSeed())
+		{
+			Divergence = FString::Printf(TEXT("Deck reshuffle seed was %i, but simulation has %i"),
+				Record.Seed, State.DeckReshuffleStream.GetCurrentSeed());
+		}
+		else if (!IsSimulatedRecord(Record.Type))
+		{
+			++OutResult.NumSkipped;
+			continue;
+		}
+		else if (Record.PlayerID != State.ActivePlayer)
+		{
+			Divergence = FString::Printf(TEXT("Requested by player %i, but simulation is in player %i's action phase"),
+				Record.PlayerID + 1, State.ActivePlayer + 1);
+		}
+		else if (Record.Type == ECSKReplayRecordType::EndActionPhase && Record.bTimeOut)
+		{
+			Engine.TimeOutActionPhase(State);
+		}
+		else
+		{
+			FCSKRulesAction Action;
+			switch (Record.Type)
+			{
+				case ECSKReplayRecordType::EndActionPhase:
+				{
+					Action = FCSKRulesAction(ECSKRulesActionType::EndPhase, INDEX_NONE);
+					break;
+				}
+				case ECSKReplayRecordType::CastleMove:
+				{
+					Action = FCSKRulesAction(ECSKRulesActionType::MoveCastle, Record.Cell);
+					break;
+				}
+				case ECSKReplayRecordType::BuildTower:
+				{
+					if (Record.ClassIndex < 0 || Record.ClassIndex >= NumTowers)
+					{
+						Divergence = TEXT("Tower is not one of the towers of the rules");
+					}
+
+					Action = FCSKRulesAction(ECSKRulesActionType::BuildTower, Record.Cell, Record.ClassIndex);
+					break;
+				}
+				case ECSKReplayRecordType::CastSpell:
+				{
+					// Rules engine casts spells by hand slot
+					const int32 CardIndex = Record.ClassIndex - NumTowers;
+					const int32 HandSlot = Record.ClassIndex >= NumTowers ?
+						State.Players[Record.PlayerID].SpellCardsInHand.IndexOfByKey(static_cast<uint8>(CardIndex)) : INDEX_NONE;
+
+					if (HandSlot == INDEX_NONE)
+					{
+						Divergence = TEXT("Spell card is not in players hand");
+					}
+
+					Action = FCSKRulesAction(ECSKRulesActionType::CastSpell, Record.Cell, HandSlot, Record.AdditionalMana);
+					break;
+				}
+				default:
+				{
+					checkNoEntry();
+					break;
+				}
+			}
+
+			if (Divergence.IsEmpty())
+			{
+				if (Action.Type != ECSKRulesActionType::EndPhase && (Record.Cell < 0 || Record.Cell >= Rules.NumCells()))
+				{
+					Divergence = FString::Printf(TEXT("Tile %i is not on the board"), Record.Cell);
+				}
+				else if (!Engine.ApplyAction(State, Action))
+				{
+					Divergence = TEXT("Request is not legal in simulation");
+				}
+			}
+		}
+
+		if (!Divergence.IsEmpty())
+		{
+			OutResult.DivergedRecord = i;
+			break;
+		}
+
+		++OutResult.NumApplied;
+	}
+
+	OutResult.Time = FPlatformTime::Seconds() - StartTime;
+}
+
+FString FCSKReplayLog::GetReplayDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Replays");
+}
+
+#if !UE_BUILD_SHIPPING
+
+/** Saves the replay log of the match in progress */
+static void SaveReplayLog(const TArray<FString>& Args, UWorld* World)
+{
+	ACSKGameMode* GameMode = World ? UConquestFunctionLibrary::GetCSKGameMode(World) : nullptr;
+	if (!GameMode)
+	{
+		UE_LOG(LogConquest, Warning, TEXT("CSK.Replay.Save: Can only be used by the server during a match"));
+		return;
+	}
+
+	GameMode->SaveReplayLog(Args.Num() > 0 ? Args[0] : FString());
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SaveReplayLogCommand(
+	TEXT("CSK.Replay.Save"),
+	TEXT("Saves the replay log of the match in progress. Usage: CSK.Replay.Save [Filename]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SaveReplayLog));
+
+/** Loads a replay log and re-executes it using the rules engine, reporting where it diverged (if at all) */
+static void FastForwardReplayLog(const TArray<FString>& Args)
+{
+	if (Args.Num() < 1)
+	{
+		UE_LOG(LogConquest, Display, TEXT("Usage: CSK.Replay.FastForward <Filename>"));
+		return;
+	}
+
+	FCSKReplayLog ReplayLog;
+	if (!ReplayLog.LoadFromFile(Args[0]))
+	{
+		return;
+	}
+
+	FCSKReplayResult Result;
+	ReplayLog.FastForward(Result);
+
+	UE_LOG(LogConquest, Display, TEXT("ReplayLog: Fast forwarded %i records (%i skipped) in %.3f ms. Finished in round %i, winner %i"),
+		Result.NumApplied, Result.NumSkipped, Result.Time * 1000.0, Result.State.Round, Result.State.Winner + 1);
+
+	if (Result.HasDiverged())
+	{
+		const TArray<FCSKReplayRecord>& Records = ReplayLog.GetRecords();
+		if (Records.IsValidIndex(Result.DivergedRecord))
+		{
+			const FCSKReplayRecord& Record = Records[Result.DivergedRecord];
+			UE_LOG(LogConquest, Warning, TEXT("ReplayLog: Diverged at record %i (type %i, player %i, round %i, tile %i, class %s): %s"),
+				Result.DivergedRecord, static_cast<int32>(Record.Type), Record.PlayerID + 1, Record.Round, Record.Cell,
+				Record.ClassIndex != INDEX_NONE ? *ReplayLog.GetClassPath(Record.ClassIndex) : TEXT("None"), *Result.Divergence);
+		}
+		else
+		{
+			UE_LOG(LogConquest, Warning, TEXT("ReplayLog: Diverged: %s"), *Result.Divergence);
+		}
+	}
+}
+
+static FAutoConsoleCommand FastForwardReplayLogCommand(
+	TEXT("CSK.Replay.FastForward"),
+	TEXT("Re-executes a saved replay log using the rules engine. Usage: CSK.Replay.FastForward <Filename>"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&FastForwardReplayLog));
+
+#endif
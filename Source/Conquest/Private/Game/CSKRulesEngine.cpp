@@ -0,0 +1,1063 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CSKRulesEngine.h"
+#include "CSKZobrist.h"
+#include "Containers/HexCore.h"
+
+#include "Algo/Reverse.h"
+#include "Algo/StableSort.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("RulesEngine ApplyAction"), STAT_RulesEngineApplyAction, STATGROUP_Conquest);
+DECLARE_CYCLE_STAT(TEXT("RulesEngine GetLegalActions"), STAT_RulesEngineGetLegalActions, STATGROUP_Conquest);
+
+FCSKRules::FCSKRules()
+	: Rows(0)
+	, Columns(0)
+{
+	for (int32 i = 0; i < CSK_MAX_NUM_PLAYERS; ++i)
+	{
+		PlayerPortals[i] = INDEX_NONE;
+	}
+
+	// Matches the defaults of ACSKGameMode
+	StartingGold = 5;
+	StartingMana = 3;
+	CollectionPhaseGold = 3;
+	CollectionPhaseMana = 2;
+	MaxGold = 30;
+	MaxMana = 30;
+	MaxBuildRange = 4;
+	MaxSpellUses = 1;
+	MaxSpellCardsInHand = 3;
+	MinTileMovements = 1;
+	MaxTileMovements = 2;
+	CastleHealth = 40;
+	bLimitOneMoveActionPerTurn = false;
+}
+
+bool FCSKRules::InitBoard(int32 InRows, int32 InColumns)
+{
+	check(InRows > 0 && InColumns > 0);
+
+	// Cells are stored as int16 by actions and board pieces
+	if (InRows * InColumns > MAX_int16)
+	{
+		return false;
+	}
+
+	Rows = InRows;
+	Columns = InColumns;
+
+	const int32 Num = NumCells();
+
+	CellHexes.SetNumUninitialized(Num);
+	Neighbors.SetNumUninitialized(Num * 6);
+
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		const FIntVector Hex = HexCore::IndexToHex<FIntVector>(Index, Columns);
+		CellHexes[Index] = Hex;
+
+		for (int32 Dir = 0; Dir < 6; ++Dir)
+		{
+			Neighbors[Index * 6 + Dir] = HexCore::HexToIndex(HexCore::HexNeighbor(Hex, Dir), Rows, Columns);
+		}
+	}
+
+	NullCells.Init(Num);
+	PortalCells.Init(Num);
+
+	for (int32 i = 0; i < CSK_MAX_NUM_PLAYERS; ++i)
+	{
+		PlayerPortals[i] = INDEX_NONE;
+	}
+
+	return true;
+}
+
+int32 FCSKRules::GetDistance(int32 Cell1, int32 Cell2) const
+{
+	return HexCore::HexDisplacement(CellHexes[Cell1], CellHexes[Cell2]);
+}
+
+FCSKRulesPlayerState::FCSKRulesPlayerState()
+	: Gold(0)
+	, Mana(0)
+	, CastleCell(INDEX_NONE)
+	, CastleHealth(0)
+	, TilesTraversedThisRound(0)
+	, BonusTileMovements(0)
+	, SpellsCastThisRound(0)
+	, MaxNumSpellUses(0)
+	, SpellDiscount(0)
+	, RemainingActions(ECSKActionPhaseMode::None)
+	, NumNormalTowers(0)
+	, NumLegendaryTowers(0)
+{
+
+}
+
+FCSKRulesState::FCSKRulesState()
+	: Round(0)
+	, RoundState(ECSKRoundState::Invalid)
+	, StartingPlayer(0)
+	, ActivePlayer(INDEX_NONE)
+	, Winner(INDEX_NONE)
+	, WinCondition(ECSKMatchWinCondition::Unknown)
+{
+
+}
+
+FCSKRulesEngine::FCSKRulesEngine(const FCSKRules& InRules)
+	: Rules(InRules)
+{
+	check(Rules.NumCells() > 0);
+	check(Rules.Towers.Num() <= MAX_uint8 && Rules.SpellCards.Num() <= MAX_uint8);
+}
+
+void FCSKRulesEngine::InitMatch(FCSKRulesState& OutState, int32 StartingPlayer, int32 Seed) const
+{
+	check(StartingPlayer >= 0 && StartingPlayer < CSK_MAX_NUM_PLAYERS);
+
+	OutState = FCSKRulesState();
+	OutState.StartingPlayer = StartingPlayer;
+	OutState.DeckReshuffleStream.Initialize(Seed);
+	OutState.OccupiedCells.Init(Rules.NumCells());
+
+	// See ACSKGameMode::ResetPlayerResources
+	for (int32 i = 0; i < CSK_MAX_NUM_PLAYERS; ++i)
+	{
+		FCSKRulesPlayerState& Player = OutState.Players[i];
+		Player.Gold = Rules.StartingGold;
+		Player.Mana = Rules.StartingMana;
+		Player.MaxNumSpellUses = Rules.MaxSpellUses;
+		Player.TowerCounts.SetNumZeroed(Rules.Towers.Num());
+
+		// Castles start on their portals
+		Player.CastleCell = Rules.PlayerPortals[i];
+		Player.CastleHealth = Rules.CastleHealth;
+
+		if (Player.CastleCell != INDEX_NONE)
+		{
+			OutState.OccupiedCells.Set(Player.CastleCell);
+		}
+	}
+
+	StartRound(OutState);
+}
+
+bool FCSKRulesEngine::IsActionLegal(const FCSKRulesState& State, const FCSKRulesAction& Action, bool bCheckSpellTarget) const
+{
+	if (State.IsMatchOver() || State.ActivePlayer == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const int32 PlayerID = State.ActivePlayer;
+	const FCSKRulesPlayerState& Player = State.Players[PlayerID];
+
+	switch (Action.Type)
+	{
+		case ECSKRulesActionType::EndPhase:
+		{
+			// See ACSKPlayerController::CanEndActionPhase. Players who are stuck have to wait for the action phase to time out
+			return Player.TilesTraversedThisRound >= Rules.MinTileMovements;
+		}
+		case ECSKRulesActionType::MoveCastle:
+		{
+			// See ACSKGameMode::RequestCastleMove
+			if (!EnumHasAnyFlags(Player.RemainingActions, ECSKActionPhaseMode::MoveCastle))
+			{
+				return false;
+			}
+
+			if (Action.Cell < 0 || Action.Cell >= Rules.NumCells() || Action.Cell == Player.CastleCell)
+			{
+				return false;
+			}
+
+			TArray<int32, TInlineAllocator<256>> Distances, Parents, Queue;
+			FindReachableCells(State, Distances, Parents, Queue);
+
+			return Distances[Action.Cell] > 0;
+		}
+		case ECSKRulesActionType::BuildTower:
+		{
+			// See ACSKGameMode::RequestBuildTower
+			if (!EnumHasAnyFlags(Player.RemainingActions, ECSKActionPhaseMode::BuildTowers))
+			{
+				return false;
+			}
+
+			return IsBuildableCell(State, PlayerID, Action.Cell) && CanBuildTower(State, PlayerID, Action.Index);
+		}
+		case ECSKRulesActionType::CastSpell:
+		{
+			// See ACSKGameMode::RequestCastSpell
+			if (!EnumHasAnyFlags(Player.RemainingActions, ECSKActionPhaseMode::CastSpell))
+			{
+				return false;
+			}
+
+			int32 FinalCost = 0;
+			return CanCastSpell(State, PlayerID, Action.Index, Action.Cell, Action.AdditionalMana, FinalCost, bCheckSpellTarget);
+		}
+	}
+
+	return false;
+}
+
+bool FCSKRulesEngine::ApplyAction(FCSKRulesState& State, const FCSKRulesAction& Action) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_RulesEngineApplyAction);
+
+	if (!IsActionLegal(State, Action))
+	{
+		return false;
+	}
+
+	const int32 PlayerID = State.ActivePlayer;
+	FCSKRulesPlayerState& Player = State.Players[PlayerID];
+
+	switch (Action.Type)
+	{
+		case ECSKRulesActionType::EndPhase:
+		{
+			EndActionPhase(State);
+			break;
+		}
+		case ECSKRulesActionType::MoveCastle:
+		{
+			TArray<int32, TInlineAllocator<256>> Distances, Parents, Queue;
+			FindReachableCells(State, Distances, Parents, Queue);
+
+			TArray<int32, TInlineAllocator<16>> Path;
+			for (int32 Cell = Action.Cell; Cell != Player.CastleCell; Cell = Parents[Cell])
+			{
+				Path.Add(Cell);
+			}
+
+			Algo::Reverse(Path);
+
+			State.OccupiedCells.Clear(Player.CastleCell);
+
+			// Match is won as soon as the opponents portal is reached, even if mid path
+			// (see ACSKGameMode::OnActivePlayersPathSegmentComplete)
+			const int32 OpposingPortal = Rules.PlayerPortals[1 - PlayerID];
+			for (int32 Cell : Path)
+			{
+				++Player.TilesTraversedThisRound;
+				Player.CastleCell = Cell;
+
+				if (Cell == OpposingPortal)
+				{
+					State.OccupiedCells.Set(Cell);
+					State.Winner = PlayerID;
+					State.WinCondition = ECSKMatchWinCondition::PortalReached;
+					return true;
+				}
+			}
+
+			State.OccupiedCells.Set(Player.CastleCell);
+
+			// See ACSKGameMode::FinishCastleMove
+			if (Rules.bLimitOneMoveActionPerTurn ||
+				Player.TilesTraversedThisRound >= (Rules.MaxTileMovements + Player.BonusTileMovements))
+			{
+				DisableAction(State, ECSKActionPhaseMode::MoveCastle);
+			}
+
+			break;
+		}
+		case ECSKRulesActionType::BuildTower:
+		{
+			const FCSKRulesTower& TowerData = Rules.Towers[Action.Index];
+
+			FCSKRulesTowerState& Tower = State.Towers.AddDefaulted_GetRef();
+			Tower.Type = Action.Index;
+			Tower.Owner = static_cast<uint8>(PlayerID);
+			Tower.Cell = Action.Cell;
+			Tower.Health = static_cast<int16>(TowerData.Health);
+
+			State.OccupiedCells.Set(Action.Cell);
+
+			// See ACSKGameMode::ConfirmBuildTower
+			++Player.TowerCounts[Action.Index];
+			if (TowerData.bIsLegendary)
+			{
+				++Player.NumLegendaryTowers;
+			}
+			else
+			{
+				++Player.NumNormalTowers;
+			}
+
+			Player.Gold -= TowerData.GoldCost;
+			Player.Mana -= TowerData.ManaCost;
+
+			// See ACSKPlayerState::AddTower (infinite spell uses are MAX_int32)
+			if (Player.MaxNumSpellUses != MAX_int32)
+			{
+				Player.MaxNumSpellUses += TowerData.SpellUses;
+			}
+
+			// See ACSKGameMode::FinishBuildTower
+			if (!CanBuildMoreTowers(State, PlayerID))
+			{
+				DisableAction(State, ECSKActionPhaseMode::BuildTowers);
+			}
+
+			break;
+		}
+		case ECSKRulesActionType::CastSpell:
+		{
+			int32 FinalCost = 0;
+			verify(CanCastSpell(State, PlayerID, Action.Index, Action.Cell, Action.AdditionalMana, FinalCost));
+
+			const FCSKRulesSpellCard& SpellCard = Rules.SpellCards[Player.SpellCardsInHand[Action.Index]];
+			const int32 AdditionalMana = SpellCard.bExpectsAdditionalMana ? Action.AdditionalMana : 0;
+
+			// See ACSKGameMode::ConfirmCastSpell
+			Player.Mana -= FinalCost;
+			Player.SpellCardsInHand.RemoveAt(Action.Index, 1, false);
+
+			DamageCell(State, Action.Cell, SpellCard.Damage + AdditionalMana);
+			ClearDestroyedTowers(State);
+
+			if (State.IsMatchOver())
+			{
+				return true;
+			}
+
+			// See ACSKGameMode::FinishCastSpell
+			++Player.SpellsCastThisRound;
+
+			if (!CanCastAnotherSpell(Player, true))
+			{
+				DisableAction(State, ECSKActionPhaseMode::CastSpell);
+			}
+
+			break;
+		}
+	}
+
+	return true;
+}
+
+void FCSKRulesEngine::GetLegalActions(const FCSKRulesState& State, TArray<FCSKRulesAction>& OutActions) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_RulesEngineGetLegalActions);
+
+	OutActions.Reset();
+
+	if (State.IsMatchOver() || State.ActivePlayer == INDEX_NONE)
+	{
+		return;
+	}
+
+	const int32 PlayerID = State.ActivePlayer;
+	const FCSKRulesPlayerState& Player = State.Players[PlayerID];
+
+	TArray<int32, TInlineAllocator<256>> Distances, Parents, Queue;
+	const int32 NumReached = FindReachableCells(State, Distances, Parents, Queue);
+
+	if (Player.TilesTraversedThisRound >= Rules.MinTileMovements)
+	{
+		OutActions.Emplace(ECSKRulesActionType::EndPhase, INDEX_NONE);
+	}
+
+	if (EnumHasAnyFlags(Player.RemainingActions, ECSKActionPhaseMode::MoveCastle))
+	{
+		// First cell is the castle
+		for (int32 i = 1; i < NumReached; ++i)
+		{
+			OutActions.Emplace(ECSKRulesActionType::MoveCastle, Queue[i]);
+		}
+	}
+
+	if (EnumHasAnyFlags(Player.RemainingActions, ECSKActionPhaseMode::BuildTowers))
+	{
+		for (int32 TowerType = 0; TowerType < Rules.Towers.Num(); ++TowerType)
+		{
+			if (!CanBuildTower(State, PlayerID, TowerType))
+			{
+				continue;
+			}
+
+			HexCore::ForEachHexInSpiral(Rules.CellHexes[Player.CastleCell], Rules.MaxBuildRange, [&](const FIntVector& Hex)
+			{
+				const int32 Cell = HexCore::HexToIndex(Hex, Rules.Rows, Rules.Columns);
+				if (Cell != INDEX_NONE && IsBuildableCell(State, PlayerID, Cell))
+				{
+					OutActions.Emplace(ECSKRulesActionType::BuildTower, Cell, TowerType);
+				}
+
+				return true;
+			});
+		}
+	}
+
+	if (EnumHasAnyFlags(Player.RemainingActions, ECSKActionPhaseMode::CastSpell))
+	{
+		for (int32 HandSlot = 0; HandSlot < Player.SpellCardsInHand.Num(); ++HandSlot)
+		{
+			// Casting either of two identical cards has the same outcome
+			const uint8 CardIndex = Player.SpellCardsInHand[HandSlot];
+			if (Player.SpellCardsInHand.Find(CardIndex) != HandSlot)
+			{
+				continue;
+			}
+
+			const bool bExpectsAdditionalMana = Rules.SpellCards[CardIndex].bExpectsAdditionalMana;
+
+			State.OccupiedCells.ForEachSetBit([&](int32 Cell)
+			{
+				int32 FinalCost = 0;
+				for (int32 AdditionalMana = 0; AdditionalMana <= MAX_uint8; ++AdditionalMana)
+				{
+					if (!CanCastSpell(State, PlayerID, HandSlot, Cell, AdditionalMana, FinalCost))
+					{
+						break;
+					}
+
+					OutActions.Emplace(ECSKRulesActionType::CastSpell, Cell, HandSlot, AdditionalMana);
+
+					if (!bExpectsAdditionalMana)
+					{
+						break;
+					}
+				}
+			});
+		}
+	}
+}
+
+void FCSKRulesEngine::TimeOutActionPhase(FCSKRulesState& State) const
+{
+	if (!State.IsMatchOver() && State.ActivePlayer != INDEX_NONE)
+	{
+		EndActionPhase(State);
+	}
+}
+
+int32 FCSKRulesEngine::GetRemainingMoves(int32 MinTileMovements, int32 MaxTileMovements, int32 BonusTileMovements, int32 TilesTraversed)
+{
+	// Bonus tiles can be negative (to signal less moves) but should ultimately be clamped to not exceed min
+	const int32 CalculatedMaxMovements = FMath::Max(MinTileMovements, MaxTileMovements + BonusTileMovements);
+	return FMath::Max(0, CalculatedMaxMovements - TilesTraversed);
+}
+
+bool FCSKRulesEngine::GetDiscountedCostIfAffordable(int32 StaticCost, int32 SpellDiscount, int32 Mana, int32& OutCost)
+{
+	// Lowest amount of mana to spend is one
+	const int32 RequiredAmount = FMath::Max(1, StaticCost - SpellDiscount);
+	if (Mana >= RequiredAmount)
+	{
+		OutCost = RequiredAmount;
+		return true;
+	}
+
+	OutCost = 0;
+	return false;
+}
+
+bool FCSKRulesEngine::IsTowerWithinLimits(const FCSKTowerLimits& Limits, bool bIsLegendary, int32 NumNormalTowers,
+	int32 NumLegendaryTowers, int32 NumInstances, int32 NumDuplicateTypes)
+{
+	if (bIsLegendary)
+	{
+		// Has player built max amount of legendary towers allowed?
+		if (Limits.MaxNumLegendaryTowers > 0 && NumLegendaryTowers >= Limits.MaxNumLegendaryTowers)
+		{
+			return false;
+		}
+
+		// There can only be one instance
+		return NumInstances == 0;
+	}
+
+	// Has player built the max amount of normal towers allowed?
+	if (Limits.MaxNumTowers > 0 && NumNormalTowers >= Limits.MaxNumTowers)
+	{
+		return false;
+	}
+
+	// Has player already built the max amount of duplicates for this tower?
+	if (Limits.MaxNumDuplicatedTowers > 0 && NumInstances >= Limits.MaxNumDuplicatedTowers)
+	{
+		return false;
+	}
+
+	// Has player already created too many duplicates for different towers? (if this would be a duplicate)
+	if (Limits.MaxNumDuplicatedTowerTypes > 0 && NumDuplicateTypes >= Limits.MaxNumDuplicatedTowerTypes)
+	{
+		return NumInstances == 0;
+	}
+
+	return true;
+}
+
+uint64 FCSKRulesEngine::HashState(const FCSKRulesState& State)
+{
+	uint64 Hash = 0;
+
+	for (int32 PlayerID = 0; PlayerID < CSK_MAX_NUM_PLAYERS; ++PlayerID)
+	{
+		const FCSKRulesPlayerState& Player = State.Players[PlayerID];
+
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::Castle, PlayerID, Player.CastleCell + 1);
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::Occupant, Player.CastleCell, PlayerID + 1);
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::Health, Player.CastleCell, Player.CastleHealth);
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::Gold, PlayerID, Player.Gold);
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::Mana, PlayerID, Player.Mana);
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::HandSize, PlayerID, Player.SpellCardsInHand.Num());
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::DeckSize, PlayerID, Player.SpellCardDeck.Num());
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::TilesTraversed, PlayerID, Player.TilesTraversedThisRound);
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::BonusTileMovements, PlayerID, Player.BonusTileMovements);
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::SpellsCast, PlayerID, Player.SpellsCastThisRound);
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::SpellModifiers, PlayerID, (Player.SpellDiscount << 16) | (Player.MaxNumSpellUses & 0xFFFF));
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::RemainingActions, PlayerID, static_cast<int32>(Player.RemainingActions));
+	}
+
+	for (const FCSKRulesTowerState& Tower : State.Towers)
+	{
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::Occupant, Tower.Cell, Tower.Owner + 1);
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::Tower, Tower.Cell, (Tower.Owner << 16) | (Tower.Type + 1));
+		FCSKZobrist::Toggle(Hash, ECSKHashFeature::Health, Tower.Cell, Tower.Health);
+	}
+
+	FCSKZobrist::Toggle(Hash, ECSKHashFeature::Round, 0, State.Round);
+	FCSKZobrist::Toggle(Hash, ECSKHashFeature::RoundState, 0, static_cast<int32>(State.RoundState));
+	FCSKZobrist::Toggle(Hash, ECSKHashFeature::ActivePlayer, 0, State.ActivePlayer + 1);
+	FCSKZobrist::Toggle(Hash, ECSKHashFeature::Winner, 0, State.Winner + 1);
+
+	return Hash;
+}
+
+void FCSKRulesEngine::StartRound(FCSKRulesState& State) const
+{
+	++State.Round;
+	State.RoundState = ECSKRoundState::CollectionPhase;
+
+	// See ACSKGameMode::UpdatePlayerResources
+	for (int32 PlayerID = 0; PlayerID < CSK_MAX_NUM_PLAYERS; ++PlayerID)
+	{
+		FCSKRulesPlayerState& Player = State.Players[PlayerID];
+
+		int32 GoldToGive = Rules.CollectionPhaseGold;
+		int32 ManaToGive = Rules.CollectionPhaseMana;
+
+		for (const FCSKRulesTowerState& Tower : State.Towers)
+		{
+			if (Tower.Owner == PlayerID)
+			{
+				GoldToGive += Rules.Towers[Tower.Type].CollectionGold;
+				ManaToGive += Rules.Towers[Tower.Type].CollectionMana;
+			}
+		}
+
+		Player.Gold = FMath::Clamp(Player.Gold + GoldToGive, 0, Rules.MaxGold);
+		Player.Mana = FMath::Clamp(Player.Mana + ManaToGive, 0, Rules.MaxMana);
+
+		// Reshuffle the deck if all cards have been used (see ACSKPlayerState::ResetSpellDeck)
+		if (Player.SpellCardDeck.Num() == 0 && Player.SpellCardsInHand.Num() == 0)
+		{
+			const int32 LastIndex = Rules.SpellCards.Num() - 1;
+
+			Player.SpellCardDeck.SetNumUninitialized(Rules.SpellCards.Num());
+			for (int32 i = 0; i <= LastIndex; ++i)
+			{
+				Player.SpellCardDeck[i] = static_cast<uint8>(i);
+			}
+
+			for (int32 i = 0; i <= LastIndex; ++i)
+			{
+				int32 Index = State.DeckReshuffleStream.RandRange(i, LastIndex);
+				if (i != Index)
+				{
+					Player.SpellCardDeck.Swap(i, Index);
+				}
+			}
+		}
+
+		// Player can only carry X amount of cards in hand
+		if (Player.SpellCardsInHand.Num() < Rules.MaxSpellCardsInHand && Player.SpellCardDeck.Num() > 0)
+		{
+			Player.SpellCardsInHand.Add(Player.SpellCardDeck[0]);
+			Player.SpellCardDeck.RemoveAt(0, 1, false);
+		}
+	}
+
+	StartActionPhase(State, 0);
+}
+
+void FCSKRulesEngine::StartActionPhase(FCSKRulesState& State, int32 Phase) const
+{
+	State.RoundState = Phase == 0 ? ECSKRoundState::FirstActionPhase : ECSKRoundState::SecondActionPhase;
+	State.ActivePlayer = Phase == 0 ? State.StartingPlayer : 1 - State.StartingPlayer;
+
+	FCSKRulesPlayerState& Player = State.Players[State.ActivePlayer];
+	Player.TilesTraversedThisRound = 0;
+	Player.SpellsCastThisRound = 0;
+
+	// Players can always move, other actions need to be affordable
+	Player.RemainingActions = ECSKActionPhaseMode::MoveCastle;
+
+	if (CanCastAnotherSpell(Player, true))
+	{
+		Player.RemainingActions |= ECSKActionPhaseMode::CastSpell;
+	}
+
+	if (CanBuildMoreTowers(State, State.ActivePlayer))
+	{
+		Player.RemainingActions |= ECSKActionPhaseMode::BuildTowers;
+	}
+}
+
+void FCSKRulesEngine::EndActionPhase(FCSKRulesState& State) const
+{
+	State.Players[State.ActivePlayer].RemainingActions = ECSKActionPhaseMode::None;
+
+	if (State.RoundState == ECSKRoundState::FirstActionPhase)
+	{
+		StartActionPhase(State, 1);
+		return;
+	}
+
+	State.ActivePlayer = INDEX_NONE;
+
+	RunEndRoundPhase(State);
+	if (!State.IsMatchOver())
+	{
+		StartRound(State);
+	}
+}
+
+void FCSKRulesEngine::RunEndRoundPhase(FCSKRulesState& State) const
+{
+	State.RoundState = ECSKRoundState::EndRoundPhase;
+
+	// Towers are identified by cell, as destroyed towers will be removed while running actions
+	TArray<FCSKRulesTowerState, TInlineAllocator<16>> ActionTowers;
+	for (const FCSKRulesTowerState& Tower : State.Towers)
+	{
+		if (Rules.Towers[Tower.Type].EndRoundDamage > 0)
+		{
+			ActionTowers.Add(Tower);
+		}
+	}
+
+	// Lowest priority goes first, with the starting players towers
+	// going first if tied (see ACSKGameMode::PrepareEndRoundActionTowers)
+	const int32 PlayerWithPriority = State.StartingPlayer;
+	Algo::StableSortBy(ActionTowers, [this, PlayerWithPriority](const FCSKRulesTowerState& Tower)
+	{
+		return Rules.Towers[Tower.Type].EndRoundPriority * 2 + (Tower.Owner == PlayerWithPriority ? 0 : 1);
+	});
+
+	for (const FCSKRulesTowerState& ActionTower : ActionTowers)
+	{
+		// Tower might have been destroyed by an earlier action
+		const FCSKRulesTowerState* Tower = State.Towers.FindByPredicate([&ActionTower](const FCSKRulesTowerState& Other)
+		{
+			return Other.Cell == ActionTower.Cell && Other.Owner == ActionTower.Owner && Other.Health > 0;
+		});
+
+		if (!Tower)
+		{
+			continue;
+		}
+
+		const FCSKRulesTower& TowerData = Rules.Towers[ActionTower.Type];
+		const int32 OpposingID = 1 - ActionTower.Owner;
+
+		TArray<int32, TInlineAllocator<16>> Targets;
+		if (Rules.GetDistance(ActionTower.Cell, State.Players[OpposingID].CastleCell) <= TowerData.EndRoundRange)
+		{
+			Targets.Add(State.Players[OpposingID].CastleCell);
+		}
+
+		for (const FCSKRulesTowerState& Other : State.Towers)
+		{
+			if (Other.Owner == OpposingID && Other.Health > 0 && Rules.GetDistance(ActionTower.Cell, Other.Cell) <= TowerData.EndRoundRange)
+			{
+				Targets.Add(Other.Cell);
+			}
+		}
+
+		for (int32 Cell : Targets)
+		{
+			DamageCell(State, Cell, TowerData.EndRoundDamage);
+		}
+
+		// See ACSKGameMode::NotifyEndRoundActionFinished
+		ClearDestroyedTowers(State);
+		if (State.IsMatchOver())
+		{
+			return;
+		}
+	}
+}
+
+void FCSKRulesEngine::DisableAction(FCSKRulesState& State, ECSKActionPhaseMode Action) const
+{
+	FCSKRulesPlayerState& Player = State.Players[State.ActivePlayer];
+
+	// Reset the bonus tiles a player can move at the end of a round
+	if (Action == ECSKActionPhaseMode::MoveCastle)
+	{
+		Player.BonusTileMovements = 0;
+	}
+
+	Player.RemainingActions &= ~Action;
+	if (Player.RemainingActions == ECSKActionPhaseMode::None)
+	{
+		EndActionPhase(State);
+	}
+}
+
+void FCSKRulesEngine::DamageCell(FCSKRulesState& State, int32 Cell, int32 Amount) const
+{
+	if (Amount <= 0)
+	{
+		return;
+	}
+
+	for (int32 PlayerID = 0; PlayerID < CSK_MAX_NUM_PLAYERS; ++PlayerID)
+	{
+		FCSKRulesPlayerState& Player = State.Players[PlayerID];
+		if (Player.CastleCell == Cell)
+		{
+			Player.CastleHealth = FMath::Max(0, Player.CastleHealth - Amount);
+
+			// See ACSKGameMode::OnBoardPieceHealthChanged
+			if (Player.CastleHealth == 0 && !State.IsMatchOver())
+			{
+				State.Winner = 1 - PlayerID;
+				State.WinCondition = ECSKMatchWinCondition::CastleDestroyed;
+			}
+
+			return;
+		}
+	}
+
+	for (FCSKRulesTowerState& Tower : State.Towers)
+	{
+		if (Tower.Cell == Cell && Tower.Health > 0)
+		{
+			Tower.Health = static_cast<int16>(FMath::Max(0, Tower.Health - Amount));
+			return;
+		}
+	}
+}
+
+void FCSKRulesEngine::ClearDestroyedTowers(FCSKRulesState& State) const
+{
+	for (int32 i = State.Towers.Num() - 1; i >= 0; --i)
+	{
+		const FCSKRulesTowerState& Tower = State.Towers[i];
+		if (Tower.Health > 0)
+		{
+			continue;
+		}
+
+		FCSKRulesPlayerState& Owner = State.Players[Tower.Owner];
+		--Owner.TowerCounts[Tower.Type];
+
+		// See ACSKPlayerState::RemoveTower
+		if (Owner.MaxNumSpellUses != MAX_int32)
+		{
+			Owner.MaxNumSpellUses = FMath::Max(0, Owner.MaxNumSpellUses - Rules.Towers[Tower.Type].SpellUses);
+		}
+
+		if (Rules.Towers[Tower.Type].bIsLegendary)
+		{
+			--Owner.NumLegendaryTowers;
+		}
+		else
+		{
+			--Owner.NumNormalTowers;
+		}
+
+		State.OccupiedCells.Clear(Tower.Cell);
+		State.Towers.RemoveAt(i, 1, false);
+	}
+}
+
+bool FCSKRulesEngine::CanCastAnotherSpell(const FCSKRulesPlayerState& Player, bool bCheckCosts) const
+{
+	// See ACSKPlayerState::CanCastAnotherSpell
+	if (Player.SpellsCastThisRound >= Player.MaxNumSpellUses)
+	{
+		return false;
+	}
+
+	if (!bCheckCosts)
+	{
+		return true;
+	}
+
+	for (uint8 CardIndex : Player.SpellCardsInHand)
+	{
+		if (!Rules.SpellCards[CardIndex].bIsActionSpell)
+		{
+			continue;
+		}
+
+		int32 DiscountedCost = 0;
+		if (GetDiscountedCostIfAffordable(Rules.SpellCards[CardIndex].StaticCost, Player.SpellDiscount, Player.Mana, DiscountedCost))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool FCSKRulesEngine::CanCastSpell(const FCSKRulesState& State, int32 PlayerID, int32 HandSlot, int32 Cell, int32 AdditionalMana, int32& OutFinalCost, bool bCheckTarget) const
+{
+	const FCSKRulesPlayerState& Player = State.Players[PlayerID];
+	if (!Player.SpellCardsInHand.IsValidIndex(HandSlot) || !CanCastAnotherSpell(Player, false))
+	{
+		return false;
+	}
+
+	if (Cell < 0 || Cell >= Rules.NumCells())
+	{
+		return false;
+	}
+
+	// Spells need a board piece to affect
+	if (bCheckTarget && (Rules.NullCells.Test(Cell) || !State.OccupiedCells.Test(Cell)))
+	{
+		return false;
+	}
+
+	const FCSKRulesSpellCard& SpellCard = Rules.SpellCards[Player.SpellCardsInHand[HandSlot]];
+	if (!SpellCard.bIsActionSpell || (!SpellCard.bExpectsAdditionalMana && AdditionalMana != 0))
+	{
+		return false;
+	}
+
+	int32 DiscountedCost = 0;
+	if (!GetDiscountedCostIfAffordable(SpellCard.StaticCost, Player.SpellDiscount, Player.Mana, DiscountedCost))
+	{
+		return false;
+	}
+
+	// See USpell::CalculateFinalCost and ACSKPlayerState::HasRequiredMana
+	OutFinalCost = DiscountedCost + AdditionalMana;
+	return Player.Mana >= FMath::Max(1, OutFinalCost - Player.SpellDiscount);
+}
+
+bool FCSKRulesEngine::CanBuildTower(const FCSKRulesState& State, int32 PlayerID, int32 TowerType) const
+{
+	if (!Rules.Towers.IsValidIndex(TowerType))
+	{
+		return false;
+	}
+
+	const FCSKRulesPlayerState& Player = State.Players[PlayerID];
+	const FCSKRulesTower& TowerData = Rules.Towers[TowerType];
+
+	// Is tower to expensive? We do not apply discount as it only applies to spells
+	if (Player.Gold < TowerData.GoldCost || Player.Mana < TowerData.ManaCost)
+	{
+		return false;
+	}
+
+	int32 NumInstances = Player.TowerCounts[TowerType];
+	if (TowerData.bIsLegendary)
+	{
+		NumInstances += State.Players[1 - PlayerID].TowerCounts[TowerType];
+	}
+
+	return IsTowerWithinLimits(Rules.TowerLimits, TowerData.bIsLegendary, Player.NumNormalTowers,
+		Player.NumLegendaryTowers, NumInstances, GetNumDuplicateTypes(Player));
+}
+
+bool FCSKRulesEngine::CanBuildMoreTowers(const FCSKRulesState& State, int32 PlayerID) const
+{
+	for (int32 TowerType = 0; TowerType < Rules.Towers.Num(); ++TowerType)
+	{
+		if (CanBuildTower(State, PlayerID, TowerType))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool FCSKRulesEngine::IsBuildableCell(const FCSKRulesState& State, int32 PlayerID, int32 Cell) const
+{
+	if (Cell < 0 || Cell >= Rules.NumCells())
+	{
+		return false;
+	}
+
+	// See ABoardManager::GetBuildableMask
+	if (Rules.NullCells.Test(Cell) || Rules.PortalCells.Test(Cell) || State.OccupiedCells.Test(Cell))
+	{
+		return false;
+	}
+
+	return Rules.GetDistance(State.Players[PlayerID].CastleCell, Cell) <= Rules.MaxBuildRange;
+}
+
+int32 FCSKRulesEngine::GetNumDuplicateTypes(const FCSKRulesPlayerState& Player) const
+{
+	int32 NumTypes = 0;
+	for (int32 TowerType = 0; TowerType < Player.TowerCounts.Num(); ++TowerType)
+	{
+		// Legendary towers are never duplicated
+		if (Player.TowerCounts[TowerType] >= 2)
+		{
+			++NumTypes;
+		}
+	}
+
+	return NumTypes;
+}
+
+int32 FCSKRulesEngine::FindReachableCells(const FCSKRulesState& State, TArray<int32, TInlineAllocator<256>>& Distances,
+	TArray<int32, TInlineAllocator<256>>& Parents, TArray<int32, TInlineAllocator<256>>& Queue) const
+{
+	const int32 Num = Rules.NumCells();
+	Distances.SetNumUninitialized(Num);
+	Parents.SetNumUninitialized(Num);
+	Queue.SetNumUninitialized(Num);
+
+	const FCSKRulesPlayerState& Player = State.Players[State.ActivePlayer];
+	const int32 MaxDistance = GetRemainingMoves(Rules.MinTileMovements, Rules.MaxTileMovements,
+		Player.BonusTileMovements, Player.TilesTraversedThisRound);
+
+	auto Neighbor = [this](int32 Index, int32 Direction) { return Rules.GetNeighbor(Index, Direction); };
+
+	// Occupied and null tiles can't be travelled through (see FHexGrid::GetReachableSet)
+	auto Passable = [this, &State](int32 Index) { return !Rules.NullCells.Test(Index) && !State.OccupiedCells.Test(Index); };
+
+	return HexCore::BreadthFirstSearch(Num, Player.CastleCell, MaxDistance, Distances.GetData(), Parents.GetData(), Queue.GetData(), Neighbor, Passable);
+}
+
+#if !UE_BUILD_SHIPPING
+
+void FCSKRules::InitBenchmark()
+{
+	verify(InitBoard(11, 11));
+
+	PlayerPortals[0] = 5;
+	PlayerPortals[1] = 10 * 11 + 5;
+	PortalCells.Set(PlayerPortals[0]);
+	PortalCells.Set(PlayerPortals[1]);
+
+	// Scatter a few null tiles around the middle of the board
+	for (int32 Cell : { 4 * 11 + 3, 5 * 11 + 5, 6 * 11 + 7 })
+	{
+		NullCells.Set(Cell);
+	}
+
+	{
+		FCSKRulesTower& Mine = Towers.AddDefaulted_GetRef();
+		Mine.GoldCost = 5;
+		Mine.CollectionGold = 2;
+
+		FCSKRulesTower& Turret = Towers.AddDefaulted_GetRef();
+		Turret.GoldCost = 8;
+		Turret.ManaCost = 2;
+		Turret.EndRoundRange = 2;
+		Turret.EndRoundDamage = 2;
+		Turret.EndRoundPriority = 1;
+
+		FCSKRulesTower& Legendary = Towers.AddDefaulted_GetRef();
+		Legendary.GoldCost = 20;
+		Legendary.ManaCost = 10;
+		Legendary.Health = 15;
+		Legendary.EndRoundRange = 4;
+		Legendary.EndRoundDamage = 5;
+		Legendary.bIsLegendary = true;
+	}
+
+	{
+		FCSKRulesSpellCard& Bolt = SpellCards.AddDefaulted_GetRef();
+		Bolt.StaticCost = 3;
+		Bolt.Damage = 3;
+
+		FCSKRulesSpellCard& Surge = SpellCards.AddDefaulted_GetRef();
+		Surge.StaticCost = 2;
+		Surge.bExpectsAdditionalMana = true;
+
+		FCSKRulesSpellCard& Quake = SpellCards.AddDefaulted_GetRef();
+		Quake.StaticCost = 6;
+		Quake.Damage = 8;
+	}
+}
+
+/** Plays random matches on a generated board, reporting how many can be simulated per second on this thread */
+static void RunRulesEngineBenchmark(const TArray<FString>& Args)
+{
+	const int32 NumMatches = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+
+	// Rounds before a match is abandoned (random players are not very good at ending matches)
+	const int32 MaxRounds = 100;
+
+	FCSKRules Rules;
+	Rules.InitBenchmark();
+
+	FCSKRulesEngine Engine(Rules);
+	FRandomStream PlayerStream(NumMatches);
+
+	FCSKRulesState State;
+	TArray<FCSKRulesAction> Actions;
+
+	int64 NumActions = 0;
+	int32 NumWins[CSK_MAX_NUM_PLAYERS] = { 0 };
+	int32 NumAbandoned = 0;
+
+	double Time = FPlatformTime::Seconds();
+	for (int32 Match = 0; Match < NumMatches; ++Match)
+	{
+		Engine.InitMatch(State, Match % CSK_MAX_NUM_PLAYERS, Match);
+
+		while (!State.IsMatchOver() && State.Round <= MaxRounds)
+		{
+			Engine.GetLegalActions(State, Actions);
+			if (Actions.Num() == 0)
+			{
+				if (State.ActivePlayer == INDEX_NONE)
+				{
+					break;
+				}
+
+				// Player is stuck, in the game they would have to wait for the action phase to time out
+				Engine.TimeOutActionPhase(State);
+				continue;
+			}
+
+			verify(Engine.ApplyAction(State, Actions[PlayerStream.RandHelper(Actions.Num())]));
+			++NumActions;
+		}
+
+		if (State.IsMatchOver())
+		{
+			++NumWins[State.Winner];
+		}
+		else
+		{
+			++NumAbandoned;
+		}
+	}
+	Time = FPlatformTime::Seconds() - Time;
+
+	UE_LOG(LogConquest, Display, TEXT("RulesEngine: %i matches in %.3f s (%.1f matches/s, %.2f us/action, %.1f actions/match). Wins P1 %i, P2 %i, abandoned %i"),
+		NumMatches, Time, NumMatches / Time, Time * 1e6 / FMath::Max<int64>(1, NumActions),
+		static_cast<double>(NumActions) / NumMatches, NumWins[0], NumWins[1], NumAbandoned);
+}
+
+static FAutoConsoleCommand RulesEngineBenchmarkCommand(
+	TEXT("CSK.Rules.Benchmark"),
+	TEXT("Simulates matches between random players using the rules engine on one thread. Usage: CSK.Rules.Benchmark [NumMatches]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunRulesEngineBenchmark));
+
+#endif
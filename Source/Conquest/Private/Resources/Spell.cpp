@@ -2,7 +2,11 @@
 
 #include "Spell.h"
 #include "SpellActor.h"
+#include "BoardManager.h"
+#include "Castle.h"
 #include "CSKPlayerState.h"
+#include "Tile.h"
+#include "Containers/HexBitboard.h"
 
 #define LOCTEXT_NAMESPACE "USpell"
 
@@ -15,6 +19,7 @@ USpell::USpell()
 	bSpellRequiresTarget = false;
 	bSpellExpectsAdditionalMana = false;
 	bSpellNullifiesSpells = false;
+	SimulatedDamage = 0;
 
 	SpellActorClass = ASpellActor::StaticClass();
 }
@@ -26,19 +31,172 @@ bool USpell::RequiresTarget_Implementation() const
 
 bool USpell::CanActivateSpell_Implementation(const ACSKPlayerState* CastingPlayer, const ATile* TargetTile) const
 {
-	return TargetTile != nullptr;
+	return DoesTileMatchTargetingRules(CastingPlayer, TargetTile);
 }
 
 int32 USpell::CalculateFinalCost_Implementation(const ACSKPlayerState* CastingPlayer, const ATile* TargetTile, int32 DiscountedCost, int32 AdditionalMana) const
 {
+	int32 FinalCost = DiscountedCost;
 	if (bSpellExpectsAdditionalMana)
 	{
-		return DiscountedCost + AdditionalMana;
+		FinalCost += AdditionalMana;
 	}
-	else
+
+	if (TargetingRules.HasCostPerTile() && TargetTile)
+	{
+		const ATile* CastleTile = GetCastingPlayersCastleTile(CastingPlayer);
+		if (CastleTile)
+		{
+			const int32 Distance = FHexGrid::HexDisplacement(CastleTile->GetGridHexValue(), TargetTile->GetGridHexValue());
+			FinalCost += Distance * TargetingRules.ManaPerTileFromCastle;
+		}
+	}
+
+	return FinalCost;
+}
+
+bool USpell::CanActivateSpellOnTile(const ACSKPlayerState* CastingPlayer, const ATile* TargetTile) const
+{
+	// Avoid the blueprint VM unless this spell has custom logic
+	if (GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(USpell, CanActivateSpell)))
+	{
+		return CanActivateSpell(CastingPlayer, TargetTile);
+	}
+
+	return CanActivateSpell_Implementation(CastingPlayer, TargetTile);
+}
+
+int32 USpell::GetFinalCost(const ACSKPlayerState* CastingPlayer, const ATile* TargetTile, int32 DiscountedCost, int32 AdditionalMana) const
+{
+	// Avoid the blueprint VM unless this spell has custom logic
+	if (GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(USpell, CalculateFinalCost)))
+	{
+		return CalculateFinalCost(CastingPlayer, TargetTile, DiscountedCost, AdditionalMana);
+	}
+
+	return CalculateFinalCost_Implementation(CastingPlayer, TargetTile, DiscountedCost, AdditionalMana);
+}
+
+bool USpell::UsesCustomTargeting() const
+{
+	const UClass* SpellClass = GetClass();
+	return SpellClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(USpell, CanActivateSpell)) ||
+		SpellClass->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(USpell, CalculateFinalCost));
+}
+
+bool USpell::DoesTileMatchTargetingRules(const ACSKPlayerState* CastingPlayer, const ATile* TargetTile) const
+{
+	if (!TargetTile)
+	{
+		return false;
+	}
+
+	if (TargetingRules.HasMaxRange())
+	{
+		const ATile* CastleTile = GetCastingPlayersCastleTile(CastingPlayer);
+		if (!CastleTile || FHexGrid::HexDisplacement(CastleTile->GetGridHexValue(), TargetTile->GetGridHexValue()) > TargetingRules.MaxRange)
+		{
+			return false;
+		}
+	}
+
+	const ECSKElementType Elements = TargetingRules.GetElements();
+	if (Elements != ECSKElementType::None && (TargetTile->TileType & Elements) == ECSKElementType::None)
+	{
+		return false;
+	}
+
+	ESpellTargetOccupant Occupant = ESpellTargetOccupant::Empty;
+	if (TargetTile->bIsNullTile)
+	{
+		Occupant = ESpellTargetOccupant::NullTile;
+	}
+	else if (TargetTile->IsTileOccupied(false))
 	{
-		return DiscountedCost;
+		const bool bIsOwn = CastingPlayer && TargetTile->GetBoardPiecesOwnerPlayerID() == CastingPlayer->GetCSKPlayerID();
+		if (TargetTile->GetBoardPiece()->IsA<ACastle>())
+		{
+			Occupant = bIsOwn ? ESpellTargetOccupant::OwnCastle : ESpellTargetOccupant::EnemyCastle;
+		}
+		else
+		{
+			Occupant = bIsOwn ? ESpellTargetOccupant::OwnTower : ESpellTargetOccupant::EnemyTower;
+		}
 	}
+
+	return (TargetingRules.GetOccupants() & Occupant) != ESpellTargetOccupant::None;
+}
+
+void USpell::GetTargetingRulesMask(const ACSKPlayerState* CastingPlayer, const ABoardManager* BoardManager, FHexBitboard& OutMask) const
+{
+	if (!BoardManager)
+	{
+		OutMask.Init(0);
+		return;
+	}
+
+	const FHexGrid& HexGrid = BoardManager->GetHexGrid();
+	const int32 NumCells = HexGrid.Num();
+
+	OutMask.Init(NumCells);
+
+	// Bitboards are only built once play begins
+	if (!BoardManager->AreBitboardsValid())
+	{
+		for (int32 Index = 0; Index < NumCells; ++Index)
+		{
+			OutMask.SetValue(Index, DoesTileMatchTargetingRules(CastingPlayer, HexGrid.GetTileAtIndex(Index)));
+		}
+
+		return;
+	}
+
+	const ESpellTargetOccupant Occupants = TargetingRules.GetOccupants();
+	if ((Occupants & ESpellTargetOccupant::Empty) != ESpellTargetOccupant::None)
+	{
+		OutMask.SetAll();
+		OutMask.AndNot(BoardManager->GetNullBitboard());
+		OutMask.AndNot(BoardManager->GetOccupiedBitboard());
+	}
+
+	if ((Occupants & ESpellTargetOccupant::NullTile) != ESpellTargetOccupant::None)
+	{
+		OutMask |= BoardManager->GetNullBitboard();
+	}
+
+	// There are only ever a handful of board pieces, so we can check them individually
+	const ESpellTargetOccupant PieceOccupants = ESpellTargetOccupant::OwnCastle | ESpellTargetOccupant::OwnTower |
+		ESpellTargetOccupant::EnemyCastle | ESpellTargetOccupant::EnemyTower;
+	if ((Occupants & PieceOccupants) != ESpellTargetOccupant::None)
+	{
+		BoardManager->GetOccupiedBitboard().ForEachSetBit([this, CastingPlayer, &HexGrid, &OutMask](int32 Index)
+		{
+			OutMask.SetValue(Index, DoesTileMatchTargetingRules(CastingPlayer, HexGrid.GetTileAtIndex(Index)));
+		});
+	}
+
+	const ECSKElementType Elements = TargetingRules.GetElements();
+	if (Elements != ECSKElementType::None && Elements != ECSKElementType::All)
+	{
+		FHexBitboard ElementMask;
+		BoardManager->GetElementMask(Elements, ElementMask);
+
+		OutMask &= ElementMask;
+	}
+
+	if (TargetingRules.HasMaxRange())
+	{
+		FHexBitboard RangeMask;
+		BoardManager->GetRangeMask(GetCastingPlayersCastleTile(CastingPlayer), TargetingRules.MaxRange, RangeMask);
+
+		OutMask &= RangeMask;
+	}
+}
+
+const ATile* USpell::GetCastingPlayersCastleTile(const ACSKPlayerState* CastingPlayer)
+{
+	const ACastle* Castle = CastingPlayer ? CastingPlayer->GetCastle() : nullptr;
+	return Castle ? Castle->GetCachedTile() : nullptr;
 }
 
 ACSKGameMode* USpell::GetCSKGameMode(const ACSKPlayerState* CastingPlayer) const
@@ -9,4 +9,13 @@ UTowerConstructionData::UTowerConstructionData()
 	TowerClass = ATower::StaticClass();
 	GoldCost = 5;
 	ManaCost = 0;
+
+	CollectionGold = 0;
+	CollectionMana = 0;
+	CollectionSpellUses = 0;
+
+	SimulatedCollectionGold = 0;
+	SimulatedCollectionMana = 0;
+	SimulatedEndRoundDamage = 0;
+	SimulatedEndRoundRange = 0;
 }
\ No newline at end of file
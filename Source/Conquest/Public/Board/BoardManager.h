@@ -3,11 +3,16 @@
 #pragma once
 
 #include "Conquest.h"
+#include "BoardOccupancy.h"
 #include "Tile.h"
+#include "Containers/HexBitboard.h"
 #include "Containers/HexGrid.h"
+#include "Containers/LruCache.h"
 #include "BoardManager.generated.h"
 
 class ATower;
+class UInstancedStaticMeshComponent;
+class UTexture2D;
 class UMaterialInstanceConstant;
 class UMaterialInterface;
 
@@ -108,6 +113,7 @@ protected:
 	// End AActor Interface
 
 	// Begin UObject Interface
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	#if WITH_EDITOR
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 	#endif
@@ -246,6 +252,93 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Board")
 	bool GetOccupiedTilesWithinDistance(const ATile* Origin, int32 Distance, TArray<ATile*>& OutTiles, bool bIgnoreNullTiles = true, bool bIgnoreOrigin = true) const;
 
+	/** Finds all the tiles that can be reached from the origin within given amount of moves (or null if none can be).
+	The set can then be used to generate the path to any of these tiles without searching again. The set is shared
+	with the query cache, so repeated queries for the same origin and occupancy never copy it */
+	TSharedPtr<const FHexGridReachableSet> GetReachableTiles(const ATile* Origin, int32 MaxDistance) const;
+
+	/** Generates a path from a reachable sets origin to goal tile. Get if goal was reachable */
+	bool GetPathFromReachableSet(const FHexGridReachableSet& ReachableSet, const ATile* Goal, FBoardPath& OutPath) const;
+
+public:
+
+	/** Get the current occupancy generation. This changes every time a board piece is placed or cleared */
+	FORCEINLINE uint32 GetOccupancyGeneration() const { return OccupancyGeneration; }
+
+	/** Get the zobrist hash of the board (see FCSKZobrist). This covers the element of every tile and the owner of
+	every board piece, and is updated as pieces are placed and cleared, so will match on the server and every client */
+	FORCEINLINE uint64 GetBoardHash() const { return BoardHash; }
+
+private:
+
+	/** Key for cached path finding results */
+	struct FPathCacheKey
+	{
+		FPathCacheKey(const FIntVector& InStart, const FIntVector& InGoal, int32 InMaxDistance, bool bInAllowPartial, uint32 InGeneration)
+			: Start(InStart)
+			, Goal(InGoal)
+			, MaxDistance(InMaxDistance)
+			, bAllowPartial(bInAllowPartial)
+			, Generation(InGeneration)
+		{
+
+		}
+
+		FORCEINLINE bool operator == (const FPathCacheKey& Other) const
+		{
+			return Start == Other.Start && Goal == Other.Goal && MaxDistance == Other.MaxDistance &&
+				bAllowPartial == Other.bAllowPartial && Generation == Other.Generation;
+		}
+
+		FORCEINLINE friend uint32 GetTypeHash(const FPathCacheKey& Key)
+		{
+			uint32 Hash = HashCombine(GetTypeHash(Key.Start), GetTypeHash(Key.Goal));
+			Hash = HashCombine(Hash, GetTypeHash(Key.MaxDistance) ^ (Key.bAllowPartial ? 0x80000000 : 0));
+			return HashCombine(Hash, GetTypeHash(Key.Generation));
+		}
+
+		FIntVector Start;
+		FIntVector Goal;
+		int32 MaxDistance;
+		bool bAllowPartial;
+		uint32 Generation;
+	};
+
+	/** Key for cached reachable sets */
+	struct FReachableCacheKey
+	{
+		FReachableCacheKey(const FIntVector& InOrigin, int32 InMaxDistance, uint32 InGeneration)
+			: Origin(InOrigin)
+			, MaxDistance(InMaxDistance)
+			, Generation(InGeneration)
+		{
+
+		}
+
+		FORCEINLINE bool operator == (const FReachableCacheKey& Other) const
+		{
+			return Origin == Other.Origin && MaxDistance == Other.MaxDistance && Generation == Other.Generation;
+		}
+
+		FORCEINLINE friend uint32 GetTypeHash(const FReachableCacheKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.Origin), GetTypeHash(Key.MaxDistance)), GetTypeHash(Key.Generation));
+		}
+
+		FIntVector Origin;
+		int32 MaxDistance;
+		uint32 Generation;
+	};
+
+	/** Incremented whenever a tiles board piece changes, used to invalidate cached queries */
+	uint32 OccupancyGeneration;
+
+	/** Recently generated paths. Entries of old generations are never hit and will eventually be evicted */
+	mutable TLruCache<FPathCacheKey, FHexGridPathFindResultData> PathCache;
+
+	/** Recently generated reachable sets. Entries of old generations are never hit and will eventually be evicted */
+	mutable TLruCache<FReachableCacheKey, TSharedPtr<const FHexGridReachableSet>> ReachableCache;
+
 public:
 
 	/** Attempts to place the board piece on given tile. This only runs on the server */
@@ -256,11 +349,25 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Board|Tiles")
 	bool ClearBoardPieceOnTile(ATile* Tile);
 
+public:
+
+	/** Notify that an occupancy entry has been replicated to this client (or the entries board piece has) */
+	void OnBoardPieceEntryAdded(const FBoardOccupancyEntry& Entry);
+
+	/** Notify that an occupancy entry is about to be removed from this client */
+	void OnBoardPieceEntryRemoved(const FBoardOccupancyEntry& Entry);
+
 private:
 
-	/** Add/Removes tile with board piece for each client */
-	UFUNCTION(NetMulticast, Reliable)
-	void Multi_SetTileWithBoardPiece(ATile* Tile, bool bHasBoardPiece);
+	/** Add/Removes tile with board piece. Owner ID is the player who owns the piece (or -1) */
+	void SetTileWithBoardPiece(ATile* Tile, bool bHasBoardPiece, int32 OwnerID);
+
+private:
+
+	/** Every board piece on the board. Clients apply these to their tiles as they replicate, which allows
+	players who join late to receive the whole board, and for changes to be sent as deltas */
+	UPROPERTY(Replicated)
+	FBoardOccupancyArray BoardOccupancy;
 
 protected:
 
@@ -269,6 +376,69 @@ protected:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Board|Tiles")
 	TSet<ATile*> TilesWithBoardPieces;
 
+public:
+
+	/** Rebuilds all bitboards using the current state of each tile */
+	void RebuildBitboards();
+
+	/** Get if bitboards can be used to query the board (they are built once play begins) */
+	bool AreBitboardsValid() const;
+
+	/** Get the cells within given distance of origin as a mask (including origin) */
+	void GetRangeMask(const ATile* Origin, int32 Distance, FHexBitboard& OutMask) const;
+
+	/** Get the cells that match any of given elements as a mask */
+	void GetElementMask(ECSKElementType Elements, FHexBitboard& OutMask) const;
+
+	/** Get the cells towers can be placed on as a mask (not occupied, null or a portal) */
+	void GetBuildableMask(FHexBitboard& OutMask) const;
+
+	/** Get the tiles for every cell set in given mask */
+	void GetTilesFromMask(const FHexBitboard& Mask, TArray<ATile*>& OutTiles) const;
+
+public:
+
+	/** Get the bitboard of null tiles */
+	FORCEINLINE const FHexBitboard& GetNullBitboard() const { return NullBitboard; }
+
+	/** Get the bitboard of tiles with a board piece on them */
+	FORCEINLINE const FHexBitboard& GetOccupiedBitboard() const { return OccupiedBitboard; }
+
+	/** Get the bitboard of portal tiles */
+	FORCEINLINE const FHexBitboard& GetPortalBitboard() const { return PortalBitboard; }
+
+	/** Get the bitboard of tiles with a board piece owned by given player */
+	FORCEINLINE const FHexBitboard& GetPlayerBitboard(int32 PlayerID) const
+	{
+		check(PlayerID >= 0 && PlayerID < CSK_MAX_NUM_PLAYERS);
+		return PlayerBitboards[PlayerID];
+	}
+
+private:
+
+	/** Updates bitboards for a tile that has had its board piece changed */
+	void UpdateBitboardsForTile(const ATile* Tile, bool bHasBoardPiece, int32 OwnerID);
+
+private:
+
+	/** Cells of tiles that are null */
+	FHexBitboard NullBitboard;
+
+	/** Cells of tiles with board pieces on them */
+	FHexBitboard OccupiedBitboard;
+
+	/** Cells of tiles that are player portals */
+	FHexBitboard PortalBitboard;
+
+	/** Cells of tiles with board pieces owned by each player */
+	FHexBitboard PlayerBitboards[CSK_MAX_NUM_PLAYERS];
+
+	/** Cells of tiles for each element (in order of ECSKElementType flags) */
+	FHexBitboard ElementBitboards[4];
+
+	/** Hash of elements and occupants, kept in sync with the bitboards */
+	uint64 BoardHash;
+
 public:
 
 	/** Moves a board piece under the board based on it's boundaries */
@@ -304,7 +474,21 @@ public:
 public:
 
 	/** Determines and sets the highlight material that given tile should use */
-	void SetTilesHighlightMaterial(ATile* Tile) const;
+	void SetTilesHighlightMaterial(ATile* Tile);
+
+	/** Marks given tile as needing its highlight refreshed. Tiles are refreshed once
+	on the next tick, no matter how many times their state changed before then */
+	void MarkTileHighlightDirty(ATile* Tile);
+
+	/** Refreshes the highlight of every tile marked as dirty */
+	void FlushDirtyTileHighlights();
+
+	/** Determines the highlight material that given tile should use. Get if the tiles material should be changed */
+	bool GetTilesHighlightMaterial(const ATile* Tile, UMaterialInterface*& OutMaterial) const;
+
+	/** Determines the highlight state given tile should be displaying. Player ID will be
+	set to the player associated with the highlight, or -1 if no player is associated */
+	bool GetTilesHighlightState(const ATile* Tile, ETileHighlightState& OutState, int32& OutPlayerID) const;
 
 	/** Sets the color for highlight material associated with player. This will create a new material if it doesn't exist */
 	void SetHighlightColorForPlayer(int32 PlayerID, FLinearColor Color);
@@ -349,5 +533,100 @@ protected:
 	/** The player highlight material associated with player 2 */
 	UPROPERTY(Transient)
 	UMaterialInstanceDynamic* Player2HighlightMaterial;
+
+public:
+
+	/** Get if tiles are being rendered as instances instead of by their own meshes */
+	FORCEINLINE bool IsUsingInstancedTileRendering() const { return bInstancedTilesActive; }
+
+private:
+
+	/** Hides each tiles mesh and starts rendering them as instances. Tiles
+	sharing the same material are batched into the same instanced component */
+	void InitInstancedTileRendering();
+
+	/** Moves the instance of given tile into the batch for material */
+	void SetTileInstanceMaterial(const ATile* Tile, UMaterialInterface* Material);
+
+	/** Adds an instance for the cell to the batch for material */
+	void AddTileInstance(int32 CellIndex, UMaterialInterface* Material, const FTransform& Transform);
+
+	/** Removes the instance of the cell from its current batch. Get the transform of the removed instance */
+	FTransform RemoveTileInstance(int32 CellIndex);
+
+protected:
+
+	/** If tiles should be rendered as instances (one draw call per highlight material) 
+	instead of by each tiles own mesh. Tiles still exist, but their meshes are hidden */
+	UPROPERTY(EditAnywhere, Category = "Board|Rendering")
+	uint8 bUseInstancedTileRendering : 1;
+
+private:
+
+	/** If instanced tile rendering has been initialized */
+	uint8 bInstancedTilesActive : 1;
+
+	/** Instanced component for each material tiles are currently using */
+	UPROPERTY(Transient)
+	TArray<UInstancedStaticMeshComponent*> TileInstanceBatches;
+
+	/** Maps materials to their batch in tile instance batches */
+	TMap<UMaterialInterface*, int32> TileInstanceBatchLookup;
+
+	/** The cell each instance of each batch is for */
+	TArray<TArray<int32>> TileInstanceBatchCells;
+
+	/** The batch (X) and instance (Y) of each cell, INDEX_NONE if cell has no instance */
+	TArray<FIntPoint> TileInstanceHandles;
+
+public:
+
+	/** Get if tiles are highlighted using the board state texture */
+	FORCEINLINE bool IsUsingBoardStateTexture() const { return BoardStateMaterialInstance != nullptr; }
+
+	/** Get the texture containing the highlight state of each cell */
+	FORCEINLINE UTexture2D* GetBoardStateTexture() const { return BoardStateTexture; }
+
+private:
+
+	/** Creates the board state texture and has every tile use the board state material */
+	void InitBoardStateTexture();
+
+	/** Writes the highlight state of given tile into the board state. Will queue an upload if state changed */
+	void WriteTileBoardState(const ATile* Tile);
+
+	/** Uploads the board state to the texture. Is called at most once a frame */
+	void UploadBoardStateTexture();
+
+protected:
+
+	/** Material all tiles will share if set. This material should sample the BoardState texture parameter to 
+	determine the highlight of the tile being rendered. Each texel (Column, Row) of the texture represents a cell, with
+	R = ETileHighlightState, G = ECSKElementType and B = Player ID + 1. The board is described by the BoardOrigin,
+	BoardHexSize and BoardDimensions (Rows, Columns) parameters, with player colors set by Player1Color and Player2Color */
+	UPROPERTY(EditAnywhere, Category = "Board|Rendering")
+	UMaterialInterface* BoardStateMaterial;
+
+private:
+
+	/** Dynamic instance of the board state material shared by every tile */
+	UPROPERTY(Transient)
+	UMaterialInstanceDynamic* BoardStateMaterialInstance;
+
+	/** Texture containing the highlight state of each cell */
+	UPROPERTY(Transient)
+	UTexture2D* BoardStateTexture;
+
+	/** CPU copy of the board state, indexed by cell */
+	TArray<FColor> BoardStateTexels;
+
+	/** Handle to the pending upload of the board state */
+	FTimerHandle BoardStateUploadHandle;
+
+	/** Cells of tiles waiting for their highlight to be refreshed */
+	FHexBitboard DirtyHighlightBitboard;
+
+	/** Handle to the pending refresh of dirty tiles */
+	FTimerHandle DirtyHighlightHandle;
 };
 
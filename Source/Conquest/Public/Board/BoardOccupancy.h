@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Conquest.h"
+#include "BoardOccupancy.generated.h"
+
+class ABoardManager;
+
+/** A board piece placed on a tile, replicated as part of the boards occupancy */
+USTRUCT()
+struct CONQUEST_API FBoardOccupancyEntry : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+public:
+
+	FBoardOccupancyEntry()
+		: Cell(INDEX_NONE)
+		, BoardPiece(nullptr)
+		, OwnerID(-1)
+	{
+
+	}
+
+	FBoardOccupancyEntry(int32 InCell, AActor* InBoardPiece, int32 InOwnerID)
+		: Cell(InCell)
+		, BoardPiece(InBoardPiece)
+		, OwnerID(static_cast<int8>(InOwnerID))
+	{
+
+	}
+
+public:
+
+	// Begin FFastArraySerializerItem Interface
+	void PreReplicatedRemove(const struct FBoardOccupancyArray& InArraySerializer);
+	void PostReplicatedAdd(const struct FBoardOccupancyArray& InArraySerializer);
+	void PostReplicatedChange(const struct FBoardOccupancyArray& InArraySerializer);
+	// End FFastArraySerializerItem Interface
+
+public:
+
+	/** Index of the tile the board piece is on */
+	UPROPERTY()
+	int32 Cell;
+
+	/** The board piece on the tile. This can be null on clients if the piece has yet to replicate */
+	UPROPERTY()
+	AActor* BoardPiece;
+
+	/** The player who owns the board piece (or -1) */
+	UPROPERTY()
+	int8 OwnerID;
+};
+
+/**
+ * Every board piece on the board, replicated by the board manager. Only entries that have been
+ * added, changed or removed are sent, with clients applying them to their tiles as they arrive
+ */
+USTRUCT()
+struct CONQUEST_API FBoardOccupancyArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+public:
+
+	FBoardOccupancyArray()
+		: BoardManager(nullptr)
+	{
+
+	}
+
+public:
+
+	/** Adds an entry for board piece placed on cell */
+	void AddEntry(int32 Cell, AActor* BoardPiece, int32 OwnerID);
+
+	/** Removes the entry for cell. Get if an entry was removed */
+	bool RemoveEntry(int32 Cell);
+
+	/** Get the entries of the array */
+	FORCEINLINE const TArray<FBoardOccupancyEntry>& GetEntries() const { return Entries; }
+
+public:
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FBoardOccupancyEntry, FBoardOccupancyArray>(Entries, DeltaParms, *this);
+	}
+
+private:
+
+	/** Every board piece on the board */
+	UPROPERTY()
+	TArray<FBoardOccupancyEntry> Entries;
+
+public:
+
+	/** The board manager that owns this array */
+	UPROPERTY(NotReplicated)
+	ABoardManager* BoardManager;
+};
+
+template<>
+struct TStructOpsTypeTraits<FBoardOccupancyArray> : public TStructOpsTypeTraitsBase2<FBoardOccupancyArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true
+	};
+};
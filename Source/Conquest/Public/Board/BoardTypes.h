@@ -44,6 +44,30 @@ enum class ETileSelectionState : uint8
 	UnselectablePriority
 };
 
+/** The highlight a tile should be displaying, in order of priority. This is
+written into the board state texture, so values should not be re-ordered */
+UENUM(BlueprintType)
+enum class ETileHighlightState : uint8
+{
+	/** Tile is highlighted based on its element */
+	Element,
+
+	/** Tile is a null tile */
+	Null,
+
+	/** Tile is marked as selectable */
+	Selectable,
+
+	/** Tile is marked as unselectable */
+	Unselectable,
+
+	/** Tile is being hovered by the local player */
+	Hovered,
+
+	/** Tile is a players portal or has a board piece owned by a player */
+	Player
+};
+
 /** A path for traversing the board */
 USTRUCT(BlueprintType)
 struct CONQUEST_API FBoardPath
@@ -5,6 +5,8 @@
 #include "Conquest.h"
 #include "GameFramework/Pawn.h"
 #include "BoardPieceInterface.h"
+#include "BoardTypes.h"
+#include "NetTileRef.h"
 #include "Castle.generated.h"
 
 class UFloatingPawnMovement;
@@ -36,6 +38,12 @@ public:
 	virtual void GetBoardPieceUIData(FBoardPieceUIData& OutUIData) const override;
 	// End IBoardPiece Interface
 
+public:
+
+	// Begin AActor Interface
+	virtual void Tick(float DeltaTime) override;
+	// End AActor Interface
+
 protected:
 
 	// Begin UObject Interface
@@ -96,6 +104,51 @@ protected:
 	UPROPERTY(BlueprintReadOnly, Transient, Replicated, Category = BoardPiece)
 	ACSKPlayerState* OwnerPlayerState;
 
+public:
+
+	/** Sends path castle has started following to clients, who will simulate it locally (only call on server) */
+	void ReplicateBoardPath(const FBoardPath& InPath);
+
+	/** Notifies clients that castle has reached given tile of the path being followed (only call on server) */
+	void ReplicateBoardPathCheckpoint(ATile* Tile);
+
+	/** Stops clients simulating any path and moves them to our current location (only call on server) */
+	void ReplicateLocation();
+
+private:
+
+	/** Starts simulating given path that the server started following at start time */
+	UFUNCTION(NetMulticast, Reliable)
+	void Multi_FollowBoardPath(const TArray<FNetTileRef>& PathTiles, float ServerStartTime);
+
+	/** Snaps simulated path to tile at index, which the server reached at given time */
+	UFUNCTION(NetMulticast, Reliable)
+	void Multi_BoardPathCheckpoint(uint8 TileIndex, float ServerTime);
+
+	/** Stops simulating path and moves to location */
+	UFUNCTION(NetMulticast, Reliable)
+	void Multi_SyncLocation(FVector_NetQuantize Location);
+
+	/** Moves along the simulated path based on the servers world time */
+	void TickSimulatedBoardPath();
+
+	/** Stops simulating path (if any) */
+	void StopSimulatingBoardPath();
+
+	/** Get the current server world time */
+	float GetServerWorldTime() const;
+
+private:
+
+	/** The path we are following. Clients use this to simulate movement, while the server uses it for checkpoints */
+	FBoardPath SimulatedPath;
+
+	/** Index of tile in the path we were last at */
+	int32 SimulatedTileIndex;
+
+	/** Server world time we were at simulated tile index */
+	float SimulatedTileTime;
+
 private:
 
 	/** The tile we are currently on, this is cached for quick access to it */
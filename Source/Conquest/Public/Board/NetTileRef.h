@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Conquest.h"
+#include "NetTileRef.generated.h"
+
+class ABoardManager;
+class ATile;
+
+/**
+ * Reference to a tile that is sent over the network by its hex instead of as an object. Only the row and column
+ * of the hex are written, bit-packed to the fewest bits that fit them (so never larger than the board needs).
+ * Unlike object references, these never need to be mapped and will resolve as soon as the board is available
+ */
+USTRUCT()
+struct CONQUEST_API FNetTileRef
+{
+	GENERATED_BODY()
+
+public:
+
+	FNetTileRef()
+		: Hex(-1)
+	{
+
+	}
+
+	/** Implicit so tiles can be passed directly to RPCs */
+	FNetTileRef(const ATile* Tile);
+
+public:
+
+	/** Get if this references a tile */
+	bool IsValid() const;
+
+	/** Get the tile this references on given board (or null) */
+	ATile* Resolve(const ABoardManager* BoardManager) const;
+
+	/** Get the tile this references on the match board of world (or null) */
+	ATile* Resolve(const UObject* WorldContextObject) const;
+
+	/** Get the hex of the tile this references */
+	FORCEINLINE const FIntVector& GetHex() const { return Hex; }
+
+public:
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+private:
+
+	/** The hex of the tile this references */
+	UPROPERTY()
+	FIntVector Hex;
+};
+
+template<>
+struct TStructOpsTypeTraits<FNetTileRef> : public TStructOpsTypeTraitsBase2<FNetTileRef>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
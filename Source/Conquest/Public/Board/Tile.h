@@ -36,7 +36,6 @@ public:
 protected:
 
 	// Begin UObject Interface
-	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	#if WITH_EDITOR
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 	#endif
@@ -140,13 +139,15 @@ protected:
 	UFUNCTION(BlueprintImplementableEvent, Category = "Board|Tiles", meta = (DisplayName = "On Board Piece Cleared"))
 	void BP_OnBoardPieceCleared();
 
-	/** Sets the board piece to occupy this tile */
-	UFUNCTION(NetMulticast, Reliable)
-	void Multi_SetBoardPiece(AActor* BoardPiece);
+private:
+
+	friend class ABoardManager;
+
+	/** Sets the board piece to occupy this tile. This is called on clients by the board manager as occupancy replicates */
+	void HandleBoardPieceSet(AActor* BoardPiece);
 
-	/** Clears the board piece occupying this tile */
-	UFUNCTION(NetMulticast, Reliable)
-	void Multi_ClearBoardPiece();
+	/** Clears the board piece occupying this tile. This is called on clients by the board manager as occupancy replicates */
+	void HandleBoardPieceCleared();
 
 public:
 
@@ -191,7 +192,7 @@ private:
 
 public:
 
-	/** Refreshes this tiles highlight material */
+	/** Refreshes this tiles highlight material. The refresh is deferred to the next tick during play */
 	UFUNCTION(BlueprintCallable, Category = "Board|Tiles")
 	void RefreshHighlightMaterial();
 };
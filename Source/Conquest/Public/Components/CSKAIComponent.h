@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Conquest.h"
+#include "Components/ActorComponent.h"
+#include "CSKMonteCarloSearch.h"
+#include "Async/Future.h"
+#include "CSKAIComponent.generated.h"
+
+class ACSKGameMode;
+class ACSKPlayerController;
+
+/**
+ * Component that decides actions for the player controller that owns it. Actions are decided using a Monte
+ * Carlo Tree Search over the rules engine, which runs on background threads while the game thread carries on.
+ * Decisions are requested using the same server requests as a human player. This only runs on the server
+ */
+UCLASS(ClassGroup = (CSK), meta = (BlueprintSpawnableComponent))
+class CONQUEST_API UCSKAIComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	UCSKAIComponent();
+
+public:
+
+	// Begin UActorComponent Interface
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	// End UActorComponent Interface
+
+public:
+
+	/** The time (in seconds) the AI is allowed to spend deciding each action */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = AI, meta = (ClampMin = 0.05))
+	float TimeBudget;
+
+	/** The amount of threads to search with (zero uses every search thread) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = AI, meta = (ClampMin = 0))
+	int32 NumThreads;
+
+private:
+
+	/** Starts searching for the next action to perform */
+	void StartSearch(ACSKGameMode* GameMode);
+
+	/** Requests the action found by the last search */
+	void FinishSearch(ACSKGameMode* GameMode);
+
+	/** Cancels the search in progress, waiting for it to finish */
+	void CancelSearch();
+
+	/** Requests action using owners server requests */
+	void RequestAction(ACSKPlayerController* Controller, const FCSKRulesAction& Action) const;
+
+	/** Get if the match has moved onto a different action phase since last checked */
+	bool HasActionPhaseChanged(ACSKGameMode* GameMode);
+
+private:
+
+	/** Data shared with a search running on another thread */
+	struct FSearchTask
+	{
+		FSearchTask()
+			: bCancelled(false)
+		{
+
+		}
+
+		FCSKRulesState State;
+		FCSKSearchSettings Settings;
+		TAtomic<bool> bCancelled;
+	};
+
+	/** The search currently in progress */
+	TSharedPtr<FSearchTask, ESPMode::ThreadSafe> PendingSearch;
+
+	/** Result of the search in progress */
+	TFuture<FCSKSearchResult> PendingResult;
+
+	/** Actions that were denied during this action phase */
+	TArray<FCSKRulesAction> DeniedActions;
+
+	/** The round and round state of the action phase we last acted in */
+	int32 ActionPhaseRound;
+	ECSKRoundState ActionPhaseRoundState;
+
+	/** If we have no actions left and are waiting for the action phase to time out */
+	uint8 bWaitingForTimeOut : 1;
+};
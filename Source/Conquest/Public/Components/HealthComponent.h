@@ -37,6 +37,9 @@ public:
 	/** Initializes health, should be called during component creation */
 	void InitHealth(int32 InHealth, int32 InMaxHealth);
 
+	/** Overrides health and max health without notifying listeners. This is used when restoring a match snapshot */
+	void OverrideHealth(int32 InHealth, int32 InMaxHealth);
+
 	/** Applies damage to the owner. Get how much damage was applied */
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Health")
 	int32 ApplyDamage(int32 Amount);
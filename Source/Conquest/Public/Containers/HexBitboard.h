@@ -0,0 +1,201 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * A packed set of hex grid cells, with one bit per dense cell index (see FHexGrid::HexToIndex).
+ * Allows queries about the board to be performed as set operations, 64 cells at a time
+ */
+struct CONQUEST_API FHexBitboard
+{
+public:
+
+	FHexBitboard()
+		: NumBits(0)
+	{
+
+	}
+
+	explicit FHexBitboard(int32 InNumBits)
+	{
+		Init(InNumBits);
+	}
+
+public:
+
+	/** Resizes this board to fit given amount of cells, with all bits cleared */
+	FORCEINLINE void Init(int32 InNumBits)
+	{
+		check(InNumBits >= 0);
+
+		NumBits = InNumBits;
+		Words.Init(0, FMath::DivideAndRoundUp(InNumBits, 64));
+	}
+
+	/** Clears all bits without resizing */
+	FORCEINLINE void ClearAll()
+	{
+		FMemory::Memzero(Words.GetData(), Words.Num() * sizeof(uint64));
+	}
+
+	/** Sets the bits of every cell */
+	FORCEINLINE void SetAll()
+	{
+		FMemory::Memset(Words.GetData(), 0xff, Words.Num() * sizeof(uint64));
+
+		// Bits beyond the last cell should remain cleared
+		const int32 NumSlackBits = Words.Num() * 64 - NumBits;
+		if (NumSlackBits > 0)
+		{
+			Words.Last() >>= NumSlackBits;
+		}
+	}
+
+	/** Set the bit for given cell */
+	FORCEINLINE void Set(int32 Index)
+	{
+		check(Index >= 0 && Index < NumBits);
+		Words[Index >> 6] |= (uint64(1) << (Index & 63));
+	}
+
+	/** Clears the bit for given cell */
+	FORCEINLINE void Clear(int32 Index)
+	{
+		check(Index >= 0 && Index < NumBits);
+		Words[Index >> 6] &= ~(uint64(1) << (Index & 63));
+	}
+
+	/** Sets or clears the bit for given cell */
+	FORCEINLINE void SetValue(int32 Index, bool bValue)
+	{
+		if (bValue)
+		{
+			Set(Index);
+		}
+		else
+		{
+			Clear(Index);
+		}
+	}
+
+	/** Get if the bit for given cell is set. Cells outside of this board are never set */
+	FORCEINLINE bool Test(int32 Index) const
+	{
+		if (Index < 0 || Index >= NumBits)
+		{
+			return false;
+		}
+
+		return (Words[Index >> 6] & (uint64(1) << (Index & 63))) != 0;
+	}
+
+public:
+
+	/** Get the amount of cells this board covers */
+	FORCEINLINE int32 Num() const
+	{
+		return NumBits;
+	}
+
+	/** Get the amount of cells that are set */
+	FORCEINLINE int32 CountSetBits() const
+	{
+		int32 Count = 0;
+		for (uint64 Word : Words)
+		{
+			Count += static_cast<int32>(FMath::CountBits(Word));
+		}
+
+		return Count;
+	}
+
+	/** Get if no cells are set */
+	FORCEINLINE bool IsEmpty() const
+	{
+		for (uint64 Word : Words)
+		{
+			if (Word != 0)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/** Calls functor with the index of every set cell, in ascending order */
+	template <typename FunctorType>
+	FORCEINLINE void ForEachSetBit(FunctorType&& Functor) const
+	{
+		for (int32 WordIndex = 0; WordIndex < Words.Num(); ++WordIndex)
+		{
+			uint64 Word = Words[WordIndex];
+			while (Word != 0)
+			{
+				const int32 Bit = static_cast<int32>(FMath::CountTrailingZeros64(Word));
+				Functor((WordIndex << 6) + Bit);
+
+				// Clear lowest set bit
+				Word &= Word - 1;
+			}
+		}
+	}
+
+public:
+
+	FORCEINLINE FHexBitboard& operator &= (const FHexBitboard& Other)
+	{
+		check(NumBits == Other.NumBits);
+		for (int32 i = 0; i < Words.Num(); ++i)
+		{
+			Words[i] &= Other.Words[i];
+		}
+
+		return *this;
+	}
+
+	FORCEINLINE FHexBitboard& operator |= (const FHexBitboard& Other)
+	{
+		check(NumBits == Other.NumBits);
+		for (int32 i = 0; i < Words.Num(); ++i)
+		{
+			Words[i] |= Other.Words[i];
+		}
+
+		return *this;
+	}
+
+	/** Clears all cells that are set in other */
+	FORCEINLINE FHexBitboard& AndNot(const FHexBitboard& Other)
+	{
+		check(NumBits == Other.NumBits);
+		for (int32 i = 0; i < Words.Num(); ++i)
+		{
+			Words[i] &= ~Other.Words[i];
+		}
+
+		return *this;
+	}
+
+	FORCEINLINE friend FHexBitboard operator & (FHexBitboard Lhs, const FHexBitboard& Rhs)
+	{
+		Lhs &= Rhs;
+		return Lhs;
+	}
+
+	FORCEINLINE friend FHexBitboard operator | (FHexBitboard Lhs, const FHexBitboard& Rhs)
+	{
+		Lhs |= Rhs;
+		return Lhs;
+	}
+
+private:
+
+	/** The amount of cells this board covers */
+	int32 NumBits;
+
+	/** Bits for each cell, 64 cells per word */
+	TArray<uint64> Words;
+};
@@ -0,0 +1,392 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// This header must not include any engine headers, it should be usable outside of the engine
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Engine independent core of the hex grid. All functions are templated on the coordinate
+ * types used, hex types are expected to have integer X, Y and Z members and be constructible
+ * from (X, Y, Z), while vector types are expected to have floating point X, Y and Z members.
+ * Cells of a grid are addressed using dense row-major indices (see HexToIndex).
+ * Thanks to https://www.redblobgames.com/grids/hexagons/ for most of the math here.
+ * Unit tests and benchmarks build standalone with CMake from Tests/HexCore
+ */
+namespace HexCore
+{
+	/** Value used for invalid cell indices (matches INDEX_NONE) */
+	constexpr int32_t InvalidIndex = -1;
+
+	/** Offsets for travelling in each of the six directions */
+	constexpr int32_t DirectionTable[6][3] =
+	{
+		{ +1, -1, 0 }, { +1, 0, -1 }, { 0, +1, -1 },
+		{ -1, +1, 0 }, { -1, 0, +1 }, { 0, -1, +1 }
+	};
+
+	/** Get if hex is a valid cube coordinate */
+	template <typename HexType>
+	inline bool IsValidHex(const HexType& Hex)
+	{
+		return (Hex.X + Hex.Y + Hex.Z) == 0;
+	}
+
+	/** Get the hex in given direction (0 to 5) */
+	template <typename HexType>
+	inline HexType HexDirection(int32_t Direction)
+	{
+		return HexType(DirectionTable[Direction][0], DirectionTable[Direction][1], DirectionTable[Direction][2]);
+	}
+
+	/** Get the neighbor of hex in given direction (0 to 5) */
+	template <typename HexType>
+	inline HexType HexNeighbor(const HexType& Hex, int32_t Direction)
+	{
+		return HexType(Hex.X + DirectionTable[Direction][0], Hex.Y + DirectionTable[Direction][1], Hex.Z + DirectionTable[Direction][2]);
+	}
+
+	/** Get the length of a hex (distance from the center) */
+	template <typename HexType>
+	inline int32_t HexLength(const HexType& Hex)
+	{
+		// Sum is always even for valid hexes
+		return (std::abs(Hex.X) + std::abs(Hex.Y) + std::abs(Hex.Z)) / 2;
+	}
+
+	/** Get the amount of cells between two hexes */
+	template <typename HexType>
+	inline int32_t HexDisplacement(const HexType& H1, const HexType& H2)
+	{
+		return HexLength(HexType(H1.X - H2.X, H1.Y - H2.Y, H1.Z - H2.Z));
+	}
+
+	/** Rounds a fractional hex to the nearest hex */
+	template <typename HexType, typename FracHexType>
+	inline HexType HexRound(const FracHexType& FracHex)
+	{
+		// Rounds halves up (same as FMath::RoundToFloat)
+		float X = std::floor(static_cast<float>(FracHex.X) + 0.5f);
+		float Y = std::floor(static_cast<float>(FracHex.Y) + 0.5f);
+		float Z = std::floor(static_cast<float>(FracHex.Z) + 0.5f);
+
+		float DeltaX = std::abs(X - static_cast<float>(FracHex.X));
+		float DeltaY = std::abs(Y - static_cast<float>(FracHex.Y));
+		float DeltaZ = std::abs(Z - static_cast<float>(FracHex.Z));
+
+		// Need to assure that hex length will equal zero
+		if (DeltaX > DeltaY && DeltaX > DeltaZ)
+		{
+			X = -Y - Z;
+		}
+		else if (DeltaY > DeltaZ)
+		{
+			Y = -X - Z;
+		}
+		else
+		{
+			Z = -X - Y;
+		}
+
+		return HexType(static_cast<int32_t>(X), static_cast<int32_t>(Y), static_cast<int32_t>(Z));
+	}
+
+	/** Get row and column indices as a hex cell */
+	template <typename HexType>
+	inline HexType IndicesToHex(int32_t Row, int32_t Column)
+	{
+		return HexType(Row, Column, -Row - Column);
+	}
+
+	/** Get the dense index of hex in a grid with given rows and columns (or InvalidIndex if outside).
+	Columns are offset by half of the column index, matching the rectangular layout of FHexGrid */
+	template <typename HexType>
+	inline int32_t HexToIndex(const HexType& Hex, int32_t Rows, int32_t Columns)
+	{
+		const int32_t Column = Hex.Y;
+		const int32_t Row = Hex.X + (Column >> 1);
+
+		if (!IsValidHex(Hex) || Row < 0 || Row >= Rows || Column < 0 || Column >= Columns)
+		{
+			return InvalidIndex;
+		}
+
+		return Row * Columns + Column;
+	}
+
+	/** Get the hex of a dense index in a grid with given columns */
+	template <typename HexType>
+	inline HexType IndexToHex(int32_t Index, int32_t Columns)
+	{
+		const int32_t Row = Index / Columns;
+		const int32_t Column = Index % Columns;
+
+		return IndicesToHex<HexType>(Row - (Column >> 1), Column);
+	}
+
+	/** Converts a hex cell into a world position based off an origin and cell size.
+	The cell is only applied onto the XY plane, with Z being the same as Origin.Z */
+	template <typename VectorType, typename HexType>
+	inline VectorType HexToWorld(const HexType& Hex, const VectorType& Origin, const VectorType& Size)
+	{
+		const float f0 = std::sqrt(3.f);
+		const float f1 = f0 / 2.f;
+		const float f2 = 0.f;
+		const float f3 = 3.f / 2.f;
+
+		float X = (f0 * static_cast<float>(Hex.X) + f1 * static_cast<float>(Hex.Y)) * Size.X;
+		float Y = (f2 * static_cast<float>(Hex.X) + f3 * static_cast<float>(Hex.Y)) * Size.Y;
+
+		return VectorType(Origin.X + X, Origin.Y + Y, Origin.Z);
+	}
+
+	/** Converts a world position to a hex cell. Z axis does not affect calculation */
+	template <typename HexType, typename VectorType>
+	inline HexType WorldToHex(const VectorType& Position, const VectorType& Origin, const VectorType& Size)
+	{
+		const float b0 = std::sqrt(3.f) / 3.f;
+		const float b1 = -1.f / 3.f;
+		const float b2 = 0.f;
+		const float b3 = 2.f / 3.f;
+
+		float PointX = (Position.X - Origin.X) / Size.X;
+		float PointY = (Position.Y - Origin.Y) / Size.Y;
+
+		float X = b0 * PointX + b1 * PointY;
+		float Y = b2 * PointX + b3 * PointY;
+
+		return HexRound<HexType>(VectorType(X, Y, -X - Y));
+	}
+
+	/** Converts a hex tiles vertex index to a world position */
+	template <typename VectorType>
+	inline VectorType HexVertexToWorld(const VectorType& Origin, float Size, int32_t Index)
+	{
+		const float Angle = 60.f * static_cast<float>(Index) - 30.f;
+		const float Radians = Angle * (3.14159265358979323846f / 180.f);
+
+		return VectorType(
+			Origin.X + Size * std::cos(Radians),
+			Origin.Y + Size * std::sin(Radians),
+			Origin.Z);
+	}
+
+	/** Calls functor with the offset (as row and column) of every cell within distance of
+	a center cell (including the center). Functor should return false to stop early */
+	template <typename FunctorType>
+	inline bool ForEachOffsetInRange(int32_t Distance, FunctorType&& Functor)
+	{
+		for (int32_t x = -Distance; x <= Distance; ++x)
+		{
+			for (int32_t y = std::max(-Distance, -x - Distance); y <= std::min(Distance, -x + Distance); ++y)
+			{
+				if (!Functor(x, y))
+				{
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	/** Calls functor with every hex that is exactly radius cells away from center, walking around
+	the ring starting from the south west corner. Functor should return false to stop early */
+	template <typename HexType, typename FunctorType>
+	inline bool ForEachHexInRing(const HexType& Center, int32_t Radius, FunctorType&& Functor)
+	{
+		if (Radius <= 0)
+		{
+			return Radius < 0 || Functor(Center);
+		}
+
+		HexType Hex(
+			Center.X + DirectionTable[4][0] * Radius,
+			Center.Y + DirectionTable[4][1] * Radius,
+			Center.Z + DirectionTable[4][2] * Radius);
+
+		for (int32_t Side = 0; Side < 6; ++Side)
+		{
+			for (int32_t Step = 0; Step < Radius; ++Step)
+			{
+				if (!Functor(static_cast<const HexType&>(Hex)))
+				{
+					return false;
+				}
+
+				Hex = HexNeighbor(Hex, Side);
+			}
+		}
+
+		return true;
+	}
+
+	/** Calls functor with every hex within radius of center, ring by ring starting
+	from the center (see ForEachHexInRing). Functor should return false to stop early */
+	template <typename HexType, typename FunctorType>
+	inline bool ForEachHexInSpiral(const HexType& Center, int32_t Radius, FunctorType&& Functor)
+	{
+		for (int32_t Ring = 0; Ring <= Radius; ++Ring)
+		{
+			if (!ForEachHexInRing(Center, Ring, Functor))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/** Get the amount of hexes within radius of a center hex (including center) */
+	constexpr int32_t NumHexesInRange(int32_t Radius)
+	{
+		return Radius < 0 ? 0 : 3 * Radius * (Radius + 1) + 1;
+	}
+
+	/** Result of a single A* search */
+	struct FSearchStats
+	{
+		/** Closest cell to the goal that was expanded */
+		int32_t ClosestIndex = InvalidIndex;
+
+		/** Amount of cells that were expanded */
+		int32_t NumExpanded = 0;
+	};
+
+	/** Performs an A* search from start to goal with every move costing one. Parents and Costs should point to
+	arrays with an entry per cell, Parents will contain the cell used to reach each cell. NeighborFunc(Index, Direction)
+	should return the index of a neighbor (or InvalidIndex), PassableFunc(Index) if a cell can be entered and
+	HeuristicFunc(Index) the estimated moves to reach the goal. Get if goal was reached */
+	template <typename NeighborFunc, typename PassableFunc, typename HeuristicFunc>
+	bool AStarSearch(int32_t NumCells, int32_t Start, int32_t Goal, int32_t MaxDistance, int32_t* Parents, int32_t* Costs,
+		NeighborFunc&& Neighbor, PassableFunc&& Passable, HeuristicFunc&& Heuristic, FSearchStats& OutStats)
+	{
+		struct FNode
+		{
+			int32_t Index;
+			int32_t Cost;
+			int32_t Heuristic;
+		};
+
+		// std heaps keep the largest element at the front, so this is reversed. Ties favor nodes closer to goal
+		auto Compare = [](const FNode& lhs, const FNode& rhs)
+		{
+			const int32_t LTotal = lhs.Cost + lhs.Heuristic;
+			const int32_t RTotal = rhs.Cost + rhs.Heuristic;
+
+			return LTotal != RTotal ? LTotal > RTotal : lhs.Heuristic > rhs.Heuristic;
+		};
+
+		std::fill(Parents, Parents + NumCells, InvalidIndex);
+		std::fill(Costs, Costs + NumCells, INT32_MAX);
+
+		// Cells are closed once expanded, entries in the queue are never
+		// removed, stale ones are skipped once popped instead
+		std::vector<bool> Closed(NumCells, false);
+		std::vector<FNode> Queue;
+
+		Queue.push_back(FNode{ Start, 0, Heuristic(Start) });
+		Costs[Start] = 0;
+
+		int32_t ClosestHeuristic = INT32_MAX;
+		int32_t ClosestCost = 0;
+		OutStats = FSearchStats();
+
+		while (!Queue.empty())
+		{
+			std::pop_heap(Queue.begin(), Queue.end(), Compare);
+			const FNode Node = Queue.back();
+			Queue.pop_back();
+
+			// A cheaper route to this cell has already been expanded
+			if (Closed[Node.Index] || Node.Cost > Costs[Node.Index])
+			{
+				continue;
+			}
+
+			Closed[Node.Index] = true;
+			++OutStats.NumExpanded;
+
+			if (Node.Index == Goal)
+			{
+				OutStats.ClosestIndex = Goal;
+				return true;
+			}
+
+			if (Node.Heuristic < ClosestHeuristic || (Node.Heuristic == ClosestHeuristic && Node.Cost < ClosestCost))
+			{
+				OutStats.ClosestIndex = Node.Index;
+				ClosestHeuristic = Node.Heuristic;
+				ClosestCost = Node.Cost;
+			}
+
+			// We can't travel any further from this cell
+			const int32_t NewCost = Node.Cost + 1;
+			if (NewCost > MaxDistance)
+			{
+				continue;
+			}
+
+			for (int32_t i = 0; i < 6; ++i)
+			{
+				const int32_t NeighborIndex = Neighbor(Node.Index, i);
+				if (NeighborIndex == InvalidIndex || Closed[NeighborIndex] || NewCost >= Costs[NeighborIndex] || !Passable(NeighborIndex))
+				{
+					continue;
+				}
+
+				Costs[NeighborIndex] = NewCost;
+				Parents[NeighborIndex] = Node.Index;
+
+				Queue.push_back(FNode{ NeighborIndex, NewCost, Heuristic(NeighborIndex) });
+				std::push_heap(Queue.begin(), Queue.end(), Compare);
+			}
+		}
+
+		return false;
+	}
+
+	/** Performs a breadth-first search from origin, visiting every cell that can be reached within max distance.
+	Distances and Parents should point to arrays with an entry per cell, Queue to an array that can hold every cell.
+	Queue will contain reached cells in order of distance (starting with origin). Get the amount of cells in queue */
+	template <typename NeighborFunc, typename PassableFunc>
+	int32_t BreadthFirstSearch(int32_t NumCells, int32_t Origin, int32_t MaxDistance, int32_t* Distances, int32_t* Parents, int32_t* Queue,
+		NeighborFunc&& Neighbor, PassableFunc&& Passable)
+	{
+		std::fill(Distances, Distances + NumCells, InvalidIndex);
+		std::fill(Parents, Parents + NumCells, InvalidIndex);
+
+		int32_t Tail = 0;
+		Queue[Tail++] = Origin;
+		Distances[Origin] = 0;
+
+		for (int32_t Head = 0; Head < Tail; ++Head)
+		{
+			const int32_t Index = Queue[Head];
+			const int32_t NewDistance = Distances[Index] + 1;
+			if (NewDistance > MaxDistance)
+			{
+				// Everything after this is at least as far away
+				break;
+			}
+
+			for (int32_t i = 0; i < 6; ++i)
+			{
+				const int32_t NeighborIndex = Neighbor(Index, i);
+				if (NeighborIndex == InvalidIndex || Distances[NeighborIndex] != InvalidIndex || !Passable(NeighborIndex))
+				{
+					continue;
+				}
+
+				Distances[NeighborIndex] = NewDistance;
+				Parents[NeighborIndex] = Index;
+				Queue[Tail++] = NeighborIndex;
+			}
+		}
+
+		return Tail;
+	}
+}
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/HexCore.h"
 #include "HexGrid.generated.h"
 
 class ATile;
@@ -42,6 +43,7 @@ public:
 
 	FHexGridPathFindResultData()
 		: Result(EHexGridPathFindResult::Unknown)
+		, NumExpanded(0)
 	{
 
 	}
@@ -53,6 +55,7 @@ public:
 	{
 		Result = InResult;
 		Path.Empty();
+		NumExpanded = 0;
 	}
 
 	/** Set result and copy path */
@@ -60,13 +63,15 @@ public:
 	{
 		Result = InResult;
 		Path = InPath;
+		NumExpanded = 0;
 	}
 
 	/** Set result and move path */
 	FORCEINLINE void Set(EHexGridPathFindResult InResult, TArray<ATile*>&& InPath)
 	{
 		Result = InResult;
-		Path = InPath;
+		Path = MoveTemp(InPath);
+		NumExpanded = 0;
 	}
 
 	/** Reset result */
@@ -74,6 +79,7 @@ public:
 	{
 		Result = EHexGridPathFindResult::Unknown;
 		Path.Empty();
+		NumExpanded = 0;
 	}
 
 public:
@@ -91,6 +97,69 @@ public:
 
 	/** Tiles in the generated path (from start to finish) */
 	TArray<ATile*> Path;
+
+	/** Amount of tiles the search expanded (zero if no search was needed) */
+	int32 NumExpanded;
+};
+
+/** Data about all cells that can be reached from an origin within a max amount of moves */
+struct CONQUEST_API FHexGridReachableSet
+{
+public:
+
+	FHexGridReachableSet()
+		: OriginIndex(INDEX_NONE)
+		, MaxDistance(0)
+	{
+
+	}
+
+public:
+
+	/** Resets this set to be empty */
+	FORCEINLINE void Reset()
+	{
+		OriginIndex = INDEX_NONE;
+		MaxDistance = 0;
+		Cells.Reset();
+		Distances.Reset();
+		Parents.Reset();
+	}
+
+	/** Get if given cell (dense index) can be reached. The origin is not considered reachable */
+	FORCEINLINE bool IsReachable(int32 Index) const
+	{
+		return Distances.IsValidIndex(Index) && Distances[Index] > 0;
+	}
+
+	/** Get the amount of moves required to reach given cell (dense index), INDEX_NONE if not reachable */
+	FORCEINLINE int32 GetDistance(int32 Index) const
+	{
+		return Distances.IsValidIndex(Index) ? Distances[Index] : INDEX_NONE;
+	}
+
+	/** Get the amount of cells that can be reached */
+	FORCEINLINE int32 Num() const
+	{
+		return Cells.Num();
+	}
+
+public:
+
+	/** Dense index of the cell the search started from */
+	int32 OriginIndex;
+
+	/** The max distance used when generating this set */
+	int32 MaxDistance;
+
+	/** Dense indices of all reachable cells (excluding origin), sorted by distance */
+	TArray<int32> Cells;
+
+	/** Distance to each cell in the grid, INDEX_NONE for cells that can't be reached */
+	TArray<int32> Distances;
+
+	/** The cell we came from to reach each cell in the grid (INDEX_NONE for origin and unreached cells) */
+	TArray<int32> Parents;
 };
 
 /**
@@ -125,45 +194,20 @@ public:
 
 private:
 
-	/** Lookup table for travelling */
-	static const FHex DirectionTable[6];
-
 	FORCEINLINE static bool IsValidHex(const FHex& Hex)
 	{
-		return (Hex.X + Hex.Y + Hex.Z) == 0;
+		return HexCore::IsValidHex(Hex);
 	}
 
-	FORCEINLINE static const FHex& HexDirection(int32 Index)
+	FORCEINLINE static FHex HexDirection(int32 Index)
 	{
 		check(Index >= 0 && Index <= 5);
-		return DirectionTable[Index];
+		return HexCore::HexDirection<FHex>(Index);
 	}
 
 	FORCEINLINE static FHex HexRound(const FFracHex& FracHex)
 	{
-		float X = FMath::RoundToFloat(FracHex.X);
-		float Y = FMath::RoundToFloat(FracHex.Y);
-		float Z = FMath::RoundToFloat(FracHex.Z);
-
-		float DeltaX = FMath::Abs(X - FracHex.X);
-		float DeltaY = FMath::Abs(Y - FracHex.Y);
-		float DeltaZ = FMath::Abs(Z - FracHex.Z);
-
-		// Need to assure that hex length will equal zero
-		if (DeltaX > DeltaY && DeltaX > DeltaZ)
-		{
-			X = -Y - Z;
-		}
-		else if (DeltaY > DeltaZ)
-		{
-			Y = -X - Z;
-		}
-		else
-		{
-			Z = -X - Y;
-		}
-
-		FHex HexValue(static_cast<int32>(X), static_cast<int32>(Y), static_cast<int32>(Z));
+		FHex HexValue = HexCore::HexRound<FHex>(FracHex);
 		check(IsValidHex(HexValue));
 
 		return HexValue;
@@ -173,12 +217,12 @@ public:
 
 	FORCEINLINE static int32 HexLength(FHex Hex)
 	{
-		return FMath::DivideAndRoundDown(FMath::Abs(Hex.X) + FMath::Abs(Hex.Y) + FMath::Abs(Hex.Z), 2);
+		return HexCore::HexLength(Hex);
 	}
 
 	FORCEINLINE static int32 HexDisplacement(const FHex& H1, const FHex& H2)
 	{
-		return HexLength(H1 - H2);
+		return HexCore::HexDisplacement(H1, H2);
 	}
 
 public:
@@ -186,7 +230,7 @@ public:
 	/** Get row and column indices as a hex cell */
 	FORCEINLINE static FHex ConvertIndicesToHex(int32 Row, int32 Column)
 	{
-		FHex Hex(Row, Column, -Row - Column);
+		FHex Hex = HexCore::IndicesToHex<FHex>(Row, Column);
 		check(IsValidHex(Hex));
 
 		return Hex;
@@ -196,44 +240,22 @@ public:
 	The cell is only applied onto the XY plane, with Z being the same as Origin.Z */
 	FORCEINLINE static FVector ConvertHexToWorld(const FHex& Hex, const FVector& Origin, const FVector& Size)
 	{
-		const float f0 = FMath::Sqrt(3.f);
-		const float f1 = f0 / 2.f;
-		const float f2 = 0.f;
-		const float f3 = 3.f / 2.f;
-
-		float X = (f0 * static_cast<float>(Hex.X) + f1 * static_cast<float>(Hex.Y)) * Size.X;
-		float Y = (f2 * static_cast<float>(Hex.X) + f3 * static_cast<float>(Hex.Y)) * Size.Y;
-
-		return FVector(Origin.X + X, Origin.Y + Y, Origin.Z);
+		return HexCore::HexToWorld(Hex, Origin, Size);
 	}
 
 	/** Converts a world position to a hex cell. Z axis does not affect calculation */
 	FORCEINLINE static FHex ConvertWorldToHex(const FVector& Position, const FVector& Origin, const FVector& Size)
 	{
-		const float b0 = FMath::Sqrt(3.f) / 3.f;
-		const float b1 = -1.f / 3.f;
-		const float b2 = 0.f;
-		const float b3 = 2.f / 3.f;
-
-		float PointX = (Position.X - Origin.X) / Size.X;
-		float PointY = (Position.Y - Origin.Y) / Size.Y;
-
-		float X = b0 * PointX + b1 * PointY;
-		float Y = b2 * PointX + b3 * PointY;
+		FHex HexValue = HexCore::WorldToHex<FHex>(Position, Origin, Size);
+		check(IsValidHex(HexValue));
 
-		return HexRound(FFracHex(X, Y, -X - Y));
+		return HexValue;
 	}
 
 	/** Converts a hex tiles vertex index to a world position */
 	FORCEINLINE static FVector ConvertHexVertexIndexToWorld(const FVector& Origin, float Size, int32 Index)
 	{
-		float Angle = 60.f * static_cast<float>(Index) - 30.f;
-		float Radians = FMath::DegreesToRadians(Angle);
-
-		return FVector(
-			Origin.X + Size * FMath::Cos(Radians),
-			Origin.Y + Size * FMath::Sin(Radians),
-			Origin.Z);
+		return HexCore::HexVertexToWorld(Origin, Size, Index);
 	}
 
 public:
@@ -249,8 +271,49 @@ public:
 	/** Removes all cells starting and beyond given row and column */
 	void RemoveCellsFrom(int32 Row, int32 Column);
 
+	/** Rebuilds the dense tile array and neighbor table from the grid map.
+	This is automatically called after generating or loading the grid */
+	void RebuildDenseStorage();
+
+	/** Called after this grid has been serialized */
+	void PostSerialize(const FArchive& Ar);
+
 public:
 
+	/** Get the dense index of given hex (or INDEX_NONE if not in the grid). Cells are
+	stored row-major, using the same row and column layout as GenerateGrid */
+	FORCEINLINE int32 HexToIndex(const FHex& Hex) const
+	{
+		return HexCore::HexToIndex(Hex, GridDimensions.X, GridDimensions.Y);
+	}
+
+	/** Get the hex of given dense index. Expects index to be valid */
+	FORCEINLINE FHex IndexToHex(int32 Index) const
+	{
+		check(GridTiles.IsValidIndex(Index));
+		return HexCore::IndexToHex<FHex>(Index, GridDimensions.Y);
+	}
+
+	/** Get the amount of cells in the grid */
+	FORCEINLINE int32 Num() const
+	{
+		return GridTiles.Num();
+	}
+
+	/** Get the tile at given dense index. Expects index to be valid */
+	FORCEINLINE ATile* GetTileAtIndex(int32 Index) const
+	{
+		return GridTiles[Index];
+	}
+
+	/** Get the dense index of a neighbor of given cell. Direction should be within
+	0 to 5 (see direction table). Get INDEX_NONE if neighbor is outside of grid */
+	FORCEINLINE int32 GetNeighborIndex(int32 Index, int32 Direction) const
+	{
+		check(Direction >= 0 && Direction <= 5);
+		return NeighborTable[Index * 6 + Direction];
+	}
+
 	/** Get an individual tile */
 	FORCEINLINE ATile* GetTile(const FHex& Hex) const
 	{
@@ -258,16 +321,22 @@ public:
 
 		if (bGridGenerated)
 		{
-			ATile* const* ValuePtr = GridMap.Find(Hex);
-			if (ValuePtr != nullptr)
+			int32 Index = HexToIndex(Hex);
+			if (Index != INDEX_NONE)
 			{
-				Tile = *ValuePtr;
+				Tile = GridTiles[Index];
 			}
 		}
 
 		return Tile;
 	}
 
+	/** Get if given hex is a cell in this grid */
+	FORCEINLINE bool ContainsHex(const FHex& Hex) const
+	{
+		return GetTile(Hex) != nullptr;
+	}
+
 	/** Get all tiles in the grid */
 	FORCEINLINE TArray<ATile*> GetAllTiles() const
 	{
@@ -275,7 +344,15 @@ public:
 		
 		if (bGridGenerated)
 		{
-			GridMap.GenerateValueArray(Tiles);
+			// Cells without tiles are left empty in the dense array
+			Tiles.Reserve(GridMap.Num());
+			for (ATile* Tile : GridTiles)
+			{
+				if (Tile)
+				{
+					Tiles.Add(Tile);
+				}
+			}
 		}
 
 		return Tiles;
@@ -286,20 +363,125 @@ public:
 	{
 		TArray<FHex> Neighbors;
 
-		if (bGridGenerated && GridMap.Contains(Hex))
+		ForEachNeighbor(Hex, [this, &Neighbors](ATile* Tile, int32 Index)
+		{
+			Neighbors.Add(IndexToHex(Index));
+			return true;
+		});
+
+		return Neighbors;
+	}
+
+public:
+
+	/** Visitors call functor with each tile (and its dense index) that exists in the grid, so tiles are never null.
+	Functors should have the signature bool(ATile*, int32), returning false to stop visiting. Visitors will never
+	allocate and get if every tile was visited (false if functor stopped early) */
+
+	/** Visits each neighbor of given hex */
+	template <typename FunctorType>
+	bool ForEachNeighbor(const FHex& Hex, FunctorType&& Functor) const
+	{
+		const int32 Index = bGridGenerated ? HexToIndex(Hex) : INDEX_NONE;
+		if (Index == INDEX_NONE)
+		{
+			return true;
+		}
+
+		// There can be a total of six neighbours (see direction table)
+		for (int32 i = 0; i < 6; ++i)
 		{
-			// There can be a total of six neighbours (see direction table)
-			for (int32 i = 0; i < 6; ++i)
+			const int32 NeighborIndex = GetNeighborIndex(Index, i);
+			if (NeighborIndex != INDEX_NONE && !VisitTile(NeighborIndex, Functor))
 			{
-				FHex NeighborHex = Hex + HexDirection(i);
-				if (GridMap.Contains(NeighborHex))
-				{
-					Neighbors.Add(NeighborHex);
-				}
+				return false;
 			}
 		}
 
-		return Neighbors;
+		return true;
+	}
+
+	/** Visits each tile exactly distance tiles away from origin */
+	template <typename FunctorType>
+	bool ForEachInRing(const FHex& Origin, int32 Distance, FunctorType&& Functor) const
+	{
+		if (!bGridGenerated || Distance < 0)
+		{
+			return true;
+		}
+
+		if (Distance <= MaxStencilRadius)
+		{
+			// Rings are stored one after the other in the stencil
+			return VisitStencil(Origin, HexCore::NumHexesInRange(Distance - 1), HexCore::NumHexesInRange(Distance), Functor);
+		}
+
+		return HexCore::ForEachHexInRing(Origin, Distance, [this, &Functor](const FHex& Hex)
+		{
+			const int32 Index = HexToIndex(Hex);
+			return Index == INDEX_NONE || VisitTile(Index, Functor);
+		});
+	}
+
+	/** Visits each tile within distance of origin (including origin), ordered by distance from origin */
+	template <typename FunctorType>
+	bool ForEachInSpiral(const FHex& Origin, int32 Distance, FunctorType&& Functor) const
+	{
+		if (!bGridGenerated || Distance < 0)
+		{
+			return true;
+		}
+
+		if (Distance <= MaxStencilRadius)
+		{
+			return VisitStencil(Origin, 0, HexCore::NumHexesInRange(Distance), Functor);
+		}
+
+		return HexCore::ForEachHexInSpiral(Origin, Distance, [this, &Functor](const FHex& Hex)
+		{
+			const int32 Index = HexToIndex(Hex);
+			return Index == INDEX_NONE || VisitTile(Index, Functor);
+		});
+	}
+
+	/** Visits each tile within distance of origin (including origin). Order is not guaranteed */
+	template <typename FunctorType>
+	FORCEINLINE bool ForEachInRange(const FHex& Origin, int32 Distance, FunctorType&& Functor) const
+	{
+		return ForEachInSpiral(Origin, Distance, Forward<FunctorType>(Functor));
+	}
+
+private:
+
+	/** The largest distance that stencils are cached for, visitors beyond this will generate hexes as they go */
+	static constexpr int32 MaxStencilRadius = 32;
+
+	/** Get offsets of every hex within max stencil radius of the center, ordered ring by ring. This is built once */
+	static const TArray<FHex>& GetSpiralStencil();
+
+	/** Visits the tiles for a section of the spiral stencil placed at origin */
+	template <typename FunctorType>
+	FORCEINLINE bool VisitStencil(const FHex& Origin, int32 First, int32 Last, FunctorType& Functor) const
+	{
+		const TArray<FHex>& Stencil = GetSpiralStencil();
+		for (int32 i = First; i < Last; ++i)
+		{
+			const int32 Index = HexToIndex(Origin + Stencil[i]);
+			if (Index != INDEX_NONE && !VisitTile(Index, Functor))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/** Calls functor with the tile at dense index, cells without a tile are skipped */
+	template <typename FunctorType>
+	FORCEINLINE bool VisitTile(int32 Index, FunctorType& Functor) const
+	{
+		ATile* Tile = GridTiles[Index];
+		return !Tile || Functor(Tile, Index);
 	}
 
 public:
@@ -312,15 +494,23 @@ public:
 
 private:
 
-	/** Performs pathfinding using generated grid. Will generate a path if successful.
+	/** Performs pathfinding (AStar) using generated grid. Will generate a path if successful. When
+	allowing partial paths, the path will lead to the tile closest to the goal that could be reached.
 	This function assumes only pre-checks have already been performed */
 	bool FindPath(const FHex& Start, const FHex& Goal, FHexGridPathFindResultData& OutResultData, bool bAllowPartial, int32 MaxDistance) const;
 
-	/** Converts path edges into an actual path array of tiles */
-	void ConvertEdgesToPath(const FHex& Start, const FHex& Goal, const TMap<FHex, FHex>& Edges, TArray<ATile*>& OutPath) const;
+	/** Converts the parent of each cell visited during a search into an actual path array of tiles */
+	void ConvertParentsToPath(int32 GoalIndex, const TArray<int32>& Parents, TArray<ATile*>& OutPath) const;
+
+public:
+
+	/** Finds every cell reachable from origin within the given amount of moves (single breadth-first
+	pass). The set keeps the route used to reach each cell, so the path to any of them can be generated
+	using GetPathFromReachableSet without needing to search again. Get if at least one cell is reachable */
+	bool GetReachableSet(const FHex& Origin, int32 MaxDistance, FHexGridReachableSet& OutReachableSet) const;
 
-	/** Heuristic used when generating a path */
-	static float PathHeuristic(const ATile* T1, const ATile* T2);
+	/** Generates the path from the origin of given set to goal. Get if goal was reachable */
+	bool GetPathFromReachableSet(const FHexGridReachableSet& ReachableSet, const FHex& Goal, TArray<ATile*>& OutPath) const;
 
 public:
 
@@ -345,4 +535,21 @@ private:
 	/** Dimensions of the grid */
 	UPROPERTY()
 	FIntPoint GridDimensions;
+
+	/** Dense row-major array of tiles, this mirrors the grid map but allows us
+	to find tiles without having to hash the hex. Cells without a tile are null */
+	UPROPERTY(Transient)
+	TArray<ATile*> GridTiles;
+
+	/** Neighbor indices of each cell, six entries per cell (see direction table) */
+	TArray<int32> NeighborTable;
+};
+
+template<>
+struct TStructOpsTypeTraits<FHexGrid> : public TStructOpsTypeTraitsBase2<FHexGrid>
+{
+	enum
+	{
+		WithPostSerialize = true
+	};
 };
\ No newline at end of file
@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Writes integers as LEB128 varints, signed integers being zigzag encoded first */
+class FCSKBinaryWriter
+{
+public:
+
+	FCSKBinaryWriter(TArray<uint8>& InBytes)
+		: Bytes(InBytes)
+	{
+
+	}
+
+	FORCEINLINE void WriteByte(uint8 Value)
+	{
+		Bytes.Add(Value);
+	}
+
+	FORCEINLINE void WriteUnsigned(uint32 Value)
+	{
+		while (Value >= 0x80)
+		{
+			Bytes.Add(static_cast<uint8>(Value | 0x80));
+			Value >>= 7;
+		}
+
+		Bytes.Add(static_cast<uint8>(Value));
+	}
+
+	FORCEINLINE void WriteSigned(int32 Value)
+	{
+		WriteUnsigned((static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31));
+	}
+
+	/** Writes a float as its raw bits */
+	FORCEINLINE void WriteFloat(float Value)
+	{
+		const uint8* ValueBytes = reinterpret_cast<const uint8*>(&Value);
+		Bytes.Append(ValueBytes, sizeof(float));
+	}
+
+	void WriteString(const FString& Value)
+	{
+		FTCHARToUTF8 UTF8(*Value);
+		WriteUnsigned(UTF8.Length());
+		Bytes.Append(reinterpret_cast<const uint8*>(UTF8.Get()), UTF8.Length());
+	}
+
+private:
+
+	TArray<uint8>& Bytes;
+};
+
+/** Reads values written by FCSKBinaryWriter. Reading past the end flags an error rather than asserting */
+class FCSKBinaryReader
+{
+public:
+
+	FCSKBinaryReader(const TArray<uint8>& InBytes)
+		: Bytes(InBytes)
+		, Offset(0)
+		, bError(false)
+	{
+
+	}
+
+	FORCEINLINE uint8 ReadByte()
+	{
+		if (Offset >= Bytes.Num())
+		{
+			bError = true;
+			return 0;
+		}
+
+		return Bytes[Offset++];
+	}
+
+	uint32 ReadUnsigned()
+	{
+		uint32 Value = 0;
+		for (int32 Shift = 0; Shift < 35; Shift += 7)
+		{
+			const uint8 Byte = ReadByte();
+			Value |= static_cast<uint32>(Byte & 0x7F) << Shift;
+
+			if ((Byte & 0x80) == 0)
+			{
+				return Value;
+			}
+		}
+
+		bError = true;
+		return 0;
+	}
+
+	FORCEINLINE int32 ReadSigned()
+	{
+		const uint32 Value = ReadUnsigned();
+		return static_cast<int32>((Value >> 1) ^ (0u - (Value & 1)));
+	}
+
+	float ReadFloat()
+	{
+		float Value = 0.f;
+		if (Offset + static_cast<int32>(sizeof(float)) > Bytes.Num())
+		{
+			bError = true;
+			return Value;
+		}
+
+		FMemory::Memcpy(&Value, Bytes.GetData() + Offset, sizeof(float));
+		Offset += sizeof(float);
+
+		return Value;
+	}
+
+	/** Reads the amount of elements to follow. Every element takes at
+	least a byte, so we can reject counts that could never be valid */
+	int32 ReadCount()
+	{
+		const uint32 Count = ReadUnsigned();
+		if (Count > static_cast<uint32>(Bytes.Num() - Offset))
+		{
+			bError = true;
+			return 0;
+		}
+
+		return static_cast<int32>(Count);
+	}
+
+	FString ReadString()
+	{
+		const int32 Length = ReadCount();
+		if (bError)
+		{
+			return FString();
+		}
+
+		FUTF8ToTCHAR TCHARData(reinterpret_cast<const ANSICHAR*>(Bytes.GetData() + Offset), Length);
+		Offset += Length;
+
+		return FString(TCHARData.Length(), TCHARData.Get());
+	}
+
+	FORCEINLINE bool HasError() const { return bError; }
+
+private:
+
+	const TArray<uint8>& Bytes;
+	int32 Offset;
+	bool bError;
+};
@@ -6,11 +6,14 @@
 #include "GameFramework/GameModeBase.h"
 #include "BoardPieceInterface.h"
 #include "BoardTypes.h"
+#include "CSKReplayLog.h"
 #include "CSKGameMode.generated.h"
 
+class ABoardManager;
 class ACastle;
 class ACastleAIController;
 class ACoinSequenceActor;
+class ACSKGameState;
 class ACSKPlayerController;
 class ACSKPlayerState;
 class APlayerStart;
@@ -24,6 +27,13 @@ class USpell;
 class USpellCard;
 class UTowerConstructionData;
 
+class FCSKRulesEngine;
+
+struct FCSKMatchSnapshot;
+struct FCSKRules;
+struct FCSKRulesAction;
+struct FCSKRulesState;
+
 using FCSKPlayerControllerArray = TArray<ACSKPlayerController*, TFixedAllocator<CSK_MAX_NUM_PLAYERS>>;
 
 /** Delegate for when a sub spell has finished execution */
@@ -599,6 +609,10 @@ public:
 	UFUNCTION(BlueprintPure, Category = CSK)
 	bool IsWaitingForSpellCast() const { return bWaitingOnSpellAction; }
 
+	/** If we are waiting on a player to select a quick effect or bonus spell */
+	UFUNCTION(BlueprintPure, Category = CSK)
+	bool IsWaitingForSpellSelection() const { return bWaitingOnNullifyQuickEffectSelection || bWaitingOnPostQuickEffectSelection || bWaitingOnBonusSpellSelection; }
+
 private:
 
 	/** If we should allow any action requests */
@@ -736,9 +750,19 @@ public:
 
 private:
 
-	/** Checks all towers determine order to execute end round actions. Get if any actions are ready to be performed */
+	/** Prepares the end round action queue for a new end round phase. Get if any actions are ready to be performed */
 	bool PrepareEndRoundActionTowers();
 
+	/** Inserts a newly owned tower into the end round action queue (if it wants end round actions) */
+	void InsertEndRoundActionTower(ATower* Tower);
+
+	/** Removes a tower that is no longer owned from the end round action queue */
+	void RemoveEndRoundActionTower(ATower* Tower);
+
+	/** Get if tower should run its end round action before other. Towers of equal
+	priority are ordered by the player who won the coin toss, then by build order */
+	bool ShouldRunEndRoundActionBefore(const ATower* Tower, const ATower* Other) const;
+
 	/** Attempts to start the action for end round tower at given index. Get if starting the next towers action was successfull */
 	bool StartRunningTowersEndRoundAction(int32 Index);
 
@@ -750,8 +774,8 @@ private:
 
 private:
 
-	/** The list of towers that will run the end round action during this end
-	round phase. This array is sorted by order of action priority (see Tower.h).*/
+	/** The list of towers that will run the end round action during end round phases. This array is sorted
+	by order of action priority (see Tower.h), with towers being inserted when built and removed when destroyed */
 	UPROPERTY()
 	TArray<ATower*> EndRoundActionTowers;
 
@@ -969,8 +993,8 @@ private:
 
 protected:
 
-	/** Reports of health changed during the current action, sorted in the order
-	they were recieved. Actions are a spell cast or a towers end round phase action */
+	/** Reports of health changed during the current action, sorted in the order they were recieved. Actions are a spell
+	cast or a towers end round phase action. Damage and healing of the same building are each merged into one report */
 	UPROPERTY(VisibleInstanceOnly, Transient, Category = "CSK|Game")
 	TArray<FHealthChangeReport> ActiveActionHealthReports;
 
@@ -1001,6 +1025,127 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Classes)
 	TSubclassOf<AWinnerSequenceActor> CastleDestroyedSequenceClass;
 
+public:
+
+	/** Fills out the rules of this match for use with the rules engine. Effects of
+	towers and spells are modelled using their simulated estimates. Get if successful */
+	bool GetRulesEngineRules(FCSKRules& OutRules) const;
+
+	/** Captures the current match for use with the rules engine.
+	Rules should have been filled out by GetRulesEngineRules. Get if successful */
+	bool GetRulesEngineState(const FCSKRules& Rules, FCSKRulesState& OutState) const;
+
+	/** Get the spell card represented by given rules engine spell card index */
+	TSubclassOf<USpellCard> GetRulesEngineSpellCard(int32 Index) const { return AvailableSpellCards.IsValidIndex(Index) ? AvailableSpellCards[Index] : nullptr; }
+
+	/** Get the spell card in players hand at given rules engine hand slot (or null). This is the inverse of GetRulesEngineHandSlot */
+	TSubclassOf<USpellCard> GetRulesEngineHandCard(const ACSKPlayerState* PlayerState, int32 HandSlot) const;
+
+	/** Get the rules engine of the match in progress (or null if rules couldn't be built). Requests are
+	validated by this, so anything simulating the match with it (e.g. the AI) follows the same rules */
+	TSharedPtr<const FCSKRulesEngine, ESPMode::ThreadSafe> GetRulesEngine() const { return RulesEngine; }
+
+private:
+
+	/** Builds the rules engine for the match that is starting */
+	void InitRulesEngine();
+
+	/** Get if action by the active player is legal according to the rules engine. Only what the rules
+	engine doesn't model (e.g. the targeting rules of spells) is validated by requests themselves.
+	Always fails if there is no rules engine, requests use their own checks instead in this case */
+	bool IsRulesEngineActionLegal(const FCSKRulesAction& Action, bool bCheckSpellTarget = true) const;
+
+	/** Get if the active player can build tower on tile, used to validate build requests when there is no rules engine */
+	bool CanBuildTowerWithoutRulesEngine(TSubclassOf<UTowerConstructionData> TowerTemplate, ATile* Tile) const;
+
+	/** Get the rules engine cell of tile (or INDEX_NONE) */
+	int32 GetRulesEngineCell(const ATile* Tile) const;
+
+	/** Get the rules engine hand slot of spell card in players hand (or INDEX_NONE) */
+	int32 GetRulesEngineHandSlot(const ACSKPlayerState* PlayerState, TSubclassOf<USpellCard> SpellCard) const;
+
+private:
+
+	/** Rules engine for the match in progress */
+	TSharedPtr<const FCSKRulesEngine, ESPMode::ThreadSafe> RulesEngine;
+
+public:
+
+	/** Get if player has their actions decided by the AI */
+	bool IsPlayerUsingAI(int32 PlayerID) const { return PlayerID == 0 ? bPlayer1UsesAI : PlayerID == 1 ? bPlayer2UsesAI : false; }
+
+	/** Sets if player should have their actions decided by the AI */
+	void SetPlayerUsesAI(int32 PlayerID, bool bEnable);
+
+private:
+
+	/** Spawns an AI player (with no client) to fill the slot of player, which has their actions decided by the AI */
+	ACSKPlayerController* SpawnAIPlayer(int32 PlayerID);
+
+	/** Spawns AI players for each player using the AI that nobody has joined as */
+	void SpawnAIPlayers();
+
+	/** Destroys every AI player, so they don't follow us when travelling */
+	void DestroyAIPlayers();
+
+protected:
+
+	/** If player 1 should have their actions decided by the AI. If nobody has joined as player 1 once
+	play starts an AI player is spawned in their place, otherwise whoever joined can no longer make decisions */
+	UPROPERTY(EditAnywhere, Category = AI, meta = (DisplayName = "Player 1 Uses AI"))
+	uint32 bPlayer1UsesAI : 1;
+
+	/** If player 2 should have their actions decided by the AI. If nobody has joined as player 2 once
+	play starts an AI player is spawned in their place, otherwise whoever joined can no longer make decisions */
+	UPROPERTY(EditAnywhere, Category = AI, meta = (DisplayName = "Player 2 Uses AI"))
+	uint32 bPlayer2UsesAI : 1;
+
+public:
+
+	/** Get the replay log of the match in progress */
+	const FCSKReplayLog& GetReplayLog() const { return ReplayLog; }
+
+	/** Saves the replay log of this match to file, generating a name if none is given. Get if successful */
+	bool SaveReplayLog(const FString& Filename = FString()) const;
+
+private:
+
+	/** Starts recording the replay log for the match that is starting */
+	void BeginReplayLog();
+
+	/** Records a request that has just been accepted into the replay log */
+	void RecordReplayRequest(ECSKReplayRecordType Type, int32 PlayerID, const UClass* Class = nullptr,
+		const ATile* Tile = nullptr, int32 SpellIndex = 0, int32 AdditionalMana = 0, bool bTimeOut = false);
+
+protected:
+
+	/** If the replay log should be saved once the match has finished or been aborted */
+	UPROPERTY(EditAnywhere, Category = Replay)
+	uint32 bSaveReplayLogs : 1;
+
+private:
+
+	/** Log of every request accepted during this match */
+	FCSKReplayLog ReplayLog;
+
+public:
+
+	/** Captures the match in progress into snapshot. Snapshots can only be captured during an
+	action phase while no action is being performed (a pending spell request is allowed) */
+	bool CaptureMatchSnapshot(FCSKMatchSnapshot& OutSnapshot) const;
+
+	/** Restores the match in progress to snapshot. This patches the actors already in play rather
+	than respawning the board, so the board needs to match. The same restrictions as capturing apply */
+	bool ApplyMatchSnapshot(const FCSKMatchSnapshot& Snapshot);
+
+private:
+
+	/** Get if the match is in a state that can be captured or restored */
+	bool CanSnapshotMatch() const;
+
+	/** Restores the towers on the board, destroying and spawning towers only when they differ */
+	void ApplyTowerSnapshots(const FCSKMatchSnapshot& Snapshot, ABoardManager* BoardManager, ACSKGameState* CSKGameState);
+
 protected:
 
 	/** Notify that a client has disconnected */
@@ -4,6 +4,7 @@
 
 #include "Conquest.h"
 #include "GameFramework/GameStateBase.h"
+#include "NetTileRef.h"
 #include "CSKGameState.generated.h"
 
 class ABoardManager;
@@ -17,6 +18,8 @@ class ATower;
 class USpell;
 class USpellCard;
 class UTowerConstructionData;
+struct FCSKMatchSnapshot;
+struct FHexBitboard;
 
 /** The state of the games timer (What is currently being timed */
 UENUM(BlueprintType)
@@ -230,11 +233,16 @@ public:
 	UFUNCTION(BlueprintPure, Category = Rules)
 	bool IsTimerActive() const { return TimerState != ECSKTimerState::None; }
 
-	/** Get the time remaining for current action taking place (this
-	can either action phase turn time, quick effect counter time) */
+	/** Get the time remaining for current action taking place (this can either action phase
+	turn time, quick effect counter time). This is rounded up to the nearest second */
 	UFUNCTION(BlueprintPure, Category = Rules)
 	int32 GetCountdownTimeRemaining(bool& bOutIsInfinite) const;
 
+	/** Get the time remaining for current action taking place in seconds. Clients
+	compute this locally using the servers world time, so it's always up to date */
+	UFUNCTION(BlueprintPure, Category = Rules)
+	float GetCountdownTimeRemainingSeconds(bool& bOutIsInfinite) const;
+
 	/** Get the amount of instances of given type of tower active on the board */
 	UFUNCTION(BlueprintPure, Category = Rules)
 	int32 GetTowerInstanceCount(TSubclassOf<ATower> Tower) const;
@@ -244,41 +252,51 @@ public:
 
 	/** Get all the towers that were damaged during the previous action */
 	UFUNCTION(BlueprintPure, Category = "CSK|Game")
-	TArray<FHealthChangeReport> GetDamageHealthReports(bool bFilterOutDead = false) const;
+	const TArray<FHealthChangeReport>& GetDamageHealthReports(bool bFilterOutDead = false) const;
 
 	/** Get all the towers that were healed during the previous action */
 	UFUNCTION(BlueprintPure, Category = "CSK|Game")
-	TArray<FHealthChangeReport> GetHealingHealthReports() const;
+	const TArray<FHealthChangeReport>& GetHealingHealthReports() const;
 
 	/** Get all the towers that were damaged during the previous action that belong to specified player */
 	UFUNCTION(BlueprintPure, Category = "CSK|Game")
-	TArray<FHealthChangeReport> GetPlayersDamagedHealthReports(ACSKPlayerState* PlayerState, bool bFilterOutDead = false) const;
+	const TArray<FHealthChangeReport>& GetPlayersDamagedHealthReports(ACSKPlayerState* PlayerState, bool bFilterOutDead = false) const;
 
 	/** Get all the towers that were healed during the previous action that belong to specified player */
 	UFUNCTION(BlueprintPure, Category = "CSK|Game")
-	TArray<FHealthChangeReport> GetPlayersHealingHealthReports(ACSKPlayerState* PlayerState) const;
+	const TArray<FHealthChangeReport>& GetPlayersHealingHealthReports(ACSKPlayerState* PlayerState) const;
+
+	/** Captures the round and timer into snapshot */
+	void CaptureMatchSnapshot(FCSKMatchSnapshot& OutSnapshot) const;
+
+	/** Restores the round, coin toss winner and timer from snapshot. This
+	should be called by the game mode after entering the snapshots round state */
+	void RestoreMatchSnapshot(const FCSKMatchSnapshot& Snapshot);
 
 protected:
 
-	/** Activates the timer for given state */
-	void ActivateTickTimer(ECSKTimerState InTimerState, int32 InTime);
+	/** Activates the timer for given state, which will finish after time (negative for infinite) */
+	void ActivateTickTimer(ECSKTimerState InTimerState, float InTime);
 
 	/** Deactivates the timer */
 	void DeactivateTickTimer();
 
-	/** Set if tick for timer is enabled/disabled */
+	/** Set if the servers timer for finishing the active timer is enabled/disabled */
 	void SetTickTimerEnabled(bool bEnable);
 
+	/** Pauses or resumes the active timer */
+	void SetTimerPaused(bool bPaused);
+
 	/** Helper function for adding bonus time to given time clamped by action phase time */
-	int32 GetActionTimeBonusApplied(int32 Time) const;
+	float GetActionTimeBonusApplied(float Time) const;
 
 private:
 
 	/** Updates action phase properties, including activating timer */
 	void UpdateActionPhaseProperties();
 
-	/** Handles ticking the timer */
-	void TickTimer();
+	/** Get the time remaining for the active timer. Get -1 if the timer is infinite */
+	float GetTimerTimeRemaining() const;
 
 	/** Handles when timer has finished */
 	void HandleTickTimerFinished();
@@ -286,8 +304,15 @@ private:
 	/** Executes the custom timer finished event only if bound */
 	void ExecuteCustomTimerFinishedEvent(bool bWasSkipped);
 
-	/** Generates a new array containing health reports filtered by passed in arguments */
-	TArray<FHealthChangeReport> QueryLatestHealthReports(bool bDamaged, ACSKPlayerState* InOwner, bool bExcludeDead) const;
+	/** Get the bucket of health reports matching passed in arguments */
+	const TArray<FHealthChangeReport>& QueryLatestHealthReports(bool bDamaged, ACSKPlayerState* InOwner, bool bExcludeDead) const;
+
+	/** Notify that the latest health reports have been replicated */
+	UFUNCTION()
+	void OnRep_LatestActionHealthReports();
+
+	/** Sorts the latest health reports into buckets, so queries don't need to filter or copy them */
+	void RebuildHealthReportBuckets() const;
 
 protected:
 
@@ -303,30 +328,62 @@ protected:
 	UPROPERTY(Transient, Replicated)
 	ECSKTimerState TimerState;
 
-	/** The time remaining for the current timer state */
+	/** The server world time the current timer state finishes at (negative if infinite). This is only replicated
+	when a timer is activated, with clients calculating the time remaining using the servers world time */
 	UPROPERTY(Transient, Replicated)
-	int32 TimeRemaining;
+	float TimerEndTime;
+
+	/** The server world time the timer was paused at */
+	UPROPERTY(Transient, Replicated)
+	float TimerPauseTime;
 
 	/** The amount of time the action phase had before entering a different timer state */
 	UPROPERTY(Transient)
-	int32 NewActionPhaseTimeRemaining;
+	float NewActionPhaseTimeRemaining;
 
-	/** If the timer is paused, this doesn't pause the actual timer
-	but instead skips TickTimer whenever the callback is executed */
-	UPROPERTY(Transient)
+	/** If the timer is paused, the time remaining is frozen and the timer will not finish */
+	UPROPERTY(Transient, Replicated)
 	uint32 bTimerPaused : 1;
 
 	/** Lookup table for how many instances of a certain tower exists on the board */
 	UPROPERTY(Transient)
 	TMap<TSubclassOf<ATower>, int32> TowerInstanceTable;
 
-	/** The health reports from the latest action */
-	UPROPERTY(BlueprintReadOnly, Transient, Replicated, Category = "CSK|Game")
+	/** The health reports from the latest action. The game mode merges reports
+	for the same building, so this holds at most two reports per building */
+	UPROPERTY(BlueprintReadOnly, Transient, ReplicatedUsing = OnRep_LatestActionHealthReports, Category = "CSK|Game")
 	TArray<FHealthChangeReport> LatestActionHealthReports;
 
 private:
 
-	/** Handle for the timers tick */
+	/** Latest health reports sorted by type */
+	struct FHealthReportBuckets
+	{
+		/** Owner of the reports in these buckets (only used for comparisons) */
+		const ACSKPlayerState* Owner = nullptr;
+
+		TArray<FHealthChangeReport> Damaged;
+		TArray<FHealthChangeReport> DamagedAlive;
+		TArray<FHealthChangeReport> Healed;
+
+		void Reset();
+		void Add(const FHealthChangeReport& Report);
+	};
+
+	/** Buckets for every report, then for the reports of each owner. Buckets are keyed by owner rather than player ID,
+	as clients may receive the reports before the owners ID has replicated. These are rebuilt by the first query after
+	the latest reports change, with allocations kept for the rest of the match. We don't use an arena allocator for
+	reports, as they are replicated properties (which require the default allocator) and the amount of reports is
+	bound by the amount of buildings, so reusing these allocations already avoids allocating every action */
+	mutable FHealthReportBuckets AllHealthReports;
+	mutable FHealthReportBuckets PlayersHealthReports[CSK_MAX_NUM_PLAYERS];
+
+	/** If the latest reports have changed since the buckets were last built */
+	mutable uint8 bHealthReportBucketsDirty : 1;
+
+private:
+
+	/** Handle for finishing the timer on the server */
 	FTimerHandle Handle_TickTimer;
 
 	/** Event for when the custom timer has finished */
@@ -370,7 +427,7 @@ private:
 
 	/** Handle build request confirmation client side */
 	UFUNCTION(NetMulticast, Reliable)
-	void Multi_HandleBuildRequestConfirmed(ATile* TargetTile);
+	void Multi_HandleBuildRequestConfirmed(const FNetTileRef& TargetTileRef);
 
 	/** Handle build request finished client side */
 	UFUNCTION(NetMulticast, Reliable)
@@ -378,7 +435,7 @@ private:
 
 	/** Handle spell request confirmation client side */
 	UFUNCTION(NetMulticast, Reliable)
-	void Multi_HandleSpellRequestConfirmed(EActiveSpellContext Context, ATile* TargetTile);
+	void Multi_HandleSpellRequestConfirmed(EActiveSpellContext Context, const FNetTileRef& TargetTileRef);
 
 	/** Handle spell request finished client side */
 	UFUNCTION(NetMulticast, Reliable)
@@ -434,6 +491,11 @@ public:
 	bool CanPlayerCastSpell(const ACSKPlayerController* Controller, ATile* TargetTile,
 		TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, int32 AdditionalMana) const;
 
+	/** Get every cell of the board the given player can cast spell onto as a mask (see CanPlayerCastSpell). Spells that
+	don't override their checks in blueprint are evaluated in parallel, otherwise each tile is checked on the game thread */
+	void GetSpellTargetMask(const ACSKPlayerController* Controller, TSubclassOf<USpellCard> SpellCard,
+		int32 SpellIndex, int32 AdditionalMana, FHexBitboard& OutMask) const;
+
 	/** Get all towers that can be built this match */
 	FORCEINLINE const TArray<TSubclassOf<UTowerConstructionData>>& GetAvailableTowers() const { return AvailableTowers; }
 
@@ -496,11 +558,14 @@ public:
 	/** Notify that a building has been destroyed */
 	void HandleTowerDestroyed(ATower* DestroyedTower, bool bByRequest);
 
+	/** Notify that a tower has been placed on the board when restoring a match snapshot */
+	void HandleTowerRestored(ATower* RestoredTower);
+
 private:
 
 	/** Handle portal reached client side */
 	UFUNCTION(NetMulticast, Reliable)
-	void Multi_HandlePortalReached(ACSKPlayerState* Player, ATile* ReachedPortal);
+	void Multi_HandlePortalReached(ACSKPlayerState* Player, const FNetTileRef& ReachedPortalRef);
 
 	/** Handle castle destroyed client side */
 	UFUNCTION(NetMulticast, Reliable)
@@ -520,6 +585,11 @@ public:
 	/** Get the current round being played */
 	FORCEINLINE int32 GetRound() const { return RoundsPlayed; }
 
+	/** Get the zobrist hash of the publicly known state of the match (the board, health of every board piece and each
+	players resources). Hands and decks are only replicated to their owners, so are not included. This can be compared
+	between the server and clients to detect if they have diverged, provided replication has settled */
+	uint64 GetMatchHash() const;
+
 protected:
 
 	/** The time when the match started (Coin Flip) */
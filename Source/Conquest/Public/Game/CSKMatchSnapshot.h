@@ -0,0 +1,223 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Conquest.h"
+#include "BoardTypes.h"
+#include "CSKGameState.h"
+#include "Containers/HexBitboard.h"
+
+class USpellCard;
+class UTowerConstructionData;
+
+/** A tower on the board when a snapshot was captured */
+struct CONQUEST_API FCSKTowerSnapshot
+{
+public:
+
+	FCSKTowerSnapshot()
+		: Owner(0)
+		, Cell(INDEX_NONE)
+		, Health(0)
+		, MaxHealth(0)
+	{
+
+	}
+
+public:
+
+	/** The construction data the tower was built with */
+	TSubclassOf<UTowerConstructionData> ConstructData;
+
+	/** The player who owns the tower */
+	uint8 Owner;
+
+	/** Index of the tile the tower is on */
+	int32 Cell;
+
+	/** Health of the tower */
+	int32 Health;
+	int32 MaxHealth;
+};
+
+/** State of a player when a snapshot was captured */
+struct CONQUEST_API FCSKPlayerSnapshot
+{
+public:
+
+	FCSKPlayerSnapshot()
+		: Gold(0)
+		, Mana(0)
+		, BonusTileMovements(0)
+		, MaxNumSpellUses(0)
+		, bHasInfiniteSpellUses(false)
+		, SpellDiscount(0)
+		, TilesTraversedThisRound(0)
+		, SpellsCastThisRound(0)
+		, TotalGoldCollected(0)
+		, TotalManaCollected(0)
+		, TotalTilesTraversed(0)
+		, TotalTowersBuilt(0)
+		, TotalLegendaryTowersBuilt(0)
+		, TotalSpellsCast(0)
+		, TotalQuickEffectSpellsCast(0)
+		, RemainingActions(ECSKActionPhaseMode::None)
+		, CastleCell(INDEX_NONE)
+		, CastleHealth(0)
+		, CastleMaxHealth(0)
+	{
+
+	}
+
+public:
+
+	/** Resources and spell modifiers */
+	int32 Gold;
+	int32 Mana;
+	int32 BonusTileMovements;
+	int32 MaxNumSpellUses;
+	bool bHasInfiniteSpellUses;
+	int32 SpellDiscount;
+
+	/** Counters for the round in progress */
+	int32 TilesTraversedThisRound;
+	int32 SpellsCastThisRound;
+
+	/** Stats for the match so far */
+	int32 TotalGoldCollected;
+	int32 TotalManaCollected;
+	int32 TotalTilesTraversed;
+	int32 TotalTowersBuilt;
+	int32 TotalLegendaryTowersBuilt;
+	int32 TotalSpellsCast;
+	int32 TotalQuickEffectSpellsCast;
+
+	/** Actions the player has left this action phase (only used for the active player) */
+	ECSKActionPhaseMode RemainingActions;
+
+	/** Index of the tile the players castle is on */
+	int32 CastleCell;
+
+	/** Health of the players castle */
+	int32 CastleHealth;
+	int32 CastleMaxHealth;
+
+	/** Spell cards in order they are held */
+	TArray<TSubclassOf<USpellCard>> SpellCardDeck;
+	TArray<TSubclassOf<USpellCard>> SpellCardsInHand;
+	TArray<TSubclassOf<USpellCard>> SpellCardsDiscarded;
+};
+
+/** An action spell request waiting on the opposing player to select a nullify quick effect */
+struct CONQUEST_API FCSKPendingSpellSnapshot
+{
+public:
+
+	FCSKPendingSpellSnapshot()
+		: bIsSet(false)
+		, SpellIndex(0)
+		, TargetCell(INDEX_NONE)
+		, CalculatedCost(0)
+		, AdditionalMana(0)
+	{
+
+	}
+
+public:
+
+	/** If a request was pending */
+	bool bIsSet;
+
+	/** The spell card being cast */
+	TSubclassOf<USpellCard> SpellCard;
+
+	/** The index of the spell being cast */
+	int32 SpellIndex;
+
+	/** Index of the tile being targeted */
+	int32 TargetCell;
+
+	/** The final cost of the request (discounted + additional mana) */
+	int32 CalculatedCost;
+
+	/** The additional mana that was provided to the spell */
+	int32 AdditionalMana;
+};
+
+/**
+ * Snapshot of a match in progress, capturing the board, players and round. Snapshots are captured and
+ * applied by the game mode (see ACSKGameMode::CaptureMatchSnapshot), with applying patching the actors
+ * already in play rather than respawning the board. Snapshots serialize into a compact versioned format,
+ * using varints for values and a per snapshot table for classes
+ */
+struct CONQUEST_API FCSKMatchSnapshot
+{
+public:
+
+	FCSKMatchSnapshot();
+
+public:
+
+	/** Resets this snapshot to be empty */
+	void Reset();
+
+	/** Get the amount of cells on the board */
+	FORCEINLINE int32 NumCells() const { return Rows * Columns; }
+
+public:
+
+	/** Writes this snapshot into bytes */
+	void Serialize(TArray<uint8>& OutBytes) const;
+
+	/** Reads a snapshot written by Serialize. Get if successful */
+	bool Deserialize(const TArray<uint8>& Bytes);
+
+	/** Saves this snapshot to file (relative paths are relative to the snapshot directory). Get if successful */
+	bool SaveToFile(const FString& Filename) const;
+
+	/** Loads a snapshot from file (relative paths are relative to the snapshot directory). Get if successful */
+	bool LoadFromFile(const FString& Filename);
+
+	/** Get the directory snapshots are saved to */
+	static FString GetSnapshotDirectory();
+
+public:
+
+	/** Dimensions of the board */
+	int32 Rows;
+	int32 Columns;
+
+	/** Tiles that are null tiles (used to verify the board matches) */
+	FHexBitboard NullCells;
+
+	/** Element of every tile */
+	TArray<ECSKElementType> TileElements;
+
+	/** The round in progress */
+	int32 Round;
+
+	/** The round state in progress (always an action phase) */
+	ECSKRoundState RoundState;
+
+	/** The winner of the coin toss */
+	int32 StartingPlayer;
+
+	/** Current seed of the deck reshuffle stream */
+	int32 DeckReshuffleSeed;
+
+	/** State of the game states timer */
+	ECSKTimerState TimerState;
+	int32 TimeRemaining;
+
+	/** Time the action phase had before the timer switched to another state */
+	int32 ActionPhaseTimeRemaining;
+
+	/** State of each player */
+	FCSKPlayerSnapshot Players[CSK_MAX_NUM_PLAYERS];
+
+	/** Every tower on the board */
+	TArray<FCSKTowerSnapshot> Towers;
+
+	/** The action spell request waiting on a nullify quick effect selection */
+	FCSKPendingSpellSnapshot PendingSpell;
+};
@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Conquest.h"
+#include "CSKRulesEngine.h"
+#include "Async/Future.h"
+#include "Templates/Atomic.h"
+
+class FQueuedThreadPool;
+
+/** Settings for a single search */
+struct CONQUEST_API FCSKSearchSettings
+{
+public:
+
+	FCSKSearchSettings()
+		: TimeBudget(2.0)
+		, NumThreads(0)
+		, MaxIterations(0)
+		, MaxRolloutRounds(20)
+		, MaxNodesPerThread(1 << 18)
+		, TranspositionTableSize(1 << 16)
+		, ExplorationConstant(1.41f)
+		, Seed(0)
+	{
+
+	}
+
+public:
+
+	/** Time (in seconds) the search is allowed to run for */
+	double TimeBudget;
+
+	/** Amount of threads to search with (zero uses every search thread, see GetMaxThreads) */
+	int32 NumThreads;
+
+	/** Max iterations per thread (zero means only the time budget applies) */
+	int32 MaxIterations;
+
+	/** Rounds a rollout can play past the root before the state is evaluated instead */
+	int32 MaxRolloutRounds;
+
+	/** Max amount of nodes each threads tree can hold, rollouts continue once full */
+	int32 MaxNodesPerThread;
+
+	/** Amount of entries in the transposition table shared by every thread (zero disables it) */
+	int32 TranspositionTableSize;
+
+	/** Exploration constant used when selecting children (UCT) */
+	float ExplorationConstant;
+
+	/** Seed for the random streams of each thread */
+	int32 Seed;
+
+	/** Actions to never choose (e.g. actions that were previously denied) */
+	TArray<FCSKRulesAction> ExcludedActions;
+};
+
+/** Result of a search */
+struct CONQUEST_API FCSKSearchResult
+{
+public:
+
+	FCSKSearchResult()
+		: bFoundAction(false)
+		, NumRollouts(0)
+		, NumThreads(0)
+		, NumTranspositionHits(0)
+		, Visits(0)
+		, WinRate(0.f)
+		, Time(0.0)
+	{
+
+	}
+
+public:
+
+	/** If any action could be performed */
+	bool bFoundAction;
+
+	/** The action deemed best (most visited) */
+	FCSKRulesAction BestAction;
+
+	/** Amount of rollouts performed across all threads */
+	int64 NumRollouts;
+
+	/** Amount of threads that were searching */
+	int32 NumThreads;
+
+	/** Amount of times a child was scored using statistics shared through the transposition table */
+	int64 NumTranspositionHits;
+
+	/** Amount of times best action was visited */
+	int32 Visits;
+
+	/** Average result of best action for searching player */
+	float WinRate;
+
+	/** Time (in seconds) spent searching */
+	double Time;
+};
+
+/**
+ * Monte Carlo Tree Search over the rules engine. Searches are root parallel, with each thread growing
+ * its own tree from the root before the visits of the roots children are merged. This avoids any
+ * locking between threads, so rollouts scale with the amount of cores available. Results are also
+ * recorded by state hash in a lock free transposition table, allowing threads to share what they have
+ * learnt about states reached by different orders of actions (e.g. moving then building or vice versa).
+ * Trees are grown on a dedicated pool of low priority threads rather than the task graph, as searches
+ * occupy their threads for the entire time budget and would otherwise stall the game and render threads
+ */
+class CONQUEST_API FCSKMonteCarloSearch
+{
+public:
+
+	/** Searches for the best action for the active player of state. This will
+	block the calling thread until finished, so should be run asynchronously */
+	static FCSKSearchResult Search(const FCSKRulesEngine& Engine, const FCSKRulesState& State,
+		const FCSKSearchSettings& Settings, const TAtomic<bool>* bCancelled = nullptr);
+
+	/** Runs a search on the search thread pool, which will then grow the first tree on the pooled thread it was given.
+	Searches are run immediately if there is no pool. Cancelled flag must remain valid until the result is ready */
+	static TFuture<FCSKSearchResult> SearchAsync(const TSharedRef<const FCSKRulesEngine, ESPMode::ThreadSafe>& Engine,
+		const FCSKRulesState& State, const FCSKSearchSettings& Settings, const TAtomic<bool>* bCancelled = nullptr);
+
+	/** Get the value of state for player if the match were to stop now (between zero and one) */
+	static float EvaluateState(const FCSKRules& Rules, const FCSKRulesState& State, int32 PlayerID);
+
+	/** Get the max amount of threads a search can use (the calling thread plus each pooled thread) */
+	static int32 GetMaxThreads();
+
+public:
+
+	/** Creates the pool of threads searches grow trees on. Should be called once on startup */
+	static void StartupThreadPool();
+
+	/** Destroys the pool of threads, waiting for any trees still growing. Should be called once on shutdown */
+	static void ShutdownThreadPool();
+
+private:
+
+	/** Pool of threads trees are grown on, null if not supported */
+	static FQueuedThreadPool* ThreadPool;
+};
@@ -5,6 +5,8 @@
 #include "Conquest.h"
 #include "GameFramework/PlayerController.h"
 #include "BoardTypes.h"
+#include "NetTileRef.h"
+#include "Containers/HexBitboard.h"
 #include "CSKPlayerController.generated.h"
 
 class ACastle;
@@ -87,6 +89,7 @@ class CONQUEST_API ACSKPlayerController : public APlayerController
 	GENERATED_BODY()
 
 	friend class ACSKPlayerCameraManager;
+	friend class UCSKAIComponent;
 	
 public:
 
@@ -162,6 +165,11 @@ public:
 	UFUNCTION(BlueprintPure, Category = CSK)
 	ACSKPlayerCameraManager* GetCSKPlayerCameraManager() const;
 
+	/** Get if this controller is an AI player spawned by the server. These have no client,
+	so never report back when client sequences (e.g. transitions) have finished */
+	UFUNCTION(BlueprintPure, Category = CSK)
+	bool IsAIPlayer() const;
+
 	/** Get cached CSK HUD (only valid on clients) */
 	UFUNCTION(BlueprintPure, Category = CSK)
 	ACSKHUD* GetCSKHUD() const;
@@ -205,7 +213,7 @@ private:
 
 	/** Executes the on select tile event on the server */
 	UFUNCTION(Server, Reliable, WithValidation)
-	void Server_ExecuteCustomOnSelectTile(ATile* SelectedTile);
+	void Server_ExecuteCustomOnSelectTile(const FNetTileRef& SelectedTileRef);
 
 public:
 
@@ -243,6 +251,47 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, AdvancedDisplay, Category = CSK)
 	int32 SelectedSpellAdditionalMana;
 
+private:
+
+	/** Get if the selected spell can be cast onto tile, rebuilding the spell target mask if out of date */
+	bool CanCastSelectedSpellOnTile(const ATile* Tile);
+
+	/** Rebuilds the spell target mask if anything it was built with has since changed */
+	void UpdateSpellTargetMask();
+
+private:
+
+	/** State the spell target mask was built with */
+	struct FSpellTargetMaskKey
+	{
+		FORCEINLINE bool operator == (const FSpellTargetMaskKey& Other) const
+		{
+			return SpellCard == Other.SpellCard && SpellIndex == Other.SpellIndex && AdditionalMana == Other.AdditionalMana &&
+				Mana == Other.Mana && SpellDiscount == Other.SpellDiscount && Generation == Other.Generation;
+		}
+
+		FORCEINLINE bool operator != (const FSpellTargetMaskKey& Other) const
+		{
+			return !(*this == Other);
+		}
+
+		UClass* SpellCard;
+		int32 SpellIndex;
+		int32 AdditionalMana;
+		int32 Mana;
+		int32 SpellDiscount;
+		uint32 Generation;
+	};
+
+	/** Cells the selected spell can be cast onto, allowing hovering to skip evaluating the spell (only valid on the client) */
+	FHexBitboard SpellTargetMask;
+
+	/** Key of the spell target mask, the mask is only valid while this matches */
+	FSpellTargetMaskKey SpellTargetMaskKey;
+
+	/** If the spell target mask has been built at least once */
+	uint32 bHasSpellTargetMask : 1;
+
 public:
 
 	/** Set the castle this player manages. This only works on the server */
@@ -368,6 +417,9 @@ public:
 	/** If this player is currently performing their action phase */
 	FORCEINLINE bool IsPerformingActionPhase() const { return bIsActionPhase; }
 
+	/** Get the actions this player can still perform during their action phase */
+	FORCEINLINE ECSKActionPhaseMode GetRemainingActions() const { return RemainingActions; }
+
 	/** If this player is allowed to end their action phase */
 	UFUNCTION(BlueprintPure, Category = CSK)
 	bool CanEndActionPhase() const;
@@ -455,7 +507,7 @@ public:
 
 	/** Notify that an action phase build request has been confirmed */
 	UFUNCTION(Client, Reliable)
-	void Client_OnTowerBuildRequestConfirmed(ATile* TargetTile);
+	void Client_OnTowerBuildRequestConfirmed(const FNetTileRef& TargetTileRef);
 
 	/** Notify that an action phase build request has finished */
 	UFUNCTION(Client, Reliable)
@@ -463,7 +515,7 @@ public:
 
 	/** Notify that a spell cast has been confirmed */
 	UFUNCTION(Client, Reliable)
-	void Client_OnCastSpellRequestConfirmed(EActiveSpellContext SpellContext, ATile* TargetTile);
+	void Client_OnCastSpellRequestConfirmed(EActiveSpellContext SpellContext, const FNetTileRef& TargetTileRef);
 
 	/** Notify that a spell cast has finished */
 	UFUNCTION(Client, Reliable)
@@ -472,7 +524,7 @@ public:
 	/** Notify that this player is able to counter an incoming spell cast
 	(and if the spell is selection is a nullify or post action counter )*/
 	UFUNCTION(Client, Reliable)
-	void Client_OnSelectCounterSpell(bool bNullify, TSubclassOf<USpell> SpellToCounter, ATile* TargetTile);
+	void Client_OnSelectCounterSpell(bool bNullify, TSubclassOf<USpell> SpellToCounter, const FNetTileRef& TargetTileRef);
 
 	/** Notify that this players spell request is pending as the opposing player is selecting a counter */
 	UFUNCTION(Client, Reliable)
@@ -492,7 +544,7 @@ public:
 
 	/** Notify that the tower on given tile is starting is end round action */
 	UFUNCTION(Client, Reliable)
-	void Client_OnTowerActionStart(ATile* TileWithTower);
+	void Client_OnTowerActionStart(const FNetTileRef& TileWithTowerRef);
 
 public:
 
@@ -541,19 +593,19 @@ protected:
 
 	/** Makes a request to move our castle towards the goal tile */
 	UFUNCTION(Server, Reliable, WithValidation)
-	void Server_RequestCastleMoveAction(ATile* Goal);
+	void Server_RequestCastleMoveAction(const FNetTileRef& GoalRef);
 
 	/** Makes a request to build a tower at given tile */
 	UFUNCTION(Server, Reliable, WithValidation)
-	void Server_RequestBuildTowerAction(TSubclassOf<UTowerConstructionData> TowerConstructData, ATile* Target);
+	void Server_RequestBuildTowerAction(TSubclassOf<UTowerConstructionData> TowerConstructData, const FNetTileRef& TargetRef);
 
 	/** Makes a request to cast a spell at given tile (with additional mana cost) */
 	UFUNCTION(Server, Reliable, WithValidation)
-	void Server_RequestCastSpellAction(TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, ATile* Target, int32 AdditionalMana);
+	void Server_RequestCastSpellAction(TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, const FNetTileRef& TargetRef, int32 AdditionalMana);
 
 	/** Makes a request to cast a counter spell at given tile */
 	UFUNCTION(Server, Reliable, WithValidation)
-	void Server_RequestCastQuickEffectAction(TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, ATile* Target, int32 AdditionalMana);
+	void Server_RequestCastQuickEffectAction(TSubclassOf<USpellCard> SpellCard, int32 SpellIndex, const FNetTileRef& TargetRef, int32 AdditionalMana);
 
 	/** Makes a request to skip selecting a counter spell */
 	UFUNCTION(Server, Reliable, WithValidation)
@@ -561,7 +613,7 @@ protected:
 
 	/** Makes a request to use bonus spell at selected tile */
 	UFUNCTION(Server, Reliable, WithValidation)
-	void Server_RequestCastBonusSpellAction(ATile* Target);
+	void Server_RequestCastBonusSpellAction(const FNetTileRef& TargetRef);
 
 	/** Makes a request to skip using a bonus elemental spell */
 	UFUNCTION(Server, Reliable, WithValidation)
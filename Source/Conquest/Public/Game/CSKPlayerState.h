@@ -11,6 +11,7 @@ class ACSKPlayerController;
 class ATower;
 class USpell;
 class USpellCard;
+struct FCSKPlayerSnapshot;
 enum class ESpellType : uint8;
 
 /**
@@ -113,6 +114,11 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Board)
 	void RemoveTower(ATower* InTower);
 
+	/** Checks again if a tower this player owns wants the collection phase event. This should be
+	called after the tower has been built, as towers may only decide this when built by a player */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Board)
+	void UpdateCollectionPhaseTower(ATower* InTower);
+
 	/** Gives this player additional amount of spell uses per action phase (can be negative) */
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = Spells)
 	void AddSpellUses(int32 Amount);
@@ -226,7 +232,16 @@ public:
 	FORCEINLINE int32 GetBonusTileMovements() const { return BonusTileMovements; }
 
 	/** Get the towers this player owns */
-	FORCEINLINE const TArray<ATower*> GetOwnedTowers() const { return OwnedTowers; }
+	FORCEINLINE const TArray<ATower*>& GetOwnedTowers() const { return OwnedTowers; }
+
+	/** Get the towers this player owns that want the collection phase event (only valid on the server) */
+	FORCEINLINE const TArray<ATower*>& GetCollectionPhaseTowers() const { return CollectionPhaseTowers; }
+
+	/** Get the fixed amount of gold this players towers without the collection phase event give (only valid on the server) */
+	FORCEINLINE int32 GetCollectionGoldFromTowers() const { return CollectionGoldFromTowers; }
+
+	/** Get the fixed amount of mana this players towers without the collection phase event give (only valid on the server) */
+	FORCEINLINE int32 GetCollectionManaFromTowers() const { return CollectionManaFromTowers; }
 
 	/** Get the number of NORMAL towers this player owns */
 	UFUNCTION(BlueprintPure, Category = Board)
@@ -271,6 +286,9 @@ private:
 	/** Updates our cached tower numbers based on current state of owned towers */
 	void UpdateTowerCounts();
 
+	/** Adds (or removes if scale is negative) the fixed collection yields of tower */
+	void ApplyFixedCollectionYields(const ATower* InTower, int32 Scale);
+
 protected:
 
 	/** This players assigned color */
@@ -296,6 +314,16 @@ protected:
 	/** Cached count of how many LEGENDARY towers this player owns */
 	int32 CachedNumLegendaryTowers;
 
+	/** Towers that wanted the collection phase event when they were added. These
+	are the only towers that need to be asked for resources each collection phase */
+	UPROPERTY(Transient)
+	TArray<ATower*> CollectionPhaseTowers;
+
+	/** Sum of the fixed collection yields of every tower this player owns
+	that doesn't want the collection phase event (see UTowerConstructionData) */
+	int32 CollectionGoldFromTowers;
+	int32 CollectionManaFromTowers;
+
 	/** Cached map for counting how many of a certain type of any tower this players owns */
 	TMap<TSubclassOf<ATower>, int32> CachedUniqueTowerCount;
 
@@ -347,6 +375,15 @@ public:
 	/** Get the amount of spells this player has cast this round */
 	FORCEINLINE int32 GetSpellsCastThisRound() const { return SpellsCastThisRound; }
 
+public:
+
+	/** Captures this players resources, spell cards and stats into snapshot */
+	void CaptureMatchSnapshot(FCSKPlayerSnapshot& OutSnapshot) const;
+
+	/** Restores this players resources, spell cards and stats from snapshot. Towers
+	and the castle are restored by the game mode (see ACSKGameMode::ApplyMatchSnapshot) */
+	void RestoreMatchSnapshot(const FCSKPlayerSnapshot& Snapshot);
+
 protected:
 
 	/** The total amount of gold this player collected */
@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Conquest.h"
+#include "CSKRulesEngine.h"
+
+class USpellCard;
+class UTowerConstructionData;
+
+/** Type of request recorded by a replay log */
+enum class ECSKReplayRecordType : uint8
+{
+	/** Player ended their action phase (or it timed out) */
+	EndActionPhase,
+
+	/** Player moved their castle to tile */
+	CastleMove,
+
+	/** Player built tower of class on tile */
+	BuildTower,
+
+	/** Player cast spell card of class during their action phase */
+	CastSpell,
+
+	/** Player cast quick effect card of class in response to a spell */
+	CastQuickEffect,
+
+	/** Player skipped casting a quick effect */
+	SkipQuickEffect,
+
+	/** Player cast the pending bonus spell at tile */
+	CastBonusSpell,
+
+	/** Player skipped casting the pending bonus spell */
+	SkipBonusSpell,
+
+	MAX
+};
+
+/** A request that was accepted by the game mode */
+struct CONQUEST_API FCSKReplayRecord
+{
+public:
+
+	FCSKReplayRecord()
+		: Type(ECSKReplayRecordType::EndActionPhase)
+		, PlayerID(0)
+		, bTimeOut(false)
+		, Round(0)
+		, Cell(INDEX_NONE)
+		, ClassIndex(INDEX_NONE)
+		, SpellIndex(0)
+		, AdditionalMana(0)
+		, Seed(0)
+	{
+
+	}
+
+public:
+
+	/** The type of request */
+	ECSKReplayRecordType Type;
+
+	/** The player who made the request */
+	uint8 PlayerID;
+
+	/** If this request was made due to running out of time */
+	bool bTimeOut;
+
+	/** The round this request was made in */
+	int32 Round;
+
+	/** Index of the tile targeted by this request (or INDEX_NONE) */
+	int32 Cell;
+
+	/** Index of the tower or spell card class in the logs class table (or INDEX_NONE) */
+	int32 ClassIndex;
+
+	/** Index of the spell of the spell card that was cast */
+	int32 SpellIndex;
+
+	/** Additional mana spent on spell */
+	int32 AdditionalMana;
+
+	/** Current seed of the deck reshuffle stream when this request was made */
+	int32 Seed;
+};
+
+/** Result of fast forwarding through a replay log */
+struct CONQUEST_API FCSKReplayResult
+{
+public:
+
+	FCSKReplayResult()
+		: NumApplied(0)
+		, NumSkipped(0)
+		, DivergedRecord(INDEX_NONE)
+		, Time(0.0)
+	{
+
+	}
+
+	/** Get if a record could not be re-executed */
+	FORCEINLINE bool HasDiverged() const { return DivergedRecord != INDEX_NONE; }
+
+public:
+
+	/** Amount of records re-executed by the rules engine */
+	int32 NumApplied;
+
+	/** Amount of records skipped as the rules engine doesn't simulate them (quick effects and bonus spells) */
+	int32 NumSkipped;
+
+	/** Index of the first record that could not be re-executed (or INDEX_NONE) */
+	int32 DivergedRecord;
+
+	/** Why the diverged record could not be re-executed */
+	FString Divergence;
+
+	/** State of the match once fast forwarding stopped */
+	FCSKRulesState State;
+
+	/** Time (in seconds) spent fast forwarding */
+	double Time;
+};
+
+/**
+ * Compact binary log of every request accepted during a match. Along with the rules and coin toss, each
+ * record carries the seed of the deck reshuffle stream, allowing a match to be re-executed by the rules
+ * engine without a world. Tiles are stored as hex indices and classes as indices into a per match table
+ */
+class CONQUEST_API FCSKReplayLog
+{
+public:
+
+	FCSKReplayLog();
+
+public:
+
+	/** Clears this log and starts recording a new match. Classes of towers and spell cards
+	need to match those used by the rules (see ACSKGameMode::GetRulesEngineRules) */
+	void BeginMatch(const FCSKRules& InRules, int32 InSeed, int32 InStartingPlayer,
+		const TArray<TSubclassOf<UTowerConstructionData>>& Towers, const TArray<TSubclassOf<USpellCard>>& SpellCards);
+
+	/** Stops recording and clears the log */
+	void Reset();
+
+	/** Adds a record to the log if recording */
+	void AddRecord(const FCSKReplayRecord& Record);
+
+	/** Get the index of class in the class table, adding it if required */
+	int32 GetClassIndex(const UClass* Class);
+
+	/** Get if a match is being recorded */
+	FORCEINLINE bool IsRecording() const { return bRecording; }
+
+	/** Get the records of the match */
+	FORCEINLINE const TArray<FCSKReplayRecord>& GetRecords() const { return Records; }
+
+	/** Get the path of class at index in the class table */
+	FORCEINLINE const FString& GetClassPath(int32 Index) const { return ClassPaths[Index]; }
+
+public:
+
+	/** Writes this log into bytes */
+	void Serialize(TArray<uint8>& OutBytes) const;
+
+	/** Reads a log written by Serialize. Get if successful */
+	bool Deserialize(const TArray<uint8>& Bytes);
+
+	/** Saves this log to file (relative paths are relative to the replay directory). Get if successful */
+	bool SaveToFile(const FString& Filename) const;
+
+	/** Loads a log from file (relative paths are relative to the replay directory). Get if successful */
+	bool LoadFromFile(const FString& Filename);
+
+	/** Re-executes the match using the rules engine, stopping at the first record that diverges */
+	void FastForward(FCSKReplayResult& OutResult) const;
+
+	/** Get the directory replay logs are saved to */
+	static FString GetReplayDirectory();
+
+private:
+
+	/** The rules the match was played with */
+	FCSKRules Rules;
+
+	/** Initial seed of the deck reshuffle stream */
+	int32 Seed;
+
+	/** The winner of the coin toss */
+	int32 StartingPlayer;
+
+	/** Classes referenced by records. Towers and spell cards of rules are always first */
+	TArray<FString> ClassPaths;
+
+	/** Index of classes already in the class table */
+	TMap<const UClass*, int32> ClassIndices;
+
+	/** Requests in order they were accepted */
+	TArray<FCSKReplayRecord> Records;
+
+	/** If a match is being recorded */
+	bool bRecording;
+};
@@ -0,0 +1,454 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Conquest.h"
+#include "BoardTypes.h"
+#include "Containers/HexBitboard.h"
+
+/** The limits on the amount of towers a player can own (see ACSKGameMode) */
+struct CONQUEST_API FCSKTowerLimits
+{
+public:
+
+	FCSKTowerLimits()
+		: MaxNumTowers(7)
+		, MaxNumDuplicatedTowers(2)
+		, MaxNumDuplicatedTowerTypes(2)
+		, MaxNumLegendaryTowers(1)
+	{
+
+	}
+
+public:
+
+	/** Max normal towers a player can own (zero means unlimited) */
+	int32 MaxNumTowers;
+
+	/** Max instances of the same normal tower a player can own (zero means unlimited) */
+	int32 MaxNumDuplicatedTowers;
+
+	/** Max types of normal tower a player can own duplicates of (zero means unlimited) */
+	int32 MaxNumDuplicatedTowerTypes;
+
+	/** Max legendary towers a player can own (zero means unlimited) */
+	int32 MaxNumLegendaryTowers;
+};
+
+/** Static data about a tower that can be built. Towers events are implemented in blueprints,
+so the rules engine models them as fixed resources and damage to opposing pieces in range */
+struct CONQUEST_API FCSKRulesTower
+{
+public:
+
+	FCSKRulesTower()
+		: GoldCost(0)
+		, ManaCost(0)
+		, Health(5)
+		, CollectionGold(0)
+		, CollectionMana(0)
+		, SpellUses(0)
+		, EndRoundPriority(0)
+		, EndRoundRange(0)
+		, EndRoundDamage(0)
+		, bIsLegendary(false)
+	{
+
+	}
+
+public:
+
+	/** Gold required to build this tower */
+	int32 GoldCost;
+
+	/** Mana required to build this tower */
+	int32 ManaCost;
+
+	/** Health this tower is built with */
+	int32 Health;
+
+	/** Gold this tower gives its owner every collection phase */
+	int32 CollectionGold;
+
+	/** Mana this tower gives its owner every collection phase */
+	int32 CollectionMana;
+
+	/** Additional spells its owner can cast each round while this tower is owned */
+	int32 SpellUses;
+
+	/** Priority of this towers end round action (lower goes first) */
+	int32 EndRoundPriority;
+
+	/** Range of this towers end round action */
+	int32 EndRoundRange;
+
+	/** Damage applied to each opposing piece within range during the end round phase (zero means no action) */
+	int32 EndRoundDamage;
+
+	/** If this tower is legendary */
+	bool bIsLegendary;
+};
+
+/** Static data about an action phase spell card. Spell effects are implemented in blueprints,
+so the rules engine models them as damage to the board piece on the target tile */
+struct CONQUEST_API FCSKRulesSpellCard
+{
+public:
+
+	FCSKRulesSpellCard()
+		: StaticCost(5)
+		, Damage(0)
+		, bExpectsAdditionalMana(false)
+		, bIsActionSpell(true)
+	{
+
+	}
+
+public:
+
+	/** Static cost of this spell */
+	int32 StaticCost;
+
+	/** Damage dealt to the targeted piece. Additional mana is added on top */
+	int32 Damage;
+
+	/** If this spell accepts additional mana */
+	bool bExpectsAdditionalMana;
+
+	/** If this card can be cast during the action phase (quick effect cards can't) */
+	bool bIsActionSpell;
+};
+
+/** The rules of a match, along with the board it is played on. Built once and shared by every simulation */
+struct CONQUEST_API FCSKRules
+{
+public:
+
+	FCSKRules();
+
+	/** Sets the dimensions of the board. This clears any null cells and portals. Cells are stored as int16,
+	so boards with more than MAX_int16 cells are not supported. Get if board was initialized */
+	bool InitBoard(int32 InRows, int32 InColumns);
+
+	/** Get the amount of cells on the board */
+	FORCEINLINE int32 NumCells() const { return Rows * Columns; }
+
+	/** Get the neighbor of a cell in given direction (or INDEX_NONE) */
+	FORCEINLINE int32 GetNeighbor(int32 Cell, int32 Direction) const { return Neighbors[Cell * 6 + Direction]; }
+
+	#if !UE_BUILD_SHIPPING
+	/** Sets up a small board with a few towers and spells, for use by benchmarks */
+	void InitBenchmark();
+	#endif
+
+	/** Get the distance between two cells */
+	int32 GetDistance(int32 Cell1, int32 Cell2) const;
+
+public:
+
+	/** Rows of the board */
+	int32 Rows;
+
+	/** Columns of the board */
+	int32 Columns;
+
+	/** Neighbors of each cell, 6 per cell (see FHexGrid::GetNeighborIndex) */
+	TArray<int32> Neighbors;
+
+	/** Hex of each cell */
+	TArray<FIntVector> CellHexes;
+
+	/** Cells that are null tiles */
+	FHexBitboard NullCells;
+
+	/** Cells that are portal tiles */
+	FHexBitboard PortalCells;
+
+	/** The portal of each player */
+	int32 PlayerPortals[CSK_MAX_NUM_PLAYERS];
+
+public:
+
+	int32 StartingGold;
+	int32 StartingMana;
+	int32 CollectionPhaseGold;
+	int32 CollectionPhaseMana;
+	int32 MaxGold;
+	int32 MaxMana;
+	int32 MaxBuildRange;
+	int32 MaxSpellUses;
+	int32 MaxSpellCardsInHand;
+	int32 MinTileMovements;
+	int32 MaxTileMovements;
+	int32 CastleHealth;
+	bool bLimitOneMoveActionPerTurn;
+
+	/** Limits for building towers */
+	FCSKTowerLimits TowerLimits;
+
+	/** Towers that can be built */
+	TArray<FCSKRulesTower> Towers;
+
+	/** Spell cards every players deck is made of */
+	TArray<FCSKRulesSpellCard> SpellCards;
+};
+
+/** Type of action a player can perform during their action phase */
+enum class ECSKRulesActionType : uint8
+{
+	/** End the active players action phase */
+	EndPhase,
+
+	/** Move the active players castle to cell */
+	MoveCastle,
+
+	/** Build tower of index on cell */
+	BuildTower,
+
+	/** Cast spell card in hand slot of index on cell */
+	CastSpell
+};
+
+/** An action that can be applied to a match */
+struct CONQUEST_API FCSKRulesAction
+{
+public:
+
+	FCSKRulesAction()
+		: Type(ECSKRulesActionType::EndPhase)
+		, Index(0)
+		, AdditionalMana(0)
+		, Cell(INDEX_NONE)
+	{
+
+	}
+
+	FCSKRulesAction(ECSKRulesActionType InType, int32 InCell, int32 InIndex = 0, int32 InAdditionalMana = 0)
+		: Type(InType)
+		, Index(static_cast<uint8>(InIndex))
+		, AdditionalMana(static_cast<uint8>(InAdditionalMana))
+		, Cell(static_cast<int16>(InCell))
+	{
+
+	}
+
+	FORCEINLINE bool operator == (const FCSKRulesAction& Other) const
+	{
+		return Type == Other.Type && Index == Other.Index && AdditionalMana == Other.AdditionalMana && Cell == Other.Cell;
+	}
+
+	FORCEINLINE bool operator != (const FCSKRulesAction& Other) const
+	{
+		return !(*this == Other);
+	}
+
+public:
+
+	/** The action to perform */
+	ECSKRulesActionType Type;
+
+	/** Tower type or hand slot */
+	uint8 Index;
+
+	/** Additional mana to spend on spell */
+	uint8 AdditionalMana;
+
+	/** Target cell */
+	int16 Cell;
+};
+
+/** A tower that has been built */
+struct CONQUEST_API FCSKRulesTowerState
+{
+public:
+
+	/** Index of tower in rules */
+	uint8 Type;
+
+	/** Player who owns this tower */
+	uint8 Owner;
+
+	/** Cell this tower is on */
+	int16 Cell;
+
+	/** Remaining health of this tower, a tower with no health is waiting to be removed */
+	int16 Health;
+};
+
+/** State of a player during a match (see ACSKPlayerState) */
+struct CONQUEST_API FCSKRulesPlayerState
+{
+public:
+
+	FCSKRulesPlayerState();
+
+public:
+
+	int32 Gold;
+	int32 Mana;
+	int32 CastleCell;
+	int32 CastleHealth;
+	int32 TilesTraversedThisRound;
+	int32 BonusTileMovements;
+	int32 SpellsCastThisRound;
+	int32 MaxNumSpellUses;
+	int32 SpellDiscount;
+
+	/** Actions that can still be performed this action phase */
+	ECSKActionPhaseMode RemainingActions;
+
+	/** Spell cards in hand and left in deck (as index in rules) */
+	TArray<uint8, TInlineAllocator<8>> SpellCardsInHand;
+	TArray<uint8, TInlineAllocator<16>> SpellCardDeck;
+
+	/** Amount of each tower type this player owns */
+	TArray<uint8, TInlineAllocator<8>> TowerCounts;
+
+	int32 NumNormalTowers;
+	int32 NumLegendaryTowers;
+};
+
+/** State of a match. This is a value type, so copying it will fork the match */
+struct CONQUEST_API FCSKRulesState
+{
+public:
+
+	FCSKRulesState();
+
+	/** Get if match has finished */
+	FORCEINLINE bool IsMatchOver() const { return Winner != INDEX_NONE; }
+
+public:
+
+	/** State of each player */
+	FCSKRulesPlayerState Players[CSK_MAX_NUM_PLAYERS];
+
+	/** Towers that have been built by both players */
+	TArray<FCSKRulesTowerState, TInlineAllocator<16>> Towers;
+
+	/** Cells with a board piece on them */
+	FHexBitboard OccupiedCells;
+
+	/** Stream used to shuffle decks */
+	FRandomStream DeckReshuffleStream;
+
+	/** Rounds that have started */
+	int32 Round;
+
+	/** The current round state. Only action phases are ever observed, others are run automatically */
+	ECSKRoundState RoundState;
+
+	/** Player who won the coin toss */
+	int32 StartingPlayer;
+
+	/** Player performing their action phase */
+	int32 ActivePlayer;
+
+	/** Player who won the match, INDEX_NONE if still running */
+	int32 Winner;
+
+	/** How the match was won */
+	ECSKMatchWinCondition WinCondition;
+};
+
+/**
+ * Headless implementation of the rules of CSK. Matches are played by applying actions to a
+ * state, with collection and end round phases being run automatically in between action phases.
+ * This does not require a world, allowing matches to be simulated (e.g. for AI) or requests validated
+ */
+class CONQUEST_API FCSKRulesEngine
+{
+public:
+
+	FCSKRulesEngine(const FCSKRules& InRules);
+
+public:
+
+	/** Starts a new match, running the first collection phase. Seed is used for shuffling decks */
+	void InitMatch(FCSKRulesState& OutState, int32 StartingPlayer, int32 Seed) const;
+
+	/** Get if action can be applied to state by the active player. Spell targets are modelled as needing a board piece,
+	this can be skipped when the actual targeting rules of the spell are being checked instead (see ACSKGameMode::RequestCastSpell) */
+	bool IsActionLegal(const FCSKRulesState& State, const FCSKRulesAction& Action, bool bCheckSpellTarget = true) const;
+
+	/** Applies action to state if legal. Get if action was applied */
+	bool ApplyAction(FCSKRulesState& State, const FCSKRulesAction& Action) const;
+
+	/** Get every action the active player can perform */
+	void GetLegalActions(const FCSKRulesState& State, TArray<FCSKRulesAction>& OutActions) const;
+
+	/** Ends the active players action phase even if requirements haven't been met (see ACSKGameMode::RequestEndActionPhase) */
+	void TimeOutActionPhase(FCSKRulesState& State) const;
+
+	/** Get the rules in use */
+	FORCEINLINE const FCSKRules& GetRules() const { return Rules; }
+
+public:
+
+	/** Get the amount of tiles a player can still move this round (see ACSKGameState::GetPlayersNumRemainingMoves) */
+	static int32 GetRemainingMoves(int32 MinTileMovements, int32 MaxTileMovements, int32 BonusTileMovements, int32 TilesTraversed);
+
+	/** Get the discounted cost of a spell if affordable (see ACSKPlayerState::GetDiscountedManaIfAffordable) */
+	static bool GetDiscountedCostIfAffordable(int32 StaticCost, int32 SpellDiscount, int32 Mana, int32& OutCost);
+
+	/** Get if a player is allowed to own another tower (see ACSKGameState::CanPlayerBuildTower). Instances are the duplicates
+	of this tower owned by the player if normal, and the instances owned by all players if legendary. This does not check costs */
+	static bool IsTowerWithinLimits(const FCSKTowerLimits& Limits, bool bIsLegendary, int32 NumNormalTowers,
+		int32 NumLegendaryTowers, int32 NumInstances, int32 NumDuplicateTypes);
+
+	/** Get the zobrist hash of state (see FCSKZobrist). Hands and decks are only hashed by size, so states that
+	only differ in the order cards will be drawn share a hash (as they would look the same to the opposing player) */
+	static uint64 HashState(const FCSKRulesState& State);
+
+private:
+
+	/** Runs collection phase then starts the first action phase */
+	void StartRound(FCSKRulesState& State) const;
+
+	/** Starts action phase for player (see ACSKPlayerController::SetActionPhaseEnabled) */
+	void StartActionPhase(FCSKRulesState& State, int32 Phase) const;
+
+	/** Ends the current action phase, running end round phase if required */
+	void EndActionPhase(FCSKRulesState& State) const;
+
+	/** Runs every towers end round action, in order of priority */
+	void RunEndRoundPhase(FCSKRulesState& State) const;
+
+	/** Disables an action for the active player, ending their phase if no actions remain */
+	void DisableAction(FCSKRulesState& State, ECSKActionPhaseMode Action) const;
+
+	/** Applies damage to the board piece on cell */
+	void DamageCell(FCSKRulesState& State, int32 Cell, int32 Amount) const;
+
+	/** Removes towers destroyed during the last action */
+	void ClearDestroyedTowers(FCSKRulesState& State) const;
+
+private:
+
+	/** Get if player can cast another spell. Costs are checked if required */
+	bool CanCastAnotherSpell(const FCSKRulesPlayerState& Player, bool bCheckCosts) const;
+
+	/** Get if player can cast spell in hand slot on cell. Cell only needs to be on the board if not checking target */
+	bool CanCastSpell(const FCSKRulesState& State, int32 PlayerID, int32 HandSlot, int32 Cell, int32 AdditionalMana, int32& OutFinalCost, bool bCheckTarget = true) const;
+
+	/** Get if player can build tower type (ignoring where) */
+	bool CanBuildTower(const FCSKRulesState& State, int32 PlayerID, int32 TowerType) const;
+
+	/** Get if player can build any tower */
+	bool CanBuildMoreTowers(const FCSKRulesState& State, int32 PlayerID) const;
+
+	/** Get if a tower can be built on cell by player */
+	bool IsBuildableCell(const FCSKRulesState& State, int32 PlayerID, int32 Cell) const;
+
+	/** Get the amount of tower types player owns duplicates of */
+	int32 GetNumDuplicateTypes(const FCSKRulesPlayerState& Player) const;
+
+	/** Searches for every cell the active player can move to. Get the amount of cells in queue (including the castle) */
+	int32 FindReachableCells(const FCSKRulesState& State, TArray<int32, TInlineAllocator<256>>& Distances,
+		TArray<int32, TInlineAllocator<256>>& Parents, TArray<int32, TInlineAllocator<256>>& Queue) const;
+
+private:
+
+	/** The rules matches are played by */
+	FCSKRules Rules;
+};
@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Features of a match that contribute to its hash */
+enum class ECSKHashFeature : uint8
+{
+	/** Value is the player who owns the board piece on cell index (plus one) */
+	Occupant,
+
+	/** Value is the element of tile of index */
+	Element,
+
+	/** Value is the health of the board piece on cell index */
+	Health,
+
+	/** Value is the tower type on cell index (plus one) with its owner in the upper half */
+	Tower,
+
+	/** Value is the cell of castle of player index (plus one) */
+	Castle,
+
+	/** Resources of player index */
+	Gold,
+	Mana,
+
+	/** Amount of cards held by player index */
+	HandSize,
+	DeckSize,
+
+	/** Round counters of player index */
+	TilesTraversed,
+	BonusTileMovements,
+	SpellsCast,
+	RemainingActions,
+
+	/** Value is the spell discount of player index in the upper half and max spell uses in the lower half */
+	SpellModifiers,
+
+	/** Match wide values (index is always zero) */
+	Round,
+	RoundState,
+	ActivePlayer,
+	Winner
+};
+
+/**
+ * Zobrist hashing for match states. Rather than filling tables of random keys (which would need to be identical on every
+ * machine), keys are derived by mixing the feature, index and value. A hash is the xor of the keys of every feature, so
+ * can be updated incrementally by toggling the old value out and the new value in. Values of zero contribute nothing,
+ * which allows empty cells and spent resources to be skipped entirely
+ */
+struct FCSKZobrist
+{
+public:
+
+	/** Get the key for feature of index having value */
+	static FORCEINLINE uint64 GetKey(ECSKHashFeature Feature, int32 Index, int32 Value)
+	{
+		if (Value == 0)
+		{
+			return 0;
+		}
+
+		// SplitMix64 finalizer, every input bit affects every output bit
+		uint64 Key = (static_cast<uint64>(Feature) << 56) | (static_cast<uint64>(static_cast<uint16>(Index)) << 32) | static_cast<uint32>(Value);
+		Key += 0x9E3779B97F4A7C15ull;
+		Key = (Key ^ (Key >> 30)) * 0xBF58476D1CE4E5B9ull;
+		Key = (Key ^ (Key >> 27)) * 0x94D049BB133111EBull;
+		return Key ^ (Key >> 31);
+	}
+
+	/** Toggles feature of index having value in or out of hash */
+	static FORCEINLINE void Toggle(uint64& Hash, ECSKHashFeature Feature, int32 Index, int32 Value)
+	{
+		Hash ^= GetKey(Feature, Index, Value);
+	}
+
+	/** Updates hash for feature of index changing from old value to new value */
+	static FORCEINLINE void Update(uint64& Hash, ECSKHashFeature Feature, int32 Index, int32 OldValue, int32 NewValue)
+	{
+		if (OldValue != NewValue)
+		{
+			Hash ^= GetKey(Feature, Index, OldValue) ^ GetKey(Feature, Index, NewValue);
+		}
+	}
+};
+
+/**
+ * Fixed size table of visits and values keyed by match hash, shared by every thread of a search. Entries are written
+ * without locks by storing the key xor'd with the data, so an entry torn by two threads writing at once will simply fail
+ * to match its key on the next probe. Lost updates only skew statistics slightly, which a search can tolerate
+ */
+class FCSKTranspositionTable
+{
+public:
+
+	/** Amount of entries is rounded up to a power of two */
+	FCSKTranspositionTable(int32 NumEntries)
+	{
+		const uint32 Size = FMath::RoundUpToPowerOfTwo(static_cast<uint32>(FMath::Max(2, NumEntries)));
+		Mask = Size - 1;
+
+		Checks.SetNumZeroed(Size);
+		Data.SetNumZeroed(Size);
+	}
+
+	/** Get the visits and total value recorded for hash. Get if hash was found */
+	bool Probe(uint64 Hash, int32& OutVisits, float& OutValue) const
+	{
+		for (uint32 Slot : { GetSlot(Hash), GetSlot(Hash) ^ 1 })
+		{
+			const uint64 Entry = Read(Data[Slot]);
+			if ((Read(Checks[Slot]) ^ Entry) == Hash && Entry != 0)
+			{
+				Unpack(Entry, OutVisits, OutValue);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/** Adds visits and value to the entry of hash, replacing the least visited entry of its bucket if not found */
+	void Add(uint64 Hash, int32 Visits, float Value)
+	{
+		const uint32 Slots[2] = { GetSlot(Hash), GetSlot(Hash) ^ 1 };
+
+		uint32 ReplaceSlot = Slots[0];
+		int32 ReplaceVisits = MAX_int32;
+
+		int32 OldVisits = 0;
+		float OldValue = 0.f;
+
+		for (uint32 Slot : Slots)
+		{
+			const uint64 Entry = Read(Data[Slot]);
+			Unpack(Entry, OldVisits, OldValue);
+
+			if ((Read(Checks[Slot]) ^ Entry) == Hash)
+			{
+				Write(Slot, Hash, Pack(OldVisits + Visits, OldValue + Value));
+				return;
+			}
+
+			if (OldVisits < ReplaceVisits)
+			{
+				ReplaceSlot = Slot;
+				ReplaceVisits = OldVisits;
+			}
+		}
+
+		Write(ReplaceSlot, Hash, Pack(Visits, Value));
+	}
+
+	/** Get the amount of entries */
+	FORCEINLINE int32 Num() const { return Data.Num(); }
+
+private:
+
+	FORCEINLINE uint32 GetSlot(uint64 Hash) const
+	{
+		return static_cast<uint32>(Hash) & Mask;
+	}
+
+	static FORCEINLINE uint64 Read(const int64& Value)
+	{
+		return static_cast<uint64>(FPlatformAtomics::AtomicRead_Relaxed(&Value));
+	}
+
+	FORCEINLINE void Write(uint32 Slot, uint64 Hash, uint64 Entry)
+	{
+		FPlatformAtomics::AtomicStore_Relaxed(&Data[Slot], static_cast<int64>(Entry));
+		FPlatformAtomics::AtomicStore_Relaxed(&Checks[Slot], static_cast<int64>(Hash ^ Entry));
+	}
+
+	/** Visits are stored in the upper half and the value as raw float bits in the lower half */
+	static FORCEINLINE uint64 Pack(int32 Visits, float Value)
+	{
+		uint32 ValueBits;
+		FMemory::Memcpy(&ValueBits, &Value, sizeof(float));
+		return (static_cast<uint64>(static_cast<uint32>(Visits)) << 32) | ValueBits;
+	}
+
+	static FORCEINLINE void Unpack(uint64 Entry, int32& OutVisits, float& OutValue)
+	{
+		const uint32 ValueBits = static_cast<uint32>(Entry);
+		FMemory::Memcpy(&OutValue, &ValueBits, sizeof(float));
+		OutVisits = static_cast<int32>(Entry >> 32);
+	}
+
+private:
+
+	/** Key xor'd with data for each entry */
+	TArray<int64> Checks;
+
+	/** Packed visits and value for each entry */
+	TArray<int64> Data;
+
+	/** Mask for mapping hashes to slots */
+	uint32 Mask;
+};
@@ -5,12 +5,14 @@
 #include "BoardTypes.h"
 #include "Spell.generated.h"
 
+class ABoardManager;
 class ACSKPlayerState;
 class ACSKGameMode;
 class ACSKGameState;
 class ASpellActor;
 class ATile;
 class USpellWidget;
+struct FHexBitboard;
 
 /** Type used to indentify when a spell can be used */
 UENUM(BlueprintType)
@@ -28,6 +30,82 @@ enum class ESpellType : uint8
 	ElementBonus
 };
 
+/** The occupants of tiles a spell can target (bitset so spells can target multiple) */
+UENUM(BlueprintType, meta = (Bitflags, UseEnumValuesAsMaskValuesInEditor = "true"))
+enum class ESpellTargetOccupant : uint8
+{
+	/** Tiles without a board piece */
+	Empty			= 1,
+
+	/** Tiles with the casting players castle or towers */
+	OwnCastle		= 2,
+	OwnTower		= 4,
+
+	/** Tiles with the opposing players castle or towers */
+	EnemyCastle		= 8,
+	EnemyTower		= 16,
+
+	/** Tiles that are null tiles */
+	NullTile		= 32,
+
+	All				= 63	UMETA(Hidden="true"),
+	None			= 0		UMETA(Hidden="true")
+};
+
+ENUM_CLASS_FLAGS(ESpellTargetOccupant);
+
+/** Declarative rules for which tiles a spell can target and how much casting on them costs. These are evaluated
+natively (over the boards bitboards when possible), so spells that only need these rules should not override
+CanActivateSpell or CalculateFinalCost, as doing so requires every tile to be checked through blueprints */
+USTRUCT(BlueprintType)
+struct CONQUEST_API FSpellTargetingRules
+{
+	GENERATED_BODY()
+
+public:
+
+	FSpellTargetingRules()
+		: MaxRange(-1)
+		, Elements(static_cast<uint8>(ECSKElementType::None))
+		, Occupants(static_cast<uint8>(ESpellTargetOccupant::All))
+		, ManaPerTileFromCastle(0)
+	{
+
+	}
+
+public:
+
+	/** Get if range is limited by distance from the casting players castle */
+	FORCEINLINE bool HasMaxRange() const { return MaxRange >= 0; }
+
+	/** Get the elements that can be targeted (None if any element can be) */
+	FORCEINLINE ECSKElementType GetElements() const { return static_cast<ECSKElementType>(Elements); }
+
+	/** Get the occupants that can be targeted */
+	FORCEINLINE ESpellTargetOccupant GetOccupants() const { return static_cast<ESpellTargetOccupant>(Occupants); }
+
+	/** Get if cost depends on the tile being targeted */
+	FORCEINLINE bool HasCostPerTile() const { return ManaPerTileFromCastle != 0; }
+
+public:
+
+	/** Max distance from the casting players castle a tile can be targeted at. Negative for no limit */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting, meta = (ClampMin = -1))
+	int32 MaxRange;
+
+	/** Elements of tiles that can be targeted. No elements means any element can be targeted */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting, meta = (Bitmask, BitmaskEnum = "ECSKElementType"))
+	uint8 Elements;
+
+	/** Occupants of tiles that can be targeted */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting, meta = (Bitmask, BitmaskEnum = "ESpellTargetOccupant"))
+	uint8 Occupants;
+
+	/** Additional mana required for each tile the target is away from the casting players castle */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Targeting, meta = (ClampMin = 0))
+	int32 ManaPerTileFromCastle;
+};
+
 /**
  * An indiviual spell a player can use. Spells are attached to a spell card and are used
  * to verify costs and ultimately spawn in the spell actor which handles casting the spell.
@@ -49,19 +127,39 @@ public:
 	UFUNCTION(BlueprintNativeEvent, BlueprintPure, Category = Spells)
 	bool RequiresTarget() const;
 
-	/** Check if spell can be used on given tile. This can get called on clients,
-	but will ultimately be called on the server to validate before allowing cast */
+	/** Check if spell can be used on given tile. This can get called on clients, but will ultimately
+	be called on the server to validate before allowing cast. By default, checks the targeting rules */
 	UFUNCTION(BlueprintNativeEvent, BlueprintPure, Category = Spells)
 	bool CanActivateSpell(const ACSKPlayerState* CastingPlayer, const ATile* TargetTile) const;
 
 	/** Calculates the final cost of this spell. Passes in the player casting the spell, the
-	tile they plan to cast it onto, the discounted static cost and how much additional mana 
-	they are willing to spend. By default, will return DiscountedCost + AdditionalMana */
+	tile they plan to cast it onto, the discounted static cost and how much additional mana they are willing
+	to spend. By default, will return DiscountedCost + AdditionalMana + the targeting rules cost for the tile */
 	UFUNCTION(BlueprintNativeEvent, BlueprintPure, Category = Spells)
 	int32 CalculateFinalCost(const ACSKPlayerState* CastingPlayer, const ATile* TargetTile, int32 DiscountedCost, int32 AdditionalMana) const;
 
+public:
+
+	/** Checks if spell can be used on given tile, only calling CanActivateSpell through blueprints if overridden */
+	bool CanActivateSpellOnTile(const ACSKPlayerState* CastingPlayer, const ATile* TargetTile) const;
+
+	/** Calculates the final cost of this spell, only calling CalculateFinalCost through blueprints if overridden */
+	int32 GetFinalCost(const ACSKPlayerState* CastingPlayer, const ATile* TargetTile, int32 DiscountedCost, int32 AdditionalMana) const;
+
+	/** Get if this spell overrides CanActivateSpell or CalculateFinalCost in blueprints */
+	bool UsesCustomTargeting() const;
+
+	/** Get if given tile passes this spells targeting rules */
+	bool DoesTileMatchTargetingRules(const ACSKPlayerState* CastingPlayer, const ATile* TargetTile) const;
+
+	/** Get the cells that pass this spells targeting rules as a mask. This ignores any blueprint overrides */
+	void GetTargetingRulesMask(const ACSKPlayerState* CastingPlayer, const ABoardManager* BoardManager, FHexBitboard& OutMask) const;
+
 protected:
 
+	/** Get the tile the casting players castle is on */
+	static const ATile* GetCastingPlayersCastleTile(const ACSKPlayerState* CastingPlayer);
+
 	/** Helper function for retrieving the CSK Game Mode */
 	UFUNCTION(BlueprintPure, Category = Spells)
 	ACSKGameMode* GetCSKGameMode(const ACSKPlayerState* CastingPlayer) const;
@@ -96,6 +194,12 @@ public:
 	/** Get if this spell nullifies other spells (only valid for quick effects ) */
 	FORCEINLINE bool NullifiesOtherSpell() const { return bSpellNullifiesSpells; }
 
+	/** Get the damage this spell is expected to deal to its target when simulating matches */
+	FORCEINLINE int32 GetSimulatedDamage() const { return SimulatedDamage; }
+
+	/** Get this spells targeting rules */
+	FORCEINLINE const FSpellTargetingRules& GetTargetingRules() const { return TargetingRules; }
+
 protected:
 
 	/** The name of this spell */
@@ -133,7 +237,16 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Spells, meta = (DisplayName="Expects Additional Mana"))
 	uint8 bSpellExpectsAdditionalMana : 1;
 
+	/** The tiles this spell can target and any additional cost for targeting them.
+	Used by the default implementations of CanActivateSpell and CalculateFinalCost */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Spells)
+	FSpellTargetingRules TargetingRules;
+
 	/** If this spell is a quick effect, do we instantly nullify the opponents spell or activate afterwards */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Quick Effect", meta = (DisplayName = "Nullifies Other Spells"))
 	uint8 bSpellNullifiesSpells : 1;
+
+	/** Damage this spell is expected to deal to its target (plus any additional mana). Only used when simulating matches (e.g. by the AI) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Simulation, meta = (ClampMin = 0))
+	int32 SimulatedDamage;
 };
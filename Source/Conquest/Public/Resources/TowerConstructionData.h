@@ -46,4 +46,40 @@ public:
 	/** The cost of mana to build this tower */
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Cost, meta = (ClampMin = 0))
 	int32 ManaCost;
+
+public:
+
+	/** Gold this tower gives its owner each collection phase. This is summed natively, so towers with fixed resources
+	don't need to implement the collection phase event. Only used if the tower doesn't want the event, in which case
+	the event decides all resources given instead (see ATower::BP_GetCollectionPhaseResources) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Collection, meta = (ClampMin = 0))
+	int32 CollectionGold;
+
+	/** Mana this tower gives its owner each collection phase (see CollectionGold) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Collection, meta = (ClampMin = 0))
+	int32 CollectionMana;
+
+	/** Additional spells its owner can cast each round. As spell uses are restored every round, these are given for as
+	long as the tower is owned rather than each collection phase. Only used if the tower doesn't want the event either */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Collection, meta = (ClampMin = 0))
+	int32 CollectionSpellUses;
+
+public:
+
+	/** Gold this tower is expected to give its owner each collection phase. Only used when simulating matches (e.g. by
+	the AI) and only if the tower wants the collection phase event, as CollectionGold is used as is otherwise */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Simulation, meta = (ClampMin = 0))
+	int32 SimulatedCollectionGold;
+
+	/** Mana this tower is expected to give its owner each collection phase (see SimulatedCollectionGold) */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Simulation, meta = (ClampMin = 0))
+	int32 SimulatedCollectionMana;
+
+	/** Damage this tower is expected to deal to each opposing piece in range during the end round phase. Only used when simulating matches */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Simulation, meta = (ClampMin = 0))
+	int32 SimulatedEndRoundDamage;
+
+	/** Range of this towers end round action. Only used when simulating matches */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Simulation, meta = (ClampMin = 0))
+	int32 SimulatedEndRoundRange;
 };
\ No newline at end of file
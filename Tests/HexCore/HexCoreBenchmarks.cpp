@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HexCoreTestTypes.h"
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+	/** Start and goal cells for searches, picked from passable cells of a grid */
+	std::vector<std::pair<int32_t, int32_t>> MakeQueries(const FTestGrid& Grid, int32_t NumQueries, uint32_t Seed)
+	{
+		std::mt19937 Generator(Seed);
+		std::uniform_int_distribution<int32_t> Cells(0, Grid.NumCells() - 1);
+
+		std::vector<std::pair<int32_t, int32_t>> Queries;
+		while (static_cast<int32_t>(Queries.size()) < NumQueries)
+		{
+			const int32_t Start = Cells(Generator);
+			const int32_t Goal = Cells(Generator);
+			if (Start != Goal && Grid.Passable(Start) && Grid.Passable(Goal))
+			{
+				Queries.emplace_back(Start, Goal);
+			}
+		}
+
+		return Queries;
+	}
+}
+
+static void BM_HexToIndex(benchmark::State& State)
+{
+	const int32_t Size = static_cast<int32_t>(State.range(0));
+	const FTestGrid Grid(Size, Size);
+
+	for (auto _ : State)
+	{
+		int32_t Sum = 0;
+		for (int32_t Index = 0; Index < Grid.NumCells(); ++Index)
+		{
+			Sum += Grid.Index(Grid.Hex(Index));
+		}
+
+		benchmark::DoNotOptimize(Sum);
+	}
+
+	State.SetItemsProcessed(State.iterations() * Grid.NumCells());
+}
+BENCHMARK(BM_HexToIndex)->Arg(16)->Arg(64)->Arg(256);
+
+static void BM_SpiralRange(benchmark::State& State)
+{
+	const int32_t Radius = static_cast<int32_t>(State.range(0));
+
+	for (auto _ : State)
+	{
+		int32_t Sum = 0;
+		HexCore::ForEachHexInSpiral(FTestHex(), Radius, [&Sum](const FTestHex& Hex)
+		{
+			Sum += Hex.X;
+			return true;
+		});
+
+		benchmark::DoNotOptimize(Sum);
+	}
+
+	State.SetItemsProcessed(State.iterations() * HexCore::NumHexesInRange(Radius));
+}
+BENCHMARK(BM_SpiralRange)->Arg(2)->Arg(4)->Arg(8);
+
+static void BM_AStar(benchmark::State& State)
+{
+	const int32_t Size = static_cast<int32_t>(State.range(0));
+
+	FTestGrid Grid(Size, Size);
+	Grid.BlockRandomCells(0.35f, 1337);
+
+	const std::vector<std::pair<int32_t, int32_t>> Queries = MakeQueries(Grid, 64, 7);
+
+	std::vector<int32_t> Parents;
+	HexCore::FSearchStats Stats;
+
+	int64_t NumExpanded = 0;
+	for (auto _ : State)
+	{
+		for (const std::pair<int32_t, int32_t>& Query : Queries)
+		{
+			benchmark::DoNotOptimize(Grid.FindPath(Query.first, Query.second, INT32_MAX, Parents, Stats));
+			NumExpanded += Stats.NumExpanded;
+		}
+	}
+
+	State.SetItemsProcessed(State.iterations() * static_cast<int64_t>(Queries.size()));
+	State.counters["Expanded"] = benchmark::Counter(static_cast<double>(NumExpanded), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_AStar)->Arg(16)->Arg(64)->Arg(256)->Unit(benchmark::kMicrosecond);
+
+static void BM_BreadthFirst(benchmark::State& State)
+{
+	const int32_t Size = static_cast<int32_t>(State.range(0));
+	const int32_t Range = static_cast<int32_t>(State.range(1));
+
+	FTestGrid Grid(Size, Size);
+	Grid.BlockRandomCells(0.2f, 1337);
+
+	const int32_t Origin = (Size / 2) * Size + Size / 2;
+	Grid.Blocked[static_cast<size_t>(Origin)] = false;
+
+	std::vector<int32_t> Distances, Parents, Queue;
+
+	for (auto _ : State)
+	{
+		benchmark::DoNotOptimize(Grid.FindReachable(Origin, Range, Distances, Parents, Queue));
+	}
+}
+BENCHMARK(BM_BreadthFirst)->Args({ 16, 4 })->Args({ 64, 4 })->Args({ 64, 16 })->Args({ 256, 16 })->Unit(benchmark::kMicrosecond);
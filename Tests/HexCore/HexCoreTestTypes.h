@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "HexCore.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+/** Minimal hex type, standing in for FIntVector */
+struct FTestHex
+{
+	FTestHex()
+		: X(0)
+		, Y(0)
+		, Z(0)
+	{
+
+	}
+
+	FTestHex(int32_t InX, int32_t InY, int32_t InZ)
+		: X(InX)
+		, Y(InY)
+		, Z(InZ)
+	{
+
+	}
+
+	bool operator == (const FTestHex& Other) const
+	{
+		return X == Other.X && Y == Other.Y && Z == Other.Z;
+	}
+
+	bool operator != (const FTestHex& Other) const
+	{
+		return !(*this == Other);
+	}
+
+	int32_t X;
+	int32_t Y;
+	int32_t Z;
+};
+
+/** Minimal vector type, standing in for FVector */
+struct FTestVector
+{
+	FTestVector()
+		: X(0.f)
+		, Y(0.f)
+		, Z(0.f)
+	{
+
+	}
+
+	FTestVector(float InX, float InY, float InZ)
+		: X(InX)
+		, Y(InY)
+		, Z(InZ)
+	{
+
+	}
+
+	float X;
+	float Y;
+	float Z;
+};
+
+/** Rectangular grid with blocked cells, laid out the same way as FHexGrid */
+struct FTestGrid
+{
+	FTestGrid(int32_t InRows, int32_t InColumns)
+		: Rows(InRows)
+		, Columns(InColumns)
+		, Blocked(static_cast<size_t>(InRows * InColumns), false)
+	{
+
+	}
+
+	/** Blocks cells at random, the same seed will always block the same cells */
+	void BlockRandomCells(float Chance, uint32_t Seed)
+	{
+		std::mt19937 Generator(Seed);
+		std::uniform_real_distribution<float> Distribution(0.f, 1.f);
+
+		for (size_t i = 0; i < Blocked.size(); ++i)
+		{
+			Blocked[i] = Distribution(Generator) < Chance;
+		}
+	}
+
+	int32_t NumCells() const
+	{
+		return Rows * Columns;
+	}
+
+	int32_t Index(const FTestHex& Hex) const
+	{
+		return HexCore::HexToIndex(Hex, Rows, Columns);
+	}
+
+	FTestHex Hex(int32_t Index) const
+	{
+		return HexCore::IndexToHex<FTestHex>(Index, Columns);
+	}
+
+	int32_t Neighbor(int32_t Index, int32_t Direction) const
+	{
+		return HexCore::HexToIndex(HexCore::HexNeighbor(Hex(Index), Direction), Rows, Columns);
+	}
+
+	bool Passable(int32_t Index) const
+	{
+		return !Blocked[static_cast<size_t>(Index)];
+	}
+
+	/** Runs an A* search between cells, filling parents. Get if goal was reached */
+	bool FindPath(int32_t Start, int32_t Goal, int32_t MaxDistance, std::vector<int32_t>& OutParents, HexCore::FSearchStats& OutStats) const
+	{
+		OutParents.resize(static_cast<size_t>(NumCells()));
+		std::vector<int32_t> Costs(static_cast<size_t>(NumCells()));
+
+		const FTestHex GoalHex = Hex(Goal);
+
+		return HexCore::AStarSearch(NumCells(), Start, Goal, MaxDistance, OutParents.data(), Costs.data(),
+			[this](int32_t Index, int32_t Direction) { return Neighbor(Index, Direction); },
+			[this](int32_t Index) { return Passable(Index); },
+			[this, &GoalHex](int32_t Index) { return HexCore::HexDisplacement(Hex(Index), GoalHex); },
+			OutStats);
+	}
+
+	/** Runs a breadth-first search from origin. Get the amount of cells reached */
+	int32_t FindReachable(int32_t Origin, int32_t MaxDistance, std::vector<int32_t>& OutDistances, std::vector<int32_t>& OutParents, std::vector<int32_t>& OutQueue) const
+	{
+		OutDistances.resize(static_cast<size_t>(NumCells()));
+		OutParents.resize(static_cast<size_t>(NumCells()));
+		OutQueue.resize(static_cast<size_t>(NumCells()));
+
+		return HexCore::BreadthFirstSearch(NumCells(), Origin, MaxDistance, OutDistances.data(), OutParents.data(), OutQueue.data(),
+			[this](int32_t Index, int32_t Direction) { return Neighbor(Index, Direction); },
+			[this](int32_t Index) { return Passable(Index); });
+	}
+
+	int32_t Rows;
+	int32_t Columns;
+	std::vector<bool> Blocked;
+};
@@ -0,0 +1,409 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HexCoreTestTypes.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	/** Get the amount of moves in a path by walking parents back from goal */
+	int32_t CountPathMoves(const std::vector<int32_t>& Parents, int32_t Start, int32_t Goal)
+	{
+		int32_t NumMoves = 0;
+		for (int32_t Index = Goal; Index != Start; Index = Parents[static_cast<size_t>(Index)])
+		{
+			if (Index == HexCore::InvalidIndex)
+			{
+				return -1;
+			}
+
+			++NumMoves;
+		}
+
+		return NumMoves;
+	}
+}
+
+// Hex math
+
+TEST(HexMath, NeighborsAreValidAndOneCellAway)
+{
+	const FTestHex Center(2, -5, 3);
+	for (int32_t Direction = 0; Direction < 6; ++Direction)
+	{
+		const FTestHex Neighbor = HexCore::HexNeighbor(Center, Direction);
+
+		EXPECT_TRUE(HexCore::IsValidHex(Neighbor));
+		EXPECT_EQ(HexCore::HexDisplacement(Center, Neighbor), 1);
+		EXPECT_EQ(HexCore::HexLength(HexCore::HexDirection<FTestHex>(Direction)), 1);
+	}
+}
+
+TEST(HexMath, Displacement)
+{
+	const FTestHex Origin(0, 0, 0);
+
+	EXPECT_EQ(HexCore::HexDisplacement(Origin, Origin), 0);
+	EXPECT_EQ(HexCore::HexDisplacement(Origin, FTestHex(3, -3, 0)), 3);
+	EXPECT_EQ(HexCore::HexDisplacement(Origin, FTestHex(2, 1, -3)), 3);
+	EXPECT_EQ(HexCore::HexDisplacement(FTestHex(-4, 2, 2), FTestHex(1, -1, 0)), 5);
+
+	// Displacement is symmetric
+	EXPECT_EQ(HexCore::HexDisplacement(FTestHex(1, -1, 0), FTestHex(-4, 2, 2)), 5);
+}
+
+TEST(HexMath, IsValidHex)
+{
+	EXPECT_TRUE(HexCore::IsValidHex(FTestHex(1, 2, -3)));
+	EXPECT_FALSE(HexCore::IsValidHex(FTestHex(1, 2, 3)));
+}
+
+TEST(HexMath, RoundsToNearestValidHex)
+{
+	EXPECT_EQ(HexCore::HexRound<FTestHex>(FTestVector(0.1f, -0.2f, 0.1f)), FTestHex(0, 0, 0));
+	EXPECT_EQ(HexCore::HexRound<FTestHex>(FTestVector(1.9f, -1.1f, -0.8f)), FTestHex(2, -1, -1));
+
+	// Largest delta is the one that gets corrected
+	const FTestHex Rounded = HexCore::HexRound<FTestHex>(FTestVector(0.4f, 0.4f, -0.8f));
+	EXPECT_TRUE(HexCore::IsValidHex(Rounded));
+}
+
+TEST(HexMath, WorldConversionRoundTrips)
+{
+	const FTestVector Origin(100.f, -50.f, 20.f);
+	const FTestVector Size(64.f, 64.f, 0.f);
+
+	for (int32_t Row = -6; Row <= 6; ++Row)
+	{
+		for (int32_t Column = -6; Column <= 6; ++Column)
+		{
+			const FTestHex Hex = HexCore::IndicesToHex<FTestHex>(Row, Column);
+			const FTestVector World = HexCore::HexToWorld(Hex, Origin, Size);
+
+			EXPECT_FLOAT_EQ(World.Z, Origin.Z);
+			EXPECT_EQ(HexCore::WorldToHex<FTestHex>(World, Origin, Size), Hex);
+		}
+	}
+}
+
+TEST(HexMath, VerticesAreOnCellBoundary)
+{
+	const FTestVector Origin(10.f, 20.f, 30.f);
+	for (int32_t Index = 0; Index < 6; ++Index)
+	{
+		const FTestVector Vertex = HexCore::HexVertexToWorld(Origin, 50.f, Index);
+		const float Distance = std::sqrt((Vertex.X - Origin.X) * (Vertex.X - Origin.X) + (Vertex.Y - Origin.Y) * (Vertex.Y - Origin.Y));
+
+		EXPECT_NEAR(Distance, 50.f, 1e-3f);
+		EXPECT_FLOAT_EQ(Vertex.Z, Origin.Z);
+	}
+}
+
+TEST(HexMath, RangeOffsetsMatchHexCount)
+{
+	for (int32_t Distance = 0; Distance <= 8; ++Distance)
+	{
+		int32_t NumOffsets = 0;
+		HexCore::ForEachOffsetInRange(Distance, [&NumOffsets, Distance](int32_t X, int32_t Y)
+		{
+			EXPECT_LE(HexCore::HexLength(FTestHex(X, Y, -X - Y)), Distance);
+			++NumOffsets;
+			return true;
+		});
+
+		EXPECT_EQ(NumOffsets, HexCore::NumHexesInRange(Distance));
+	}
+}
+
+TEST(HexMath, RingsContainOnlyHexesAtRadius)
+{
+	const FTestHex Center(3, -1, -2);
+	for (int32_t Radius = 0; Radius <= 6; ++Radius)
+	{
+		int32_t NumHexes = 0;
+		HexCore::ForEachHexInRing(Center, Radius, [&](const FTestHex& Hex)
+		{
+			EXPECT_EQ(HexCore::HexDisplacement(Center, Hex), Radius);
+			++NumHexes;
+			return true;
+		});
+
+		EXPECT_EQ(NumHexes, Radius == 0 ? 1 : 6 * Radius);
+	}
+}
+
+TEST(HexMath, SpiralVisitsRingsInOrder)
+{
+	const FTestHex Center(0, 0, 0);
+
+	int32_t NumHexes = 0;
+	int32_t LastDistance = 0;
+	HexCore::ForEachHexInSpiral(Center, 5, [&](const FTestHex& Hex)
+	{
+		const int32_t Distance = HexCore::HexDisplacement(Center, Hex);
+		EXPECT_GE(Distance, LastDistance);
+
+		LastDistance = Distance;
+		++NumHexes;
+		return true;
+	});
+
+	EXPECT_EQ(NumHexes, HexCore::NumHexesInRange(5));
+}
+
+TEST(HexMath, IterationStopsEarly)
+{
+	int32_t NumVisited = 0;
+	const bool bCompleted = HexCore::ForEachHexInSpiral(FTestHex(), 4, [&NumVisited](const FTestHex&)
+	{
+		return ++NumVisited < 3;
+	});
+
+	EXPECT_FALSE(bCompleted);
+	EXPECT_EQ(NumVisited, 3);
+}
+
+// Index layout
+
+TEST(IndexLayout, IndicesAreDenseAndRoundTrip)
+{
+	const int32_t Rows = 7;
+	const int32_t Columns = 12;
+
+	std::vector<bool> Seen(static_cast<size_t>(Rows * Columns), false);
+	for (int32_t Index = 0; Index < Rows * Columns; ++Index)
+	{
+		const FTestHex Hex = HexCore::IndexToHex<FTestHex>(Index, Columns);
+
+		EXPECT_TRUE(HexCore::IsValidHex(Hex));
+		ASSERT_EQ(HexCore::HexToIndex(Hex, Rows, Columns), Index);
+
+		Seen[static_cast<size_t>(Index)] = true;
+	}
+
+	EXPECT_TRUE(std::all_of(Seen.begin(), Seen.end(), [](bool bSeen) { return bSeen; }));
+}
+
+TEST(IndexLayout, IsRowMajorWithOffsetColumns)
+{
+	const int32_t Rows = 5;
+	const int32_t Columns = 6;
+
+	for (int32_t Column = 0; Column < Columns; ++Column)
+	{
+		// Same offsetting as FHexGrid::GenerateGrid
+		const int32_t Offset = Column / 2;
+		for (int32_t Row = 0; Row < Rows; ++Row)
+		{
+			const FTestHex Hex = HexCore::IndicesToHex<FTestHex>(Row - Offset, Column);
+			EXPECT_EQ(HexCore::HexToIndex(Hex, Rows, Columns), Row * Columns + Column);
+		}
+	}
+}
+
+TEST(IndexLayout, OutsideGridIsInvalid)
+{
+	const int32_t Rows = 4;
+	const int32_t Columns = 4;
+
+	EXPECT_EQ(HexCore::HexToIndex(FTestHex(-1, 0, 1), Rows, Columns), HexCore::InvalidIndex);
+	EXPECT_EQ(HexCore::HexToIndex(FTestHex(0, -1, 1), Rows, Columns), HexCore::InvalidIndex);
+	EXPECT_EQ(HexCore::HexToIndex(FTestHex(4, 0, -4), Rows, Columns), HexCore::InvalidIndex);
+	EXPECT_EQ(HexCore::HexToIndex(FTestHex(0, 4, -4), Rows, Columns), HexCore::InvalidIndex);
+
+	// Not a valid cube coordinate
+	EXPECT_EQ(HexCore::HexToIndex(FTestHex(1, 1, 1), Rows, Columns), HexCore::InvalidIndex);
+}
+
+// A*
+
+TEST(AStar, OpenGridPathIsDisplacement)
+{
+	const FTestGrid Grid(12, 12);
+
+	const int32_t Start = Grid.Index(HexCore::IndicesToHex<FTestHex>(0, 0));
+	const int32_t Goal = Grid.Index(HexCore::IndicesToHex<FTestHex>(2, 11));
+	ASSERT_NE(Goal, HexCore::InvalidIndex);
+
+	std::vector<int32_t> Parents;
+	HexCore::FSearchStats Stats;
+
+	ASSERT_TRUE(Grid.FindPath(Start, Goal, INT32_MAX, Parents, Stats));
+	EXPECT_EQ(CountPathMoves(Parents, Start, Goal), HexCore::HexDisplacement(Grid.Hex(Start), Grid.Hex(Goal)));
+	EXPECT_EQ(Stats.ClosestIndex, Goal);
+	EXPECT_GT(Stats.NumExpanded, 0);
+}
+
+TEST(AStar, PathsAroundWalls)
+{
+	FTestGrid Grid(9, 9);
+
+	// Wall down column 4, leaving only the last row open
+	for (int32_t Row = 0; Row < Grid.Rows - 1; ++Row)
+	{
+		Grid.Blocked[static_cast<size_t>(Row * Grid.Columns + 4)] = true;
+	}
+
+	const int32_t Start = 0 * Grid.Columns + 2;
+	const int32_t Goal = 0 * Grid.Columns + 6;
+
+	std::vector<int32_t> Parents;
+	HexCore::FSearchStats Stats;
+
+	ASSERT_TRUE(Grid.FindPath(Start, Goal, INT32_MAX, Parents, Stats));
+
+	const int32_t NumMoves = CountPathMoves(Parents, Start, Goal);
+	EXPECT_GT(NumMoves, HexCore::HexDisplacement(Grid.Hex(Start), Grid.Hex(Goal)));
+
+	// Path never enters a blocked cell and every step is to a neighbor
+	for (int32_t Index = Goal; Index != Start; Index = Parents[static_cast<size_t>(Index)])
+	{
+		EXPECT_TRUE(Grid.Passable(Index));
+		EXPECT_EQ(HexCore::HexDisplacement(Grid.Hex(Index), Grid.Hex(Parents[static_cast<size_t>(Index)])), 1);
+	}
+
+	// Breadth-first search agrees on the shortest distance
+	std::vector<int32_t> Distances, BFSParents, Queue;
+	Grid.FindReachable(Start, INT32_MAX, Distances, BFSParents, Queue);
+	EXPECT_EQ(NumMoves, Distances[static_cast<size_t>(Goal)]);
+}
+
+TEST(AStar, UnreachableGoalReportsClosestCell)
+{
+	FTestGrid Grid(6, 8);
+
+	// Wall off the last two columns completely
+	for (int32_t Row = 0; Row < Grid.Rows; ++Row)
+	{
+		Grid.Blocked[static_cast<size_t>(Row * Grid.Columns + 5)] = true;
+	}
+
+	const int32_t Start = 2 * Grid.Columns + 0;
+	const int32_t Goal = 2 * Grid.Columns + 7;
+
+	std::vector<int32_t> Parents;
+	HexCore::FSearchStats Stats;
+
+	EXPECT_FALSE(Grid.FindPath(Start, Goal, INT32_MAX, Parents, Stats));
+	ASSERT_NE(Stats.ClosestIndex, HexCore::InvalidIndex);
+
+	// Closest cell is right up against the wall
+	EXPECT_EQ(Stats.ClosestIndex % Grid.Columns, 4);
+	EXPECT_GE(CountPathMoves(Parents, Start, Stats.ClosestIndex), 0);
+}
+
+TEST(AStar, RespectsMaxDistance)
+{
+	const FTestGrid Grid(10, 10);
+
+	const int32_t Start = 0;
+	const int32_t Goal = 9;
+
+	std::vector<int32_t> Parents;
+	HexCore::FSearchStats Stats;
+
+	EXPECT_FALSE(Grid.FindPath(Start, Goal, 5, Parents, Stats));
+	EXPECT_LE(HexCore::HexDisplacement(Grid.Hex(Start), Grid.Hex(Stats.ClosestIndex)), 5);
+
+	EXPECT_TRUE(Grid.FindPath(Start, Goal, 9, Parents, Stats));
+}
+
+TEST(AStar, MatchesBreadthFirstOnRandomBoards)
+{
+	FTestGrid Grid(24, 24);
+	Grid.BlockRandomCells(0.3f, 42);
+
+	std::mt19937 Generator(7);
+	std::uniform_int_distribution<int32_t> Cells(0, Grid.NumCells() - 1);
+
+	std::vector<int32_t> Parents, Distances, BFSParents, Queue;
+	HexCore::FSearchStats Stats;
+
+	for (int32_t i = 0; i < 64; ++i)
+	{
+		const int32_t Start = Cells(Generator);
+		const int32_t Goal = Cells(Generator);
+		if (!Grid.Passable(Start) || !Grid.Passable(Goal))
+		{
+			continue;
+		}
+
+		Grid.FindReachable(Start, INT32_MAX, Distances, BFSParents, Queue);
+
+		const bool bFound = Grid.FindPath(Start, Goal, INT32_MAX, Parents, Stats);
+		EXPECT_EQ(bFound, Distances[static_cast<size_t>(Goal)] != HexCore::InvalidIndex);
+
+		if (bFound)
+		{
+			EXPECT_EQ(CountPathMoves(Parents, Start, Goal), Distances[static_cast<size_t>(Goal)]);
+		}
+	}
+}
+
+// Breadth-first search
+
+TEST(BreadthFirst, OpenGridReachesFullRange)
+{
+	const FTestGrid Grid(21, 21);
+	const int32_t Origin = 10 * Grid.Columns + 10;
+	const int32_t Range = 4;
+
+	std::vector<int32_t> Distances, Parents, Queue;
+	const int32_t NumReached = Grid.FindReachable(Origin, Range, Distances, Parents, Queue);
+
+	EXPECT_EQ(NumReached, HexCore::NumHexesInRange(Range));
+	EXPECT_EQ(Queue[0], Origin);
+	EXPECT_EQ(Parents[static_cast<size_t>(Origin)], HexCore::InvalidIndex);
+
+	for (int32_t i = 0; i < NumReached; ++i)
+	{
+		const int32_t Index = Queue[static_cast<size_t>(i)];
+		EXPECT_EQ(Distances[static_cast<size_t>(Index)], HexCore::HexDisplacement(Grid.Hex(Origin), Grid.Hex(Index)));
+	}
+}
+
+TEST(BreadthFirst, QueueIsOrderedByDistance)
+{
+	FTestGrid Grid(16, 16);
+	Grid.BlockRandomCells(0.25f, 3);
+
+	const int32_t Origin = 8 * Grid.Columns + 8;
+	Grid.Blocked[static_cast<size_t>(Origin)] = false;
+
+	std::vector<int32_t> Distances, Parents, Queue;
+	const int32_t NumReached = Grid.FindReachable(Origin, 6, Distances, Parents, Queue);
+
+	for (int32_t i = 1; i < NumReached; ++i)
+	{
+		const int32_t Index = Queue[static_cast<size_t>(i)];
+		const int32_t Parent = Parents[static_cast<size_t>(Index)];
+
+		EXPECT_GE(Distances[static_cast<size_t>(Index)], Distances[static_cast<size_t>(Queue[static_cast<size_t>(i - 1)])]);
+		EXPECT_LE(Distances[static_cast<size_t>(Index)], 6);
+		EXPECT_EQ(Distances[static_cast<size_t>(Index)], Distances[static_cast<size_t>(Parent)] + 1);
+		EXPECT_TRUE(Grid.Passable(Index));
+	}
+}
+
+TEST(BreadthFirst, BlockedCellsAreNeverReached)
+{
+	FTestGrid Grid(9, 9);
+	const int32_t Origin = 4 * Grid.Columns + 4;
+
+	// Surround the origin
+	for (int32_t Direction = 0; Direction < 6; ++Direction)
+	{
+		Grid.Blocked[static_cast<size_t>(Grid.Neighbor(Origin, Direction))] = true;
+	}
+
+	std::vector<int32_t> Distances, Parents, Queue;
+	EXPECT_EQ(Grid.FindReachable(Origin, 8, Distances, Parents, Queue), 1);
+
+	for (int32_t Direction = 0; Direction < 6; ++Direction)
+	{
+		EXPECT_EQ(Distances[static_cast<size_t>(Grid.Neighbor(Origin, Direction))], HexCore::InvalidIndex);
+	}
+}